@@ -7,13 +7,16 @@
 #include <crypto/sha256.h>
 #include <node/miner.h>
 #include <random.h>
+#include <script/script.h>
 #include <test/util/mining.h>
 #include <test/util/script.h>
 #include <test/util/setup_common.h>
 #include <txmempool.h>
+#include <util/chaintype.h>
 #include <validation.h>
+#include <validationinterface.h>
 
-
+#include <memory>
 #include <vector>
 
 static void AssembleBlock(benchmark::Bench& bench)
@@ -60,5 +63,79 @@ static void BlockAssemblerAddPackageTxns(benchmark::Bench& bench)
     });
 }
 
+// Steady-state template latency: each iteration adds one transaction to the mempool and then
+// requests a template, either from a BlockTemplateCache or by running BlockAssembler again. The
+// template is requested right away, as by a miner polling, so the cache may not have been notified
+// of the latest transactions yet.
+static void BlockTemplateUpdates(benchmark::Bench& bench, bool use_cache)
+{
+    constexpr size_t NUM_INITIAL{1000};
+    constexpr size_t NUM_STREAM{1000};
+    FastRandomContext det_rand{true};
+    // Skip the per-transaction mempool consistency checks, which would dominate.
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>(ChainType::REGTEST, {"-checkmempool=0"})};
+    node::NodeContext& node{testing_setup->m_node};
+    const CScript script_pub_key{GetScriptForRawPubKey(testing_setup->coinbaseKey.GetPubKey())};
+
+    // Fan the mature coinbase out into one confirmed output per transaction.
+    const CAmount output_value{COIN / 100};
+    std::vector<CTxOut> outputs(NUM_INITIAL + NUM_STREAM, CTxOut{output_value, script_pub_key});
+    const CTransactionRef fan_out{MakeTransactionRef(testing_setup->CreateValidTransaction(
+        {testing_setup->m_coinbase_txns[0]}, {COutPoint{testing_setup->m_coinbase_txns[0]->GetHash(), 0}},
+        /*input_height=*/1, {testing_setup->coinbaseKey}, outputs, std::nullopt, std::nullopt).first)};
+    testing_setup->CreateAndProcessBlock({CMutableTransaction{*fan_out}}, script_pub_key);
+    const int fan_out_height{WITH_LOCK(::cs_main, return node.chainman->ActiveHeight())};
+
+    std::vector<CTransactionRef> txs;
+    for (uint32_t i = 0; i < NUM_INITIAL + NUM_STREAM; ++i) {
+        const CAmount fee{1000 + CAmount(det_rand.randrange(10000))};
+        txs.push_back(MakeTransactionRef(testing_setup->CreateValidTransaction(
+            {fan_out}, {COutPoint{fan_out->GetHash(), i}}, fan_out_height, {testing_setup->coinbaseKey},
+            {CTxOut{output_value - fee, P2WSH_OP_TRUE}}, std::nullopt, std::nullopt).first));
+    }
+    const auto submit = [&](const CTransactionRef& tx) {
+        LOCK(::cs_main);
+        const MempoolAcceptResult res{node.chainman->ProcessTransaction(tx)};
+        assert(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+    };
+    for (size_t i = 0; i < NUM_INITIAL; ++i) submit(txs[i]);
+
+    node::BlockAssembler::Options assembler_options;
+    assembler_options.test_block_validity = false;
+    std::unique_ptr<node::BlockTemplateCache> cache;
+    std::shared_ptr<const node::CBlockTemplate> block_template;
+    if (use_cache) {
+        cache = std::make_unique<node::BlockTemplateCache>(*node.chainman, *node.mempool, assembler_options);
+        node.validation_signals->RegisterValidationInterface(cache.get());
+        block_template = cache->Get(P2WSH_OP_TRUE);
+    }
+
+    size_t next{NUM_INITIAL};
+    bench.epochs(10).epochIterations(NUM_STREAM / 10).run([&] {
+        assert(next < txs.size());
+        submit(txs[next++]);
+        if (use_cache) {
+            block_template = cache->Get(P2WSH_OP_TRUE);
+            assert(block_template->block.vtx.size() <= next + 1);
+        } else {
+            block_template = node::BlockAssembler{node.chainman->ActiveChainstate(), node.mempool.get(), assembler_options}.CreateNewBlock(P2WSH_OP_TRUE);
+            assert(block_template->block.vtx.size() == next + 1);
+        }
+    });
+
+    if (cache) {
+        // The cache catches up by appending once notified, without rebuilding.
+        node.validation_signals->SyncWithValidationInterfaceQueue();
+        assert(cache->Get(P2WSH_OP_TRUE)->block.vtx.size() == next + 1);
+        assert(cache->GetRebuildCount() == 1);
+        node.validation_signals->UnregisterValidationInterface(cache.get());
+    }
+}
+
+static void BlockTemplateUpdatesCached(benchmark::Bench& bench) { BlockTemplateUpdates(bench, /*use_cache=*/true); }
+static void BlockTemplateUpdatesRebuild(benchmark::Bench& bench) { BlockTemplateUpdates(bench, /*use_cache=*/false); }
+
 BENCHMARK(AssembleBlock, benchmark::PriorityLevel::HIGH);
 BENCHMARK(BlockAssemblerAddPackageTxns, benchmark::PriorityLevel::LOW);
+BENCHMARK(BlockTemplateUpdatesCached, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockTemplateUpdatesRebuild, benchmark::PriorityLevel::HIGH);
@@ -6,6 +6,7 @@
 #include <coins.h>
 #include <policy/policy.h>
 #include <script/signingprovider.h>
+#include <random.h>
 #include <test/util/transaction_utils.h>
 
 #include <vector>
@@ -49,4 +50,69 @@ static void CCoinsCaching(benchmark::Bench& bench)
     });
 }
 
+/**
+ * Cache access pattern of connecting blocks against a warm cache: look up the
+ * spent outputs (mostly hits), spend them (erasing FRESH ones), add the newly
+ * created outputs, and probe a few outpoints that are not cached at all.
+ * Runs against both CCoinsMap implementations, independently of which one
+ * CCoinsViewCache was built with.
+ */
+template <typename Map>
+static void CoinsMapAccess(benchmark::Bench& bench, Map& map)
+{
+    constexpr size_t INITIAL_COINS{200'000};
+    constexpr size_t COINS_PER_BLOCK{2'000};
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    const CScript script{CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0) << OP_EQUALVERIFY << OP_CHECKSIG};
+    std::vector<COutPoint> live;
+    live.reserve(INITIAL_COINS);
+    for (size_t i = 0; i < INITIAL_COINS; ++i) {
+        live.emplace_back(Txid::FromUint256(rng.rand256()), 0);
+        map.emplace(std::piecewise_construct, std::forward_as_tuple(live.back()),
+                    std::forward_as_tuple(Coin{CTxOut{1, script}, 1, false}, CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH));
+    }
+
+    bench.batch(COINS_PER_BLOCK).unit("coin").run([&] {
+        for (size_t i = 0; i < COINS_PER_BLOCK; ++i) {
+            // Spend a random cached coin.
+            const size_t idx{rng.randrange(live.size())};
+            auto it = map.find(live[idx]);
+            assert(it != map.end());
+            if (it->second.flags & CCoinsCacheEntry::FRESH) {
+                map.erase(it);
+            } else {
+                it->second.coin.Clear();
+                it->second.flags |= CCoinsCacheEntry::DIRTY;
+            }
+            // Create a new one in its place.
+            live[idx] = COutPoint{Txid::FromUint256(rng.rand256()), 0};
+            auto [new_it, inserted] = map.emplace(std::piecewise_construct, std::forward_as_tuple(live[idx]), std::tuple<>());
+            assert(inserted);
+            new_it->second.coin = Coin{CTxOut{1, script}, 2, false};
+            new_it->second.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+            // Occasionally miss.
+            if (i % 4 == 0) {
+                const bool found{map.find(COutPoint{Txid::FromUint256(rng.rand256()), 0}) != map.end()};
+                assert(!found);
+            }
+        }
+    });
+}
+
+static void CCoinsNodeMapAccess(benchmark::Bench& bench)
+{
+    CCoinsNodeMap::allocator_type::ResourceType resource{};
+    CCoinsNodeMap map{0, SaltedOutpointHasher{}, CCoinsNodeMap::key_equal{}, &resource};
+    CoinsMapAccess(bench, map);
+}
+
+static void CCoinsFlatMapAccess(benchmark::Bench& bench)
+{
+    CCoinsFlatMap map{0, SaltedOutpointHasher{}, CCoinsFlatMap::key_equal{}};
+    CoinsMapAccess(bench, map);
+}
+
 BENCHMARK(CCoinsCaching, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsNodeMapAccess, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsFlatMapAccess, benchmark::PriorityLevel::HIGH);
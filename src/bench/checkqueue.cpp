@@ -5,11 +5,13 @@
 #include <bench/bench.h>
 #include <checkqueue.h>
 #include <common/system.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <pubkey.h>
 #include <random.h>
 
+#include <algorithm>
 #include <vector>
 
 static const size_t BATCHES = 101;
@@ -64,3 +66,53 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     });
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob, benchmark::PriorityLevel::HIGH);
+
+// This Benchmark tests how the CheckQueue scales with the number of threads
+// when check costs are uneven: about 1% of the checks are a hundred times as
+// expensive as the rest, like a block mixing cheap spends with a few large
+// multisig or bare script inputs.
+static void CCheckQueueUneven(benchmark::Bench& bench, int worker_threads_num, bool work_stealing)
+{
+    struct UnevenJob {
+        unsigned int rounds;
+        bool operator()()
+        {
+            unsigned char hash[CSHA256::OUTPUT_SIZE]{};
+            for (unsigned int i = 0; i < rounds; ++i) {
+                CSHA256().Write(hash, sizeof(hash)).Finalize(hash);
+            }
+            return hash[0] != 0 || hash[1] != 0 || rounds < 2;
+        }
+    };
+
+    CCheckQueue<UnevenJob> queue{QUEUE_BATCH_SIZE, worker_threads_num, work_stealing};
+
+    FastRandomContext insecure_rand(true);
+    std::vector<std::vector<UnevenJob>> vBatches(BATCHES);
+    for (auto& vChecks : vBatches) {
+        vChecks.reserve(BATCH_SIZE);
+        for (size_t x = 0; x < BATCH_SIZE; ++x) {
+            vChecks.push_back({insecure_rand.randrange(100) == 0 ? 2000U : 20U});
+        }
+    }
+
+    bench.batch(BATCH_SIZE * BATCHES).unit("job").run([&] {
+        CCheckQueueControl<UnevenJob> control(&queue);
+        for (auto vChecks : vBatches) {
+            control.Add(std::move(vChecks));
+        }
+        assert(control.Wait());
+    });
+}
+static void CCheckQueueUnevenShared2(benchmark::Bench& bench) { CCheckQueueUneven(bench, 1, /*work_stealing=*/false); }
+static void CCheckQueueUnevenShared8(benchmark::Bench& bench) { CCheckQueueUneven(bench, 7, /*work_stealing=*/false); }
+static void CCheckQueueUnevenShared32(benchmark::Bench& bench) { CCheckQueueUneven(bench, 31, /*work_stealing=*/false); }
+static void CCheckQueueUnevenStealing2(benchmark::Bench& bench) { CCheckQueueUneven(bench, 1, /*work_stealing=*/true); }
+static void CCheckQueueUnevenStealing8(benchmark::Bench& bench) { CCheckQueueUneven(bench, 7, /*work_stealing=*/true); }
+static void CCheckQueueUnevenStealing32(benchmark::Bench& bench) { CCheckQueueUneven(bench, 31, /*work_stealing=*/true); }
+BENCHMARK(CCheckQueueUnevenShared2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueUnevenShared8, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueUnevenShared32, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueUnevenStealing2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueUnevenStealing8, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueUnevenStealing32, benchmark::PriorityLevel::HIGH);
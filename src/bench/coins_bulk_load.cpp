@@ -0,0 +1,48 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <consensus/amount.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <txdb.h>
+#include <util/check.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+static constexpr int NUM_COINS{250000};
+
+/** Flush a cache of synthetic P2WPKH-like coins, like a snapshot being loaded, into an empty database. */
+static void FlushCoins(benchmark::Bench& bench, bool bulk_load)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    coins.reserve(NUM_COINS);
+    for (int i = 0; i < NUM_COINS; ++i) {
+        coins.emplace_back(COutPoint{Txid::FromUint256(rng.rand256()), uint32_t(rng.randrange(4))},
+                           Coin{CTxOut{CAmount(rng.randrange(MAX_MONEY)), CScript() << OP_0 << rng.randbytes(20)}, 100, false});
+    }
+    const uint256 best_block{rng.rand256()};
+
+    bench.batch(NUM_COINS).unit("coin").run([&] {
+        CCoinsViewDB coins_db{{.path = "", .cache_bytes = 64 << 20, .memory_only = true}, {.bulk_load_min_coins = 1}};
+        coins_db.SetBulkLoad(bulk_load);
+        CCoinsViewCache cache{&coins_db};
+        for (const auto& [outpoint, coin] : coins) {
+            cache.AddCoin(outpoint, Coin{coin}, /*possible_overwrite=*/true);
+        }
+        cache.SetBestBlock(best_block);
+        Assert(cache.Flush());
+    });
+}
+
+static void CoinsFlushBatches(benchmark::Bench& bench) { FlushCoins(bench, /*bulk_load=*/false); }
+static void CoinsFlushBulkLoad(benchmark::Bench& bench) { FlushCoins(bench, /*bulk_load=*/true); }
+
+BENCHMARK(CoinsFlushBatches, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CoinsFlushBulkLoad, benchmark::PriorityLevel::HIGH);
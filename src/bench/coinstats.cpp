@@ -0,0 +1,53 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <consensus/amount.h>
+#include <kernel/coinstats.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <util/check.h>
+#include <validation.h>
+
+#include <memory>
+
+static constexpr int NUM_COINS{100000};
+
+/** Compute the MuHash of a synthetic UTXO set with P2WPKH-like outputs, like gettxoutsetinfo muhash. */
+static void ComputeUTXOStatsMuHash(benchmark::Bench& bench, int threads)
+{
+    const auto setup{MakeNoLogFileContext<const TestingSetup>()};
+    CCoinsViewDB coins_db{{.path = "", .cache_bytes = 64 << 20, .memory_only = true}, {}};
+    {
+        FastRandomContext rng{/*fDeterministic=*/true};
+        CCoinsViewCache cache{&coins_db};
+        for (int i = 0; i < NUM_COINS; ++i) {
+            cache.AddCoin(COutPoint{Txid::FromUint256(rng.rand256()), uint32_t(rng.randrange(4))},
+                          Coin{CTxOut{CAmount(rng.randrange(MAX_MONEY)), CScript() << OP_0 << rng.randbytes(20)}, 100, false},
+                          /*possible_overwrite=*/true);
+        }
+        // The statistics are for the best block, which must be known.
+        cache.SetBestBlock(WITH_LOCK(::cs_main, return setup->m_node.chainman->ActiveTip()->GetBlockHash()));
+        Assert(cache.Flush());
+    }
+
+    bench.batch(NUM_COINS).unit("coin").run([&] {
+        const auto stats{kernel::ComputeUTXOStats(kernel::CoinStatsHashType::MUHASH, coins_db, setup->m_node.chainman->m_blockman, threads)};
+        assert(stats && stats->coins_count == NUM_COINS);
+    });
+}
+
+static void ComputeUTXOStatsMuHashOneThread(benchmark::Bench& bench) { ComputeUTXOStatsMuHash(bench, 1); }
+static void ComputeUTXOStatsMuHashTwoThreads(benchmark::Bench& bench) { ComputeUTXOStatsMuHash(bench, 2); }
+static void ComputeUTXOStatsMuHashFourThreads(benchmark::Bench& bench) { ComputeUTXOStatsMuHash(bench, 4); }
+static void ComputeUTXOStatsMuHashEightThreads(benchmark::Bench& bench) { ComputeUTXOStatsMuHash(bench, 8); }
+
+BENCHMARK(ComputeUTXOStatsMuHashOneThread, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ComputeUTXOStatsMuHashTwoThreads, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ComputeUTXOStatsMuHashFourThreads, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ComputeUTXOStatsMuHashEightThreads, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,85 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <common/args.h>
+#include <httpserver.h>
+#include <rpc/protocol.h>
+#include <support/events.h>
+#include <test/util/setup_common.h>
+#include <util/chaintype.h>
+#include <util/check.h>
+#include <util/signalinterrupt.h>
+
+#include <event2/http.h>
+
+#include <string>
+#include <vector>
+
+//! Port of the benchmarked server, away from the default regtest RPC port of a local node
+static constexpr uint16_t BENCH_RPC_PORT{18449};
+//! Concurrent client connections
+static constexpr int NUM_CONNECTIONS{32};
+//! Requests queued on each connection per iteration, which are sent over keep-alive
+static constexpr int REQUESTS_PER_CONNECTION{16};
+
+/** Load generator: many keep-alive connections to a regtest HTTP server with a trivial handler */
+static void HTTPServerRequests(benchmark::Bench& bench, int event_threads)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>(ChainType::REGTEST)};
+    gArgs.ForceSetArg("-rpcport", std::to_string(BENCH_RPC_PORT));
+    gArgs.ForceSetArg("-rpceventthreads", std::to_string(event_threads));
+    gArgs.ForceSetArg("-rpcworkqueue", std::to_string(NUM_CONNECTIONS));
+
+    util::SignalInterrupt interrupt;
+    Assert(InitHTTPServer(interrupt));
+    RegisterHTTPHandler("/", true, [](HTTPRequest* req, const std::string&) {
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, "{\"result\":null,\"error\":null,\"id\":null}\n");
+        return true;
+    });
+    StartHTTPServer();
+
+    raii_event_base base{obtain_event_base()};
+    std::vector<raii_evhttp_connection> connections;
+    for (int i = 0; i < NUM_CONNECTIONS; ++i) {
+        connections.push_back(obtain_evhttp_connection_base(base.get(), "127.0.0.1", BENCH_RPC_PORT));
+    }
+
+    struct Progress {
+        event_base* base;
+        int pending;
+        int failed;
+    } progress{base.get(), 0, 0};
+    const auto on_reply{[](evhttp_request* req, void* arg) {
+        auto& progress{*static_cast<Progress*>(arg)};
+        if (!req || evhttp_request_get_response_code(req) != HTTP_OK) ++progress.failed;
+        if (--progress.pending == 0) event_base_loopbreak(progress.base);
+    }};
+
+    bench.batch(NUM_CONNECTIONS * REQUESTS_PER_CONNECTION).unit("request").run([&] {
+        progress.pending = NUM_CONNECTIONS * REQUESTS_PER_CONNECTION;
+        for (const auto& connection : connections) {
+            for (int i = 0; i < REQUESTS_PER_CONNECTION; ++i) {
+                // libevent frees the request once it is answered
+                evhttp_request* req{evhttp_request_new(on_reply, &progress)};
+                evhttp_add_header(evhttp_request_get_output_headers(req), "Host", "127.0.0.1");
+                evhttp_make_request(connection.get(), req, EVHTTP_REQ_POST, "/");
+            }
+        }
+        event_base_dispatch(base.get());
+    });
+    assert(progress.failed == 0);
+
+    connections.clear();
+    InterruptHTTPServer();
+    UnregisterHTTPHandler("/", true);
+    StopHTTPServer();
+}
+
+static void HTTPServerOneEventThread(benchmark::Bench& bench) { HTTPServerRequests(bench, 1); }
+static void HTTPServerFourEventThreads(benchmark::Bench& bench) { HTTPServerRequests(bench, 4); }
+
+BENCHMARK(HTTPServerOneEventThread, benchmark::PriorityLevel::HIGH);
+BENCHMARK(HTTPServerFourEventThreads, benchmark::PriorityLevel::HIGH);
@@ -12,7 +12,7 @@
 #include <util/strencodings.h>
 
 // Very simple block filter index sync benchmark, only using coinbase outputs.
-static void BlockFilterIndexSync(benchmark::Bench& bench)
+static void BlockFilterIndexSyncThreads(benchmark::Bench& bench, int worker_threads)
 {
     const auto test_setup = MakeNoLogFileContext<TestChain100Setup>();
 
@@ -27,12 +27,12 @@ static void BlockFilterIndexSync(benchmark::Bench& bench)
     }
     assert(WITH_LOCK(::cs_main, return test_setup->m_node.chainman->ActiveHeight() == CHAIN_SIZE));
 
-    bench.minEpochIterations(5).run([&] {
+    bench.minEpochIterations(5).batch(CHAIN_SIZE).unit("block").run([&] {
         BlockFilterIndex filter_index(interfaces::MakeChain(test_setup->m_node), BlockFilterType::BASIC,
                                       /*n_cache_size=*/0, /*f_memory=*/false, /*f_wipe=*/true);
         assert(filter_index.Init());
         assert(!filter_index.BlockUntilSyncedToCurrentChain());
-        filter_index.Sync();
+        filter_index.Sync(worker_threads);
 
         IndexSummary summary = filter_index.GetSummary();
         assert(summary.synced);
@@ -40,4 +40,12 @@ static void BlockFilterIndexSync(benchmark::Bench& bench)
     });
 }
 
+static void BlockFilterIndexSync(benchmark::Bench& bench) { BlockFilterIndexSyncThreads(bench, /*worker_threads=*/0); }
+static void BlockFilterIndexSyncOneWorker(benchmark::Bench& bench) { BlockFilterIndexSyncThreads(bench, /*worker_threads=*/1); }
+static void BlockFilterIndexSyncThreeWorkers(benchmark::Bench& bench) { BlockFilterIndexSyncThreads(bench, /*worker_threads=*/3); }
+static void BlockFilterIndexSyncSevenWorkers(benchmark::Bench& bench) { BlockFilterIndexSyncThreads(bench, /*worker_threads=*/7); }
+
 BENCHMARK(BlockFilterIndexSync, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockFilterIndexSyncOneWorker, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockFilterIndexSyncThreeWorkers, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockFilterIndexSyncSevenWorkers, benchmark::PriorityLevel::HIGH);
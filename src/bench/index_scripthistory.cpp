@@ -0,0 +1,87 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <index/scripthistoryindex.h>
+#include <interfaces/chain.h>
+#include <primitives/transaction.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
+#include <validation.h>
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+static constexpr int NUM_TX_BLOCKS{20};
+static constexpr int TXS_PER_BLOCK{100};
+//! Number of scripts the transactions pay to, so that each has a history spread over all blocks
+static constexpr int NUM_SCRIPTS{10};
+
+static CScript BenchScript(int i) { return CScript() << i << OP_DROP << OP_TRUE; }
+
+/** Add blocks of transactions spending a fanout output each, and paying to the bench scripts in turn. */
+static void AddHistoryBlocks(TestChain100Setup& setup)
+{
+    const CScript script{CScript() << ToByteVector(setup.coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const CTransactionRef& coinbase{setup.m_coinbase_txns[0]};
+    const CAmount fanout_amount{coinbase->vout[0].nValue / (NUM_TX_BLOCKS * TXS_PER_BLOCK + 1)};
+    const CTransactionRef fanout{MakeTransactionRef(setup.CreateValidMempoolTransaction(
+        /*input_transactions=*/{coinbase}, /*inputs=*/{COutPoint{coinbase->GetHash(), 0}},
+        /*input_height=*/1, /*input_signing_keys=*/{setup.coinbaseKey},
+        /*outputs=*/std::vector<CTxOut>(NUM_TX_BLOCKS * TXS_PER_BLOCK, CTxOut{fanout_amount, script}),
+        /*submit=*/false))};
+    setup.CreateAndProcessBlock({CMutableTransaction{*fanout}}, script);
+    const int fanout_height{WITH_LOCK(::cs_main, return setup.m_node.chainman->ActiveHeight())};
+
+    for (int block = 0; block < NUM_TX_BLOCKS; ++block) {
+        std::vector<CMutableTransaction> txs;
+        for (int i = 0; i < TXS_PER_BLOCK; ++i) {
+            const int n{block * TXS_PER_BLOCK + i};
+            txs.push_back(setup.CreateValidMempoolTransaction(fanout, n, fanout_height, setup.coinbaseKey,
+                                                              BenchScript(n % NUM_SCRIPTS), fanout_amount - 1000, /*submit=*/false));
+        }
+        setup.CreateAndProcessBlock(txs, script);
+    }
+}
+
+static std::unique_ptr<ScriptHistoryIndex> SyncScriptHistoryIndex(TestChain100Setup& setup)
+{
+    auto index{std::make_unique<ScriptHistoryIndex>(interfaces::MakeChain(setup.m_node), /*n_cache_size=*/1 << 20, /*f_memory=*/true)};
+    Assert(index->Init());
+    index->Sync();
+    Assert(index->GetSummary().synced);
+    return index;
+}
+
+static void ScriptHistoryIndexSync(benchmark::Bench& bench)
+{
+    const auto setup{MakeNoLogFileContext<TestChain100Setup>()};
+    AddHistoryBlocks(*setup);
+    const int height{WITH_LOCK(::cs_main, return setup->m_node.chainman->ActiveHeight())};
+
+    bench.minEpochIterations(10).batch(height).unit("block").run([&] {
+        SyncScriptHistoryIndex(*setup);
+    });
+}
+
+/** Read the whole history of a script, which has an output in every block of transactions. */
+static void ScriptHistoryIndexLookUp(benchmark::Bench& bench)
+{
+    const auto setup{MakeNoLogFileContext<TestChain100Setup>()};
+    AddHistoryBlocks(*setup);
+    const auto index{SyncScriptHistoryIndex(*setup)};
+
+    int i{0};
+    std::vector<ScriptHistoryEntry> entries;
+    bench.batch(NUM_TX_BLOCKS * TXS_PER_BLOCK / NUM_SCRIPTS).unit("output").run([&] {
+        bool more;
+        assert(index->LookUpHistory(BenchScript(i++ % NUM_SCRIPTS), 0, std::numeric_limits<int>::max(), std::nullopt,
+                                    std::numeric_limits<size_t>::max(), entries, more));
+        assert(entries.size() == NUM_TX_BLOCKS * TXS_PER_BLOCK / NUM_SCRIPTS);
+    });
+}
+
+BENCHMARK(ScriptHistoryIndexSync, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ScriptHistoryIndexLookUp, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,114 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <index/scriptutxoindex.h>
+#include <interfaces/chain.h>
+#include <primitives/transaction.h>
+#include <rpc/blockchain.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <util/check.h>
+#include <validation.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+static constexpr int NUM_TX_BLOCKS{20};
+static constexpr int TXS_PER_BLOCK{100};
+//! Number of outputs of each transaction, so that the UTXO set is much larger than the outputs of one script
+static constexpr int OUTPUTS_PER_TX{10};
+//! Number of scripts the first output of each transaction pays to in turn
+static constexpr int NUM_SCRIPTS{10};
+
+static CScript BenchScript(int i) { return CScript() << i << OP_DROP << OP_TRUE; }
+
+/** Add blocks of transactions spending a fanout output each, with outputs to the bench scripts and to unrelated ones. */
+static void AddUTXOBlocks(TestChain100Setup& setup)
+{
+    const CScript script{CScript() << ToByteVector(setup.coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const CTransactionRef& coinbase{setup.m_coinbase_txns[0]};
+    const CAmount fanout_amount{coinbase->vout[0].nValue / (NUM_TX_BLOCKS * TXS_PER_BLOCK + 1)};
+    const CTransactionRef fanout{MakeTransactionRef(setup.CreateValidMempoolTransaction(
+        /*input_transactions=*/{coinbase}, /*inputs=*/{COutPoint{coinbase->GetHash(), 0}},
+        /*input_height=*/1, /*input_signing_keys=*/{setup.coinbaseKey},
+        /*outputs=*/std::vector<CTxOut>(NUM_TX_BLOCKS * TXS_PER_BLOCK, CTxOut{fanout_amount, script}),
+        /*submit=*/false))};
+    setup.CreateAndProcessBlock({CMutableTransaction{*fanout}}, script);
+    const int fanout_height{WITH_LOCK(::cs_main, return setup.m_node.chainman->ActiveHeight())};
+
+    const CAmount output_amount{(fanout_amount - 10000) / OUTPUTS_PER_TX};
+    for (int block = 0; block < NUM_TX_BLOCKS; ++block) {
+        std::vector<CMutableTransaction> txs;
+        for (int i = 0; i < TXS_PER_BLOCK; ++i) {
+            const int n{block * TXS_PER_BLOCK + i};
+            std::vector<CTxOut> outputs{CTxOut{output_amount, BenchScript(n % NUM_SCRIPTS)}};
+            for (int j = 1; j < OUTPUTS_PER_TX; ++j) outputs.emplace_back(output_amount, BenchScript(NUM_SCRIPTS + n * OUTPUTS_PER_TX + j));
+            txs.push_back(setup.CreateValidMempoolTransaction({fanout}, {COutPoint{fanout->GetHash(), uint32_t(n)}}, fanout_height,
+                                                              {setup.coinbaseKey}, outputs, /*submit=*/false));
+        }
+        setup.CreateAndProcessBlock(txs, script);
+    }
+}
+
+static std::unique_ptr<ScriptUTXOIndex> SyncScriptUTXOIndex(TestChain100Setup& setup)
+{
+    auto index{std::make_unique<ScriptUTXOIndex>(interfaces::MakeChain(setup.m_node), /*n_cache_size=*/1 << 20, /*f_memory=*/true)};
+    Assert(index->Init());
+    index->Sync();
+    Assert(index->GetSummary().synced);
+    return index;
+}
+
+/** The work the index adds per connected block, done on the validation interface thread. */
+static void ScriptUTXOIndexSync(benchmark::Bench& bench)
+{
+    const auto setup{MakeNoLogFileContext<TestChain100Setup>()};
+    AddUTXOBlocks(*setup);
+    const int height{WITH_LOCK(::cs_main, return setup->m_node.chainman->ActiveHeight())};
+
+    bench.minEpochIterations(10).batch(height).unit("block").run([&] {
+        SyncScriptUTXOIndex(*setup);
+    });
+}
+
+/** Find the unspent outputs of a script, either in the index or by scanning the whole UTXO set. */
+static void FindScriptUTXOs(benchmark::Bench& bench, bool use_index)
+{
+    const auto setup{MakeNoLogFileContext<TestChain100Setup>()};
+    AddUTXOBlocks(*setup);
+    const auto index{SyncScriptUTXOIndex(*setup)};
+    Chainstate& chainstate{setup->m_node.chainman->ActiveChainstate()};
+    WITH_LOCK(::cs_main, chainstate.ForceFlushStateToDisk());
+
+    int i{0};
+    std::atomic<int> scan_progress;
+    const std::atomic<bool> should_abort{false};
+    const std::function<void()> interruption_point{[] {}};
+    bench.run([&] {
+        const std::set<CScript> needles{BenchScript(i++ % NUM_SCRIPTS)};
+        std::map<COutPoint, Coin> coins;
+        if (use_index) {
+            uint256 best_block;
+            assert(index->FindUTXOs(needles, coins, best_block));
+        } else {
+            int64_t count;
+            const auto cursors{WITH_LOCK(::cs_main, return chainstate.CoinsDB().ShardedCursors(1))};
+            assert(FindScriptPubKey(scan_progress, should_abort, count, cursors, needles, coins, interruption_point));
+        }
+        assert(coins.size() == NUM_TX_BLOCKS * TXS_PER_BLOCK / NUM_SCRIPTS);
+    });
+}
+
+static void ScriptUTXOIndexLookUp(benchmark::Bench& bench) { FindScriptUTXOs(bench, /*use_index=*/true); }
+static void ScriptUTXOScanLookUp(benchmark::Bench& bench) { FindScriptUTXOs(bench, /*use_index=*/false); }
+
+BENCHMARK(ScriptUTXOIndexSync, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ScriptUTXOIndexLookUp, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ScriptUTXOScanLookUp, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,74 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+#include <coins.h>
+#include <inputfetcher.h>
+#include <primitives/block.h>
+#include <serialize.h>
+#include <streams.h>
+#include <txdb.h>
+#include <util/hasher.h>
+
+#include <cassert>
+#include <unordered_set>
+
+namespace {
+/** A coins database holding every output spent by block 413567 but not created in it. */
+struct BlockInputsDB {
+    CBlock block;
+    CCoinsViewDB db{{.path = "", .cache_bytes = 8 << 20, .memory_only = true}, {}};
+
+    BlockInputsDB()
+    {
+        DataStream stream{benchmark::data::block413567};
+        stream >> TX_WITH_WITNESS(block);
+
+        CCoinsViewCache cache{&db};
+        const CScript script{CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0) << OP_EQUALVERIFY << OP_CHECKSIG};
+        std::unordered_set<Txid, SaltedTxidHasher> block_txids;
+        for (const auto& tx : block.vtx) {
+            if (!tx->IsCoinBase()) {
+                for (const CTxIn& txin : tx->vin) {
+                    if (block_txids.count(txin.prevout.hash)) continue;
+                    cache.AddCoin(txin.prevout, Coin{CTxOut{1, script}, 413000, false}, /*possible_overwrite=*/false);
+                }
+            }
+            block_txids.insert(tx->GetHash());
+        }
+        cache.SetBestBlock(block.hashPrevBlock);
+        bool flushed{cache.Flush()};
+        assert(flushed);
+    }
+};
+
+/** Look up every input of the block in a cold cache, as ConnectBlock does. */
+void AccessInputs(const CBlock& block, CCoinsViewCache& cache)
+{
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            cache.AccessCoin(txin.prevout);
+        }
+    }
+}
+
+void ConnectBlockInputs(benchmark::Bench& bench, int worker_threads)
+{
+    BlockInputsDB data;
+    InputFetcher fetcher{worker_threads};
+    bench.unit("block").run([&] {
+        CCoinsViewCache cache{&data.db};
+        fetcher.FetchInputs(cache, data.db, data.block);
+        AccessInputs(data.block, cache);
+    });
+}
+} // namespace
+
+static void InputFetcherSerial(benchmark::Bench& bench) { ConnectBlockInputs(bench, 0); }
+static void InputFetcherFourThreads(benchmark::Bench& bench) { ConnectBlockInputs(bench, 4); }
+
+BENCHMARK(InputFetcherSerial, benchmark::PriorityLevel::HIGH);
+BENCHMARK(InputFetcherFourThreads, benchmark::PriorityLevel::HIGH);
@@ -6,10 +6,16 @@
 #include <bench/data.h>
 #include <chainparams.h>
 #include <clientversion.h>
+#include <consensus/merkle.h>
+#include <pow.h>
+#include <streams.h>
 #include <test/util/setup_common.h>
+#include <tinyformat.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
+#include <string>
+
 /**
  * The LoadExternalBlockFile() function is used during -reindex and -loadblock.
  *
@@ -61,4 +67,61 @@ static void LoadExternalBlockFile(benchmark::Bench& bench)
     fs::remove(blkfile);
 }
 
+/**
+ * Measure the throughput of the LoadExternalBlockFile() pipeline when it has to
+ * deserialize and check every block, at a given number of workers.
+ *
+ * The test file holds a chain of regtest blocks built from the transactions of
+ * block 413567. The first run stores them, later runs find them already known,
+ * so what is measured is reading, deserializing and CheckBlock().
+ */
+static void LoadExternalBlockFileWorkers(benchmark::Bench& bench, int workers)
+{
+    const std::string par{strprintf("-par=%d", workers + 1)};
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(ChainType::REGTEST, {par.c_str()})};
+    ChainstateManager& chainman{*testing_setup->m_node.chainman};
+    const auto& params{chainman.GetParams()};
+
+    CBlock template_block;
+    SpanReader{benchmark::data::block413567} >> TX_WITH_WITNESS(template_block);
+
+    constexpr int NUM_BLOCKS{50};
+    const fs::path blkfile{testing_setup->m_path_root / "blk.dat"};
+    {
+        AutoFile file{fsbridge::fopen(blkfile, "wb+")};
+        uint256 prev_hash{WITH_LOCK(::cs_main, return chainman.ActiveChain().Tip()->GetBlockHash())};
+        for (int height = 1; height <= NUM_BLOCKS; ++height) {
+            CBlock block{template_block};
+            CMutableTransaction coinbase{*block.vtx[0]};
+            coinbase.vin[0].scriptSig = CScript() << height << OP_0;
+            block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+            block.hashPrevBlock = prev_hash;
+            block.nBits = UintToArith256(params.GetConsensus().powLimit).GetCompact();
+            block.hashMerkleRoot = BlockMerkleRoot(block);
+            while (!CheckProofOfWork(block.GetHash(), block.nBits, params.GetConsensus())) ++block.nNonce;
+            prev_hash = block.GetHash();
+
+            DataStream ss{};
+            ss << TX_WITH_WITNESS(block);
+            file << params.MessageStart() << static_cast<uint32_t>(ss.size());
+            file.write(ss);
+        }
+    }
+
+    bench.batch(NUM_BLOCKS).unit("block").run([&] {
+        AutoFile file{fsbridge::fopen(blkfile, "rb")};
+        chainman.LoadExternalBlockFile(file);
+    });
+    fs::remove(blkfile);
+}
+
+static void LoadExternalBlockFileWorkers1(benchmark::Bench& bench) { LoadExternalBlockFileWorkers(bench, 1); }
+static void LoadExternalBlockFileWorkers2(benchmark::Bench& bench) { LoadExternalBlockFileWorkers(bench, 2); }
+static void LoadExternalBlockFileWorkers4(benchmark::Bench& bench) { LoadExternalBlockFileWorkers(bench, 4); }
+static void LoadExternalBlockFileWorkers8(benchmark::Bench& bench) { LoadExternalBlockFileWorkers(bench, 8); }
+
 BENCHMARK(LoadExternalBlockFile, benchmark::PriorityLevel::HIGH);
+BENCHMARK(LoadExternalBlockFileWorkers1, benchmark::PriorityLevel::HIGH);
+BENCHMARK(LoadExternalBlockFileWorkers2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(LoadExternalBlockFileWorkers4, benchmark::PriorityLevel::HIGH);
+BENCHMARK(LoadExternalBlockFileWorkers8, benchmark::PriorityLevel::HIGH);
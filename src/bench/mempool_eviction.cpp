@@ -7,6 +7,7 @@
 #include <policy/policy.h>
 #include <test/util/setup_common.h>
 #include <txmempool.h>
+#include <util/chaintype.h>
 
 
 static void AddTx(const CTransactionRef& tx, const CAmount& nFee, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
@@ -25,9 +26,9 @@ static void AddTx(const CTransactionRef& tx, const CAmount& nFee, CTxMemPool& po
 // Right now this is only testing eviction performance in an extremely small
 // mempool. Code needs to be written to generate a much wider variety of
 // unique transactions for a more meaningful performance measurement.
-static void MempoolEviction(benchmark::Bench& bench)
+static void RunMempoolEviction(benchmark::Bench& bench, bool cluster_mempool)
 {
-    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN, {cluster_mempool ? "-clustermempool=1" : "-clustermempool=0"});
 
     CMutableTransaction tx1 = CMutableTransaction();
     tx1.vin.resize(1);
@@ -134,4 +135,8 @@ static void MempoolEviction(benchmark::Bench& bench)
     });
 }
 
+static void MempoolEviction(benchmark::Bench& bench) { RunMempoolEviction(bench, /*cluster_mempool=*/false); }
+static void MempoolEvictionClusters(benchmark::Bench& bench) { RunMempoolEviction(bench, /*cluster_mempool=*/true); }
+
 BENCHMARK(MempoolEviction, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolEvictionClusters, benchmark::PriorityLevel::HIGH);
@@ -2,15 +2,26 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <addresstype.h>
 #include <bench/bench.h>
+#include <common/system.h>
+#include <consensus/amount.h>
 #include <kernel/mempool_entry.h>
+#include <key.h>
+#include <policy/packages.h>
 #include <policy/policy.h>
+#include <primitives/transaction.h>
 #include <random.h>
+#include <script/script.h>
 #include <test/util/setup_common.h>
+#include <test/util/txmempool.h>
+#include <tinyformat.h>
 #include <txmempool.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <string>
 #include <vector>
 
 static void AddTx(const CTransactionRef& tx, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
@@ -83,7 +94,7 @@ static std::vector<CTransactionRef> CreateOrderedCoins(FastRandomContext& det_ra
     return ordered_coins;
 }
 
-static void ComplexMemPool(benchmark::Bench& bench)
+static void RunComplexMemPool(benchmark::Bench& bench, bool cluster_mempool)
 {
     FastRandomContext det_rand{true};
     int childTxs = 800;
@@ -91,7 +102,7 @@ static void ComplexMemPool(benchmark::Bench& bench)
         childTxs = static_cast<int>(bench.complexityN());
     }
     std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, childTxs, /*min_ancestors=*/1);
-    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN, {cluster_mempool ? "-clustermempool=1" : "-clustermempool=0"});
     CTxMemPool& pool = *testing_setup.get()->m_node.mempool;
     LOCK2(cs_main, pool.cs);
     bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
@@ -103,6 +114,105 @@ static void ComplexMemPool(benchmark::Bench& bench)
     });
 }
 
+// Insertion only, into a fresh mempool every iteration.
+static void MempoolInsert(benchmark::Bench& bench, bool cluster_mempool)
+{
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, /*childTxs=*/800, /*min_ancestors=*/1);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN);
+    const CTxMemPool::Options mempool_opts{.cluster_mempool = cluster_mempool};
+    bench.run([&] {
+        CTxMemPool pool{mempool_opts};
+        LOCK2(cs_main, pool.cs);
+        for (auto& tx : ordered_coins) {
+            AddTx(tx, pool);
+        }
+    });
+}
+
+// Insertion, followed by confirming all transactions in blocks of 100. With -clustermempool the
+// changed clusters are linearized after every block, as the next block template would do.
+static void MempoolRemoveForBlock(benchmark::Bench& bench, bool cluster_mempool)
+{
+    constexpr size_t BLOCK_TXS{100};
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, /*childTxs=*/800, /*min_ancestors=*/1);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN, {cluster_mempool ? "-clustermempool=1" : "-clustermempool=0"});
+    CTxMemPool& pool = *testing_setup.get()->m_node.mempool;
+    LOCK2(cs_main, pool.cs);
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (auto& tx : ordered_coins) {
+            AddTx(tx, pool);
+        }
+        for (size_t i = 0; i < ordered_coins.size(); i += BLOCK_TXS) {
+            const std::vector<CTransactionRef> block(ordered_coins.begin() + i, ordered_coins.begin() + std::min(i + BLOCK_TXS, ordered_coins.size()));
+            pool.removeForBlock(block, /*nBlockHeight=*/1);
+            if (cluster_mempool) pool.GetLinearizedClusters();
+        }
+    });
+}
+
+static void ComplexMemPool(benchmark::Bench& bench) { RunComplexMemPool(bench, /*cluster_mempool=*/false); }
+static void ComplexMemPoolClusters(benchmark::Bench& bench) { RunComplexMemPool(bench, /*cluster_mempool=*/true); }
+static void MempoolInsertAncestors(benchmark::Bench& bench) { MempoolInsert(bench, /*cluster_mempool=*/false); }
+static void MempoolInsertClusters(benchmark::Bench& bench) { MempoolInsert(bench, /*cluster_mempool=*/true); }
+static void MempoolRemoveForBlockAncestors(benchmark::Bench& bench) { MempoolRemoveForBlock(bench, /*cluster_mempool=*/false); }
+static void MempoolRemoveForBlockClusters(benchmark::Bench& bench) { MempoolRemoveForBlock(bench, /*cluster_mempool=*/true); }
+
+static CTransactionRef MakeSpendingTx(const std::vector<COutPoint>& inputs, size_t num_outputs)
+{
+    CMutableTransaction tx;
+    for (const COutPoint& input : inputs) {
+        tx.vin.emplace_back(input);
+    }
+    tx.vout.assign(num_outputs, CTxOut{COIN, CScript() << OP_TRUE});
+    return MakeTransactionRef(tx);
+}
+
+// Ancestor walks with the default limits, for transactions that are not in the mempool yet:
+// - deep: spending the last transaction of a chain of DEFAULT_ANCESTOR_LIMIT - 1 transactions
+// - wide: spending an output of each of DEFAULT_ANCESTOR_LIMIT - 2 children of one transaction
+static void MempoolAncestors(benchmark::Bench& bench, bool deep)
+{
+    constexpr size_t NUM_CANDIDATES{100};
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN);
+    CTxMemPool& pool = *testing_setup.get()->m_node.mempool;
+    LOCK2(cs_main, pool.cs);
+
+    std::vector<CTransactionRef> candidates;
+    for (uint32_t n = 0; n < NUM_CANDIDATES; ++n) {
+        const CTransactionRef root{MakeSpendingTx({COutPoint{Txid::FromUint256(uint256{static_cast<uint8_t>(n + 1)}), n}}, DEFAULT_ANCESTOR_LIMIT)};
+        AddTx(root, pool);
+        std::vector<COutPoint> inputs;
+        if (deep) {
+            CTransactionRef tip{root};
+            for (unsigned i = 0; i < DEFAULT_ANCESTOR_LIMIT - 2; ++i) {
+                tip = MakeSpendingTx({COutPoint{tip->GetHash(), 0}}, 1);
+                AddTx(tip, pool);
+            }
+            inputs.emplace_back(tip->GetHash(), 0);
+        } else {
+            for (uint32_t i = 0; i < DEFAULT_ANCESTOR_LIMIT - 2; ++i) {
+                const CTransactionRef child{MakeSpendingTx({COutPoint{root->GetHash(), i}}, 1)};
+                AddTx(child, pool);
+                inputs.emplace_back(child->GetHash(), 0);
+            }
+        }
+        candidates.push_back(MakeSpendingTx(inputs, 1));
+    }
+
+    const TestMemPoolEntryHelper entry;
+    bench.batch(NUM_CANDIDATES).unit("tx").run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (const CTransactionRef& tx : candidates) {
+            const auto ancestors{pool.CalculateMemPoolAncestors(entry.FromTx(tx), pool.m_opts.limits)};
+            assert(ancestors && ancestors->size() == DEFAULT_ANCESTOR_LIMIT - 1);
+        }
+    });
+}
+
+static void MempoolAncestorsDeepChain(benchmark::Bench& bench) { MempoolAncestors(bench, /*deep=*/true); }
+static void MempoolAncestorsWideFanout(benchmark::Bench& bench) { MempoolAncestors(bench, /*deep=*/false); }
+
 static void MempoolCheck(benchmark::Bench& bench)
 {
     FastRandomContext det_rand{true};
@@ -118,5 +228,62 @@ static void MempoolCheck(benchmark::Bench& bench)
     });
 }
 
+// Test-accept packages of MAX_PACKAGE_COUNT independent transactions with several P2WPKH inputs
+// each, so that script checks dominate. Every iteration validates a different package, as
+// signatures would otherwise be served from the signature cache.
+static void MempoolAcceptPackage(benchmark::Bench& bench, int script_threads)
+{
+    constexpr size_t NUM_PACKAGES{10};
+    constexpr size_t INPUTS_PER_TX{10};
+    constexpr size_t INPUTS_PER_PACKAGE{MAX_PACKAGE_COUNT * INPUTS_PER_TX};
+    const std::string par{strprintf("-par=%d", script_threads)};
+    auto testing_setup = MakeNoLogFileContext<TestChain100Setup>(ChainType::REGTEST, {par.c_str()});
+    // Use a fresh key so that no signatures are cached by a previous run in this process.
+    CKey key;
+    key.MakeNewKey(/*fCompressed=*/true);
+    const CScript spk{GetScriptForDestination(WitnessV0KeyHash(key.GetPubKey()))};
+
+    // Split a mature coinbase output into one output for every input spent in the benchmark.
+    const CAmount fanout_value{testing_setup->m_coinbase_txns[0]->vout[0].nValue / CAmount(NUM_PACKAGES * INPUTS_PER_PACKAGE + 1)};
+    const CTransactionRef fanout{MakeTransactionRef(testing_setup->CreateValidMempoolTransaction(
+        {testing_setup->m_coinbase_txns[0]}, {COutPoint{testing_setup->m_coinbase_txns[0]->GetHash(), 0}},
+        /*input_height=*/1, {testing_setup->coinbaseKey},
+        std::vector<CTxOut>(NUM_PACKAGES * INPUTS_PER_PACKAGE, CTxOut{fanout_value, spk}), /*submit=*/false))};
+    testing_setup->CreateAndProcessBlock({CMutableTransaction{*fanout}}, spk);
+
+    std::vector<Package> packages(NUM_PACKAGES);
+    uint32_t n{0};
+    for (auto& package : packages) {
+        for (size_t i = 0; i < MAX_PACKAGE_COUNT; ++i) {
+            std::vector<COutPoint> inputs;
+            for (size_t j = 0; j < INPUTS_PER_TX; ++j) inputs.emplace_back(fanout->GetHash(), n++);
+            package.push_back(MakeTransactionRef(testing_setup->CreateValidMempoolTransaction(
+                {fanout}, inputs, /*input_height=*/101, {key},
+                {CTxOut{fanout_value * CAmount{INPUTS_PER_TX} - COIN / 10000, spk}}, /*submit=*/false)));
+        }
+    }
+
+    Chainstate& chainstate{testing_setup->m_node.chainman->ActiveChainstate()};
+    CTxMemPool& pool{*testing_setup->m_node.mempool};
+    size_t next{0};
+    bench.epochs(1).epochIterations(NUM_PACKAGES).batch(INPUTS_PER_PACKAGE).unit("input").run([&] {
+        LOCK(cs_main);
+        const auto result{ProcessNewPackage(chainstate, pool, packages.at(next++), /*test_accept=*/true, /*client_maxfeerate=*/{})};
+        assert(result.m_state.IsValid());
+    });
+}
+
+static void MempoolAcceptPackageSequential(benchmark::Bench& bench) { MempoolAcceptPackage(bench, /*script_threads=*/1); }
+static void MempoolAcceptPackageParallel(benchmark::Bench& bench) { MempoolAcceptPackage(bench, /*script_threads=*/GetNumCores()); }
+
 BENCHMARK(ComplexMemPool, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ComplexMemPoolClusters, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolInsertAncestors, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolInsertClusters, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolRemoveForBlockAncestors, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolRemoveForBlockClusters, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolAncestorsDeepChain, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolAncestorsWideFanout, benchmark::PriorityLevel::HIGH);
 BENCHMARK(MempoolCheck, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolAcceptPackageSequential, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolAcceptPackageParallel, benchmark::PriorityLevel::HIGH);
@@ -49,5 +49,20 @@ static void ReadRawBlockFromDiskTest(benchmark::Bench& bench)
     });
 }
 
+static void ReadRawBlockFromDiskMapped(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN, {"-blockmapfiles=1"})};
+    ChainstateManager& chainman{*testing_setup->m_node.chainman};
+
+    const auto pos{WriteBlockToDisk(chainman)};
+
+    bench.run([&] {
+        node::RawBlockData block_data;
+        const auto success{chainman.m_blockman.ReadRawBlockFromDisk(block_data, pos)};
+        assert(success && block_data.IsMapped());
+    });
+}
+
 BENCHMARK(ReadBlockFromDiskTest, benchmark::PriorityLevel::HIGH);
 BENCHMARK(ReadRawBlockFromDiskTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ReadRawBlockFromDiskMapped, benchmark::PriorityLevel::HIGH);
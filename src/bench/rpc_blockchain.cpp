@@ -5,12 +5,23 @@
 #include <bench/bench.h>
 #include <bench/data.h>
 
+#include <coins.h>
+#include <common/json_writer.h>
+#include <primitives/transaction.h>
 #include <rpc/blockchain.h>
+#include <script/script.h>
 #include <streams.h>
+#include <sync.h>
 #include <test/util/setup_common.h>
+#include <txdb.h>
 #include <util/chaintype.h>
+#include <util/time.h>
 #include <validation.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include <univalue.h>
 
 namespace {
@@ -59,3 +70,69 @@ static void BlockToJsonVerboseWrite(benchmark::Bench& bench)
 }
 
 BENCHMARK(BlockToJsonVerboseWrite, benchmark::PriorityLevel::HIGH);
+
+// Write the same JSON as the two above without building the UniValue, the
+// way getblock and /rest/block answer.
+static void BlockToJsonVerboseStream(benchmark::Bench& bench)
+{
+    TestBlockAndIndex data;
+    bench.run([&] {
+        std::string str;
+        JSONTextWriter writer{str};
+        WriteBlockJSON(writer, data.testing_setup->m_node.chainman->m_blockman, data.block, data.blockindex, data.blockindex, TxVerbosity::SHOW_DETAILS_AND_PREVOUT);
+        ankerl::nanobench::doNotOptimizeAway(str);
+    });
+}
+
+BENCHMARK(BlockToJsonVerboseStream, benchmark::PriorityLevel::HIGH);
+
+// Look up coins the way gettxout and /rest/getutxos do, while another thread
+// keeps connecting blocks, either from the tip cache under cs_main or from the
+// coins snapshot without it.
+static void CoinsLookupWhileConnectingBlocks(benchmark::Bench& bench, bool use_snapshot)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    ChainstateManager& chainman{*testing_setup->m_node.chainman};
+    Chainstate& chainstate{chainman.ActiveChainstate()};
+    // A coins snapshot is started by flushing outside of initial block download.
+    chainstate.ForceFlushStateToDisk();
+    assert(chainman.GetCoinsSnapshot());
+
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : testing_setup->m_coinbase_txns) {
+        outpoints.emplace_back(tx->GetHash(), 0);
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread miner{[&] {
+        const CScript spk{CScript() << OP_TRUE};
+        while (!stop) {
+            testing_setup->CreateAndProcessBlock({}, spk);
+            SetMockTime(GetTime() + 1);
+        }
+    }};
+
+    bench.batch(outpoints.size()).unit("lookup").run([&] {
+        Coin coin;
+        if (use_snapshot) {
+            const auto snapshot{chainman.GetCoinsSnapshot()};
+            for (const COutPoint& outpoint : outpoints) {
+                assert(snapshot->GetCoin(outpoint, coin));
+            }
+        } else {
+            for (const COutPoint& outpoint : outpoints) {
+                LOCK(cs_main);
+                assert(chainstate.CoinsTip().GetCoin(outpoint, coin));
+            }
+        }
+    });
+
+    stop = true;
+    miner.join();
+}
+
+static void CoinsLookupWhileConnectingBlocksTip(benchmark::Bench& bench) { CoinsLookupWhileConnectingBlocks(bench, /*use_snapshot=*/false); }
+static void CoinsLookupWhileConnectingBlocksSnapshot(benchmark::Bench& bench) { CoinsLookupWhileConnectingBlocks(bench, /*use_snapshot=*/true); }
+
+BENCHMARK(CoinsLookupWhileConnectingBlocksTip, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CoinsLookupWhileConnectingBlocksSnapshot, benchmark::PriorityLevel::HIGH);
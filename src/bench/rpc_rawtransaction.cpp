@@ -0,0 +1,91 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <index/prevoutindex.h>
+#include <interfaces/chain.h>
+#include <primitives/transaction.h>
+#include <rpc/request.h>
+#include <rpc/server.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+#include <utility>
+#include <vector>
+
+static constexpr int NUM_TX_BLOCKS{20};
+static constexpr int TXS_PER_BLOCK{10};
+static constexpr int INPUTS_PER_TX{10};
+
+/** Add blocks of transactions with many inputs each, and return the txids and block hashes to look them up with. */
+static std::vector<std::pair<uint256, uint256>> AddPrevoutBlocks(TestChain100Setup& setup)
+{
+    const CScript script{CScript() << ToByteVector(setup.coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const CTransactionRef& coinbase{setup.m_coinbase_txns[0]};
+    const int num_outputs{NUM_TX_BLOCKS * TXS_PER_BLOCK * INPUTS_PER_TX};
+    const CAmount fanout_amount{coinbase->vout[0].nValue / (num_outputs + 1)};
+    const CTransactionRef fanout{MakeTransactionRef(setup.CreateValidMempoolTransaction(
+        /*input_transactions=*/{coinbase}, /*inputs=*/{COutPoint{coinbase->GetHash(), 0}},
+        /*input_height=*/1, /*input_signing_keys=*/{setup.coinbaseKey},
+        /*outputs=*/std::vector<CTxOut>(num_outputs, CTxOut{fanout_amount, script}),
+        /*submit=*/false))};
+    setup.CreateAndProcessBlock({CMutableTransaction{*fanout}}, script);
+    const int fanout_height{WITH_LOCK(::cs_main, return setup.m_node.chainman->ActiveHeight())};
+
+    std::vector<std::pair<uint256, uint256>> txs_to_look_up;
+    uint32_t vout{0};
+    for (int block = 0; block < NUM_TX_BLOCKS; ++block) {
+        std::vector<CMutableTransaction> txs;
+        for (int i = 0; i < TXS_PER_BLOCK; ++i) {
+            std::vector<COutPoint> inputs;
+            for (int j = 0; j < INPUTS_PER_TX; ++j) inputs.emplace_back(fanout->GetHash(), vout++);
+            txs.push_back(setup.CreateValidMempoolTransaction({fanout}, inputs, fanout_height, {setup.coinbaseKey},
+                                                              {CTxOut{INPUTS_PER_TX * fanout_amount - 10000, script}}, /*submit=*/false));
+        }
+        const CBlock new_block{setup.CreateAndProcessBlock(txs, script)};
+        for (const CMutableTransaction& tx : txs) {
+            txs_to_look_up.emplace_back(tx.GetHash(), new_block.GetHash());
+        }
+    }
+    return txs_to_look_up;
+}
+
+/** Call getrawtransaction with verbosity 2, which shows the prevouts of each input. */
+static void GetRawTransactionPrevouts(benchmark::Bench& bench, bool prevout_index)
+{
+    const auto setup{MakeNoLogFileContext<TestChain100Setup>()};
+    const std::vector<std::pair<uint256, uint256>> txs{AddPrevoutBlocks(*setup)};
+    if (prevout_index) {
+        g_prevout_index = std::make_unique<PrevoutIndex>(interfaces::MakeChain(setup->m_node), /*n_cache_size=*/1 << 20, /*f_memory=*/true);
+        Assert(g_prevout_index->Init());
+        g_prevout_index->Sync();
+        Assert(g_prevout_index->GetSummary().synced);
+    }
+
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    size_t i{0};
+    bench.run([&] {
+        const auto& [txid, block_hash]{txs[i++ % txs.size()]};
+        JSONRPCRequest request;
+        request.context = &setup->m_node;
+        request.strMethod = "getrawtransaction";
+        request.params = UniValue(UniValue::VARR);
+        request.params.push_back(txid.GetHex());
+        request.params.push_back(2);
+        request.params.push_back(block_hash.GetHex());
+        const UniValue result{tableRPC.execute(request)};
+        assert(result["vin"][0].exists("prevout"));
+    });
+
+    g_prevout_index.reset();
+}
+
+static void GetRawTransactionPrevoutsUndo(benchmark::Bench& bench) { GetRawTransactionPrevouts(bench, /*prevout_index=*/false); }
+static void GetRawTransactionPrevoutsIndex(benchmark::Bench& bench) { GetRawTransactionPrevouts(bench, /*prevout_index=*/true); }
+
+BENCHMARK(GetRawTransactionPrevoutsUndo, benchmark::PriorityLevel::HIGH);
+BENCHMARK(GetRawTransactionPrevoutsIndex, benchmark::PriorityLevel::HIGH);
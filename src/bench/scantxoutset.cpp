@@ -0,0 +1,63 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <consensus/amount.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <rpc/blockchain.h>
+#include <script/script.h>
+#include <txdb.h>
+#include <util/check.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+static constexpr int NUM_COINS{200000};
+//! One coin in this many pays to a searched script
+static constexpr int MATCH_INTERVAL{1000};
+
+/** Scan a synthetic UTXO set with P2WPKH-like outputs for a few scripts. */
+static void ScanTxOutSet(benchmark::Bench& bench, size_t threads)
+{
+    CCoinsViewDB coins_db{{.path = "", .cache_bytes = 64 << 20, .memory_only = true}, {}};
+    std::set<CScript> needles;
+    {
+        FastRandomContext rng{/*fDeterministic=*/true};
+        CCoinsViewCache cache{&coins_db};
+        for (int i = 0; i < NUM_COINS; ++i) {
+            CScript script{CScript() << OP_0 << rng.randbytes(20)};
+            if (i % MATCH_INTERVAL == 0) needles.insert(script);
+            cache.AddCoin(COutPoint{Txid::FromUint256(rng.rand256()), uint32_t(rng.randrange(4))},
+                          Coin{CTxOut{CAmount(rng.randrange(MAX_MONEY)), std::move(script)}, 100, false}, /*possible_overwrite=*/true);
+        }
+        cache.SetBestBlock(rng.rand256());
+        Assert(cache.Flush());
+    }
+
+    std::atomic<int> scan_progress;
+    const std::atomic<bool> should_abort{false};
+    const std::function<void()> interruption_point{[] {}};
+    bench.batch(NUM_COINS).unit("coin").run([&] {
+        int64_t count;
+        std::map<COutPoint, Coin> results;
+        assert(FindScriptPubKey(scan_progress, should_abort, count, coins_db.ShardedCursors(threads), needles, results, interruption_point));
+        assert(count == NUM_COINS && results.size() == needles.size());
+    });
+}
+
+static void ScanTxOutSetOneThread(benchmark::Bench& bench) { ScanTxOutSet(bench, 1); }
+static void ScanTxOutSetTwoThreads(benchmark::Bench& bench) { ScanTxOutSet(bench, 2); }
+static void ScanTxOutSetFourThreads(benchmark::Bench& bench) { ScanTxOutSet(bench, 4); }
+static void ScanTxOutSetEightThreads(benchmark::Bench& bench) { ScanTxOutSet(bench, 8); }
+
+BENCHMARK(ScanTxOutSetOneThread, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ScanTxOutSetTwoThreads, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ScanTxOutSetFourThreads, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ScanTxOutSetEightThreads, benchmark::PriorityLevel::HIGH);
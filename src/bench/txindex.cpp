@@ -0,0 +1,92 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <index/txindex.h>
+#include <interfaces/chain.h>
+#include <primitives/transaction.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
+#include <validation.h>
+
+#include <memory>
+#include <vector>
+
+//! Blocks added on top of the test chain, so that looked up transactions are at various positions within their block
+static constexpr int NUM_TX_BLOCKS{20};
+static constexpr int TXS_PER_BLOCK{100};
+
+/** Add the blocks of transactions to the test chain, and return the txids in them. */
+static std::vector<uint256> AddTxBlocks(TestChain100Setup& setup)
+{
+    const CScript script{CScript() << ToByteVector(setup.coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const CTransactionRef& coinbase{setup.m_coinbase_txns[0]};
+    const CAmount fanout_amount{coinbase->vout[0].nValue / (NUM_TX_BLOCKS * TXS_PER_BLOCK + 1)};
+    const CTransactionRef fanout{MakeTransactionRef(setup.CreateValidMempoolTransaction(
+        /*input_transactions=*/{coinbase}, /*inputs=*/{COutPoint{coinbase->GetHash(), 0}},
+        /*input_height=*/1, /*input_signing_keys=*/{setup.coinbaseKey},
+        /*outputs=*/std::vector<CTxOut>(NUM_TX_BLOCKS * TXS_PER_BLOCK, CTxOut{fanout_amount, script}),
+        /*submit=*/false))};
+    setup.CreateAndProcessBlock({CMutableTransaction{*fanout}}, script);
+    const int fanout_height{WITH_LOCK(::cs_main, return setup.m_node.chainman->ActiveHeight())};
+
+    std::vector<uint256> txids;
+    for (int block = 0; block < NUM_TX_BLOCKS; ++block) {
+        std::vector<CMutableTransaction> txs;
+        for (int i = 0; i < TXS_PER_BLOCK; ++i) {
+            txs.push_back(setup.CreateValidMempoolTransaction(fanout, block * TXS_PER_BLOCK + i, fanout_height, setup.coinbaseKey,
+                                                              script, fanout_amount - 1000, /*submit=*/false));
+        }
+        for (const CTransactionRef& tx : setup.CreateAndProcessBlock(txs, script).vtx) {
+            txids.push_back(tx->GetHash());
+        }
+    }
+    return txids;
+}
+
+static std::unique_ptr<TxIndex> SyncTxIndex(TestChain100Setup& setup, TxIndexFormat format)
+{
+    auto txindex{std::make_unique<TxIndex>(interfaces::MakeChain(setup.m_node), /*n_cache_size=*/1 << 20,
+                                           /*f_memory=*/true, /*f_wipe=*/false, format)};
+    Assert(txindex->Init());
+    txindex->Sync();
+    Assert(txindex->GetSummary().synced);
+    return txindex;
+}
+
+static void TxIndexSync(benchmark::Bench& bench, TxIndexFormat format)
+{
+    const auto setup{MakeNoLogFileContext<TestChain100Setup>()};
+    AddTxBlocks(*setup);
+    const int height{WITH_LOCK(::cs_main, return setup->m_node.chainman->ActiveHeight())};
+
+    bench.minEpochIterations(10).batch(height).unit("block").run([&] {
+        SyncTxIndex(*setup, format);
+    });
+}
+
+/** Look up transactions at all positions of their block. In the compact format, the transactions before them are read as well. */
+static void TxIndexFindTx(benchmark::Bench& bench, TxIndexFormat format)
+{
+    const auto setup{MakeNoLogFileContext<TestChain100Setup>()};
+    const std::vector<uint256> txids{AddTxBlocks(*setup)};
+    const auto txindex{SyncTxIndex(*setup, format)};
+
+    size_t i{0};
+    bench.run([&] {
+        uint256 block_hash;
+        CTransactionRef tx;
+        assert(txindex->FindTx(txids[i++ % txids.size()], block_hash, tx));
+    });
+}
+
+static void TxIndexSyncLegacy(benchmark::Bench& bench) { TxIndexSync(bench, TxIndexFormat::LEGACY); }
+static void TxIndexSyncCompact(benchmark::Bench& bench) { TxIndexSync(bench, TxIndexFormat::COMPACT); }
+static void TxIndexFindTxLegacy(benchmark::Bench& bench) { TxIndexFindTx(bench, TxIndexFormat::LEGACY); }
+static void TxIndexFindTxCompact(benchmark::Bench& bench) { TxIndexFindTx(bench, TxIndexFormat::COMPACT); }
+
+BENCHMARK(TxIndexSyncLegacy, benchmark::PriorityLevel::HIGH);
+BENCHMARK(TxIndexSyncCompact, benchmark::PriorityLevel::HIGH);
+BENCHMARK(TxIndexFindTxLegacy, benchmark::PriorityLevel::HIGH);
+BENCHMARK(TxIndexFindTxCompact, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <consensus/amount.h>
+#include <node/utxo_snapshot.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <streams.h>
+#include <util/check.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using node::SnapshotChunk;
+using node::SnapshotChunkWriter;
+
+static constexpr int NUM_TXS{50000};
+static constexpr uint32_t MAX_HEIGHT{800000};
+
+/** Write the coins of a synthetic UTXO set with P2WPKH-like outputs in either snapshot format. */
+static uint64_t WriteSnapshotCoins(AutoFile& file, bool chunked)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::optional<SnapshotChunkWriter> writer;
+    if (chunked) writer.emplace(file);
+    // Coins are written in the order of the chainstate database.
+    std::vector<uint256> hashes(NUM_TXS);
+    for (uint256& hash : hashes) hash = rng.rand256();
+    std::sort(hashes.begin(), hashes.end());
+    uint64_t coins_count{0};
+    for (const uint256& hash : hashes) {
+        const Txid txid{Txid::FromUint256(hash)};
+        const int height{int(rng.randrange(MAX_HEIGHT))};
+        std::vector<std::pair<uint32_t, Coin>> coins;
+        const uint32_t num_outputs{1 + static_cast<uint32_t>(rng.randrange(3))};
+        for (uint32_t n = 0; n < num_outputs; ++n) {
+            coins.emplace_back(n, Coin{CTxOut{CAmount(rng.randrange(MAX_MONEY)), CScript() << OP_0 << rng.randbytes(20)}, height, false});
+        }
+        coins_count += coins.size();
+        if (writer) {
+            writer->AddCoins(txid, coins);
+            continue;
+        }
+        file << txid;
+        WriteCompactSize(file, coins.size());
+        for (const auto& [n, coin] : coins) {
+            WriteCompactSize(file, n);
+            file << coin;
+        }
+    }
+    if (writer) writer->Finish();
+    return coins_count;
+}
+
+/** Read back the coins of a version 1 snapshot, as done when loading it. */
+static void SnapshotReadCoinsPlain(benchmark::Bench& bench)
+{
+    AutoFile file{std::tmpfile()};
+    const uint64_t coins_count{WriteSnapshotCoins(file, /*chunked=*/false)};
+    bench.batch(coins_count).unit("coin").run([&] {
+        file.seek(0, SEEK_SET);
+        uint64_t coins_read{0};
+        while (coins_read < coins_count) {
+            Txid txid;
+            file >> txid;
+            const uint64_t coins_per_txid{ReadCompactSize(file)};
+            for (uint64_t i = 0; i < coins_per_txid; ++i) {
+                COutPoint outpoint{txid, static_cast<uint32_t>(ReadCompactSize(file))};
+                Coin coin;
+                file >> coin;
+                Assert(outpoint.n < 3 && coin.nHeight <= MAX_HEIGHT && MoneyRange(coin.out.nValue));
+                ++coins_read;
+            }
+        }
+    });
+}
+
+/** Read back and decode the chunks of a version 2 snapshot on one thread. */
+static void SnapshotDecodeChunks(benchmark::Bench& bench)
+{
+    AutoFile file{std::tmpfile()};
+    const uint64_t coins_count{WriteSnapshotCoins(file, /*chunked=*/true)};
+    bench.batch(coins_count).unit("coin").run([&] {
+        file.seek(0, SEEK_SET);
+        uint64_t coins_read{0};
+        std::vector<std::pair<COutPoint, Coin>> coins;
+        std::string error;
+        while (coins_read < coins_count) {
+            SnapshotChunk chunk;
+            file >> chunk;
+            Assert(node::DecodeSnapshotChunk(chunk, MAX_HEIGHT, coins, error));
+            coins_read += coins.size();
+        }
+    });
+}
+
+BENCHMARK(SnapshotReadCoinsPlain, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SnapshotDecodeChunks, benchmark::PriorityLevel::HIGH);
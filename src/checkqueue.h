@@ -10,7 +10,11 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iterator>
+#include <memory>
+#include <string>
 #include <vector>
 
 /**
@@ -22,6 +26,13 @@
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * In work stealing mode, each thread (including the master) has its own
+  * queue. Added checks go to the queues in turn; a thread takes small chunks
+  * from the back of its own queue, and when that is empty, steals half of
+  * another thread's queue from the front. This avoids contention on one shared
+  * queue with many threads, and keeps the other threads busy while one is
+  * stuck on an expensive check.
   */
 template <typename T>
 class CCheckQueue
@@ -60,7 +71,115 @@ private:
     const unsigned int nBatchSize;
 
     std::vector<std::thread> m_worker_threads;
-    bool m_request_stop GUARDED_BY(m_mutex){false};
+    //! Set under m_mutex, so waiting threads do not miss it, but read without it
+    //! by StealingLoop().
+    std::atomic<bool> m_request_stop{false};
+
+    //! Per-thread queue for work stealing mode.
+    struct LocalQueue {
+        Mutex m_mutex;
+        std::deque<T> m_checks GUARDED_BY(m_mutex);
+    };
+
+    //! Work stealing mode: one queue per worker thread, followed by the master's. Empty otherwise.
+    std::vector<std::unique_ptr<LocalQueue>> m_local_queues;
+
+    //! Work stealing mode: number of elements a thread takes from its own queue at once.
+    const unsigned int m_local_chunk_size;
+
+    //! Work stealing mode: the local queue the next Add() goes to. Only
+    //! accessed by Add(), whose callers are serialized by m_control_mutex.
+    size_t m_next_local_queue{0};
+
+    //! Work stealing mode: incremented on Add(), so idle workers do not miss new work.
+    //! Like m_request_stop, only written under m_mutex.
+    std::atomic<uint64_t> m_work_epoch{0};
+
+    //! Work stealing mode: counterparts of nTodo and fAllOk, updated without m_mutex.
+    std::atomic<unsigned int> m_todo{0};
+    std::atomic<bool> m_all_ok{true};
+
+    /** Run a chunk of checks and return whether all succeeded. */
+    static bool Execute(std::vector<T>& checks)
+    {
+        for (T& check : checks) {
+            if (!check()) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Work stealing mode: move a chunk of work for thread self into checks,
+     * from its own queue if possible, or else by stealing from another queue.
+     */
+    bool TakeWork(size_t self, std::vector<T>& checks)
+    {
+        LocalQueue& own{*m_local_queues[self]};
+        for (size_t victim_offset = 1;; ++victim_offset) {
+            {
+                LOCK(own.m_mutex);
+                if (!own.m_checks.empty()) {
+                    const auto start_it{own.m_checks.end() - std::min<size_t>(own.m_checks.size(), m_local_chunk_size)};
+                    checks.assign(std::make_move_iterator(start_it), std::make_move_iterator(own.m_checks.end()));
+                    own.m_checks.erase(start_it, own.m_checks.end());
+                    return true;
+                }
+            }
+            // Look for a non-empty queue to steal from. Only one queue is
+            // locked at a time.
+            for (; victim_offset < m_local_queues.size(); ++victim_offset) {
+                LocalQueue& victim{*m_local_queues[(self + victim_offset) % m_local_queues.size()]};
+                std::vector<T> stolen;
+                {
+                    LOCK(victim.m_mutex);
+                    if (victim.m_checks.empty()) continue;
+                    const auto end_it{victim.m_checks.begin() + std::max<size_t>(1, std::min<size_t>(victim.m_checks.size() / 2, nBatchSize))};
+                    stolen.assign(std::make_move_iterator(victim.m_checks.begin()), std::make_move_iterator(end_it));
+                    victim.m_checks.erase(victim.m_checks.begin(), end_it);
+                }
+                // Put the loot in our own queue, where other threads can steal it in turn.
+                LOCK(own.m_mutex);
+                own.m_checks.insert(own.m_checks.end(), std::make_move_iterator(stolen.begin()), std::make_move_iterator(stolen.end()));
+                break;
+            }
+            if (victim_offset >= m_local_queues.size()) return false;
+        }
+    }
+
+    /** Work stealing counterpart of Loop(), for thread self. */
+    bool StealingLoop(size_t self) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        const bool fMaster{self == m_worker_threads.size()};
+        std::vector<T> vChecks;
+        vChecks.reserve(nBatchSize);
+        while (true) {
+            if (m_request_stop) return false;
+            // Read before looking for work: if Add() comes after that, the
+            // epoch will differ once we wait for it below.
+            const uint64_t epoch{m_work_epoch};
+            if (TakeWork(self, vChecks)) {
+                // Skip the work if something failed already.
+                if (m_all_ok.load(std::memory_order_relaxed) && !Execute(vChecks)) {
+                    m_all_ok.store(false, std::memory_order_relaxed);
+                }
+                const unsigned int done(vChecks.size());
+                vChecks.clear();
+                if (m_todo.fetch_sub(done, std::memory_order_acq_rel) == done && !fMaster) {
+                    // We processed the last element; inform the master it can exit and return the result
+                    WITH_LOCK(m_mutex, m_master_cv.notify_one());
+                }
+                continue;
+            }
+            WAIT_LOCK(m_mutex, lock);
+            if (fMaster) {
+                // Nothing left to take. Wait for the checks still running on the workers.
+                m_master_cv.wait(lock, [&] { return m_todo.load(std::memory_order_acquire) == 0; });
+                // return the current status, and reset it for new work later
+                return m_all_ok.exchange(true, std::memory_order_relaxed);
+            }
+            m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_request_stop || m_work_epoch != epoch; });
+        }
+    }
 
     /** Internal function that does bulk of the verification work. */
     bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
@@ -115,9 +234,7 @@ private:
                 fOk = fAllOk;
             }
             // execute work
-            for (T& check : vChecks)
-                if (fOk)
-                    fOk = check();
+            if (fOk) fOk = Execute(vChecks);
             vChecks.clear();
         } while (true);
     }
@@ -126,15 +243,26 @@ public:
     //! Mutex to ensure only one concurrent CCheckQueueControl
     Mutex m_control_mutex;
 
-    //! Create a new check queue
-    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num)
-        : nBatchSize(batch_size)
+    //! Create a new check queue, whose worker threads are named thread_name.N
+    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num, bool work_stealing = false,
+                         std::string thread_name = "scriptch")
+        : nBatchSize(batch_size), m_local_chunk_size(std::max(1U, batch_size / 16))
     {
+        if (work_stealing) {
+            // One queue per worker thread, and one for the master.
+            for (int n = 0; n <= worker_threads_num; ++n) {
+                m_local_queues.push_back(std::make_unique<LocalQueue>());
+            }
+        }
         m_worker_threads.reserve(worker_threads_num);
         for (int n = 0; n < worker_threads_num; ++n) {
-            m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
-                Loop(false /* worker thread */);
+            m_worker_threads.emplace_back([this, n, thread_name]() {
+                util::ThreadRename(strprintf("%s.%i", thread_name, n));
+                if (m_local_queues.empty()) {
+                    Loop(false /* worker thread */);
+                } else {
+                    StealingLoop(n);
+                }
             });
         }
     }
@@ -149,6 +277,7 @@ public:
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
+        if (!m_local_queues.empty()) return StealingLoop(m_worker_threads.size());
         return Loop(true /* master thread */);
     }
 
@@ -159,7 +288,17 @@ public:
             return;
         }
 
-        {
+        if (!m_local_queues.empty()) {
+            // Count the work before it can be taken, so m_todo never drops below zero.
+            m_todo.fetch_add(vChecks.size(), std::memory_order_relaxed);
+            {
+                LocalQueue& local{*m_local_queues[m_next_local_queue]};
+                m_next_local_queue = (m_next_local_queue + 1) % m_local_queues.size();
+                LOCK(local.m_mutex);
+                local.m_checks.insert(local.m_checks.end(), std::make_move_iterator(vChecks.begin()), std::make_move_iterator(vChecks.end()));
+            }
+            WITH_LOCK(m_mutex, ++m_work_epoch);
+        } else {
             LOCK(m_mutex);
             queue.insert(queue.end(), std::make_move_iterator(vChecks.begin()), std::make_move_iterator(vChecks.end()));
             nTodo += vChecks.size();
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cluster_linearize.h>
+
+#include <util/check.h>
+
+#include <bit>
+#include <optional>
+#include <utility>
+
+namespace cluster_linearize {
+namespace {
+
+/** Return the transactions of graph with every transaction after all of its parents. */
+std::vector<uint32_t> TopologicalOrder(const DepGraph& graph)
+{
+    const uint32_t n{graph.TxCount()};
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    // 0: not visited, 1: on the stack, 2: emitted.
+    std::vector<uint8_t> state(n, 0);
+    // Depth-first search over parents; (transaction, index of the next parent to visit).
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    for (uint32_t root = 0; root < n; ++root) {
+        if (state[root] != 0) continue;
+        state[root] = 1;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            const auto [tx, next] = stack.back();
+            const auto parents{graph.Parents(tx)};
+            if (next < parents.size()) {
+                ++stack.back().second;
+                const uint32_t parent{parents[next]};
+                if (state[parent] == 0) {
+                    state[parent] = 1;
+                    stack.emplace_back(parent, 0);
+                } else {
+                    Assume(state[parent] == 2); // the graph must be acyclic
+                }
+            } else {
+                state[tx] = 2;
+                order.push_back(tx);
+                stack.pop_back();
+            }
+        }
+    }
+    return order;
+}
+
+/** Call fn(i) for every bit i set in both a and b. */
+template <typename Fn>
+void ForEachBit(const uint64_t* a, const uint64_t* b, size_t words, Fn fn)
+{
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t bits{a[w] & b[w]};
+        while (bits) {
+            fn(uint32_t(w * 64 + std::countr_zero(bits)));
+            bits &= bits - 1;
+        }
+    }
+}
+
+} // namespace
+
+std::vector<uint32_t> Linearize(const DepGraph& graph)
+{
+    std::vector<uint32_t> topo{TopologicalOrder(graph)};
+    const uint32_t n{graph.TxCount()};
+    if (n <= 1 || n > MAX_ANCESTOR_SORT_TXS) return topo;
+
+    // Ancestor and descendant sets (each including the transaction itself) as bitsets.
+    const size_t words{(n + 63) / 64};
+    std::vector<uint64_t> anc(n * words), desc(n * words), remaining(words);
+    const auto set_bit = [](uint64_t* bits, uint32_t i) { bits[i / 64] |= uint64_t{1} << (i % 64); };
+    const auto clear_bit = [](uint64_t* bits, uint32_t i) { bits[i / 64] &= ~(uint64_t{1} << (i % 64)); };
+    const auto has_bit = [](const uint64_t* bits, uint32_t i) { return (bits[i / 64] >> (i % 64)) & 1; };
+    for (const uint32_t tx : topo) {
+        uint64_t* tx_anc{&anc[tx * words]};
+        set_bit(tx_anc, tx);
+        for (const uint32_t parent : graph.Parents(tx)) {
+            const uint64_t* parent_anc{&anc[parent * words]};
+            for (size_t w = 0; w < words; ++w) tx_anc[w] |= parent_anc[w];
+        }
+        set_bit(remaining.data(), tx);
+    }
+
+    // Combined fee and size of the not yet linearized ancestors of every transaction.
+    std::vector<FeeFrac> anc_feerate(n);
+    for (uint32_t tx = 0; tx < n; ++tx) {
+        ForEachBit(&anc[tx * words], remaining.data(), words, [&](uint32_t a) {
+            anc_feerate[tx] += graph.FeeRate(a);
+            set_bit(&desc[a * words], tx);
+        });
+    }
+
+    std::vector<uint32_t> ret;
+    ret.reserve(n);
+    while (ret.size() < n) {
+        std::optional<uint32_t> best;
+        for (const uint32_t tx : topo) {
+            if (!has_bit(remaining.data(), tx)) continue;
+            if (!best || anc_feerate[tx] > anc_feerate[*best]) best = tx;
+        }
+        // Append the remaining ancestors of the best candidate, parents first.
+        const uint64_t* best_anc{&anc[*best * words]};
+        const size_t added_begin{ret.size()};
+        for (const uint32_t tx : topo) {
+            if (has_bit(remaining.data(), tx) && has_bit(best_anc, tx)) ret.push_back(tx);
+        }
+        for (size_t i = added_begin; i < ret.size(); ++i) clear_bit(remaining.data(), ret[i]);
+        for (size_t i = added_begin; i < ret.size(); ++i) {
+            ForEachBit(&desc[ret[i] * words], remaining.data(), words, [&](uint32_t d) {
+                anc_feerate[d] -= graph.FeeRate(ret[i]);
+            });
+        }
+    }
+    return ret;
+}
+
+std::vector<Chunk> ChunkLinearization(const DepGraph& graph, Span<const uint32_t> linearization)
+{
+    std::vector<Chunk> ret;
+    for (const uint32_t tx : linearization) {
+        ret.push_back({graph.FeeRate(tx), 1});
+        // Merge the new chunk into its predecessors while it has a higher feerate.
+        while (ret.size() >= 2 && ret.back().feerate >> ret[ret.size() - 2].feerate) {
+            ret[ret.size() - 2].feerate += ret.back().feerate;
+            ret[ret.size() - 2].count += ret.back().count;
+            ret.pop_back();
+        }
+    }
+    return ret;
+}
+
+} // namespace cluster_linearize
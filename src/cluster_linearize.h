@@ -0,0 +1,86 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CLUSTER_LINEARIZE_H
+#define BITCOIN_CLUSTER_LINEARIZE_H
+
+#include <span.h>
+#include <util/feefrac.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace cluster_linearize {
+
+/** Clusters larger than this are not ancestor-set sorted, but get a plain topological order. */
+static constexpr uint32_t MAX_ANCESTOR_SORT_TXS{500};
+
+/** A set of transactions and the dependencies between them.
+ *
+ * Transactions are numbered 0..TxCount()-1 in the order they were added. The parents of a
+ * transaction must be added (with AddParent) directly after the transaction itself, and before
+ * the next transaction is added. Parents may refer to transactions added later, but the graph
+ * must be acyclic.
+ */
+class DepGraph
+{
+    std::vector<FeeFrac> m_feerates;
+    //! Offsets into m_parents for each transaction, plus one past the end.
+    std::vector<uint32_t> m_parent_begin{0};
+    std::vector<uint32_t> m_parents;
+
+public:
+    void Reserve(size_t txs)
+    {
+        m_feerates.reserve(txs);
+        m_parent_begin.reserve(txs + 1);
+    }
+
+    /** Add a transaction with the given fee and size, returning its index. */
+    uint32_t AddTransaction(const FeeFrac& feerate)
+    {
+        m_feerates.push_back(feerate);
+        m_parent_begin.push_back(m_parent_begin.back());
+        return m_feerates.size() - 1;
+    }
+
+    /** Make the most recently added transaction depend on parent. */
+    void AddParent(uint32_t parent)
+    {
+        m_parents.push_back(parent);
+        ++m_parent_begin.back();
+    }
+
+    uint32_t TxCount() const { return m_feerates.size(); }
+    const FeeFrac& FeeRate(uint32_t i) const { return m_feerates[i]; }
+    Span<const uint32_t> Parents(uint32_t i) const
+    {
+        return Span{m_parents}.subspan(m_parent_begin[i], m_parent_begin[i + 1] - m_parent_begin[i]);
+    }
+};
+
+/** A chunk of a linearization: a run of consecutive transactions, and their combined fee and size. */
+struct Chunk {
+    FeeFrac feerate;
+    uint32_t count;
+};
+
+/** Compute a linearization (a topologically valid order) of the transactions in graph.
+ *
+ * Repeatedly picks the remaining transaction whose remaining ancestor set has the highest
+ * feerate, and appends that ancestor set. Graphs with more than MAX_ANCESTOR_SORT_TXS
+ * transactions are only sorted topologically.
+ */
+std::vector<uint32_t> Linearize(const DepGraph& graph);
+
+/** Split a linearization into chunks of non-increasing feerate.
+ *
+ * Adjacent transactions are merged whenever a later group has a higher feerate than the one
+ * before it, so every chunk can be mined as a unit in the order returned.
+ */
+std::vector<Chunk> ChunkLinearization(const DepGraph& graph, Span<const uint32_t> linearization);
+
+} // namespace cluster_linearize
+
+#endif // BITCOIN_CLUSTER_LINEARIZE_H
@@ -114,6 +114,14 @@ void CCoinsViewCache::EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coi
         std::forward_as_tuple(std::move(coin), CCoinsCacheEntry::DIRTY));
 }
 
+void CCoinsViewCache::InsertFetchedCoin(const COutPoint& outpoint, Coin&& coin) {
+    assert(!coin.IsSpent());
+    auto [it, inserted] = cacheCoins.try_emplace(outpoint, std::move(coin));
+    if (inserted) {
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
+}
+
 void AddCoins(CCoinsViewCache& cache, const CTransaction &tx, int nHeight, bool check_for_overwrite) {
     bool fCoinbase = tx.IsCoinBase();
     const Txid& txid = tx.GetHash();
@@ -280,6 +288,24 @@ bool CCoinsViewCache::Sync()
     return fOk;
 }
 
+void CCoinsViewCache::TakeModified(CCoinsMap& coins, bool keep_unmodified)
+{
+    for (auto it = cacheCoins.begin(); it != cacheCoins.end(); ) {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+            cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+            coins.emplace(it->first, CCoinsCacheEntry{std::move(it->second.coin), it->second.flags});
+            it = cacheCoins.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!keep_unmodified) {
+        cacheCoins.clear();
+        cachedCoinsUsage = 0;
+        ReallocateCache();
+    }
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& hash)
 {
     CCoinsMap::iterator it = cacheCoins.find(hash);
@@ -6,8 +6,11 @@
 #ifndef BITCOIN_COINS_H
 #define BITCOIN_COINS_H
 
+#include <config/bitcoin-config.h> // IWYU pragma: keep
+
 #include <compressor.h>
 #include <core_memusage.h>
+#include <flatmap.h>
 #include <memusage.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
@@ -140,14 +143,36 @@ struct CCoinsCacheEntry
  * Using an additional sizeof(void*)*4 for MAX_BLOCK_SIZE_BYTES should thus be sufficient so that
  * all implementations can allocate the nodes from the PoolAllocator.
  */
-using CCoinsMap = std::unordered_map<COutPoint,
-                                     CCoinsCacheEntry,
-                                     SaltedOutpointHasher,
-                                     std::equal_to<COutPoint>,
-                                     PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
-                                                   sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4>>;
+using CCoinsNodeMap = std::unordered_map<COutPoint,
+                                         CCoinsCacheEntry,
+                                         SaltedOutpointHasher,
+                                         std::equal_to<COutPoint>,
+                                         PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
+                                                       sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4>>;
+
+/**
+ * Open-addressing alternative to CCoinsNodeMap. Entries live inline in one
+ * contiguous table, so a lookup is a probe of a group of control bytes plus a
+ * single slot access, instead of a bucket load followed by a node pointer
+ * chase. Growing the table moves all entries; see FlatMap.
+ */
+using CCoinsFlatMap = FlatMap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>;
 
+#ifdef USE_FLAT_COINS_MAP
+/** CCoinsFlatMap has no node pool. This stands in for the pool resource so that
+ *  CCoinsMap is constructed the same way whichever map is selected. */
+struct CCoinsMapMemoryResource {};
+
+class CCoinsMap : public CCoinsFlatMap
+{
+public:
+    CCoinsMap(size_t bucket_count, const hasher& hash, const key_equal& equal, CCoinsMapMemoryResource*)
+        : CCoinsFlatMap(bucket_count, hash, equal) {}
+};
+#else
+using CCoinsMap = CCoinsNodeMap;
 using CCoinsMapMemoryResource = CCoinsMap::allocator_type::ResourceType;
+#endif // USE_FLAT_COINS_MAP
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -294,6 +319,17 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin);
 
+    /**
+     * Insert an unspent coin that was read from the backing view, exactly as
+     * FetchCoin() would have cached it. Does nothing if the outpoint is already
+     * cached.
+     *
+     * NOT FOR GENERAL USE. The caller must have read the coin from this cache's
+     * backing view with no intervening writes.
+     * @sa InputFetcher::FetchInputs()
+     */
+    void InsertFetchedCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call
@@ -318,6 +354,17 @@ public:
      */
     bool Sync();
 
+    /**
+     * Move the modifications applied to this cache into coins, for the caller
+     * to write to the base, e.g. with CCoinsViewDB::BatchWriteInBackground().
+     * Unmodified coins are kept if keep_unmodified is true, and wiped otherwise.
+     * The best block is left for the caller to take with GetBestBlock().
+     *
+     * Until coins has been handed to the base, lookups through this cache
+     * will not see the moved modifications.
+     */
+    void TakeModified(CCoinsMap& coins, bool keep_unmodified);
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is
      * not modified.
@@ -0,0 +1,193 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <common/json_writer.h>
+
+#include <univalue.h>
+#include <univalue_escapes.h>
+
+#include <cassert>
+#include <charconv>
+
+void JSONWriter::Members(const UniValue& obj)
+{
+    const std::vector<std::string>& keys{obj.getKeys()};
+    const std::vector<UniValue>& values{obj.getValues()};
+    for (size_t i = 0; i < keys.size(); ++i) {
+        Key(keys[i]);
+        Value(values[i]);
+    }
+}
+
+void JSONTextWriter::BeginObject()
+{
+    Separate();
+    m_out += '{';
+    m_need_comma = false;
+}
+
+void JSONTextWriter::EndObject()
+{
+    m_out += '}';
+    m_need_comma = true;
+    Written();
+}
+
+void JSONTextWriter::BeginArray()
+{
+    Separate();
+    m_out += '[';
+    m_need_comma = false;
+}
+
+void JSONTextWriter::EndArray()
+{
+    m_out += ']';
+    m_need_comma = true;
+    Written();
+}
+
+void JSONTextWriter::Key(std::string_view key)
+{
+    Separate();
+    Escaped(key);
+    m_out += ':';
+    m_need_comma = false;
+}
+
+void JSONTextWriter::String(std::string_view str)
+{
+    Separate();
+    Escaped(str);
+    Written();
+}
+
+void JSONTextWriter::Int(int64_t num)
+{
+    Separate();
+    char buf[20];
+    const auto [end, ec]{std::to_chars(buf, buf + sizeof(buf), num)};
+    m_out.append(buf, end);
+}
+
+void JSONTextWriter::Bool(bool b)
+{
+    Separate();
+    m_out += b ? "true" : "false";
+}
+
+void JSONTextWriter::Null()
+{
+    Separate();
+    m_out += "null";
+}
+
+void JSONTextWriter::Value(const UniValue& value)
+{
+    Separate();
+    m_out += value.write();
+    Written();
+}
+
+void JSONTextWriter::Flush()
+{
+    if (!m_sink || m_out.empty()) return;
+    m_sink(m_out);
+    m_out.clear();
+}
+
+void JSONTextWriter::Escaped(std::string_view str)
+{
+    m_out += '"';
+    // Copy the runs of characters that need no escaping at once.
+    size_t run_start{0};
+    for (size_t i = 0; i < str.size(); ++i) {
+        const char* escaped{escapes[static_cast<unsigned char>(str[i])]};
+        if (escaped) {
+            m_out.append(str, run_start, i - run_start);
+            m_out += escaped;
+            run_start = i + 1;
+        }
+    }
+    m_out.append(str, run_start, str.size() - run_start);
+    m_out += '"';
+}
+
+void UniValueWriter::BeginObject()
+{
+    m_open.emplace_back(std::move(m_key), UniValue{UniValue::VOBJ});
+}
+
+void UniValueWriter::EndObject()
+{
+    assert(!m_open.empty() && m_open.back().second.isObject());
+    auto [key, value]{std::move(m_open.back())};
+    m_open.pop_back();
+    m_key = std::move(key);
+    Add(std::move(value));
+}
+
+void UniValueWriter::BeginArray()
+{
+    m_open.emplace_back(std::move(m_key), UniValue{UniValue::VARR});
+}
+
+void UniValueWriter::EndArray()
+{
+    assert(!m_open.empty() && m_open.back().second.isArray());
+    auto [key, value]{std::move(m_open.back())};
+    m_open.pop_back();
+    m_key = std::move(key);
+    Add(std::move(value));
+}
+
+void UniValueWriter::Key(std::string_view key)
+{
+    m_key = key;
+}
+
+void UniValueWriter::String(std::string_view str)
+{
+    Add(UniValue{std::string{str}});
+}
+
+void UniValueWriter::Int(int64_t num)
+{
+    Add(UniValue{num});
+}
+
+void UniValueWriter::Bool(bool b)
+{
+    Add(UniValue{b});
+}
+
+void UniValueWriter::Null()
+{
+    Add(UniValue{});
+}
+
+void UniValueWriter::Value(const UniValue& value)
+{
+    Add(value);
+}
+
+void UniValueWriter::Add(UniValue value)
+{
+    if (!m_open.empty()) {
+        UniValue& parent{m_open.back().second};
+        // Keys are unique within the objects written here.
+        if (parent.isObject()) {
+            parent.pushKVEnd(std::move(m_key), std::move(value));
+        } else {
+            parent.push_back(std::move(value));
+        }
+    } else if (m_target.isObject()) {
+        m_target.pushKV(std::move(m_key), std::move(value));
+    } else if (m_target.isArray()) {
+        m_target.push_back(std::move(value));
+    } else {
+        m_target = std::move(value);
+    }
+    m_key.clear();
+}
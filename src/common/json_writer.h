@@ -0,0 +1,133 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COMMON_JSON_WRITER_H
+#define BITCOIN_COMMON_JSON_WRITER_H
+
+#include <univalue.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Receives a JSON value one token at a time. Functions that produce JSON
+ * write it to a JSONWriter, so that the same code can either build a
+ * UniValue (UniValueWriter) or write the text directly (JSONTextWriter).
+ *
+ * The caller nests the Begin and End calls, and precedes each value in an
+ * object with a Key().
+ */
+class JSONWriter
+{
+public:
+    virtual ~JSONWriter() = default;
+
+    virtual void BeginObject() = 0;
+    virtual void EndObject() = 0;
+    virtual void BeginArray() = 0;
+    virtual void EndArray() = 0;
+
+    virtual void Key(std::string_view key) = 0;
+
+    virtual void String(std::string_view str) = 0;
+    virtual void Int(int64_t num) = 0;
+    virtual void Bool(bool b) = 0;
+    virtual void Null() = 0;
+    //! Write a value built as a UniValue.
+    virtual void Value(const UniValue& value) = 0;
+    //! Write the members of an object built as a UniValue into the current object.
+    void Members(const UniValue& obj);
+};
+
+/**
+ * Writes compact JSON text, the same as UniValue::write() of the equivalent
+ * value, without building the value first.
+ *
+ * The text is appended to a buffer. If a sink is given, the buffer is handed
+ * to it and cleared whenever it grows beyond FLUSH_SIZE, and by Flush(), so
+ * that large results can be passed on without holding all of their text.
+ */
+class JSONTextWriter final : public JSONWriter
+{
+public:
+    using Sink = std::function<void(std::string_view text)>;
+    static constexpr size_t FLUSH_SIZE{1 << 16};
+
+    explicit JSONTextWriter(std::string& out, Sink sink = {}) : m_out{out}, m_sink{std::move(sink)} {}
+
+    void BeginObject() override;
+    void EndObject() override;
+    void BeginArray() override;
+    void EndArray() override;
+
+    void Key(std::string_view key) override;
+
+    void String(std::string_view str) override;
+    void Int(int64_t num) override;
+    void Bool(bool b) override;
+    void Null() override;
+    void Value(const UniValue& value) override;
+
+    //! Hand the buffered text to the sink, if any.
+    void Flush();
+
+private:
+    std::string& m_out;
+    const Sink m_sink;
+    //! Whether the next key or value follows another one.
+    bool m_need_comma{false};
+
+    void Separate()
+    {
+        if (m_need_comma) m_out += ',';
+        m_need_comma = true;
+    }
+    void Escaped(std::string_view str);
+    void Written()
+    {
+        if (m_sink && m_out.size() >= FLUSH_SIZE) Flush();
+    }
+};
+
+/**
+ * Builds the written JSON as a UniValue.
+ *
+ * If the target is an object or array, values are added to it, so the
+ * members of an existing object can be written, replacing existing keys
+ * like UniValue::pushKV(). Otherwise the target is set to the first value.
+ */
+class UniValueWriter final : public JSONWriter
+{
+public:
+    explicit UniValueWriter(UniValue& target) : m_target{target} {}
+
+    void BeginObject() override;
+    void EndObject() override;
+    void BeginArray() override;
+    void EndArray() override;
+
+    void Key(std::string_view key) override;
+
+    void String(std::string_view str) override;
+    void Int(int64_t num) override;
+    void Bool(bool b) override;
+    void Null() override;
+    void Value(const UniValue& value) override;
+
+private:
+    UniValue& m_target;
+    //! Objects and arrays being written, with the key they are written under.
+    std::vector<std::pair<std::string, UniValue>> m_open;
+    //! Key of the next value in an object.
+    std::string m_key;
+
+    void Add(UniValue value);
+};
+
+#endif // BITCOIN_COMMON_JSON_WRITER_H
@@ -20,6 +20,7 @@ class SigningProvider;
 class uint256;
 class UniValue;
 class CTxUndo;
+class JSONWriter;
 
 /**
  * Verbose level for block's transaction
@@ -55,5 +56,7 @@ std::string EncodeHexTx(const CTransaction& tx);
 std::string SighashToStr(unsigned char sighash_type);
 void ScriptToUniv(const CScript& script, UniValue& out, bool include_hex = true, bool include_address = false, const SigningProvider* provider = nullptr);
 void TxToUniv(const CTransaction& tx, const uint256& block_hash, UniValue& entry, bool include_hex = true, const CTxUndo* txundo = nullptr, TxVerbosity verbosity = TxVerbosity::SHOW_DETAILS);
+/** Write the object whose members TxToUniv() adds to entry, e.g. to a JSONTextWriter. */
+void TxToJSON(const CTransaction& tx, const uint256& block_hash, JSONWriter& writer, bool include_hex = true, const CTxUndo* txundo = nullptr, TxVerbosity verbosity = TxVerbosity::SHOW_DETAILS);
 
 #endif // BITCOIN_CORE_IO_H
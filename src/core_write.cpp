@@ -4,6 +4,7 @@
 
 #include <core_io.h>
 
+#include <common/json_writer.h>
 #include <common/system.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
@@ -147,42 +148,60 @@ std::string EncodeHexTx(const CTransaction& tx)
     return HexStr(ssTx);
 }
 
-void ScriptToUniv(const CScript& script, UniValue& out, bool include_hex, bool include_address, const SigningProvider* provider)
+/** Write the members of ScriptToUniv()'s object. */
+static void ScriptFields(const CScript& script, JSONWriter& writer, bool include_hex, bool include_address, const SigningProvider* provider)
 {
     CTxDestination address;
 
-    out.pushKV("asm", ScriptToAsmStr(script));
+    writer.Key("asm");
+    writer.String(ScriptToAsmStr(script));
     if (include_address) {
-        out.pushKV("desc", InferDescriptor(script, provider ? *provider : DUMMY_SIGNING_PROVIDER)->ToString());
+        writer.Key("desc");
+        writer.String(InferDescriptor(script, provider ? *provider : DUMMY_SIGNING_PROVIDER)->ToString());
     }
     if (include_hex) {
-        out.pushKV("hex", HexStr(script));
+        writer.Key("hex");
+        writer.String(HexStr(script));
     }
 
     std::vector<std::vector<unsigned char>> solns;
     const TxoutType type{Solver(script, solns)};
 
     if (include_address && ExtractDestination(script, address) && type != TxoutType::PUBKEY) {
-        out.pushKV("address", EncodeDestination(address));
+        writer.Key("address");
+        writer.String(EncodeDestination(address));
     }
-    out.pushKV("type", GetTxnOutputType(type));
+    writer.Key("type");
+    writer.String(GetTxnOutputType(type));
 }
 
-void TxToUniv(const CTransaction& tx, const uint256& block_hash, UniValue& entry, bool include_hex, const CTxUndo* txundo, TxVerbosity verbosity)
+void ScriptToUniv(const CScript& script, UniValue& out, bool include_hex, bool include_address, const SigningProvider* provider)
+{
+    UniValueWriter writer{out};
+    ScriptFields(script, writer, include_hex, include_address, provider);
+}
+
+/** Write the members of TxToUniv()'s object. */
+static void TxFields(const CTransaction& tx, const uint256& block_hash, JSONWriter& writer, bool include_hex, const CTxUndo* txundo, TxVerbosity verbosity)
 {
     CHECK_NONFATAL(verbosity >= TxVerbosity::SHOW_DETAILS);
 
-    entry.pushKV("txid", tx.GetHash().GetHex());
-    entry.pushKV("hash", tx.GetWitnessHash().GetHex());
+    writer.Key("txid");
+    writer.String(tx.GetHash().GetHex());
+    writer.Key("hash");
+    writer.String(tx.GetWitnessHash().GetHex());
     // Transaction version is actually unsigned in consensus checks, just signed in memory,
     // so cast to unsigned before giving it to the user.
-    entry.pushKV("version", static_cast<int64_t>(static_cast<uint32_t>(tx.nVersion)));
-    entry.pushKV("size", tx.GetTotalSize());
-    entry.pushKV("vsize", (GetTransactionWeight(tx) + WITNESS_SCALE_FACTOR - 1) / WITNESS_SCALE_FACTOR);
-    entry.pushKV("weight", GetTransactionWeight(tx));
-    entry.pushKV("locktime", (int64_t)tx.nLockTime);
-
-    UniValue vin{UniValue::VARR};
+    writer.Key("version");
+    writer.Int(static_cast<uint32_t>(tx.nVersion));
+    writer.Key("size");
+    writer.Int(tx.GetTotalSize());
+    writer.Key("vsize");
+    writer.Int((GetTransactionWeight(tx) + WITNESS_SCALE_FACTOR - 1) / WITNESS_SCALE_FACTOR);
+    writer.Key("weight");
+    writer.Int(GetTransactionWeight(tx));
+    writer.Key("locktime");
+    writer.Int(tx.nLockTime);
 
     // If available, use Undo data to calculate the fee. Note that txundo == nullptr
     // for coinbase transactions and for transactions where undo data is unavailable.
@@ -190,25 +209,34 @@ void TxToUniv(const CTransaction& tx, const uint256& block_hash, UniValue& entry
     CAmount amt_total_in = 0;
     CAmount amt_total_out = 0;
 
+    writer.Key("vin");
+    writer.BeginArray();
     for (unsigned int i = 0; i < tx.vin.size(); i++) {
         const CTxIn& txin = tx.vin[i];
-        UniValue in(UniValue::VOBJ);
+        writer.BeginObject();
         if (tx.IsCoinBase()) {
-            in.pushKV("coinbase", HexStr(txin.scriptSig));
+            writer.Key("coinbase");
+            writer.String(HexStr(txin.scriptSig));
         } else {
-            in.pushKV("txid", txin.prevout.hash.GetHex());
-            in.pushKV("vout", (int64_t)txin.prevout.n);
-            UniValue o(UniValue::VOBJ);
-            o.pushKV("asm", ScriptToAsmStr(txin.scriptSig, true));
-            o.pushKV("hex", HexStr(txin.scriptSig));
-            in.pushKV("scriptSig", std::move(o));
+            writer.Key("txid");
+            writer.String(txin.prevout.hash.GetHex());
+            writer.Key("vout");
+            writer.Int(txin.prevout.n);
+            writer.Key("scriptSig");
+            writer.BeginObject();
+            writer.Key("asm");
+            writer.String(ScriptToAsmStr(txin.scriptSig, true));
+            writer.Key("hex");
+            writer.String(HexStr(txin.scriptSig));
+            writer.EndObject();
         }
-        if (!tx.vin[i].scriptWitness.IsNull()) {
-            UniValue txinwitness(UniValue::VARR);
-            for (const auto& item : tx.vin[i].scriptWitness.stack) {
-                txinwitness.push_back(HexStr(item));
+        if (!txin.scriptWitness.IsNull()) {
+            writer.Key("txinwitness");
+            writer.BeginArray();
+            for (const auto& item : txin.scriptWitness.stack) {
+                writer.String(HexStr(item));
             }
-            in.pushKV("txinwitness", std::move(txinwitness));
+            writer.EndArray();
         }
         if (have_undo) {
             const Coin& prev_coin = txundo->vprevout[i];
@@ -217,53 +245,75 @@ void TxToUniv(const CTransaction& tx, const uint256& block_hash, UniValue& entry
             amt_total_in += prev_txout.nValue;
 
             if (verbosity == TxVerbosity::SHOW_DETAILS_AND_PREVOUT) {
-                UniValue o_script_pub_key(UniValue::VOBJ);
-                ScriptToUniv(prev_txout.scriptPubKey, /*out=*/o_script_pub_key, /*include_hex=*/true, /*include_address=*/true);
-
-                UniValue p(UniValue::VOBJ);
-                p.pushKV("generated", bool(prev_coin.fCoinBase));
-                p.pushKV("height", uint64_t(prev_coin.nHeight));
-                p.pushKV("value", ValueFromAmount(prev_txout.nValue));
-                p.pushKV("scriptPubKey", std::move(o_script_pub_key));
-                in.pushKV("prevout", std::move(p));
+                writer.Key("prevout");
+                writer.BeginObject();
+                writer.Key("generated");
+                writer.Bool(prev_coin.fCoinBase);
+                writer.Key("height");
+                writer.Int(prev_coin.nHeight);
+                writer.Key("value");
+                writer.Value(ValueFromAmount(prev_txout.nValue));
+                writer.Key("scriptPubKey");
+                writer.BeginObject();
+                ScriptFields(prev_txout.scriptPubKey, writer, /*include_hex=*/true, /*include_address=*/true, /*provider=*/nullptr);
+                writer.EndObject();
+                writer.EndObject();
             }
         }
-        in.pushKV("sequence", (int64_t)txin.nSequence);
-        vin.push_back(std::move(in));
+        writer.Key("sequence");
+        writer.Int(txin.nSequence);
+        writer.EndObject();
     }
-    entry.pushKV("vin", std::move(vin));
+    writer.EndArray();
 
-    UniValue vout(UniValue::VARR);
+    writer.Key("vout");
+    writer.BeginArray();
     for (unsigned int i = 0; i < tx.vout.size(); i++) {
         const CTxOut& txout = tx.vout[i];
-
-        UniValue out(UniValue::VOBJ);
-
-        out.pushKV("value", ValueFromAmount(txout.nValue));
-        out.pushKV("n", (int64_t)i);
-
-        UniValue o(UniValue::VOBJ);
-        ScriptToUniv(txout.scriptPubKey, /*out=*/o, /*include_hex=*/true, /*include_address=*/true);
-        out.pushKV("scriptPubKey", std::move(o));
-        vout.push_back(std::move(out));
+        writer.BeginObject();
+        writer.Key("value");
+        writer.Value(ValueFromAmount(txout.nValue));
+        writer.Key("n");
+        writer.Int(i);
+        writer.Key("scriptPubKey");
+        writer.BeginObject();
+        ScriptFields(txout.scriptPubKey, writer, /*include_hex=*/true, /*include_address=*/true, /*provider=*/nullptr);
+        writer.EndObject();
+        writer.EndObject();
 
         if (have_undo) {
             amt_total_out += txout.nValue;
         }
     }
-    entry.pushKV("vout", std::move(vout));
+    writer.EndArray();
 
     if (have_undo) {
         const CAmount fee = amt_total_in - amt_total_out;
         CHECK_NONFATAL(MoneyRange(fee));
-        entry.pushKV("fee", ValueFromAmount(fee));
+        writer.Key("fee");
+        writer.Value(ValueFromAmount(fee));
     }
 
     if (!block_hash.IsNull()) {
-        entry.pushKV("blockhash", block_hash.GetHex());
+        writer.Key("blockhash");
+        writer.String(block_hash.GetHex());
     }
 
     if (include_hex) {
-        entry.pushKV("hex", EncodeHexTx(tx)); // The hex-encoded transaction. Used the name "hex" to be consistent with the verbose output of "getrawtransaction".
+        writer.Key("hex");
+        writer.String(EncodeHexTx(tx)); // The hex-encoded transaction. Used the name "hex" to be consistent with the verbose output of "getrawtransaction".
     }
 }
+
+void TxToUniv(const CTransaction& tx, const uint256& block_hash, UniValue& entry, bool include_hex, const CTxUndo* txundo, TxVerbosity verbosity)
+{
+    UniValueWriter writer{entry};
+    TxFields(tx, block_hash, writer, include_hex, txundo, verbosity);
+}
+
+void TxToJSON(const CTransaction& tx, const uint256& block_hash, JSONWriter& writer, bool include_hex, const CTxUndo* txundo, TxVerbosity verbosity)
+{
+    writer.BeginObject();
+    TxFields(tx, block_hash, writer, include_hex, txundo, verbosity);
+    writer.EndObject();
+}
@@ -195,6 +195,34 @@ void CDBBatch::EraseImpl(Span<const std::byte> key)
     size_estimate += 2 + (slKey.size() > 127) + slKey.size();
 }
 
+struct CDBBulkLoad::BulkLoadImpl {
+    const std::unique_ptr<leveldb::BulkLoad> bulk_load;
+
+    explicit BulkLoadImpl(leveldb::BulkLoad* _bulk_load) : bulk_load{_bulk_load} {}
+};
+
+CDBBulkLoad::CDBBulkLoad(const CDBWrapper& _parent, std::unique_ptr<BulkLoadImpl> impl)
+    : parent{_parent},
+      m_impl{std::move(impl)} {}
+
+CDBBulkLoad::~CDBBulkLoad() = default;
+
+void CDBBulkLoad::WriteImpl(Span<const std::byte> key, DataStream& ssValue)
+{
+    leveldb::Slice slKey(CharCast(key.data()), key.size());
+    ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
+    leveldb::Slice slValue(CharCast(ssValue.data()), ssValue.size());
+    m_impl->bulk_load->Put(slKey, slValue);
+    size_estimate += slKey.size() + slValue.size();
+}
+
+void CDBBulkLoad::EraseImpl(Span<const std::byte> key)
+{
+    leveldb::Slice slKey(CharCast(key.data()), key.size());
+    m_impl->bulk_load->Delete(slKey);
+    size_estimate += slKey.size();
+}
+
 struct LevelDBContext {
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
@@ -305,6 +333,25 @@ bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
     return true;
 }
 
+std::unique_ptr<CDBBulkLoad> CDBWrapper::NewBulkLoad()
+{
+    leveldb::BulkLoad* bulk_load;
+    HandleError(DBContext().pdb->NewBulkLoad(&bulk_load));
+    return std::make_unique<CDBBulkLoad>(*this, std::make_unique<CDBBulkLoad::BulkLoadImpl>(bulk_load));
+}
+
+bool CDBWrapper::WriteBulkLoad(CDBBulkLoad& bulk_load)
+{
+    assert(&bulk_load.parent == this);
+    leveldb::Status status = DBContext().pdb->IngestBulkLoad(bulk_load.m_impl->bulk_load.get());
+    if (status.IsInvalidArgument()) {
+        LogPrint(BCLog::LEVELDB, "Cannot write bulk load to %s: %s\n", m_name, status.ToString());
+        return false;
+    }
+    HandleError(status);
+    return true;
+}
+
 size_t CDBWrapper::DynamicMemoryUsage() const
 {
     std::string memory;
@@ -335,11 +382,33 @@ std::vector<unsigned char> CDBWrapper::CreateObfuscateKey() const
     return ret;
 }
 
-std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key) const
+struct CDBSnapshot::SnapshotImpl {
+    leveldb::DB* const db;
+    const leveldb::Snapshot* const snapshot;
+
+    explicit SnapshotImpl(leveldb::DB* _db) : db{_db}, snapshot{_db->GetSnapshot()} {}
+    ~SnapshotImpl() { db->ReleaseSnapshot(snapshot); }
+};
+
+CDBSnapshot::CDBSnapshot(const CDBWrapper& parent, std::unique_ptr<SnapshotImpl> impl) : m_parent{parent}, m_impl{std::move(impl)} {}
+
+CDBSnapshot::~CDBSnapshot() = default;
+
+std::unique_ptr<CDBSnapshot> CDBWrapper::NewSnapshot() const
+{
+    return std::make_unique<CDBSnapshot>(*this, std::make_unique<CDBSnapshot::SnapshotImpl>(DBContext().pdb));
+}
+
+std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key, const CDBSnapshot* snapshot) const
 {
     leveldb::Slice slKey(CharCast(key.data()), key.size());
     std::string strValue;
-    leveldb::Status status = DBContext().pdb->Get(DBContext().readoptions, slKey, &strValue);
+    leveldb::ReadOptions readoptions{DBContext().readoptions};
+    if (snapshot) {
+        assert(&snapshot->m_parent == this);
+        readoptions.snapshot = snapshot->m_impl->snapshot;
+    }
+    leveldb::Status status = DBContext().pdb->Get(readoptions, slKey, &strValue);
     if (!status.ok()) {
         if (status.IsNotFound())
             return std::nullopt;
@@ -390,9 +459,14 @@ struct CDBIterator::IteratorImpl {
 CDBIterator::CDBIterator(const CDBWrapper& _parent, std::unique_ptr<IteratorImpl> _piter) : parent(_parent),
                                                                                             m_impl_iter(std::move(_piter)) {}
 
-CDBIterator* CDBWrapper::NewIterator()
+CDBIterator* CDBWrapper::NewIterator(const CDBSnapshot* snapshot)
 {
-    return new CDBIterator{*this, std::make_unique<CDBIterator::IteratorImpl>(DBContext().pdb->NewIterator(DBContext().iteroptions))};
+    leveldb::ReadOptions iteroptions{DBContext().iteroptions};
+    if (snapshot) {
+        assert(&snapshot->m_parent == this);
+        iteroptions.snapshot = snapshot->m_impl->snapshot;
+    }
+    return new CDBIterator{*this, std::make_unique<CDBIterator::IteratorImpl>(DBContext().pdb->NewIterator(iteroptions))};
 }
 
 void CDBIterator::SeekImpl(Span<const std::byte> key)
@@ -119,6 +119,57 @@ public:
     size_t SizeEstimate() const { return size_estimate; }
 };
 
+/**
+ * Entries written into a table file of their own, in increasing key order,
+ * see CDBWrapper::NewBulkLoad(). It must be destroyed before the CDBWrapper.
+ */
+class CDBBulkLoad
+{
+    friend class CDBWrapper;
+
+public:
+    struct BulkLoadImpl;
+
+private:
+    const CDBWrapper& parent;
+    const std::unique_ptr<BulkLoadImpl> m_impl;
+
+    DataStream ssKey{};
+    DataStream ssValue{};
+
+    size_t size_estimate{0};
+
+    void WriteImpl(Span<const std::byte> key, DataStream& ssValue);
+    void EraseImpl(Span<const std::byte> key);
+
+public:
+    CDBBulkLoad(const CDBWrapper& parent, std::unique_ptr<BulkLoadImpl> impl);
+    ~CDBBulkLoad();
+
+    template <typename K, typename V>
+    void Write(const K& key, const V& value)
+    {
+        ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+        ssValue.reserve(DBWRAPPER_PREALLOC_VALUE_SIZE);
+        ssKey << key;
+        ssValue << value;
+        WriteImpl(ssKey, ssValue);
+        ssKey.clear();
+        ssValue.clear();
+    }
+
+    template <typename K>
+    void Erase(const K& key)
+    {
+        ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+        ssKey << key;
+        EraseImpl(ssKey);
+        ssKey.clear();
+    }
+
+    size_t SizeEstimate() const { return size_estimate; }
+};
+
 class CDBIterator
 {
 public:
@@ -176,6 +227,26 @@ public:
     }
 };
 
+/**
+ * Consistent, read-only state of a CDBWrapper as of the time it was created,
+ * see CDBWrapper::NewSnapshot(). It must be destroyed before the CDBWrapper.
+ */
+class CDBSnapshot
+{
+    friend class CDBWrapper;
+
+public:
+    struct SnapshotImpl;
+
+private:
+    const CDBWrapper& m_parent;
+    const std::unique_ptr<SnapshotImpl> m_impl;
+
+public:
+    CDBSnapshot(const CDBWrapper& parent, std::unique_ptr<SnapshotImpl> impl);
+    ~CDBSnapshot();
+};
+
 struct LevelDBContext;
 
 class CDBWrapper
@@ -205,7 +276,7 @@ private:
     //! whether or not the database resides in memory
     bool m_is_memory;
 
-    std::optional<std::string> ReadImpl(Span<const std::byte> key) const;
+    std::optional<std::string> ReadImpl(Span<const std::byte> key, const CDBSnapshot* snapshot) const;
     bool ExistsImpl(Span<const std::byte> key) const;
     size_t EstimateSizeImpl(Span<const std::byte> key1, Span<const std::byte> key2) const;
     auto& DBContext() const LIFETIMEBOUND { return *Assert(m_db_context); }
@@ -217,13 +288,14 @@ public:
     CDBWrapper(const CDBWrapper&) = delete;
     CDBWrapper& operator=(const CDBWrapper&) = delete;
 
+    /** Read the value of key, as of snapshot if given. */
     template <typename K, typename V>
-    bool Read(const K& key, V& value) const
+    bool Read(const K& key, V& value, const CDBSnapshot* snapshot = nullptr) const
     {
         DataStream ssKey{};
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
-        std::optional<std::string> strValue{ReadImpl(ssKey)};
+        std::optional<std::string> strValue{ReadImpl(ssKey, snapshot)};
         if (!strValue) {
             return false;
         }
@@ -272,10 +344,33 @@ public:
 
     bool WriteBatch(CDBBatch& batch, bool fSync = false);
 
+    /**
+     * Start a bulk load, whose entries are written into a table file that is
+     * added to the database as is, rather than through the log and memtable
+     * like batches. Writing many sorted entries this way is faster, and, if
+     * they do not overlap the database, leaves nothing to compact.
+     *
+     * No keys in the range of the bulk load may be written until it is.
+     */
+    std::unique_ptr<CDBBulkLoad> NewBulkLoad();
+
+    /**
+     * Add the entries of a bulk load to the database, all at once.
+     *
+     * @returns false, leaving the database unchanged, if the keys of the bulk
+     *          load were not increasing or overlap writes made since it was
+     *          started
+     */
+    bool WriteBulkLoad(CDBBulkLoad& bulk_load);
+
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
-    CDBIterator* NewIterator();
+    /** Return an iterator over the database, or over snapshot if it is set. */
+    CDBIterator* NewIterator(const CDBSnapshot* snapshot = nullptr);
+
+    /** Capture the current state of the database for reads with Read(). */
+    std::unique_ptr<CDBSnapshot> NewSnapshot() const;
 
     /**
      * Return true if the database managed by this class contains no entries.
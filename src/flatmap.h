@@ -0,0 +1,457 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_FLATMAP_H
+#define BITCOIN_FLATMAP_H
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Open-addressing hash map with inline entries.
+ *
+ * The table is a single allocation holding `capacity` slots followed by one
+ * control byte per slot. A control byte is either EMPTY, DELETED, or the low
+ * 7 bits of the hash of the key stored in the slot. Slots are grouped in
+ * aligned groups of GROUP_SIZE, and a lookup compares the 7-bit hash against a
+ * whole group of control bytes at once (with SSE2 where available), only
+ * touching slots whose control byte matches. Probing moves between groups with
+ * a triangular sequence, which visits every group because the number of groups
+ * is a power of two.
+ *
+ * Compared to std::unordered_map this avoids one allocation and one pointer
+ * chase per element, at the cost of weaker iterator and reference stability:
+ *
+ * - Inserting may grow the table, which moves every element and invalidates
+ *   all iterators and references.
+ * - Erasing never moves elements; it only invalidates iterators and references
+ *   to the erased element. This makes erasing while iterating safe.
+ *
+ * The interface is the subset of std::unordered_map used by the coins cache.
+ */
+template <typename Key, typename T, typename Hash, typename KeyEqual = std::equal_to<Key>>
+class FlatMap
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using size_type = size_t;
+
+    static constexpr size_t GROUP_SIZE{16};
+
+private:
+    using ctrl_t = int8_t;
+
+    static constexpr ctrl_t CTRL_EMPTY{-128};
+    static constexpr ctrl_t CTRL_DELETED{-2};
+
+    static_assert(alignof(value_type) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+    /** View on the control bytes of one group, yielding bitmasks of matching positions. */
+    class Group
+    {
+#if defined(__SSE2__)
+        __m128i m_ctrl;
+
+    public:
+        explicit Group(const ctrl_t* pos) : m_ctrl{_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))} {}
+        uint32_t Match(ctrl_t h2) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl)); }
+        uint32_t MatchEmpty() const { return Match(CTRL_EMPTY); }
+        //! EMPTY and DELETED are the only control values with the sign bit set.
+        uint32_t MatchEmptyOrDeleted() const { return _mm_movemask_epi8(m_ctrl); }
+#else
+        const ctrl_t* m_ctrl;
+
+    public:
+        explicit Group(const ctrl_t* pos) : m_ctrl{pos} {}
+        uint32_t Match(ctrl_t h2) const
+        {
+            uint32_t mask{0};
+            for (size_t i = 0; i < GROUP_SIZE; ++i) mask |= uint32_t{m_ctrl[i] == h2} << i;
+            return mask;
+        }
+        uint32_t MatchEmpty() const { return Match(CTRL_EMPTY); }
+        uint32_t MatchEmptyOrDeleted() const
+        {
+            uint32_t mask{0};
+            for (size_t i = 0; i < GROUP_SIZE; ++i) mask |= uint32_t{m_ctrl[i] < 0} << i;
+            return mask;
+        }
+#endif
+    };
+
+    template <bool IS_CONST>
+    class Iter
+    {
+        friend class FlatMap;
+        template <bool>
+        friend class Iter;
+
+        using slot_ptr = std::conditional_t<IS_CONST, const typename FlatMap::value_type*, typename FlatMap::value_type*>;
+
+        const ctrl_t* m_ctrl{nullptr};
+        const ctrl_t* m_ctrl_end{nullptr};
+        slot_ptr m_slot{nullptr};
+
+        Iter(const ctrl_t* ctrl, const ctrl_t* ctrl_end, slot_ptr slot) : m_ctrl{ctrl}, m_ctrl_end{ctrl_end}, m_slot{slot} {}
+
+        void SkipFree()
+        {
+            while (m_ctrl != m_ctrl_end && *m_ctrl < 0) {
+                ++m_ctrl;
+                ++m_slot;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename FlatMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = slot_ptr;
+        using reference = std::conditional_t<IS_CONST, const typename FlatMap::value_type&, typename FlatMap::value_type&>;
+
+        Iter() = default;
+        template <bool OTHER_CONST>
+            requires(IS_CONST && !OTHER_CONST)
+        Iter(const Iter<OTHER_CONST>& other) : m_ctrl{other.m_ctrl}, m_ctrl_end{other.m_ctrl_end}, m_slot{other.m_slot} {}
+
+        reference operator*() const { return *m_slot; }
+        pointer operator->() const { return m_slot; }
+
+        Iter& operator++()
+        {
+            ++m_ctrl;
+            ++m_slot;
+            SkipFree();
+            return *this;
+        }
+        Iter operator++(int)
+        {
+            Iter copy{*this};
+            ++*this;
+            return copy;
+        }
+
+        template <bool OTHER_CONST>
+        bool operator==(const Iter<OTHER_CONST>& other) const { return m_ctrl == other.m_ctrl; }
+    };
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+
+private:
+    value_type* m_slots{nullptr};
+    ctrl_t* m_ctrl{nullptr};
+    //! Number of slots; zero or a power of two that is at least GROUP_SIZE.
+    size_t m_capacity{0};
+    size_t m_size{0};
+    //! Number of EMPTY slots that may still be filled before the table must grow.
+    size_t m_growth_left{0};
+    [[no_unique_address]] Hash m_hash;
+    [[no_unique_address]] KeyEqual m_equal;
+
+    static constexpr size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+    static size_t CapacityFor(size_t count)
+    {
+        size_t capacity{GROUP_SIZE};
+        while (MaxLoad(capacity) < count) capacity *= 2;
+        return capacity;
+    }
+
+    static size_t AllocationSize(size_t capacity) { return capacity * (sizeof(value_type) + sizeof(ctrl_t)); }
+
+    static constexpr ctrl_t H2(size_t hash) { return static_cast<ctrl_t>(hash & 0x7f); }
+    static constexpr size_t H1(size_t hash) { return hash >> 7; }
+
+    size_t GroupMask() const { return m_capacity / GROUP_SIZE - 1; }
+
+    iterator MakeIter(size_t pos) { return iterator{m_ctrl + pos, m_ctrl + m_capacity, m_slots + pos}; }
+    const_iterator MakeIter(size_t pos) const { return const_iterator{m_ctrl + pos, m_ctrl + m_capacity, m_slots + pos}; }
+
+    /** Return the position of the element with the given key, or m_capacity if absent. */
+    size_t FindPos(const Key& key) const
+    {
+        if (m_capacity == 0) return 0;
+        const size_t hash{m_hash(key)};
+        const ctrl_t h2{H2(hash)};
+        size_t group{H1(hash) & GroupMask()};
+        for (size_t step{1};; ++step) {
+            const size_t base{group * GROUP_SIZE};
+            const Group g{m_ctrl + base};
+            for (uint32_t match{g.Match(h2)}; match != 0; match &= match - 1) {
+                const size_t pos{base + std::countr_zero(match)};
+                if (m_equal(m_slots[pos].first, key)) return pos;
+            }
+            if (g.MatchEmpty()) return m_capacity;
+            group = (group + step) & GroupMask();
+        }
+    }
+
+    /** Return the first EMPTY or DELETED position on the probe sequence of hash. */
+    size_t FindFreePos(size_t hash) const
+    {
+        size_t group{H1(hash) & GroupMask()};
+        for (size_t step{1};; ++step) {
+            const uint32_t free{Group{m_ctrl + group * GROUP_SIZE}.MatchEmptyOrDeleted()};
+            if (free != 0) return group * GROUP_SIZE + std::countr_zero(free);
+            group = (group + step) & GroupMask();
+        }
+    }
+
+    struct InsertPos {
+        size_t pos;
+        bool found;
+        ctrl_t h2;
+    };
+
+    /**
+     * Look up key, and if it is absent, reserve a free position for it.
+     * Returns the position, whether the key was found there, and its control byte.
+     */
+    InsertPos FindOrPrepareInsert(const Key& key)
+    {
+        if (m_capacity == 0) Rehash(GROUP_SIZE);
+        const size_t hash{m_hash(key)};
+        const ctrl_t h2{H2(hash)};
+        size_t group{H1(hash) & GroupMask()};
+        for (size_t step{1};; ++step) {
+            const size_t base{group * GROUP_SIZE};
+            const Group g{m_ctrl + base};
+            for (uint32_t match{g.Match(h2)}; match != 0; match &= match - 1) {
+                const size_t pos{base + std::countr_zero(match)};
+                if (m_equal(m_slots[pos].first, key)) return {pos, true, h2};
+            }
+            if (g.MatchEmpty()) break;
+            group = (group + step) & GroupMask();
+        }
+        size_t pos{FindFreePos(hash)};
+        if (m_growth_left == 0 && m_ctrl[pos] == CTRL_EMPTY) {
+            // Only reusing a DELETED slot is free; filling an EMPTY one requires headroom.
+            // Rehash in place if tombstones make up a large part of the load, else grow.
+            Rehash(m_size * 2 <= MaxLoad(m_capacity) ? m_capacity : m_capacity * 2);
+            pos = FindFreePos(hash);
+        }
+        return {pos, false, h2};
+    }
+
+    /** Mark a position obtained from FindOrPrepareInsert as holding a newly constructed element. */
+    void CommitInsert(const InsertPos& ins)
+    {
+        if (m_ctrl[ins.pos] == CTRL_EMPTY) --m_growth_left;
+        m_ctrl[ins.pos] = ins.h2;
+        ++m_size;
+    }
+
+    void Rehash(size_t new_capacity)
+    {
+        assert(new_capacity >= GROUP_SIZE && std::has_single_bit(new_capacity) && MaxLoad(new_capacity) >= m_size);
+        value_type* old_slots{m_slots};
+        ctrl_t* old_ctrl{m_ctrl};
+        const size_t old_capacity{m_capacity};
+
+        m_slots = static_cast<value_type*>(::operator new(AllocationSize(new_capacity)));
+        m_ctrl = reinterpret_cast<ctrl_t*>(m_slots + new_capacity);
+        m_capacity = new_capacity;
+        std::memset(m_ctrl, CTRL_EMPTY, m_capacity);
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] < 0) continue;
+            const size_t hash{m_hash(old_slots[i].first)};
+            const size_t pos{FindFreePos(hash)};
+            ::new (m_slots + pos) value_type(std::move(old_slots[i]));
+            m_ctrl[pos] = H2(hash);
+            old_slots[i].~value_type();
+        }
+        m_growth_left = MaxLoad(m_capacity) - m_size;
+        if (old_slots) ::operator delete(old_slots);
+    }
+
+    void DestroyAll()
+    {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_t i = 0; i < m_capacity; ++i) {
+                if (m_ctrl[i] >= 0) m_slots[i].~value_type();
+            }
+        }
+    }
+
+    void Release()
+    {
+        DestroyAll();
+        if (m_slots) ::operator delete(m_slots);
+        m_slots = nullptr;
+        m_ctrl = nullptr;
+        m_capacity = m_size = m_growth_left = 0;
+    }
+
+    template <typename Construct>
+    std::pair<iterator, bool> EmplaceImpl(const Key& key, Construct&& construct)
+    {
+        const InsertPos ins{FindOrPrepareInsert(key)};
+        if (!ins.found) {
+            construct(m_slots + ins.pos);
+            CommitInsert(ins);
+        }
+        return {MakeIter(ins.pos), !ins.found};
+    }
+
+public:
+    explicit FlatMap(size_t bucket_count = 0, const Hash& hash = Hash{}, const KeyEqual& equal = KeyEqual{})
+        : m_hash{hash}, m_equal{equal}
+    {
+        if (bucket_count > 0) Rehash(CapacityFor(bucket_count));
+    }
+
+    FlatMap(const FlatMap&) = delete;
+    FlatMap& operator=(const FlatMap&) = delete;
+
+    FlatMap(FlatMap&& other) noexcept
+        : m_slots{std::exchange(other.m_slots, nullptr)},
+          m_ctrl{std::exchange(other.m_ctrl, nullptr)},
+          m_capacity{std::exchange(other.m_capacity, 0)},
+          m_size{std::exchange(other.m_size, 0)},
+          m_growth_left{std::exchange(other.m_growth_left, 0)},
+          m_hash{other.m_hash},
+          m_equal{other.m_equal} {}
+
+    FlatMap& operator=(FlatMap&& other) noexcept
+    {
+        if (this != &other) {
+            Release();
+            m_slots = std::exchange(other.m_slots, nullptr);
+            m_ctrl = std::exchange(other.m_ctrl, nullptr);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            m_size = std::exchange(other.m_size, 0);
+            m_growth_left = std::exchange(other.m_growth_left, 0);
+            m_hash = other.m_hash;
+            m_equal = other.m_equal;
+        }
+        return *this;
+    }
+
+    ~FlatMap() { Release(); }
+
+    iterator begin()
+    {
+        iterator it{MakeIter(0)};
+        it.SkipFree();
+        return it;
+    }
+    const_iterator begin() const
+    {
+        const_iterator it{MakeIter(0)};
+        it.SkipFree();
+        return it;
+    }
+    iterator end() { return MakeIter(m_capacity); }
+    const_iterator end() const { return MakeIter(m_capacity); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t bucket_count() const { return m_capacity; }
+    //! Bytes allocated for the table, for memory usage accounting.
+    size_t allocated_memory() const { return m_capacity == 0 ? 0 : AllocationSize(m_capacity); }
+
+    iterator find(const Key& key) { return MakeIter(FindPos(key)); }
+    const_iterator find(const Key& key) const { return MakeIter(FindPos(key)); }
+    size_t count(const Key& key) const { return FindPos(key) != m_capacity; }
+    bool contains(const Key& key) const { return FindPos(key) != m_capacity; }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        return EmplaceImpl(key, [&](value_type* slot) {
+            ::new (slot) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+    }
+
+    template <typename... KeyArgs, typename... ValueArgs>
+    std::pair<iterator, bool> emplace(std::piecewise_construct_t, std::tuple<KeyArgs...> key_args, std::tuple<ValueArgs...> value_args)
+    {
+        const Key key{std::make_from_tuple<Key>(std::move(key_args))};
+        return EmplaceImpl(key, [&](value_type* slot) {
+            ::new (slot) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::move(value_args));
+        });
+    }
+
+    template <typename K, typename V>
+    std::pair<iterator, bool> emplace(K&& key, V&& value)
+    {
+        return try_emplace(Key(std::forward<K>(key)), std::forward<V>(value));
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value) { return try_emplace(value.first, std::move(value.second)); }
+
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    /** Erase the element at it, returning an iterator to the next element. Other elements are not moved. */
+    iterator erase(const_iterator it)
+    {
+        const size_t pos(it.m_ctrl - m_ctrl);
+        m_slots[pos].~value_type();
+        --m_size;
+        // If the group still has an EMPTY slot, no probe sequence ever continued past it,
+        // so this slot can become EMPTY too instead of leaving a tombstone.
+        const size_t base{pos & ~(GROUP_SIZE - 1)};
+        if (Group{m_ctrl + base}.MatchEmpty()) {
+            m_ctrl[pos] = CTRL_EMPTY;
+            ++m_growth_left;
+        } else {
+            m_ctrl[pos] = CTRL_DELETED;
+        }
+        iterator next{MakeIter(pos)};
+        next.SkipFree();
+        return next;
+    }
+    iterator erase(iterator it) { return erase(const_iterator{it}); }
+
+    size_t erase(const Key& key)
+    {
+        const size_t pos{FindPos(key)};
+        if (pos == m_capacity) return 0;
+        erase(MakeIter(pos));
+        return 1;
+    }
+
+    /** Remove all elements, keeping the allocated table. */
+    void clear()
+    {
+        if (m_capacity == 0) return;
+        DestroyAll();
+        std::memset(m_ctrl, CTRL_EMPTY, m_capacity);
+        m_size = 0;
+        m_growth_left = MaxLoad(m_capacity);
+    }
+
+    /** Make room for at least count elements without further growth. */
+    void reserve(size_t count)
+    {
+        if (count > m_size + m_growth_left) Rehash(CapacityFor(count));
+    }
+
+    hasher hash_function() const { return m_hash; }
+    key_equal key_eq() const { return m_equal; }
+};
+
+#endif // BITCOIN_FLATMAP_H
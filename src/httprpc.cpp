@@ -16,9 +16,12 @@
 #include <walletinitinterface.h>
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <vector>
@@ -209,13 +212,52 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
             // 2.0 behavior is to catch exceptions and return HTTP success with
             // RPC errors, as long as there is not an actual HTTP server error.
             const bool catch_errors{jreq.m_json_version == JSONRPCVersion::V2};
-            reply = JSONRPCExec(jreq, catch_errors);
+            // Let long polls give the worker thread back while they wait
+            bool parked{false};
+            if (req->CanPark()) {
+                jreq.park = [&](std::function<bool()> ready, std::optional<std::chrono::milliseconds> timeout, std::function<UniValue()> result) {
+                    parked = true;
+                    req->Park(std::move(ready), timeout, [result = std::move(result), id = jreq.id, version = jreq.m_json_version, notification = jreq.IsNotification()](HTTPRequest* req) {
+                        if (notification) {
+                            req->WriteReply(HTTP_NO_CONTENT);
+                            return;
+                        }
+                        req->WriteHeader("Content-Type", "application/json");
+                        req->WriteReply(HTTP_OK, JSONRPCReplyObj(result(), NullUniValue, id, version).write() + "\n");
+                    });
+                };
+            }
+            // Let methods with large results write them straight into the reply
+            bool written{false};
+            std::string reply_after;
+            jreq.write_result = [&](const std::function<void(JSONWriter&)>& write) {
+                auto [before, after]{JSONRPCReplyEnvelope(jreq.id, jreq.m_json_version)};
+                req->WriteReplyJSON(before, write);
+                reply_after = std::move(after);
+                written = true;
+            };
+            try {
+                reply = JSONRPCExec(jreq, catch_errors);
+            } catch (...) {
+                if (written) req->ClearReplyBody();
+                throw;
+            }
+            if (parked) return true;
+            if (written && (jreq.IsNotification() || !reply.find_value("error").isNull())) {
+                req->ClearReplyBody();
+                written = false;
+            }
 
             if (jreq.IsNotification()) {
                 // Even though we do execute notifications, we do not respond to them
                 req->WriteReply(HTTP_NO_CONTENT);
                 return true;
             }
+            if (written) {
+                req->WriteHeader("Content-Type", "application/json");
+                req->WriteReply(HTTP_OK, reply_after + "\n");
+                return true;
+            }
 
         // array of requests
         } else if (valRequest.isArray()) {
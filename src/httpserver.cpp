@@ -8,6 +8,7 @@
 
 #include <chainparamsbase.h>
 #include <common/args.h>
+#include <common/json_writer.h>
 #include <compat/compat.h>
 #include <logging.h>
 #include <netbase.h>
@@ -18,15 +19,18 @@
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
 #include <util/threadnames.h>
+#include <util/time.h>
 #include <util/translation.h>
 
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <deque>
+#include <list>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include <sys/types.h>
@@ -37,6 +41,7 @@
 #include <event2/http.h>
 #include <event2/http_struct.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 #include <event2/thread.h>
 #include <event2/util.h>
 
@@ -53,10 +58,7 @@ public:
         req(std::move(_req)), path(_path), func(_func)
     {
     }
-    void operator()() override
-    {
-        func(req.get(), path);
-    }
+    void operator()() override;
 
     std::unique_ptr<HTTPRequest> req;
 
@@ -65,6 +67,30 @@ private:
     HTTPRequestHandler func;
 };
 
+/** Request waiting for a worker thread to resume it, see HTTPRequest::Park() */
+struct ParkedHTTPRequest
+{
+    std::unique_ptr<HTTPRequest> req;
+    std::function<bool()> ready;
+    HTTPRequest::Continuation resume;
+    //! Resumes the request once its timeout elapsed
+    std::unique_ptr<HTTPEvent> timer;
+};
+
+/** Work item resuming a parked request */
+class HTTPResumeItem final : public HTTPClosure
+{
+public:
+    explicit HTTPResumeItem(std::unique_ptr<ParkedHTTPRequest> parked) : m_parked(std::move(parked)) {}
+    void operator()() override
+    {
+        m_parked->resume(m_parked->req.get());
+    }
+
+private:
+    std::unique_ptr<ParkedHTTPRequest> m_parked;
+};
+
 /** Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
  */
@@ -85,11 +111,11 @@ public:
     /** Precondition: worker threads have all stopped (they have been joined).
      */
     ~WorkQueue() = default;
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    /** Enqueue a work item, beyond the maximum depth if ignore_depth is set */
+    bool Enqueue(WorkItem* item, bool ignore_depth = false) EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
         LOCK(cs);
-        if (!running || queue.size() >= maxDepth) {
+        if (!running || (queue.size() >= maxDepth && !ignore_depth)) {
             return false;
         }
         queue.emplace_back(std::unique_ptr<WorkItem>(item));
@@ -133,12 +159,20 @@ struct HTTPPathHandler
     HTTPRequestHandler handler;
 };
 
+/** libevent event loop with the HTTP server handling the connections it accepts */
+struct HTTPEventLoop
+{
+    struct event_base* base{nullptr};
+    struct evhttp* http{nullptr};
+    //! Listening sockets, shared by all event loops
+    std::vector<evhttp_bound_socket*> bound_sockets;
+    std::thread thread;
+};
+
 /** HTTP module state */
 
-//! libevent event loop
-static struct event_base* eventBase = nullptr;
-//! HTTP server
-static struct evhttp* eventHTTP = nullptr;
+//! Event loops, the first one owns the listening sockets and runs timers and custom events
+static std::vector<HTTPEventLoop> g_event_loops;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
 //! Work queue for handling longer requests off the event loop thread
@@ -146,8 +180,11 @@ static std::unique_ptr<WorkQueue<HTTPClosure>> g_work_queue{nullptr};
 //! Handlers for (sub)paths
 static GlobalMutex g_httppathhandlers_mutex;
 static std::vector<HTTPPathHandler> pathHandlers GUARDED_BY(g_httppathhandlers_mutex);
-//! Bound listening sockets
-static std::vector<evhttp_bound_socket *> boundSockets;
+//! Requests parked by their handler
+static GlobalMutex g_parked_mutex;
+static std::list<std::unique_ptr<ParkedHTTPRequest>> g_parked_requests GUARDED_BY(g_parked_mutex);
+//! Whether requests can be parked, which stops once the server is interrupted
+static bool g_parking_allowed GUARDED_BY(g_parked_mutex){false};
 
 /**
  * @brief Helps keep track of open `evhttp_connection`s with active `evhttp_requests`
@@ -204,6 +241,65 @@ public:
 //! Track active requests
 static HTTPRequestTracker g_requests;
 
+/** Hand the parked requests matching a predicate back to the worker threads */
+static void ResumeHTTPRequests(const std::function<bool(const ParkedHTTPRequest&)>& match) EXCLUSIVE_LOCKS_REQUIRED(!g_parked_mutex)
+{
+    std::vector<std::unique_ptr<ParkedHTTPRequest>> resumed;
+    {
+        LOCK(g_parked_mutex);
+        for (auto it{g_parked_requests.begin()}; it != g_parked_requests.end();) {
+            if (match(**it)) {
+                resumed.push_back(std::move(*it));
+                it = g_parked_requests.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& parked : resumed) {
+        auto item{std::make_unique<HTTPResumeItem>(std::move(parked))};
+        // Resumed requests were accepted already, so don't subject them to the queue depth
+        if (g_work_queue->Enqueue(item.get(), /*ignore_depth=*/true)) {
+            item.release(); /* if true, queue took ownership */
+        } else {
+            (*item)();
+        }
+    }
+}
+
+void HTTPWorkItem::operator()()
+{
+    func(req.get(), path);
+    if (!req->m_parking) return;
+
+    auto parked{std::make_unique<ParkedHTTPRequest>()};
+    parked->ready = std::move(req->m_parking->ready);
+    parked->resume = std::move(req->m_parking->resume);
+    const auto timeout{req->m_parking->timeout};
+    req->m_parking.reset();
+    parked->req = std::move(req);
+    if (timeout) {
+        const ParkedHTTPRequest* ptr{parked.get()};
+        parked->timer = std::make_unique<HTTPEvent>(EventBase(), false, [ptr] {
+            ResumeHTTPRequests([ptr](const ParkedHTTPRequest& p) { return &p == ptr; });
+        });
+    }
+    {
+        LOCK(g_parked_mutex);
+        // Checking readiness while holding the lock makes sure that a concurrent
+        // WakeHTTPRequests() either sees the request or happens before this check.
+        if (g_parking_allowed && !parked->ready()) {
+            if (parked->timer) {
+                struct timeval tv{MillisToTimeval(*timeout)};
+                parked->timer->trigger(&tv);
+            }
+            g_parked_requests.push_back(std::move(parked));
+            return;
+        }
+    }
+    parked->resume(parked->req.get());
+}
+
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr& netaddr)
 {
@@ -344,9 +440,9 @@ static void http_reject_request_cb(struct evhttp_request* req, void*)
 }
 
 /** Event dispatcher thread */
-static void ThreadHTTP(struct event_base* base)
+static void ThreadHTTP(struct event_base* base, int loop_num)
 {
-    util::ThreadRename("http");
+    util::ThreadRename(loop_num == 0 ? "http" : strprintf("http.%i", loop_num));
     LogPrint(BCLog::HTTP, "Entering http event loop\n");
     event_base_dispatch(base);
     // Event loop will be interrupted by InterruptHTTPServer()
@@ -354,7 +450,7 @@ static void ThreadHTTP(struct event_base* base)
 }
 
 /** Bind HTTP server to specified addresses */
-static bool HTTPBindAddresses(struct evhttp* http)
+static bool HTTPBindAddresses(HTTPEventLoop& loop)
 {
     uint16_t http_port{static_cast<uint16_t>(gArgs.GetIntArg("-rpcport", BaseParams().RPCPort()))};
     std::vector<std::pair<std::string, uint16_t>> endpoints;
@@ -381,18 +477,36 @@ static bool HTTPBindAddresses(struct evhttp* http)
     // Bind addresses
     for (std::vector<std::pair<std::string, uint16_t> >::iterator i = endpoints.begin(); i != endpoints.end(); ++i) {
         LogPrintf("Binding RPC on address %s port %i\n", i->first, i->second);
-        evhttp_bound_socket *bind_handle = evhttp_bind_socket_with_handle(http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
+        evhttp_bound_socket *bind_handle = evhttp_bind_socket_with_handle(loop.http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
         if (bind_handle) {
             const std::optional<CNetAddr> addr{LookupHost(i->first, false)};
             if (i->first.empty() || (addr.has_value() && addr->IsBindAny())) {
                 LogPrintf("WARNING: the RPC server is not safe to expose to untrusted networks such as the public internet\n");
             }
-            boundSockets.push_back(bind_handle);
+            loop.bound_sockets.push_back(bind_handle);
         } else {
             LogPrintf("Binding RPC on address %s port %i failed.\n", i->first, i->second);
         }
     }
-    return !boundSockets.empty();
+    return !loop.bound_sockets.empty();
+}
+
+/** Accept connections on the sockets bound by another event loop too */
+static bool HTTPShareBoundSockets(const HTTPEventLoop& from, HTTPEventLoop& loop)
+{
+    for (evhttp_bound_socket* bound_socket : from.bound_sockets) {
+        // The socket is listening already (negative backlog) and stays owned by
+        // the loop that bound it (no LEV_OPT_CLOSE_ON_FREE).
+        evconnlistener* listener{evconnlistener_new(loop.base, nullptr, nullptr, /*flags=*/0, /*backlog=*/-1, evhttp_bound_socket_get_fd(bound_socket))};
+        if (!listener) return false;
+        evhttp_bound_socket* handle{evhttp_bind_listener(loop.http, listener)};
+        if (!handle) {
+            evconnlistener_free(listener);
+            return false;
+        }
+        loop.bound_sockets.push_back(handle);
+    }
+    return true;
 }
 
 /** Simple wrapper to set thread name and run work queue */
@@ -423,6 +537,16 @@ static void libevent_log_cb(int severity, const char *msg)
     LogPrintLevel(BCLog::LIBEVENT, level, "%s\n", msg);
 }
 
+/** Free event loops that are not running, the ones sharing sockets of earlier loops first */
+static void FreeEventLoops(std::vector<HTTPEventLoop>& loops)
+{
+    for (auto loop{loops.rbegin()}; loop != loops.rend(); ++loop) {
+        if (loop->http) evhttp_free(loop->http);
+        if (loop->base) event_base_free(loop->base);
+    }
+    loops.clear();
+}
+
 bool InitHTTPServer(const util::SignalInterrupt& interrupt)
 {
     if (!InitHTTPAllowList())
@@ -439,34 +563,51 @@ bool InitHTTPServer(const util::SignalInterrupt& interrupt)
     evthread_use_pthreads();
 #endif
 
-    raii_event_base base_ctr = obtain_event_base();
+    const int event_threads = std::max((long)gArgs.GetIntArg("-rpceventthreads", DEFAULT_HTTP_EVENT_THREADS), 1L);
+    std::vector<HTTPEventLoop> event_loops(event_threads);
+    for (HTTPEventLoop& loop : event_loops) {
+        raii_event_base base_ctr = obtain_event_base();
+
+        /* Create a new evhttp object to handle requests. */
+        raii_evhttp http_ctr = obtain_evhttp(base_ctr.get());
+        struct evhttp* http = http_ctr.get();
+        if (!http) {
+            LogPrintf("couldn't create evhttp. Exiting.\n");
+            FreeEventLoops(event_loops);
+            return false;
+        }
 
-    /* Create a new evhttp object to handle requests. */
-    raii_evhttp http_ctr = obtain_evhttp(base_ctr.get());
-    struct evhttp* http = http_ctr.get();
-    if (!http) {
-        LogPrintf("couldn't create evhttp. Exiting.\n");
-        return false;
-    }
+        evhttp_set_timeout(http, gArgs.GetIntArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
+        evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
+        evhttp_set_max_body_size(http, MAX_SIZE);
+        evhttp_set_gencb(http, http_request_cb, (void*)&interrupt);
 
-    evhttp_set_timeout(http, gArgs.GetIntArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
-    evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
-    evhttp_set_max_body_size(http, MAX_SIZE);
-    evhttp_set_gencb(http, http_request_cb, (void*)&interrupt);
+        // transfer ownership to the event loop via .release()
+        loop.http = http_ctr.release();
+        loop.base = base_ctr.release();
+    }
 
-    if (!HTTPBindAddresses(http)) {
+    if (!HTTPBindAddresses(event_loops.front())) {
         LogPrintf("Unable to bind any endpoint for RPC server\n");
+        FreeEventLoops(event_loops);
         return false;
     }
+    // All event loops accept connections on the same sockets, rather than each binding
+    // its own with SO_REUSEPORT, which would let other processes bind the RPC port too.
+    for (size_t i{1}; i < event_loops.size(); ++i) {
+        if (!HTTPShareBoundSockets(event_loops.front(), event_loops[i])) {
+            LogPrintf("Unable to share the RPC server sockets with event loop %d\n", i);
+            FreeEventLoops(event_loops);
+            return false;
+        }
+    }
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
     LogDebug(BCLog::HTTP, "creating work queue of depth %d\n", workQueueDepth);
 
     g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
-    // transfer ownership to eventBase/HTTP via .release()
-    eventBase = base_ctr.release();
-    eventHTTP = http_ctr.release();
+    g_event_loops = std::move(event_loops);
     return true;
 }
 
@@ -478,14 +619,16 @@ void UpdateHTTPServerLogging(bool enable) {
     }
 }
 
-static std::thread g_thread_http;
 static std::vector<std::thread> g_thread_http_workers;
 
 void StartHTTPServer()
 {
     int rpcThreads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogInfo("Starting HTTP server with %d worker threads\n", rpcThreads);
-    g_thread_http = std::thread(ThreadHTTP, eventBase);
+    LogInfo("Starting HTTP server with %d event threads and %d worker threads\n", g_event_loops.size(), rpcThreads);
+    for (size_t i{0}; i < g_event_loops.size(); ++i) {
+        g_event_loops[i].thread = std::thread(ThreadHTTP, g_event_loops[i].base, i);
+    }
+    WITH_LOCK(g_parked_mutex, g_parking_allowed = true);
 
     for (int i = 0; i < rpcThreads; i++) {
         g_thread_http_workers.emplace_back(HTTPWorkQueueRun, g_work_queue.get(), i);
@@ -495,11 +638,14 @@ void StartHTTPServer()
 void InterruptHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Interrupting HTTP server\n");
-    if (eventHTTP) {
+    for (const HTTPEventLoop& loop : g_event_loops) {
         // Reject requests on current connections
-        evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
+        evhttp_set_gencb(loop.http, http_reject_request_cb, nullptr);
     }
+    WITH_LOCK(g_parked_mutex, g_parking_allowed = false);
     if (g_work_queue) {
+        // Let the parked requests finish, e.g. long polls return the current state
+        ResumeHTTPRequests([](const ParkedHTTPRequest&) { return true; });
         g_work_queue->Interrupt();
     }
 }
@@ -514,32 +660,40 @@ void StopHTTPServer()
         }
         g_thread_http_workers.clear();
     }
-    // Unlisten sockets, these are what make the event loop running, which means
-    // that after this and all connections are closed the event loop will quit.
-    for (evhttp_bound_socket *socket : boundSockets) {
-        evhttp_del_accept_socket(eventHTTP, socket);
+    // Unlisten sockets, these are what make the event loops running, which means
+    // that after this and all connections are closed the event loops will quit.
+    // The first loop closes the sockets, so it has to unlisten last.
+    for (auto loop{g_event_loops.rbegin()}; loop != g_event_loops.rend(); ++loop) {
+        for (evhttp_bound_socket* socket : loop->bound_sockets) {
+            evhttp_del_accept_socket(loop->http, socket);
+        }
+        loop->bound_sockets.clear();
     }
-    boundSockets.clear();
     {
         if (const auto n_connections{g_requests.CountActiveConnections()}; n_connections != 0) {
             LogPrint(BCLog::HTTP, "Waiting for %d connections to stop HTTP server\n", n_connections);
         }
         g_requests.WaitUntilEmpty();
     }
-    if (eventHTTP) {
+    for (HTTPEventLoop& loop : g_event_loops) {
         // Schedule a callback to call evhttp_free in the event base thread, so
         // that evhttp_free does not need to be called again after the handling
         // of unfinished request connections that follows.
-        event_base_once(eventBase, -1, EV_TIMEOUT, [](evutil_socket_t, short, void*) {
-            evhttp_free(eventHTTP);
-            eventHTTP = nullptr;
-        }, nullptr, nullptr);
-    }
-    if (eventBase) {
-        LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
-        if (g_thread_http.joinable()) g_thread_http.join();
-        event_base_free(eventBase);
-        eventBase = nullptr;
+        event_base_once(loop.base, -1, EV_TIMEOUT, [](evutil_socket_t, short, void* arg) {
+            HTTPEventLoop& loop{*static_cast<HTTPEventLoop*>(arg)};
+            evhttp_free(loop.http);
+            loop.http = nullptr;
+        }, &loop, nullptr);
+    }
+    if (!g_event_loops.empty()) {
+        LogPrint(BCLog::HTTP, "Waiting for HTTP event threads to exit\n");
+        for (HTTPEventLoop& loop : g_event_loops) {
+            if (loop.thread.joinable()) loop.thread.join();
+        }
+        for (HTTPEventLoop& loop : g_event_loops) {
+            event_base_free(loop.base);
+        }
+        g_event_loops.clear();
     }
     g_work_queue.reset();
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
@@ -547,7 +701,12 @@ void StopHTTPServer()
 
 struct event_base* EventBase()
 {
-    return eventBase;
+    return g_event_loops.empty() ? nullptr : g_event_loops.front().base;
+}
+
+void WakeHTTPRequests()
+{
+    ResumeHTTPRequests([](const ParkedHTTPRequest& parked) { return parked.ready(); });
 }
 
 static void httpevent_callback_fn(evutil_socket_t, short, void* data)
@@ -634,18 +793,23 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  * Replies must be sent in the main loop in the main http thread,
  * this cannot be done from worker threads.
  */
-void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
+void HTTPRequest::WriteReply(int nStatus, Span<const std::byte> reply)
 {
     assert(!replySent && req);
+    // A handler that parked the request but replied anyway, e.g. on error, is done with it
+    m_parking.reset();
     if (m_interrupt) {
         WriteHeader("Connection", "close");
     }
     // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
+    evbuffer_add(evb, reply.data(), reply.size());
+    // The reply has to be sent from the event loop that accepted the connection
+    evhttp_connection* conn{evhttp_request_get_connection(req)};
+    struct event_base* base{conn ? evhttp_connection_get_base(conn) : EventBase()};
     auto req_copy = req;
-    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+    HTTPEvent* ev = new HTTPEvent(base, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
         // Re-enable reading from the socket. This is the second part of the libevent
         // workaround above.
@@ -664,6 +828,42 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+void HTTPRequest::WriteReplyJSON(std::string_view prefix, const std::function<void(JSONWriter&)>& write)
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    std::string buffer{prefix};
+    buffer.reserve(JSONTextWriter::FLUSH_SIZE + prefix.size());
+    JSONTextWriter writer{buffer, [evb](std::string_view text) { evbuffer_add(evb, text.data(), text.size()); }};
+    try {
+        write(writer);
+        writer.Flush();
+    } catch (...) {
+        ClearReplyBody();
+        throw;
+    }
+}
+
+void HTTPRequest::ClearReplyBody()
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_drain(evb, evbuffer_get_length(evb));
+}
+
+bool HTTPRequest::CanPark() const
+{
+    return g_event_loops.size() > 1;
+}
+
+void HTTPRequest::Park(std::function<bool()> ready, std::optional<std::chrono::milliseconds> timeout, Continuation resume)
+{
+    assert(!replySent && !m_parking && CanPark());
+    m_parking = Parking{std::move(ready), timeout, std::move(resume)};
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
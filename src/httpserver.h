@@ -5,15 +5,21 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <span.h>
+
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace util {
 class SignalInterrupt;
 } // namespace util
 
 static const int DEFAULT_HTTP_THREADS=4;
+static const int DEFAULT_HTTP_EVENT_THREADS=1;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
 
@@ -21,6 +27,7 @@ struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+class JSONWriter;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -54,16 +61,32 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base* EventBase();
 
+/** Resume the parked requests that are ready, see HTTPRequest::Park(). */
+void WakeHTTPRequests();
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
 class HTTPRequest
 {
+public:
+    //! Continues handling a parked request on a worker thread, see Park().
+    using Continuation = std::function<void(HTTPRequest* req)>;
+
 private:
     struct evhttp_request* req;
     const util::SignalInterrupt& m_interrupt;
     bool replySent;
 
+    struct Parking {
+        std::function<bool()> ready;
+        std::optional<std::chrono::milliseconds> timeout;
+        Continuation resume;
+    };
+    //! Set by Park(), taken over by the work item once the handler returns
+    std::optional<Parking> m_parking;
+    friend class HTTPWorkItem;
+
 public:
     explicit HTTPRequest(struct evhttp_request* req, const util::SignalInterrupt& interrupt, bool replySent = false);
     ~HTTPRequest();
@@ -128,7 +151,37 @@ public:
      * @note Can be called only once. As this will give the request back to the
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
-    void WriteReply(int nStatus, const std::string& strReply = "");
+    void WriteReply(int nStatus, const std::string& strReply = "") { WriteReply(nStatus, MakeByteSpan(strReply)); }
+    void WriteReply(int nStatus, Span<const std::byte> reply);
+
+    /**
+     * Write the start of the reply body: `prefix`, followed by the JSON that
+     * `write` writes, which goes to the output buffer in chunks rather than
+     * being held as one string. If `write` throws, nothing is kept.
+     *
+     * @note Send the reply with WriteReply(), whose body is appended to this,
+     * or discard this with ClearReplyBody() first to reply differently.
+     */
+    void WriteReplyJSON(std::string_view prefix, const std::function<void(JSONWriter&)>& write);
+    //! Discard what WriteReplyJSON() wrote.
+    void ClearReplyBody();
+
+    /**
+     * Whether Park() may be used. Requests are only parked when the server runs
+     * several event loops (-rpceventthreads), otherwise handlers block as before.
+     */
+    bool CanPark() const;
+
+    /**
+     * Stop handling the request on this worker thread without replying, for example
+     * because it waits for a new block, so that the thread can serve other requests
+     * meanwhile. The handler must return right after calling this.
+     *
+     * `resume` is then called on a worker thread, and has to send the reply, as soon
+     * as `ready` returns true (it is checked on every WakeHTTPRequests() call), the
+     * optional `timeout` elapses, or the server is interrupted.
+     */
+    void Park(std::function<bool()> ready, std::optional<std::chrono::milliseconds> timeout, Continuation resume);
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
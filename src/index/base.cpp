@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <checkqueue.h>
 #include <common/args.h>
 #include <index/base.h>
 #include <interfaces/chain.h>
@@ -26,6 +27,38 @@ constexpr uint8_t DB_BEST_BLOCK{'B'};
 
 constexpr auto SYNC_LOG_INTERVAL{30s};
 constexpr auto SYNC_LOCATOR_WRITE_INTERVAL{30s};
+//! Blocks read ahead per sync thread in a parallel sync, so threads finishing
+//! early can pick up more work while a slow block is still being processed.
+constexpr size_t SYNC_BLOCKS_PER_THREAD{4};
+
+namespace {
+/** A block of a sync batch, along with the outcome of reading and processing it. */
+struct SyncBlock {
+    const CBlockIndex* pindex;
+    CBlock block{};
+    std::any processed{};
+    bool read{false};
+    bool processed_ok{false};
+};
+} // namespace
+
+struct BaseIndex::SyncTask {
+    const BaseIndex* index;
+    SyncBlock* sync_block;
+
+    // Failures are recorded in sync_block instead of being returned, so the
+    // rest of the batch still runs and the sync thread can report the first
+    // failed block in chain order.
+    bool operator()()
+    {
+        SyncBlock& b{*sync_block};
+        b.read = index->m_chainstate->m_blockman.ReadBlockFromDisk(b.block, *b.pindex);
+        if (b.read) {
+            b.processed_ok = index->CustomProcessBlock(kernel::MakeBlockInfo(b.pindex, &b.block), b.processed);
+        }
+        return true;
+    }
+};
 
 template <typename... Args>
 void BaseIndex::FatalErrorf(const char* fmt, const Args&... args)
@@ -141,10 +174,17 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev, CChain&
     return chain.Next(chain.FindFork(pindex_prev));
 }
 
-void BaseIndex::Sync()
+void BaseIndex::Sync(int worker_threads)
 {
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
+        // The workers are only needed to catch up, and exit along with the sync loop.
+        std::unique_ptr<CCheckQueue<SyncTask>> queue;
+        if (worker_threads > 0) {
+            queue = std::make_unique<CCheckQueue<SyncTask>>(/*batch_size=*/1, worker_threads,
+                                                            /*work_stealing=*/false, /*thread_name=*/"idxsync");
+        }
+        const size_t batch_size{queue ? SYNC_BLOCKS_PER_THREAD * (worker_threads + 1) : 1};
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
         while (true) {
@@ -183,22 +223,42 @@ void BaseIndex::Sync()
                 FatalErrorf("%s: Failed to rewind index %s to a previous chain tip", __func__, GetName());
                 return;
             }
-            pindex = pindex_next;
 
-
-            CBlock block;
-            interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
-                FatalErrorf("%s: Failed to read block %s from disk",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
+            // Read and process a batch of consecutive blocks, in parallel if
+            // there are workers, then append them to the index in order.
+            std::vector<SyncBlock> batch;
+            batch.reserve(batch_size);
+            {
+                LOCK(cs_main);
+                for (const CBlockIndex* next{pindex_next}; next && batch.size() < batch_size; next = m_chainstate->m_chain.Next(next)) {
+                    batch.push_back(SyncBlock{.pindex = next});
+                }
+            }
+            std::vector<SyncTask> tasks;
+            tasks.reserve(batch.size());
+            for (SyncBlock& sync_block : batch) {
+                tasks.push_back(SyncTask{this, &sync_block});
+            }
+            if (queue) {
+                CCheckQueueControl<SyncTask> control(queue.get());
+                control.Add(std::move(tasks));
+                control.Wait();
             } else {
-                block_info.data = &block;
+                for (SyncTask& task : tasks) task();
             }
-            if (!CustomAppend(block_info)) {
-                FatalErrorf("%s: Failed to write block %s to index database",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
+
+            for (SyncBlock& sync_block : batch) {
+                if (!sync_block.read) {
+                    FatalErrorf("%s: Failed to read block %s from disk",
+                               __func__, sync_block.pindex->GetBlockHash().ToString());
+                    return;
+                }
+                if (!sync_block.processed_ok || !CustomAppend(kernel::MakeBlockInfo(sync_block.pindex, &sync_block.block), sync_block.processed)) {
+                    FatalErrorf("%s: Failed to write block %s to index database",
+                               __func__, sync_block.pindex->GetBlockHash().ToString());
+                    return;
+                }
+                pindex = sync_block.pindex;
             }
 
             auto current_time{std::chrono::steady_clock::now()};
@@ -312,7 +372,8 @@ void BaseIndex::BlockConnected(ChainstateRole role, const std::shared_ptr<const
         }
     }
     interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex, block.get());
-    if (CustomAppend(block_info)) {
+    std::any processed;
+    if (CustomProcessBlock(block_info, processed) && CustomAppend(block_info, processed)) {
         // Setting the best block index is intentionally the last step of this
         // function, so BlockUntilSyncedToCurrentChain callers waiting for the
         // best block index to be updated can rely on the block being fully
@@ -399,11 +460,11 @@ void BaseIndex::Interrupt()
     m_interrupt();
 }
 
-bool BaseIndex::StartBackgroundSync()
+bool BaseIndex::StartBackgroundSync(int worker_threads)
 {
     if (!m_init) throw std::logic_error("Error: Cannot start a non-initialized index");
 
-    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] { Sync(); });
+    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this, worker_threads] { Sync(worker_threads); });
     return true;
 }
 
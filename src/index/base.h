@@ -10,6 +10,7 @@
 #include <util/threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <any>
 #include <string>
 
 class CBlock;
@@ -20,6 +21,11 @@ namespace interfaces {
 class Chain;
 } // namespace interfaces
 
+//! Default for -indexworkers, the number of extra threads used to sync indexes
+static constexpr int DEFAULT_INDEX_WORKERS{0};
+//! Maximum number of extra threads used to sync an index
+static constexpr int MAX_INDEX_WORKERS{15};
+
 struct IndexSummary {
     std::string name;
     bool synced{false};
@@ -78,6 +84,9 @@ private:
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
+    /// Reads and processes one block of a parallel sync on a worker thread.
+    struct SyncTask;
+
     /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
     ///
     /// Recommendations for error handling:
@@ -108,8 +117,16 @@ protected:
     /// Initialize internal state from the database and block index.
     [[nodiscard]] virtual bool CustomInit(const std::optional<interfaces::BlockKey>& block) { return true; }
 
-    /// Write update index entries for a newly connected block.
-    [[nodiscard]] virtual bool CustomAppend(const interfaces::BlockInfo& block) { return true; }
+    /// Compute the index data of a block that does not depend on any other
+    /// block, e.g. a block filter or the positions of its transactions. During
+    /// a parallel sync this is called on worker threads for several blocks at
+    /// once and in no particular order, so it must not rely on index state that
+    /// CustomAppend updates. The result is handed to CustomAppend.
+    [[nodiscard]] virtual bool CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const { return true; }
+
+    /// Write update index entries for a newly connected block. Blocks are
+    /// appended in chain order, with the output of CustomProcessBlock.
+    [[nodiscard]] virtual bool CustomAppend(const interfaces::BlockInfo& block, std::any& processed) { return true; }
 
     /// Virtual method called internally by Commit that can be overridden to atomically
     /// commit more index state.
@@ -121,6 +138,9 @@ protected:
 
     virtual DB& GetDB() const = 0;
 
+    /// Whether the initial sync is over, so that blocks are appended as they get connected.
+    bool IsSynced() const { return m_synced; }
+
     /// Update the internal best block index as well as the prune lock.
     void SetBestBlockIndex(const CBlockIndex* block);
 
@@ -146,14 +166,20 @@ public:
     [[nodiscard]] bool Init();
 
     /// Starts the initial sync process on a background thread.
-    [[nodiscard]] bool StartBackgroundSync();
+    ///
+    /// @param[in] worker_threads  Number of extra threads to read and process blocks with, see Sync().
+    [[nodiscard]] bool StartBackgroundSync(int worker_threads = 0);
 
     /// Sync the index with the block index starting from the current best block.
     /// Intended to be run in its own thread, m_thread_sync, and can be
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
     /// flag is set and the BlockConnected ValidationInterface callback takes
     /// over and the sync thread exits.
-    void Sync();
+    ///
+    /// With worker_threads > 0, blocks are read and passed to CustomProcessBlock
+    /// in batches by a pool of that many threads plus the calling one, and only
+    /// CustomAppend runs sequentially.
+    void Sync(int worker_threads = 0);
 
     /// Stops the instance from staying in sync with blockchain updates.
     void Stop();
@@ -248,7 +248,7 @@ std::optional<uint256> BlockFilterIndex::ReadFilterHeader(int height, const uint
     return read_out.second.header;
 }
 
-bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
+bool BlockFilterIndex::CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const
 {
     CBlockUndo block_undo;
 
@@ -261,8 +261,15 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
         }
     }
 
-    BlockFilter filter(m_filter_type, *Assert(block.data), block_undo);
+    processed.emplace<BlockFilter>(m_filter_type, *Assert(block.data), block_undo);
+    return true;
+}
+
+bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block, std::any& processed)
+{
+    const BlockFilter& filter{std::any_cast<const BlockFilter&>(processed)};
 
+    // The header commits to the previous one, so it is only computed here, in chain order.
     const uint256& header = filter.ComputeHeader(m_last_header);
     bool res = Write(filter, block.height, header);
     if (res) m_last_header = header; // update last header
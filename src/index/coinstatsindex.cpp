@@ -82,6 +82,13 @@ struct DBHeightKey {
     }
 };
 
+//! What CustomProcessBlock reads and hashes for CustomAppend
+struct ProcessedBlock {
+    CBlockUndo block_undo;
+    //! The outputs the block creates over the outputs it spends
+    MuHash3072 muhash;
+};
+
 struct DBHashKey {
     uint256 block_hash;
 
@@ -112,9 +119,47 @@ CoinStatsIndex::CoinStatsIndex(std::unique_ptr<interfaces::Chain> chain, size_t
     m_db = std::make_unique<CoinStatsIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
 }
 
-bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
+bool CoinStatsIndex::CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const
 {
-    CBlockUndo block_undo;
+    auto& [block_undo, muhash]{processed.emplace<ProcessedBlock>()};
+
+    // Ignore genesis block
+    if (block.height == 0) return true;
+
+    const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
+    if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return false;
+    }
+
+    // Hash the block's changes to the UTXO set into a MuHash of their own,
+    // which CustomAppend multiplies into the running one. This skips the same
+    // coins as CustomAppend does.
+    assert(block.data);
+    for (size_t i = 0; i < block.data->vtx.size(); ++i) {
+        const auto& tx{block.data->vtx.at(i)};
+        if (IsBIP30Unspendable(*pindex) && tx->IsCoinBase()) continue;
+
+        for (uint32_t j = 0; j < tx->vout.size(); ++j) {
+            const Coin coin{tx->vout[j], block.height, tx->IsCoinBase()};
+            if (coin.out.scriptPubKey.IsUnspendable()) continue;
+            ApplyCoinHash(muhash, COutPoint{tx->GetHash(), j}, coin);
+        }
+
+        if (!tx->IsCoinBase()) {
+            const auto& tx_undo{block_undo.vtxundo.at(i - 1)};
+            for (size_t j = 0; j < tx_undo.vprevout.size(); ++j) {
+                RemoveCoinHash(muhash, tx->vin[j].prevout, tx_undo.vprevout[j]);
+            }
+        }
+    }
+    return true;
+}
+
+bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block, std::any& processed)
+{
+    // The totals are running values over the chain, so they are added up
+    // here, while CustomProcessBlock hashes the block on its own.
+    const auto& [block_undo, block_muhash]{std::any_cast<const ProcessedBlock&>(processed)};
     const CAmount block_subsidy{GetBlockSubsidy(block.height, Params().GetConsensus())};
     m_total_subsidy += block_subsidy;
 
@@ -123,9 +168,6 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
         // pindex variable gives indexing code access to node internals. It
         // will be removed in upcoming commit
         const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
-        if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
-            return false;
-        }
 
         std::pair<uint256, DBVal> read_out;
         if (!m_db->Read(DBHeightKey(block.height - 1), read_out)) {
@@ -158,27 +200,22 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
 
             for (uint32_t j = 0; j < tx->vout.size(); ++j) {
                 const CTxOut& out{tx->vout[j]};
-                Coin coin{out, block.height, tx->IsCoinBase()};
-                COutPoint outpoint{tx->GetHash(), j};
-
                 // Skip unspendable coins
-                if (coin.out.scriptPubKey.IsUnspendable()) {
-                    m_total_unspendable_amount += coin.out.nValue;
-                    m_total_unspendables_scripts += coin.out.nValue;
+                if (out.scriptPubKey.IsUnspendable()) {
+                    m_total_unspendable_amount += out.nValue;
+                    m_total_unspendables_scripts += out.nValue;
                     continue;
                 }
 
-                ApplyCoinHash(m_muhash, outpoint, coin);
-
                 if (tx->IsCoinBase()) {
-                    m_total_coinbase_amount += coin.out.nValue;
+                    m_total_coinbase_amount += out.nValue;
                 } else {
-                    m_total_new_outputs_ex_coinbase_amount += coin.out.nValue;
+                    m_total_new_outputs_ex_coinbase_amount += out.nValue;
                 }
 
                 ++m_transaction_output_count;
-                m_total_amount += coin.out.nValue;
-                m_bogo_size += GetBogoSize(coin.out.scriptPubKey);
+                m_total_amount += out.nValue;
+                m_bogo_size += GetBogoSize(out.scriptPubKey);
             }
 
             // The coinbase tx has no undo data since no former output is spent
@@ -186,10 +223,7 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
                 const auto& tx_undo{block_undo.vtxundo.at(i - 1)};
 
                 for (size_t j = 0; j < tx_undo.vprevout.size(); ++j) {
-                    Coin coin{tx_undo.vprevout[j]};
-                    COutPoint outpoint{tx->vin[j].prevout.hash, tx->vin[j].prevout.n};
-
-                    RemoveCoinHash(m_muhash, outpoint, coin);
+                    const Coin& coin{tx_undo.vprevout[j]};
 
                     m_total_prevout_spent_amount += coin.out.nValue;
 
@@ -199,6 +233,8 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
                 }
             }
         }
+
+        m_muhash *= block_muhash;
     } else {
         // genesis block
         m_total_unspendable_amount += block_subsidy;
@@ -47,7 +47,9 @@ protected:
 
     bool CustomCommit(CDBBatch& batch) override;
 
-    bool CustomAppend(const interfaces::BlockInfo& block) override;
+    bool CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block, std::any& processed) override;
 
     bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
 
@@ -0,0 +1,62 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/prevoutindex.h>
+
+#include <chain.h>
+#include <common/args.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <undo.h>
+#include <validation.h>
+
+#include <utility>
+
+/* The database has one entry per non-coinbase transaction, with the key
+ * [DB_PREVOUTS, uint256 txid] and the transaction's undo data as value.
+ *
+ * Entries of blocks disconnected by a reorg are not erased, like in the
+ * txindex: a transaction spends the same outputs in any block, and its entry
+ * is overwritten if it is confirmed again.
+ */
+constexpr uint8_t DB_PREVOUTS{'p'};
+
+std::unique_ptr<PrevoutIndex> g_prevout_index;
+
+PrevoutIndex::PrevoutIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "prevoutindex")
+{
+    fs::path path{gArgs.GetDataDirNet() / "indexes" / "prevout"};
+    fs::create_directories(path);
+
+    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+}
+
+bool PrevoutIndex::CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const
+{
+    // Blocks with only a coinbase have no prevouts.
+    if (Assert(block.data)->vtx.size() <= 1) return true;
+
+    const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
+    CBlockUndo& block_undo{processed.emplace<CBlockUndo>()};
+    return m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex);
+}
+
+bool PrevoutIndex::CustomAppend(const interfaces::BlockInfo& block, std::any& processed)
+{
+    if (!processed.has_value()) return true;
+
+    const CBlock& data{*Assert(block.data)};
+    const CBlockUndo& block_undo{std::any_cast<const CBlockUndo&>(processed)};
+    CDBBatch batch(*m_db);
+    for (size_t i = 1; i < data.vtx.size(); ++i) {
+        batch.Write(std::make_pair(DB_PREVOUTS, data.vtx[i]->GetHash()), block_undo.vtxundo.at(i - 1));
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool PrevoutIndex::FindPrevouts(const uint256& txid, CTxUndo& tx_undo) const
+{
+    return m_db->Read(std::make_pair(DB_PREVOUTS, txid), tx_undo);
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_PREVOUTINDEX_H
+#define BITCOIN_INDEX_PREVOUTINDEX_H
+
+#include <index/base.h>
+
+class CTxUndo;
+class uint256;
+
+static constexpr bool DEFAULT_PREVOUTINDEX{false};
+
+/**
+ * PrevoutIndex stores the outputs spent by every confirmed non-coinbase
+ * transaction, keyed by txid, in the same compact format as the undo data.
+ * The prevouts of a transaction are read with a single lookup, instead of
+ * reading the block and its whole undo record from disk.
+ */
+class PrevoutIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    bool CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block, std::any& processed) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit PrevoutIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Look up the outputs spent by a confirmed transaction.
+    ///
+    /// @param[in]   txid     The id of the transaction.
+    /// @param[out]  tx_undo  The spent outputs, in the order of the transaction's inputs.
+    /// @return  true if the transaction is found in the index, false otherwise
+    bool FindPrevouts(const uint256& txid, CTxUndo& tx_undo) const;
+};
+
+/// The global prevout index. May be null.
+extern std::unique_ptr<PrevoutIndex> g_prevout_index;
+
+#endif // BITCOIN_INDEX_PREVOUTINDEX_H
@@ -0,0 +1,201 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/scripthistoryindex.h>
+
+#include <chain.h>
+#include <common/args.h>
+#include <index/scriptindex.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <undo.h>
+#include <validation.h>
+
+#include <ios>
+#include <utility>
+
+/* The database has one entry per output. The key is made of the hash of the
+ * output's scriptPubKey and its position in the block chain, and the value of
+ * its amount and the input spending it, if any.
+ *
+ * Keys have the type [DB_OUTPUT, uint256 script hash, uint32 height (BE),
+ * uint256 txid, uint32 vout (BE)]. Height and vout are big-endian so that the
+ * outputs of a script sort in block chain order.
+ */
+constexpr uint8_t DB_OUTPUT{'o'};
+
+std::unique_ptr<ScriptHistoryIndex> g_script_history_index;
+
+namespace {
+
+struct DBOutputKey {
+    uint256 script_hash;
+    ScriptHistoryPosition pos;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_OUTPUT);
+        s << script_hash;
+        ser_writedata32be(s, pos.height);
+        s << pos.txid;
+        ser_writedata32be(s, pos.vout);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_OUTPUT) {
+            throw std::ios_base::failure("Invalid format for script history index DB key");
+        }
+        s >> script_hash;
+        pos.height = ser_readdata32be(s);
+        s >> pos.txid;
+        pos.vout = ser_readdata32be(s);
+    }
+};
+
+struct DBVal {
+    CAmount amount{0};
+    std::optional<ScriptHistorySpend> spent_by;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << VARINT_MODE(amount, VarIntMode::NONNEGATIVE_SIGNED);
+        // Zero for unspent outputs, the spending height plus one otherwise.
+        const uint32_t spent_code{spent_by ? static_cast<uint32_t>(spent_by->height) + 1 : 0};
+        s << VARINT(spent_code);
+        if (spent_by) s << spent_by->txid << VARINT(spent_by->vin);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        s >> VARINT_MODE(amount, VarIntMode::NONNEGATIVE_SIGNED);
+        uint32_t spent_code;
+        s >> VARINT(spent_code);
+        if (spent_code == 0) {
+            spent_by.reset();
+        } else {
+            spent_by.emplace();
+            spent_by->height = spent_code - 1;
+            s >> spent_by->txid >> VARINT(spent_by->vin);
+        }
+    }
+};
+
+using DBWrites = std::vector<std::pair<DBOutputKey, DBVal>>;
+
+} // namespace
+
+ScriptHistoryIndex::ScriptHistoryIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "scripthistoryindex")
+{
+    fs::path path{gArgs.GetDataDirNet() / "indexes" / "scripthistory"};
+    fs::create_directories(path);
+
+    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+}
+
+bool ScriptHistoryIndex::CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (block.height == 0) return true;
+
+    const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
+    CBlockUndo block_undo;
+    if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return false;
+    }
+
+    // The undo data has the script, height and amount of every spent output,
+    // so the entries are written without reading the database. Spends come
+    // before the outputs of each transaction, so an output created and spent
+    // in this block ends up spent.
+    auto& writes{processed.emplace<DBWrites>()};
+    const CBlock& data{*Assert(block.data)};
+    for (size_t i = 0; i < data.vtx.size(); ++i) {
+        const CTransaction& tx{*data.vtx[i]};
+        if (i > 0) {
+            const CTxUndo& tx_undo{block_undo.vtxundo.at(i - 1)};
+            for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin{tx_undo.vprevout.at(j)};
+                const COutPoint& prevout{tx.vin[j].prevout};
+                writes.emplace_back(DBOutputKey{ScriptIndexHash(coin.out.scriptPubKey), {static_cast<int>(coin.nHeight), prevout.hash, prevout.n}},
+                                    DBVal{coin.out.nValue, ScriptHistorySpend{tx.GetHash(), j, block.height}});
+            }
+        }
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out{tx.vout[j]};
+            if (out.scriptPubKey.IsUnspendable()) continue;
+            writes.emplace_back(DBOutputKey{ScriptIndexHash(out.scriptPubKey), {block.height, tx.GetHash(), j}},
+                                DBVal{out.nValue, std::nullopt});
+        }
+    }
+    return true;
+}
+
+bool ScriptHistoryIndex::CustomAppend(const interfaces::BlockInfo& block, std::any& processed)
+{
+    if (block.height == 0) return true;
+
+    CDBBatch batch(*m_db);
+    for (const auto& [key, value] : std::any_cast<const DBWrites&>(processed)) {
+        batch.Write(key, value);
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool ScriptHistoryIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    // Erase the outputs the disconnected blocks created, and mark the outputs
+    // they spent as unspent again.
+    CDBBatch batch(*m_db);
+    const bool ok{RewindScriptIndex(
+        *m_chainstate, current_tip, new_tip,
+        [&](const CTxOut& out, const COutPoint& outpoint, int height) {
+            batch.Erase(DBOutputKey{ScriptIndexHash(out.scriptPubKey), {height, outpoint.hash, outpoint.n}});
+        },
+        [&](const Coin& coin, const COutPoint& outpoint) {
+            batch.Write(DBOutputKey{ScriptIndexHash(coin.out.scriptPubKey), {static_cast<int>(coin.nHeight), outpoint.hash, outpoint.n}},
+                        DBVal{coin.out.nValue, std::nullopt});
+        })};
+    return ok && m_db->WriteBatch(batch);
+}
+
+bool ScriptHistoryIndex::LookUpHistory(const CScript& script, int start_height, int stop_height,
+                                       const std::optional<ScriptHistoryPosition>& after, size_t count,
+                                       std::vector<ScriptHistoryEntry>& entries, bool& more) const
+{
+    entries.clear();
+    more = false;
+
+    const uint256 script_hash{ScriptIndexHash(script)};
+    DBOutputKey key{script_hash, {start_height, uint256::ZERO, 0}};
+    if (after && after->height >= start_height) key.pos = *after;
+
+    // The iterator reads from an implicit snapshot of the database, so the
+    // result is consistent even if blocks get appended meanwhile.
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    for (db_it->Seek(key); db_it->Valid(); db_it->Next()) {
+        DBOutputKey found;
+        if (!db_it->GetKey(found) || found.script_hash != script_hash || found.pos.height > stop_height) break;
+        if (after && found.pos.height == after->height && found.pos.txid == after->txid && found.pos.vout == after->vout) continue;
+        if (entries.size() == count) {
+            more = true;
+            break;
+        }
+        DBVal value;
+        if (!db_it->GetValue(value)) {
+            LogError("%s: Cannot read script history entry of %s\n", __func__, found.pos.txid.ToString());
+            return false;
+        }
+        entries.push_back({found.pos, value.amount, value.spent_by});
+    }
+    return true;
+}
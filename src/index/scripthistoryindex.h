@@ -0,0 +1,85 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SCRIPTHISTORYINDEX_H
+#define BITCOIN_INDEX_SCRIPTHISTORYINDEX_H
+
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <optional>
+#include <vector>
+
+class CScript;
+
+static constexpr bool DEFAULT_SCRIPTHISTORYINDEX{false};
+
+/** Position of an output in the block chain. The history of a script is ordered by it. */
+struct ScriptHistoryPosition {
+    int height{0};
+    uint256 txid;
+    uint32_t vout{0};
+
+    SERIALIZE_METHODS(ScriptHistoryPosition, obj) { READWRITE(obj.height, obj.txid, obj.vout); }
+};
+
+/** The input spending an output. */
+struct ScriptHistorySpend {
+    uint256 txid;
+    uint32_t vin{0};
+    int height{0};
+};
+
+/** An output paying to a script, and the input spending it if any. */
+struct ScriptHistoryEntry {
+    ScriptHistoryPosition pos;
+    CAmount amount{0};
+    std::optional<ScriptHistorySpend> spent_by;
+};
+
+/**
+ * ScriptHistoryIndex records every output of the block chain by the SHA256
+ * hash of its scriptPubKey, along with the input that spends it. The outputs
+ * of a script are stored next to each other in block chain order, so the
+ * history of a script, or a range of heights of it, is read with one seek.
+ */
+class ScriptHistoryIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    bool CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block, std::any& processed) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit ScriptHistoryIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Look up the outputs paying to script in the blocks from start_height to
+    /// stop_height, in block chain order.
+    ///
+    /// @param[in]   after    If set, only return outputs after this position, to continue a previous lookup.
+    /// @param[in]   count    Maximum number of outputs to return.
+    /// @param[out]  entries  The outputs found.
+    /// @param[out]  more     Whether there are more outputs in the range, after the ones returned.
+    /// @return  false if the database could not be read
+    bool LookUpHistory(const CScript& script, int start_height, int stop_height,
+                       const std::optional<ScriptHistoryPosition>& after, size_t count,
+                       std::vector<ScriptHistoryEntry>& entries, bool& more) const;
+};
+
+/// The global script history index. May be null.
+extern std::unique_ptr<ScriptHistoryIndex> g_script_history_index;
+
+#endif // BITCOIN_INDEX_SCRIPTHISTORYINDEX_H
@@ -0,0 +1,68 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/scriptindex.h>
+
+#include <chain.h>
+#include <coins.h>
+#include <crypto/sha256.h>
+#include <interfaces/chain.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <undo.h>
+#include <validation.h>
+
+uint256 ScriptIndexHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+bool RewindScriptIndex(Chainstate& chainstate, const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip,
+                       const std::function<void(const CTxOut& out, const COutPoint& outpoint, int height)>& erase,
+                       const std::function<void(const Coin& coin, const COutPoint& outpoint)>& restore)
+{
+    const CBlockIndex* iter_tip;
+    const CBlockIndex* new_tip_index;
+    {
+        LOCK(cs_main);
+        iter_tip = chainstate.m_blockman.LookupBlockIndex(current_tip.hash);
+        new_tip_index = chainstate.m_blockman.LookupBlockIndex(new_tip.hash);
+    }
+
+    do {
+        CBlock block;
+        CBlockUndo block_undo;
+        if (!chainstate.m_blockman.ReadBlockFromDisk(block, *iter_tip) ||
+            !chainstate.m_blockman.UndoReadFromDisk(block_undo, *iter_tip)) {
+            LogError("%s: Failed to read block %s from disk\n",
+                     __func__, iter_tip->GetBlockHash().ToString());
+            return false;
+        }
+
+        for (size_t i = 0; i < block.vtx.size(); ++i) {
+            const CTransaction& tx{*block.vtx[i]};
+            for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+                const CTxOut& out{tx.vout[j]};
+                if (out.scriptPubKey.IsUnspendable()) continue;
+                erase(out, COutPoint{tx.GetHash(), j}, iter_tip->nHeight);
+            }
+            if (i == 0) continue;
+            const CTxUndo& tx_undo{block_undo.vtxundo.at(i - 1)};
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin{tx_undo.vprevout.at(j)};
+                // Outputs of this block are erased above.
+                if (static_cast<int>(coin.nHeight) == iter_tip->nHeight) continue;
+                restore(coin, tx.vin[j].prevout);
+            }
+        }
+
+        iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+    } while (new_tip_index != iter_tip);
+
+    return true;
+}
@@ -0,0 +1,38 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SCRIPTINDEX_H
+#define BITCOIN_INDEX_SCRIPTINDEX_H
+
+#include <uint256.h>
+
+#include <functional>
+
+class Chainstate;
+class Coin;
+class COutPoint;
+class CScript;
+class CTxOut;
+namespace interfaces {
+struct BlockKey;
+} // namespace interfaces
+
+//! The SHA256 of a script, which ScriptHistoryIndex and ScriptUTXOIndex key their entries by.
+uint256 ScriptIndexHash(const CScript& script);
+
+/**
+ * Undo the blocks disconnected by rewinding ScriptHistoryIndex or
+ * ScriptUTXOIndex from current_tip to new_tip, from the tip down. erase is called with each output the blocks
+ * created and the height of its block, and restore with each output they spent
+ * that was created by an earlier block.
+ *
+ * Pruned nodes keep these blocks, as the prune lock does not go below the
+ * index's best block. The blocks are read without holding cs_main. Returns
+ * false if a block or its undo data could not be read.
+ */
+bool RewindScriptIndex(Chainstate& chainstate, const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip,
+                       const std::function<void(const CTxOut& out, const COutPoint& outpoint, int height)>& erase,
+                       const std::function<void(const Coin& coin, const COutPoint& outpoint)>& restore);
+
+#endif // BITCOIN_INDEX_SCRIPTINDEX_H
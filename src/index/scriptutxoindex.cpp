@@ -0,0 +1,191 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/scriptutxoindex.h>
+
+#include <chain.h>
+#include <coins.h>
+#include <common/args.h>
+#include <compressor.h>
+#include <index/scriptindex.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <undo.h>
+#include <validation.h>
+
+#include <ios>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/* The database has one entry per unspent output, with the key
+ * [DB_UTXO, uint256 script hash, uint256 txid, uint32 vout (BE)] and the
+ * height, coinbase flag and amount of the output as value. The script is not
+ * stored, as it is known to whoever looks it up by its hash.
+ *
+ * DB_TIP is the hash of the block the entries are as of. It is written in the
+ * same batch as the entries, so that lookups read both consistently, while
+ * the locator of the base class is only written when the index is committed.
+ */
+constexpr uint8_t DB_UTXO{'u'};
+constexpr uint8_t DB_TIP{'T'};
+
+std::unique_ptr<ScriptUTXOIndex> g_script_utxo_index;
+
+namespace {
+
+struct DBUTXOKey {
+    uint256 script_hash;
+    COutPoint outpoint;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_UTXO);
+        s << script_hash << outpoint.hash;
+        ser_writedata32be(s, outpoint.n);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_UTXO) {
+            throw std::ios_base::failure("Invalid format for script UTXO index DB key");
+        }
+        s >> script_hash >> outpoint.hash;
+        outpoint.n = ser_readdata32be(s);
+    }
+};
+
+struct DBVal {
+    uint32_t height{0};
+    bool coinbase{false};
+    CAmount amount{0};
+
+    SERIALIZE_METHODS(DBVal, obj)
+    {
+        uint32_t code{obj.height * 2 + obj.coinbase};
+        READWRITE(VARINT(code), Using<AmountCompression>(obj.amount));
+        SER_READ(obj, obj.height = code >> 1);
+        SER_READ(obj, obj.coinbase = code & 1);
+    }
+};
+
+DBUTXOKey MakeKey(const CScript& script, const COutPoint& outpoint)
+{
+    return DBUTXOKey{ScriptIndexHash(script), outpoint};
+}
+
+DBVal MakeVal(const Coin& coin)
+{
+    return DBVal{coin.nHeight, bool(coin.fCoinBase), coin.out.nValue};
+}
+
+//! The entries to write and erase for a block, in order.
+struct DBChanges {
+    std::vector<std::pair<DBUTXOKey, std::optional<DBVal>>> changes;
+};
+
+} // namespace
+
+ScriptUTXOIndex::ScriptUTXOIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "scriptutxoindex")
+{
+    fs::path path{gArgs.GetDataDirNet() / "indexes" / "scriptutxo"};
+    fs::create_directories(path);
+
+    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+}
+
+bool ScriptUTXOIndex::CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (block.height == 0) return true;
+
+    const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
+    CBlockUndo block_undo;
+    if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return false;
+    }
+
+    // The undo data has the scripts of the spent outputs, so their keys are
+    // known without reading the database. Changes are applied in order, so an
+    // output created and spent in this block ends up erased.
+    auto& changes{processed.emplace<DBChanges>().changes};
+    const CBlock& data{*Assert(block.data)};
+    for (size_t i = 0; i < data.vtx.size(); ++i) {
+        const CTransaction& tx{*data.vtx[i]};
+        if (i > 0) {
+            const CTxUndo& tx_undo{block_undo.vtxundo.at(i - 1)};
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                changes.emplace_back(MakeKey(tx_undo.vprevout.at(j).out.scriptPubKey, tx.vin[j].prevout), std::nullopt);
+            }
+        }
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out{tx.vout[j]};
+            if (out.scriptPubKey.IsUnspendable()) continue;
+            changes.emplace_back(MakeKey(out.scriptPubKey, COutPoint{tx.GetHash(), j}),
+                                 DBVal{static_cast<uint32_t>(block.height), i == 0, out.nValue});
+        }
+    }
+    return true;
+}
+
+bool ScriptUTXOIndex::CustomAppend(const interfaces::BlockInfo& block, std::any& processed)
+{
+    CDBBatch batch(*m_db);
+    if (processed.has_value()) {
+        for (const auto& [key, value] : std::any_cast<const DBChanges&>(processed).changes) {
+            if (value) {
+                batch.Write(key, *value);
+            } else {
+                batch.Erase(key);
+            }
+        }
+    }
+    batch.Write(DB_TIP, block.hash);
+    return m_db->WriteBatch(batch);
+}
+
+bool ScriptUTXOIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    // Erase the outputs the disconnected blocks created, and restore the
+    // outputs they spent.
+    CDBBatch batch(*m_db);
+    const bool ok{RewindScriptIndex(
+        *m_chainstate, current_tip, new_tip,
+        [&](const CTxOut& out, const COutPoint& outpoint, int) { batch.Erase(MakeKey(out.scriptPubKey, outpoint)); },
+        [&](const Coin& coin, const COutPoint& outpoint) { batch.Write(MakeKey(coin.out.scriptPubKey, outpoint), MakeVal(coin)); })};
+    if (!ok) return false;
+    batch.Write(DB_TIP, new_tip.hash);
+
+    return m_db->WriteBatch(batch);
+}
+
+bool ScriptUTXOIndex::FindUTXOs(const std::set<CScript>& scripts, std::map<COutPoint, Coin>& coins, uint256& best_block) const
+{
+    // Read the tip and all entries from the same snapshot, so that they are
+    // consistent even if blocks get appended meanwhile.
+    const std::unique_ptr<CDBSnapshot> snapshot{m_db->NewSnapshot()};
+    if (!m_db->Read(DB_TIP, best_block, snapshot.get())) return false;
+
+    for (const CScript& script : scripts) {
+        const uint256 script_hash{ScriptIndexHash(script)};
+        std::unique_ptr<CDBIterator> db_it(m_db->NewIterator(snapshot.get()));
+        for (db_it->Seek(DBUTXOKey{script_hash, COutPoint{Txid{}, 0}}); db_it->Valid(); db_it->Next()) {
+            DBUTXOKey key;
+            if (!db_it->GetKey(key) || key.script_hash != script_hash) break;
+            DBVal value;
+            if (!db_it->GetValue(value)) {
+                LogError("%s: Cannot read script UTXO index entry of %s\n", __func__, key.outpoint.ToString());
+                return false;
+            }
+            coins.emplace(key.outpoint, Coin{CTxOut{value.amount, script}, static_cast<int>(value.height), value.coinbase});
+        }
+    }
+    return true;
+}
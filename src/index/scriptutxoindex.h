@@ -0,0 +1,56 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SCRIPTUTXOINDEX_H
+#define BITCOIN_INDEX_SCRIPTUTXOINDEX_H
+
+#include <index/base.h>
+
+#include <map>
+#include <set>
+
+class Coin;
+class COutPoint;
+class CScript;
+class uint256;
+
+static constexpr bool DEFAULT_SCRIPTUTXOINDEX{false};
+
+/**
+ * ScriptUTXOIndex maps the SHA256 hash of a scriptPubKey to the unspent
+ * outputs paying to it. Spent outputs are erased as blocks are connected, so
+ * the index only holds the UTXO set, ordered by script.
+ */
+class ScriptUTXOIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    bool CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block, std::any& processed) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit ScriptUTXOIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Look up the unspent outputs paying to any of scripts.
+    ///
+    /// @param[out]  coins       The unspent outputs found, added to the map.
+    /// @param[out]  best_block  The block the outputs are unspent as of.
+    /// @return  false if nothing was indexed yet, or the database could not be read
+    bool FindUTXOs(const std::set<CScript>& scripts, std::map<COutPoint, Coin>& coins, uint256& best_block) const;
+};
+
+/// The global script UTXO index. May be null.
+extern std::unique_ptr<ScriptUTXOIndex> g_script_utxo_index;
+
+#endif // BITCOIN_INDEX_SCRIPTUTXOINDEX_H
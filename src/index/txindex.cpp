@@ -6,15 +6,87 @@
 
 #include <clientversion.h>
 #include <common/args.h>
+#include <crypto/common.h>
 #include <index/disktxpos.h>
 #include <logging.h>
 #include <node/blockstorage.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <tuple>
+
 constexpr uint8_t DB_TXINDEX{'t'};
+constexpr uint8_t DB_TXINDEX_COMPACT{'c'};
+constexpr uint8_t DB_TXINDEX_FORMAT{'F'};
+
+/** Memory used by the compact format entries collected while syncing before they are written. */
+constexpr size_t MAX_PENDING_COMPACT_BYTES{16 << 20};
 
 std::unique_ptr<TxIndex> g_txindex;
 
+static const std::map<TxIndexFormat, std::string> g_txindex_format_names = {
+    {TxIndexFormat::LEGACY, "legacy"},
+    {TxIndexFormat::COMPACT, "compact"},
+};
+
+const std::string& TxIndexFormatName(TxIndexFormat format)
+{
+    static std::string unknown_retval;
+    auto it = g_txindex_format_names.find(format);
+    return it != g_txindex_format_names.end() ? it->second : unknown_retval;
+}
+
+bool TxIndexFormatByName(const std::string& name, TxIndexFormat& format)
+{
+    for (const auto& entry : g_txindex_format_names) {
+        if (entry.second == name) {
+            format = entry.first;
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+
+/** The first 8 bytes of a txid, which the compact format is keyed by. */
+uint64_t TxidPrefix(const uint256& txid) { return ReadLE64(txid.begin()); }
+
+/**
+ * Key of a compact format entry. The whole entry is in the key, as prefixes are
+ * not unique, and the value is empty. The prefix is big-endian so that keys sort
+ * by prefix and all candidates for a txid are next to each other.
+ */
+struct DBCompactKey {
+    uint64_t txid_prefix;
+    uint32_t height;
+    uint32_t tx_ordinal;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_TXINDEX_COMPACT);
+        ser_writedata32be(s, txid_prefix >> 32);
+        ser_writedata32be(s, txid_prefix & 0xffffffff);
+        s << VARINT(height) << VARINT(tx_ordinal);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_TXINDEX_COMPACT) {
+            throw std::ios_base::failure("Invalid format for compact txindex DB key");
+        }
+        txid_prefix = uint64_t{ser_readdata32be(s)} << 32;
+        txid_prefix |= ser_readdata32be(s);
+        s >> VARINT(height) >> VARINT(tx_ordinal);
+    }
+};
+
+} // namespace
 
 /** Access to the txindex database (indexes/txindex/) */
 class TxIndex::DB : public BaseIndex::DB
@@ -22,18 +94,41 @@ class TxIndex::DB : public BaseIndex::DB
 public:
     explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
 
+    /// Read the format the database was built in. Returns nullopt for databases
+    /// from before the format was recorded.
+    std::optional<TxIndexFormat> ReadFormat() const;
+
+    /// Record the format the database is built in.
+    void WriteFormat(TxIndexFormat format);
+
     /// Read the disk location of the transaction data with the given hash. Returns false if the
     /// transaction hash is not indexed.
     bool ReadTxPos(const uint256& txid, CDiskTxPos& pos) const;
 
     /// Write a batch of transaction positions to the DB.
     [[nodiscard]] bool WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos);
+
+    /// Read the (height, tx ordinal) positions of all compact format entries
+    /// whose txid prefix matches the given txid.
+    std::vector<std::pair<int, uint32_t>> ReadCompactTxPositions(const uint256& txid);
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
     BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
 {}
 
+std::optional<TxIndexFormat> TxIndex::DB::ReadFormat() const
+{
+    uint8_t format;
+    if (!Read(DB_TXINDEX_FORMAT, format)) return std::nullopt;
+    return TxIndexFormat{format};
+}
+
+void TxIndex::DB::WriteFormat(TxIndexFormat format)
+{
+    Write(DB_TXINDEX_FORMAT, static_cast<uint8_t>(format));
+}
+
 bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
 {
     return Read(std::make_pair(DB_TXINDEX, txid), pos);
@@ -48,32 +143,106 @@ bool TxIndex::DB::WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_
     return WriteBatch(batch);
 }
 
-TxIndex::TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
-    : BaseIndex(std::move(chain), "txindex"), m_db(std::make_unique<TxIndex::DB>(n_cache_size, f_memory, f_wipe))
-{}
+std::vector<std::pair<int, uint32_t>> TxIndex::DB::ReadCompactTxPositions(const uint256& txid)
+{
+    std::vector<std::pair<int, uint32_t>> positions;
+    DBCompactKey key{TxidPrefix(txid), 0, 0};
+    const uint64_t txid_prefix{key.txid_prefix};
+    std::unique_ptr<CDBIterator> db_it(NewIterator());
+    for (db_it->Seek(key); db_it->Valid() && db_it->GetKey(key) && key.txid_prefix == txid_prefix; db_it->Next()) {
+        positions.emplace_back(key.height, key.tx_ordinal);
+    }
+    return positions;
+}
+
+TxIndex::TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe, TxIndexFormat format)
+    : BaseIndex(std::move(chain), "txindex"), m_format{format}, m_db(std::make_unique<TxIndex::DB>(n_cache_size, f_memory, f_wipe))
+{
+    // Databases that do not record their format were built in the legacy one.
+    const TxIndexFormat db_format{m_db->ReadFormat().value_or(m_db->IsEmpty() ? m_format : TxIndexFormat::LEGACY)};
+    if (db_format != m_format) {
+        // The compact format needs the height and position in the block of
+        // every transaction, so converting means reading all blocks again,
+        // which is what rebuilding the index does.
+        LogPrintf("%s: Database is in the %s format, rebuilding it in the %s format\n",
+                  GetName(), TxIndexFormatName(db_format), TxIndexFormatName(m_format));
+        m_db.reset();
+        m_db = std::make_unique<TxIndex::DB>(n_cache_size, f_memory, /*f_wipe=*/true);
+    }
+    m_db->WriteFormat(m_format);
+}
 
 TxIndex::~TxIndex() = default;
 
-bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
+bool TxIndex::CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const
 {
     // Exclude genesis block transaction because outputs are not spendable.
     if (block.height == 0) return true;
 
     assert(block.data);
+    if (m_format == TxIndexFormat::COMPACT) {
+        auto& entries{processed.emplace<std::vector<CompactEntry>>()};
+        entries.reserve(block.data->vtx.size());
+        for (uint32_t i = 0; i < block.data->vtx.size(); ++i) {
+            entries.push_back({TxidPrefix(block.data->vtx[i]->GetHash()), block.height, i});
+        }
+        return true;
+    }
+
     CDiskTxPos pos({block.file_number, block.data_pos}, GetSizeOfCompactSize(block.data->vtx.size()));
-    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
+    auto& vPos{processed.emplace<std::vector<std::pair<uint256, CDiskTxPos>>>()};
     vPos.reserve(block.data->vtx.size());
     for (const auto& tx : block.data->vtx) {
         vPos.emplace_back(tx->GetHash(), pos);
         pos.nTxOffset += ::GetSerializeSize(TX_WITH_WITNESS(*tx));
     }
-    return m_db->WriteTxs(vPos);
+    return true;
+}
+
+bool TxIndex::CustomAppend(const interfaces::BlockInfo& block, std::any& processed)
+{
+    if (block.height == 0) return true;
+
+    if (m_format == TxIndexFormat::COMPACT) {
+        const auto& entries{std::any_cast<const std::vector<CompactEntry>&>(processed)};
+        m_pending.insert(m_pending.end(), entries.begin(), entries.end());
+        // Once synced, blocks must be found as soon as they are appended.
+        if (IsSynced() || m_pending.size() >= MAX_PENDING_COMPACT_BYTES / sizeof(CompactEntry)) {
+            CDBBatch batch(*m_db);
+            WritePending(batch);
+            return m_db->WriteBatch(batch);
+        }
+        return true;
+    }
+
+    return m_db->WriteTxs(std::any_cast<const std::vector<std::pair<uint256, CDiskTxPos>>&>(processed));
+}
+
+void TxIndex::WritePending(CDBBatch& batch)
+{
+    // Writing in key order keeps the new entries in few, non-overlapping
+    // LevelDB tables, which makes them cheaper to compact.
+    std::sort(m_pending.begin(), m_pending.end(), [](const CompactEntry& a, const CompactEntry& b) {
+        return std::tie(a.txid_prefix, a.height, a.tx_ordinal) < std::tie(b.txid_prefix, b.height, b.tx_ordinal);
+    });
+    for (const CompactEntry& entry : m_pending) {
+        batch.Write(DBCompactKey{entry.txid_prefix, static_cast<uint32_t>(entry.height), entry.tx_ordinal}, Span<const std::byte>{});
+    }
+    m_pending.clear();
+}
+
+bool TxIndex::CustomCommit(CDBBatch& batch)
+{
+    WritePending(batch);
+    return true;
 }
 
 BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
 
 bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
 {
+    if (m_format == TxIndexFormat::COMPACT) return FindTxCompact(tx_hash, block_hash, tx);
+
     CDiskTxPos postx;
     if (!m_db->ReadTxPos(tx_hash, postx)) {
         return false;
@@ -103,3 +272,45 @@ bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRe
     block_hash = header.GetHash();
     return true;
 }
+
+bool TxIndex::FindTxCompact(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
+{
+    // Entries of blocks that were reorganized out of the chain are not erased.
+    // They point at whatever is now at their height and fail the txid check.
+    for (const auto& [height, tx_ordinal] : m_db->ReadCompactTxPositions(tx_hash)) {
+        FlatFilePos block_pos;
+        uint256 candidate_block_hash;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* pindex{m_chainstate->m_chain[height]};
+            if (!pindex) continue;
+            block_pos = pindex->GetBlockPos();
+            candidate_block_hash = pindex->GetBlockHash();
+        }
+
+        AutoFile file{m_chainstate->m_blockman.OpenBlockFile(block_pos, true)};
+        if (file.IsNull()) {
+            LogError("%s: OpenBlockFile failed\n", __func__);
+            return false;
+        }
+        CTransactionRef candidate;
+        try {
+            CBlockHeader header;
+            file >> header;
+            if (tx_ordinal >= ReadCompactSize(file)) continue;
+            // Transactions are not fixed size, so the ones before it have to be read as well.
+            for (uint32_t i = 0; i <= tx_ordinal; ++i) {
+                file >> TX_WITH_WITNESS(candidate);
+            }
+        } catch (const std::exception& e) {
+            LogError("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            return false;
+        }
+        if (candidate->GetHash() == tx_hash) {
+            tx = std::move(candidate);
+            block_hash = candidate_block_hash;
+            return true;
+        }
+    }
+    return false;
+}
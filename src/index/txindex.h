@@ -7,12 +7,36 @@
 
 #include <index/base.h>
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 static constexpr bool DEFAULT_TXINDEX{false};
 
+/** On-disk layout of the transaction index. */
+enum class TxIndexFormat : uint8_t {
+    //! Full txid keys, mapped to the position of the transaction in the block files.
+    LEGACY = 0,
+    //! Keys made of a short txid prefix, the block height and the position of the
+    //! transaction in the block. Prefix collisions are resolved by reading the
+    //! candidate transactions from disk.
+    COMPACT = 1,
+};
+
+static constexpr TxIndexFormat DEFAULT_TXINDEX_FORMAT{TxIndexFormat::LEGACY};
+
+/** Get the human-readable name for a txindex format. Returns empty string for unknown formats. */
+const std::string& TxIndexFormatName(TxIndexFormat format);
+
+/** Find a txindex format by its human-readable name. */
+bool TxIndexFormatByName(const std::string& name, TxIndexFormat& format);
+
 /**
  * TxIndex is used to look up transactions included in the blockchain by hash.
- * The index is written to a LevelDB database and records the filesystem
- * location of each transaction by transaction hash.
+ * The index is written to a LevelDB database and records the location of each
+ * transaction by transaction hash, in one of the TxIndexFormat layouts. If the
+ * database was built in another format than the requested one, it is wiped
+ * and rebuilt.
  */
 class TxIndex final : public BaseIndex
 {
@@ -20,18 +44,41 @@ protected:
     class DB;
 
 private:
-    const std::unique_ptr<DB> m_db;
+    /// A transaction of a block, to be written to a compact format index.
+    struct CompactEntry {
+        uint64_t txid_prefix;
+        int height;
+        uint32_t tx_ordinal;
+    };
+
+    const TxIndexFormat m_format;
+    std::unique_ptr<DB> m_db;
+
+    /// Compact format entries that are not written yet. While the index syncs,
+    /// entries are collected and written sorted in large batches, at the latest
+    /// with the next Commit. Only accessed by the thread appending blocks.
+    std::vector<CompactEntry> m_pending;
 
     bool AllowPrune() const override { return false; }
 
+    /// Write and clear the pending compact entries, into batch.
+    void WritePending(CDBBatch& batch);
+
+    bool FindTxCompact(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+
 protected:
-    bool CustomAppend(const interfaces::BlockInfo& block) override;
+    bool CustomProcessBlock(const interfaces::BlockInfo& block, std::any& processed) const override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block, std::any& processed) override;
+
+    bool CustomCommit(CDBBatch& batch) override;
 
     BaseIndex::DB& GetDB() const override;
 
 public:
     /// Constructs the index, which becomes available to be queried.
-    explicit TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    explicit TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false,
+                     TxIndexFormat format = DEFAULT_TXINDEX_FORMAT);
 
     // Destructor is declared because this class contains a unique_ptr to an incomplete type.
     virtual ~TxIndex() override;
@@ -0,0 +1,123 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <inputfetcher.h>
+
+#include <primitives/block.h>
+#include <tinyformat.h>
+#include <util/hasher.h>
+#include <util/threadnames.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+InputFetcher::InputFetcher(int worker_threads_num)
+{
+    m_worker_threads.reserve(worker_threads_num);
+    for (int n = 0; n < worker_threads_num; ++n) {
+        m_worker_threads.emplace_back([this, n]() {
+            util::ThreadRename(strprintf("inputfetch.%i", n));
+            Loop();
+        });
+    }
+}
+
+InputFetcher::~InputFetcher()
+{
+    WITH_LOCK(m_mutex, m_request_stop = true);
+    m_worker_cv.notify_all();
+    for (std::thread& t : m_worker_threads) {
+        t.join();
+    }
+}
+
+void InputFetcher::Work()
+{
+    const size_t count{m_outpoints.size()};
+    while (true) {
+        const size_t begin{m_next.fetch_add(BATCH_SIZE, std::memory_order_relaxed)};
+        if (begin >= count) break;
+        const size_t end{std::min(count, begin + BATCH_SIZE)};
+        for (size_t i = begin; i < end; ++i) {
+            try {
+                if (!m_db->GetCoin(m_outpoints[i], m_coins[i])) m_coins[i].Clear();
+            } catch (const std::runtime_error&) {
+                // Leave it to the regular lookup path to run into and report the error.
+                m_coins[i].Clear();
+            }
+        }
+    }
+}
+
+void InputFetcher::Loop()
+{
+    uint64_t generation{0};
+    while (true) {
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_request_stop || m_generation != generation; });
+            if (m_request_stop) return;
+            generation = m_generation;
+        }
+        Work();
+        {
+            LOCK(m_mutex);
+            if (--m_pending_workers == 0) m_master_cv.notify_one();
+        }
+    }
+}
+
+InputFetcher::Stats InputFetcher::FetchInputs(CCoinsViewCache& cache, const CCoinsView& db, const CBlock& block)
+{
+    Stats stats;
+    if (!HasThreads() || block.vtx.size() <= 1) return stats;
+
+    std::unordered_set<Txid, SaltedTxidHasher> block_txids;
+    block_txids.reserve(block.vtx.size());
+    m_outpoints.clear();
+    for (const auto& tx : block.vtx) {
+        if (!tx->IsCoinBase()) {
+            for (const CTxIn& txin : tx->vin) {
+                if (block_txids.count(txin.prevout.hash)) {
+                    ++stats.intra_block;
+                } else if (cache.HaveCoinInCache(txin.prevout)) {
+                    ++stats.cache_hits;
+                } else {
+                    m_outpoints.push_back(txin.prevout);
+                }
+            }
+        }
+        block_txids.insert(tx->GetHash());
+    }
+    if (m_outpoints.empty()) return stats;
+
+    m_db = &db;
+    m_coins.resize(m_outpoints.size());
+    m_next.store(0, std::memory_order_relaxed);
+    {
+        LOCK(m_mutex);
+        m_pending_workers = m_worker_threads.size();
+        ++m_generation;
+    }
+    m_worker_cv.notify_all();
+    Work();
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_master_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_pending_workers == 0; });
+    }
+
+    for (size_t i = 0; i < m_outpoints.size(); ++i) {
+        if (m_coins[i].IsSpent()) {
+            ++stats.missing;
+        } else {
+            cache.InsertFetchedCoin(m_outpoints[i], std::move(m_coins[i]));
+            ++stats.fetched;
+        }
+    }
+    m_db = nullptr;
+    m_outpoints.clear();
+    m_coins.clear();
+    return stats;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INPUTFETCHER_H
+#define BITCOIN_INPUTFETCHER_H
+
+#include <coins.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+class CBlock;
+
+/**
+ * Pool of threads that read the inputs of a block from the coins database
+ * ahead of ConnectBlock.
+ *
+ * Without it, every input that misses the coins cache is a synchronous
+ * database read on the validation thread, so connecting a block on a cold
+ * cache is bound by read latency rather than CPU. FetchInputs() collects the
+ * outpoints spent by a block that are neither created earlier in the same
+ * block nor already cached, reads them from the database on the worker
+ * threads (the calling thread joins in), and then inserts the results into
+ * the cache on the calling thread. The serial connect loop then finds them
+ * cached.
+ *
+ * Prefetching is purely an optimization: coins that fail to be read here
+ * (e.g. due to a database error) are simply left uncached and will be read
+ * (and the error handled) by the regular lookup path.
+ */
+class InputFetcher
+{
+public:
+    /** Counters for a single FetchInputs() call. */
+    struct Stats {
+        //! Inputs spending an output created earlier in the same block.
+        size_t intra_block{0};
+        //! Inputs whose coin was already in the cache.
+        size_t cache_hits{0};
+        //! Inputs read from the database and inserted into the cache.
+        size_t fetched{0};
+        //! Inputs looked up in the database but not found there.
+        size_t missing{0};
+    };
+
+    //! Create a fetcher with the given number of worker threads. With zero
+    //! workers, FetchInputs() does nothing.
+    explicit InputFetcher(int worker_threads_num);
+    ~InputFetcher();
+
+    InputFetcher(const InputFetcher&) = delete;
+    InputFetcher& operator=(const InputFetcher&) = delete;
+
+    /**
+     * Read the coins spent by block from db into cache.
+     *
+     * db must be safe to read from multiple threads concurrently and must not
+     * be modified while this runs. Only coins not already present in cache are
+     * inserted, unmodified and not DIRTY, so the effect on cache is the same
+     * as looking each of them up individually.
+     */
+    Stats FetchInputs(CCoinsViewCache& cache, const CCoinsView& db, const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    bool HasThreads() const { return !m_worker_threads.empty(); }
+
+private:
+    //! Number of outpoints a thread claims at a time.
+    static constexpr size_t BATCH_SIZE{16};
+
+    Mutex m_mutex;
+    //! Worker threads block on this while waiting for a block.
+    std::condition_variable m_worker_cv;
+    //! The calling thread blocks on this until all workers are done.
+    std::condition_variable m_master_cv;
+    //! Incremented for every block handed to the workers.
+    uint64_t m_generation GUARDED_BY(m_mutex){0};
+    //! Number of workers still processing the current block.
+    size_t m_pending_workers GUARDED_BY(m_mutex){0};
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+
+    /**
+     * Work for the current block. These are written by the calling thread
+     * before m_generation is bumped and read back after m_pending_workers has
+     * dropped to zero, both under m_mutex. In between, workers only read
+     * m_db and m_outpoints, and each writes disjoint elements of m_coins.
+     */
+    const CCoinsView* m_db{nullptr};
+    std::vector<COutPoint> m_outpoints;
+    std::vector<Coin> m_coins;
+    //! Index of the next unclaimed outpoint.
+    std::atomic<size_t> m_next{0};
+
+    std::vector<std::thread> m_worker_threads;
+
+    //! Read claimed batches of outpoints until none are left.
+    void Work();
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+#endif // BITCOIN_INPUTFETCHER_H
@@ -25,6 +25,8 @@ struct BlockManagerOpts {
     const fs::path blocks_dir;
     Notifications& notifications;
     bool reindex{false};
+    //! Maximum number of block files to keep memory mapped for raw block reads, 0 to disable.
+    int block_map_files{0};
 };
 
 } // namespace kernel
@@ -22,6 +22,7 @@ class ValidationSignals;
 
 static constexpr bool DEFAULT_CHECKPOINTS_ENABLED{true};
 static constexpr auto DEFAULT_MAX_TIP_AGE{24h};
+static constexpr bool DEFAULT_PAR_WORK_STEALING{false};
 
 namespace kernel {
 
@@ -48,6 +49,8 @@ struct ChainstateManagerOpts {
     ValidationSignals* signals{nullptr};
     //! Number of script check worker threads. Zero means no parallel verification.
     int worker_threads_num{0};
+    //! Whether the script check workers use per-thread queues and steal work from each other.
+    bool work_stealing{DEFAULT_PAR_WORK_STEALING};
 };
 
 } // namespace kernel
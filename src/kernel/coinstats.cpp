@@ -5,6 +5,7 @@
 #include <kernel/coinstats.h>
 
 #include <chain.h>
+#include <checkqueue.h>
 #include <coins.h>
 #include <crypto/muhash.h>
 #include <hash.h>
@@ -22,6 +23,7 @@
 #include <util/overflow.h>
 #include <validation.h>
 
+#include <atomic>
 #include <cassert>
 #include <iosfwd>
 #include <iterator>
@@ -29,6 +31,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace kernel {
 
@@ -111,13 +114,22 @@ static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<u
     }
 }
 
-//! Calculate statistics about the unspent transaction output set
-template <typename T>
-static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+static void FinalizeHash(HashWriter& ss, CCoinsStats& stats)
 {
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
+    stats.hashSerialized = ss.GetHash();
+}
+static void FinalizeHash(MuHash3072& muhash, CCoinsStats& stats)
+{
+    uint256 out;
+    muhash.Finalize(out);
+    stats.hashSerialized = out;
+}
+static void FinalizeHash(std::nullptr_t, CCoinsStats& stats) {}
 
+//! Add the coins of a cursor to the statistics and the hash
+template <typename T>
+static bool ApplyCoins(CCoinsViewCursor* pcursor, CCoinsStats& stats, T& hash_obj, const std::function<void()>& interruption_point)
+{
     Txid prevkey;
     std::map<uint32_t, Coin> outputs;
     while (pcursor->Valid()) {
@@ -143,6 +155,17 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
         ApplyStats(stats, prevkey, outputs);
         ApplyHash(hash_obj, prevkey, outputs);
     }
+    return true;
+}
+
+//! Calculate statistics about the unspent transaction output set
+template <typename T>
+static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+{
+    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
+    assert(pcursor);
+
+    if (!ApplyCoins(pcursor.get(), stats, hash_obj, interruption_point)) return false;
 
     FinalizeHash(hash_obj, stats);
 
@@ -179,16 +202,86 @@ std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsV
     return stats;
 }
 
-static void FinalizeHash(HashWriter& ss, CCoinsStats& stats)
-{
-    stats.hashSerialized = ss.GetHash();
-}
-static void FinalizeHash(MuHash3072& muhash, CCoinsStats& stats)
+namespace {
+//! Add the coins of one cursor to the statistics and MuHash of its shard
+struct ShardStatsTask {
+    CCoinsViewCursor* cursor;
+    CCoinsStats* stats;
+    //! Null if no hash is computed
+    MuHash3072* muhash;
+    const std::function<void()>* interruption_point;
+    std::atomic<bool>* interrupted;
+
+    bool operator()()
+    {
+        try {
+            if (muhash) return ApplyCoins(cursor, *stats, *muhash, *interruption_point);
+            std::nullptr_t no_hash;
+            return ApplyCoins(cursor, *stats, no_hash, *interruption_point);
+        } catch (...) {
+            // Rethrown from the calling thread
+            *interrupted = true;
+            return false;
+        }
+    }
+};
+} // namespace
+
+std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsViewDB& view, node::BlockManager& blockman, int num_threads, const std::function<void()>& interruption_point)
 {
-    uint256 out;
-    muhash.Finalize(out);
-    stats.hashSerialized = out;
+    // The serialized hash depends on the order of the coins, so only MuHash
+    // and no hash at all can be split over threads.
+    if (hash_type == CoinStatsHashType::HASH_SERIALIZED || num_threads <= 1) {
+        return ComputeUTXOStats(hash_type, &view, blockman, interruption_point);
+    }
+
+    // The cursors read from the same snapshot, whose best block the
+    // statistics are for.
+    const std::vector<std::unique_ptr<CCoinsViewCursor>> cursors{view.ShardedCursors(num_threads)};
+    CBlockIndex* pindex = WITH_LOCK(::cs_main, return blockman.LookupBlockIndex(cursors.front()->GetBestBlock()));
+    CCoinsStats stats{Assert(pindex)->nHeight, pindex->GetBlockHash()};
+
+    // Each thread accumulates its own statistics and MuHash, combined once
+    // all are done.
+    std::vector<CCoinsStats> shard_stats(cursors.size());
+    std::vector<MuHash3072> shard_muhashes(cursors.size());
+    std::atomic<bool> interrupted{false};
+    std::vector<ShardStatsTask> tasks;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        MuHash3072* muhash{hash_type == CoinStatsHashType::MUHASH ? &shard_muhashes[i] : nullptr};
+        tasks.push_back(ShardStatsTask{cursors[i].get(), &shard_stats[i], muhash, &interruption_point, &interrupted});
+    }
+    bool ok;
+    {
+        CCheckQueue<ShardStatsTask> queue(/*batch_size=*/1, cursors.size() - 1,
+                                          /*work_stealing=*/false, /*thread_name=*/"coinstats");
+        CCheckQueueControl<ShardStatsTask> control(&queue);
+        control.Add(std::move(tasks));
+        ok = control.Wait();
+    }
+    if (interrupted) interruption_point();
+    if (!ok) {
+        LogError("%s: unable to read value\n", __func__);
+        return std::nullopt;
+    }
+
+    MuHash3072 muhash;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        const CCoinsStats& shard{shard_stats[i]};
+        stats.nTransactions += shard.nTransactions;
+        stats.nTransactionOutputs += shard.nTransactionOutputs;
+        stats.nBogoSize += shard.nBogoSize;
+        stats.coins_count += shard.coins_count;
+        if (stats.total_amount.has_value()) {
+            stats.total_amount = shard.total_amount.has_value() ? CheckedAdd(*stats.total_amount, *shard.total_amount) : std::nullopt;
+        }
+        muhash *= shard_muhashes[i];
+    }
+    if (hash_type == CoinStatsHashType::MUHASH) FinalizeHash(muhash, stats);
+
+    stats.nDiskSize = view.EstimateSize();
+
+    return stats;
 }
-static void FinalizeHash(std::nullptr_t, CCoinsStats& stats) {}
 
 } // namespace kernel
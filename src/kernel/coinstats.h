@@ -15,6 +15,7 @@
 #include <optional>
 
 class CCoinsView;
+class CCoinsViewDB;
 class Coin;
 class COutPoint;
 class CScript;
@@ -77,6 +78,13 @@ void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& co
 void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
 
 std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
+
+/**
+ * Calculate statistics about the unspent transaction output set, splitting
+ * the coins over num_threads threads by txid. Only MUHASH and NONE are
+ * computed in parallel, as HASH_SERIALIZED depends on the order of the coins.
+ */
+std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsViewDB& view, node::BlockManager& blockman, int num_threads, const std::function<void()>& interruption_point = {});
 } // namespace kernel
 
 #endif // BITCOIN_KERNEL_COINSTATS_H
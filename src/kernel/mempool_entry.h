@@ -10,18 +10,21 @@
 #include <core_memusage.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <prevector.h>
 #include <primitives/transaction.h>
 #include <util/epochguard.h>
 #include <util/overflow.h>
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <memory>
-#include <set>
 #include <stddef.h>
 #include <stdint.h>
+#include <utility>
 
 class CBlockIndex;
+struct TxMempoolCluster;
 
 struct LockPoints {
     // Will be set to the blockchain height and median time past
@@ -50,6 +53,59 @@ struct CompareIteratorByHash {
     }
 };
 
+/**
+ * Set of references to other mempool entries, kept as a vector sorted by txid.
+ *
+ * Almost all transactions have at most two in-mempool parents or children,
+ * which fit in the inline storage without any allocation. A std::set would
+ * take twice the space for the empty set, plus one allocation per element.
+ */
+template <typename Ref>
+class SortedEntryRefs
+{
+    prevector<2, Ref> m_refs;
+
+    //! Position of the first element not ordered before ref
+    size_t LowerBound(const Ref& ref) const
+    {
+        return std::lower_bound(m_refs.begin(), m_refs.end(), ref, CompareIteratorByHash{}) - m_refs.begin();
+    }
+    bool Matches(size_t pos, const Ref& ref) const { return pos < m_refs.size() && !CompareIteratorByHash{}(ref, m_refs[pos]); }
+
+public:
+    using const_iterator = typename prevector<2, Ref>::const_iterator;
+
+    const_iterator begin() const { return m_refs.begin(); }
+    const_iterator end() const { return m_refs.end(); }
+    const_iterator cbegin() const { return m_refs.begin(); }
+    const_iterator cend() const { return m_refs.end(); }
+    size_t size() const { return m_refs.size(); }
+    bool empty() const { return m_refs.empty(); }
+    void clear() { m_refs.clear(); }
+
+    size_t count(const Ref& ref) const { return Matches(LowerBound(ref), ref); }
+
+    /** Insert ref, keeping the order. Like std::set::insert, also returns whether it was not present yet. */
+    std::pair<const_iterator, bool> insert(const Ref& ref)
+    {
+        const size_t pos{LowerBound(ref)};
+        if (Matches(pos, ref)) return {begin() + pos, false};
+        m_refs.insert(m_refs.begin() + pos, ref);
+        return {begin() + pos, true};
+    }
+
+    /** Remove ref. Returns the number of elements removed, like std::set::erase. */
+    size_t erase(const Ref& ref)
+    {
+        const size_t pos{LowerBound(ref)};
+        if (!Matches(pos, ref)) return 0;
+        m_refs.erase(m_refs.begin() + pos);
+        return 1;
+    }
+
+    size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(m_refs); }
+};
+
 /** \class CTxMemPoolEntry
  *
  * CTxMemPoolEntry stores data about the corresponding transaction, as well
@@ -67,8 +123,8 @@ class CTxMemPoolEntry
 public:
     typedef std::reference_wrapper<const CTxMemPoolEntry> CTxMemPoolEntryRef;
     // two aliases, should the types ever diverge
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Parents;
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
+    typedef SortedEntryRefs<CTxMemPoolEntryRef> Parents;
+    typedef SortedEntryRefs<CTxMemPoolEntryRef> Children;
 
 private:
     CTxMemPoolEntry(const CTxMemPoolEntry&) = default;
@@ -76,16 +132,15 @@ private:
         explicit ExplicitCopyTag() = default;
     };
 
+    // Members are ordered by size so that the 4-byte fields pack together
+    // without padding; every entry is stored once per mempool transaction.
     const CTransactionRef tx;
     mutable Parents m_parents;
     mutable Children m_children;
     const CAmount nFee;             //!< Cached to avoid expensive parent-transaction lookups
-    const int32_t nTxWeight;         //!< ... and avoid recomputing tx weight (also used for GetTxSize())
     const size_t nUsageSize;        //!< ... and total memory usage
     const int64_t nTime;            //!< Local time when entering the mempool
     const uint64_t entry_sequence;  //!< Sequence number used to determine whether this transaction is too recent for relay
-    const unsigned int entryHeight; //!< Chain height when entering the mempool
-    const bool spendsCoinbase;      //!< keep track of transactions that spend a coinbase
     const int64_t sigOpCost;        //!< Total sigop cost
     CAmount m_modified_fee;         //!< Used for determining the priority of the transaction for mining in a block
     mutable LockPoints lockPoints;  //!< Track the height and time at which tx was final
@@ -93,18 +148,23 @@ private:
     // Information about descendants of this transaction that are in the
     // mempool; if we remove this transaction we must remove all of these
     // descendants as well.
-    int64_t m_count_with_descendants{1}; //!< number of descendant transactions
     // Using int64_t instead of int32_t to avoid signed integer overflow issues.
-    int64_t nSizeWithDescendants;      //!< ... and size
+    int64_t nSizeWithDescendants;      //!< size of descendant transactions
     CAmount nModFeesWithDescendants;   //!< ... and total fees (all including us)
 
     // Analogous statistics for ancestor transactions
-    int64_t m_count_with_ancestors{1};
     // Using int64_t instead of int32_t to avoid signed integer overflow issues.
     int64_t nSizeWithAncestors;
     CAmount nModFeesWithAncestors;
     int64_t nSigOpCostWithAncestors;
 
+    const int32_t nTxWeight;         //!< Cached to avoid recomputing tx weight (also used for GetTxSize())
+    const unsigned int entryHeight; //!< Chain height when entering the mempool
+    // Counts are bounded by the number of transactions in the mempool.
+    int32_t m_count_with_descendants{1}; //!< number of descendant transactions
+    int32_t m_count_with_ancestors{1};
+    const bool spendsCoinbase;      //!< keep track of transactions that spend a coinbase
+
 public:
     CTxMemPoolEntry(const CTransactionRef& tx, CAmount fee,
                     int64_t time, unsigned int entry_height, uint64_t entry_sequence,
@@ -112,20 +172,21 @@ public:
                     int64_t sigops_cost, LockPoints lp)
         : tx{tx},
           nFee{fee},
-          nTxWeight{GetTransactionWeight(*tx)},
           nUsageSize{RecursiveDynamicUsage(tx)},
           nTime{time},
           entry_sequence{entry_sequence},
-          entryHeight{entry_height},
-          spendsCoinbase{spends_coinbase},
           sigOpCost{sigops_cost},
           m_modified_fee{nFee},
           lockPoints{lp},
-          nSizeWithDescendants{GetTxSize()},
           nModFeesWithDescendants{nFee},
-          nSizeWithAncestors{GetTxSize()},
           nModFeesWithAncestors{nFee},
-          nSigOpCostWithAncestors{sigOpCost} {}
+          nSigOpCostWithAncestors{sigOpCost},
+          nTxWeight{GetTransactionWeight(*tx)},
+          entryHeight{entry_height},
+          spendsCoinbase{spends_coinbase}
+    {
+        nSizeWithDescendants = nSizeWithAncestors = GetTxSize();
+    }
 
     CTxMemPoolEntry(ExplicitCopyTag, const CTxMemPoolEntry& entry) : CTxMemPoolEntry(entry) {}
     CTxMemPoolEntry& operator=(const CTxMemPoolEntry&) = delete;
@@ -184,8 +245,11 @@ public:
     Parents& GetMemPoolParents() const { return m_parents; }
     Children& GetMemPoolChildren() const { return m_children; }
 
+    // Next to spendsCoinbase, so that both fit in 8 bytes.
+    mutable uint32_t m_cluster_pos{0}; //!< Index in the cluster's m_txs
     mutable size_t idx_randomized; //!< Index in mempool's txns_randomized
     mutable Epoch::Marker m_epoch_marker; //!< epoch when last touched, useful for graph algorithms
+    mutable TxMempoolCluster* m_cluster{nullptr}; //!< Cluster this entry belongs to (only with -clustermempool)
 };
 
 using CTxMemPoolEntryRef = CTxMemPoolEntry::CTxMemPoolEntryRef;
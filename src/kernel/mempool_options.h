@@ -23,6 +23,8 @@ static constexpr unsigned int DEFAULT_BLOCKSONLY_MAX_MEMPOOL_SIZE_MB{5};
 static constexpr unsigned int DEFAULT_MEMPOOL_EXPIRY_HOURS{336};
 /** Default for -mempoolfullrbf, if the transaction replaceability signaling is ignored */
 static constexpr bool DEFAULT_MEMPOOL_FULL_RBF{false};
+/** Default for -clustermempool, if transactions are mined and evicted by cluster linearization chunks */
+static constexpr bool DEFAULT_CLUSTER_MEMPOOL{false};
 /** Whether to fall back to legacy V1 serialization when writing mempool.dat */
 static constexpr bool DEFAULT_PERSIST_V1_DAT{false};
 /** Default for -acceptnonstdtxn */
@@ -57,6 +59,11 @@ struct MemPoolOptions {
     bool require_standard{true};
     bool full_rbf{DEFAULT_MEMPOOL_FULL_RBF};
     bool persist_v1_dat{DEFAULT_PERSIST_V1_DAT};
+    /**
+     * Track the connected components (clusters) of the mempool with a linearization, mine their
+     * chunks in feerate order and evict the lowest feerate chunk when the mempool is full.
+     */
+    bool cluster_mempool{DEFAULT_CLUSTER_MEMPOOL};
     MemPoolLimits limits{};
 
     ValidationSignals* signals{nullptr};
@@ -43,15 +43,108 @@ const int kNumNonTableCacheFiles = 10;
 // Information kept for every waiting writer
 struct DBImpl::Writer {
   explicit Writer(port::Mutex* mu)
-      : batch(nullptr), sync(false), done(false), cv(mu) {}
+      : batch(nullptr), sync(false), done(false), bulk_load(false), cv(mu) {}
 
   Status status;
   WriteBatch* batch;
   bool sync;
   bool done;
+  bool bulk_load;  // Takes a sequence number for a bulk load, never grouped
   port::CondVar cv;
 };
 
+class DBImpl::BulkLoadImpl : public BulkLoad {
+ public:
+  BulkLoadImpl(DBImpl* db, uint64_t number, SequenceNumber sequence,
+               WritableFile* file)
+      : db_(db),
+        number_(number),
+        sequence_(sequence),
+        file_(file),
+        builder_(new TableBuilder(db->options_, file)),
+        finished_(false),
+        ingested_(false),
+        file_size_(0) {}
+
+  ~BulkLoadImpl() override {
+    if (!finished_) {
+      builder_->Abandon();
+    }
+    delete builder_;
+    delete file_;
+    if (!ingested_) {
+      db_->env_->DeleteFile(TableFileName(db_->dbname_, number_));
+      MutexLock l(&db_->mutex_);
+      db_->pending_outputs_.erase(number_);
+    }
+  }
+
+  void Put(const Slice& key, const Slice& value) override {
+    Add(key, kTypeValue, value);
+  }
+
+  void Delete(const Slice& key) override { Add(key, kTypeDeletion, Slice()); }
+
+  uint64_t NumEntries() const override { return builder_->NumEntries(); }
+
+  Status status() const override { return status_; }
+
+ private:
+  friend class DBImpl;
+
+  void Add(const Slice& key, ValueType type, const Slice& value) {
+    if (!status_.ok() || finished_) {
+      return;
+    }
+    if (builder_->NumEntries() > 0 &&
+        db_->user_comparator()->Compare(key, ExtractUserKey(last_key_)) <= 0) {
+      status_ = Status::InvalidArgument("bulk load keys are not increasing");
+      return;
+    }
+    // All entries share the sequence number taken when the bulk load was
+    // started, as their keys are distinct.
+    last_key_.clear();
+    AppendInternalKey(&last_key_, ParsedInternalKey(key, sequence_, type));
+    if (builder_->NumEntries() == 0) {
+      smallest_.DecodeFrom(last_key_);
+    }
+    builder_->Add(last_key_, value);
+    status_ = builder_->status();
+  }
+
+  // Write out and sync the table file.
+  Status Finish() {
+    if (!status_.ok()) {
+      return status_;
+    }
+    finished_ = true;
+    largest_.DecodeFrom(last_key_);
+    Status s = builder_->Finish();
+    file_size_ = builder_->FileSize();
+    if (s.ok()) {
+      s = file_->Sync();
+    }
+    if (s.ok()) {
+      s = file_->Close();
+    }
+    status_ = s;
+    return s;
+  }
+
+  DBImpl* const db_;
+  uint64_t number_;
+  const SequenceNumber sequence_;
+  WritableFile* file_;
+  TableBuilder* builder_;
+  bool finished_;
+  bool ingested_;
+  uint64_t file_size_;
+  std::string last_key_;
+  InternalKey smallest_;
+  InternalKey largest_;
+  Status status_;
+};
+
 struct DBImpl::CompactionState {
   // Files produced by compaction
   struct Output {
@@ -146,6 +239,7 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
       seed_(0),
       tmp_batch_(new WriteBatch),
       background_compaction_scheduled_(false),
+      bulk_load_ingesting_(false),
       manual_compaction_(nullptr),
       versions_(new VersionSet(dbname_, &options_, table_cache_,
                                &internal_comparator_)) {}
@@ -631,7 +725,9 @@ void DBImpl::TEST_CompactRange(int level, const Slice* begin,
   }
 }
 
-Status DBImpl::TEST_CompactMemTable() {
+Status DBImpl::TEST_CompactMemTable() { return FlushMemTable(); }
+
+Status DBImpl::FlushMemTable() {
   // nullptr batch means just wait for earlier writes to be done
   Status s = Write(WriteOptions(), nullptr);
   if (s.ok()) {
@@ -647,6 +743,176 @@ Status DBImpl::TEST_CompactMemTable() {
   return s;
 }
 
+bool DBImpl::MemTableOverlaps(const Slice& smallest, const Slice& largest,
+                              SequenceNumber sequence, bool* newer) {
+  mutex_.AssertHeld();
+  InternalKey seek_key(smallest, kMaxSequenceNumber, kValueTypeForSeek);
+  bool overlaps = false;
+  *newer = false;
+  for (MemTable* mem : {mem_, imm_}) {
+    if (mem == nullptr) {
+      continue;
+    }
+    Iterator* iter = mem->NewIterator();
+    for (iter->Seek(seek_key.Encode()); iter->Valid() && !*newer;
+         iter->Next()) {
+      ParsedInternalKey ikey;
+      if (!ParseInternalKey(iter->key(), &ikey) ||
+          user_comparator()->Compare(ikey.user_key, largest) > 0) {
+        break;
+      }
+      overlaps = true;
+      *newer = ikey.sequence > sequence;
+    }
+    delete iter;
+  }
+  return overlaps;
+}
+
+Status DBImpl::NewBulkLoad(BulkLoad** result) {
+  *result = nullptr;
+  Writer w(&mutex_);
+  w.bulk_load = true;
+
+  MutexLock l(&mutex_);
+  if (!bg_error_.ok()) {
+    return bg_error_;
+  }
+
+  // No write is in progress while this writer is at the front of the queue,
+  // so the sequence number taken here is after all earlier writes and before
+  // all later ones.
+  writers_.push_back(&w);
+  while (&w != writers_.front()) {
+    w.cv.Wait();
+  }
+  const SequenceNumber sequence = versions_->LastSequence() + 1;
+  versions_->SetLastSequence(sequence);
+  writers_.pop_front();
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
+
+  const uint64_t number = versions_->NewFileNumber();
+  pending_outputs_.insert(number);
+  WritableFile* file;
+  Status s = env_->NewWritableFile(TableFileName(dbname_, number), &file);
+  if (!s.ok()) {
+    pending_outputs_.erase(number);
+    return s;
+  }
+  *result = new BulkLoadImpl(this, number, sequence, file);
+  return s;
+}
+
+Status DBImpl::IngestBulkLoad(BulkLoad* bulk_load) {
+  BulkLoadImpl* load = static_cast<BulkLoadImpl*>(bulk_load);
+  assert(!load->finished_);
+  const uint64_t start_micros = env_->NowMicros();
+  Status s = load->Finish();
+  if (!s.ok() || load->NumEntries() == 0) {
+    return s;
+  }
+  const Slice smallest = load->smallest_.user_key();
+  const Slice largest = load->largest_.user_key();
+
+  // Entries in the memtable are older than the bulk load, but would be read
+  // before it, so they are moved into tables first.
+  bool newer;
+  mutex_.Lock();
+  bool memtable_overlaps =
+      MemTableOverlaps(smallest, largest, load->sequence_, &newer);
+  mutex_.Unlock();
+  if (newer) {
+    return Status::InvalidArgument("bulk load overlaps later writes");
+  }
+  if (memtable_overlaps) {
+    s = FlushMemTable();
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
+  MutexLock l(&mutex_);
+  memtable_overlaps =
+      MemTableOverlaps(smallest, largest, load->sequence_, &newer);
+  if (memtable_overlaps) {
+    return Status::InvalidArgument("bulk load overlaps later writes");
+  }
+
+  // Compactions change the levels the table is placed by, so none may run
+  // until it is added.
+  while (background_compaction_scheduled_) {
+    background_work_finished_signal_.Wait();
+  }
+  if (!bg_error_.ok()) {
+    return bg_error_;
+  }
+  // A snapshot taken since the bulk load was started has a later sequence
+  // number, so it would see the entries appear.
+  if (!snapshots_.empty() &&
+      snapshots_.newest()->sequence_number() >= load->sequence_) {
+    return Status::InvalidArgument("bulk load overlaps a later snapshot");
+  }
+  bulk_load_ingesting_ = true;
+
+  // The table is given a new number, so that it is newer than the level-0
+  // tables written since the bulk load was started.
+  const uint64_t old_number = load->number_;
+  const uint64_t number = versions_->NewFileNumber();
+  pending_outputs_.insert(number);
+  mutex_.Unlock();
+  s = env_->RenameFile(TableFileName(dbname_, old_number),
+                       TableFileName(dbname_, number));
+  if (s.ok()) {
+    load->number_ = number;
+    // Verify that the table is usable
+    Iterator* iter =
+        table_cache_->NewIterator(ReadOptions(), number, load->file_size_);
+    s = iter->status();
+    delete iter;
+  }
+  mutex_.Lock();
+  pending_outputs_.erase(old_number);
+
+  // Place the table at the deepest level where no table on it or above
+  // overlaps it, so that it does not need to be compacted. Level-0 tables
+  // may overlap, and the newest one is read first.
+  int level = 0;
+  if (s.ok()) {
+    Version* base = versions_->current();
+    if (!base->OverlapInLevel(0, &smallest, &largest)) {
+      while (level + 1 < config::kNumLevels &&
+             !base->OverlapInLevel(level + 1, &smallest, &largest)) {
+        level++;
+      }
+    }
+    VersionEdit edit;
+    edit.AddFile(level, number, load->file_size_, load->smallest_,
+                 load->largest_);
+    s = versions_->LogAndApply(&edit, &mutex_);
+  }
+  if (s.ok()) {
+    load->ingested_ = true;
+  }
+  pending_outputs_.erase(number);
+  bulk_load_ingesting_ = false;
+  background_work_finished_signal_.SignalAll();
+  MaybeScheduleCompaction();
+
+  Log(options_.info_log, "Bulk load table #%llu@%d: %lld entries, %lld bytes %s",
+      (unsigned long long)number, level,
+      (unsigned long long)load->NumEntries(),
+      (unsigned long long)load->file_size_, s.ToString().c_str());
+  if (s.ok()) {
+    CompactionStats stats;
+    stats.micros = env_->NowMicros() - start_micros;
+    stats.bytes_written = load->file_size_;
+    stats_[level].Add(stats);
+  }
+  return s;
+}
+
 void DBImpl::RecordBackgroundError(const Status& s) {
   mutex_.AssertHeld();
   if (bg_error_.ok()) {
@@ -661,6 +927,8 @@ void DBImpl::MaybeScheduleCompaction() {
     // Already scheduled
   } else if (shutting_down_.load(std::memory_order_acquire)) {
     // DB is being deleted; no more background compactions
+  } else if (bulk_load_ingesting_) {
+    // Scheduled once the bulk load is added
   } else if (!bg_error_.ok()) {
     // Already got an error; no more changes
   } else if (imm_ == nullptr && manual_compaction_ == nullptr &&
@@ -1176,6 +1444,11 @@ void DBImpl::RecordReadSample(Slice key) {
 
 const Snapshot* DBImpl::GetSnapshot() {
   MutexLock l(&mutex_);
+  // A snapshot taken while a bulk load is added would only see it if read
+  // after it is.
+  while (bulk_load_ingesting_) {
+    background_work_finished_signal_.Wait();
+  }
   return snapshots_.New(versions_->LastSequence());
 }
 
@@ -1295,6 +1568,11 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
       break;
     }
 
+    if (w->bulk_load) {
+      // Must be at the front of the queue itself.
+      break;
+    }
+
     if (w->batch != nullptr) {
       size += WriteBatchInternal::ByteSize(w->batch);
       if (size > max_size) {
@@ -1474,6 +1752,15 @@ Status DB::Delete(const WriteOptions& opt, const Slice& key) {
   return Write(opt, &batch);
 }
 
+Status DB::NewBulkLoad(BulkLoad** result) {
+  *result = nullptr;
+  return Status::NotSupported("NewBulkLoad");
+}
+
+Status DB::IngestBulkLoad(BulkLoad* bulk_load) {
+  return Status::NotSupported("IngestBulkLoad");
+}
+
 DB::~DB() = default;
 
 Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
@@ -1521,6 +1808,8 @@ Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
 
 Snapshot::~Snapshot() = default;
 
+BulkLoad::~BulkLoad() = default;
+
 Status DestroyDB(const std::string& dbname, const Options& options) {
   Env* env = options.env;
   std::vector<std::string> filenames;
@@ -40,6 +40,8 @@ class DBImpl : public DB {
              const Slice& value) override;
   Status Delete(const WriteOptions&, const Slice& key) override;
   Status Write(const WriteOptions& options, WriteBatch* updates) override;
+  Status NewBulkLoad(BulkLoad** result) override;
+  Status IngestBulkLoad(BulkLoad* bulk_load) override;
   Status Get(const ReadOptions& options, const Slice& key,
              std::string* value) override;
   Iterator* NewIterator(const ReadOptions&) override;
@@ -73,6 +75,7 @@ class DBImpl : public DB {
 
  private:
   friend class DB;
+  class BulkLoadImpl;
   struct CompactionState;
   struct Writer;
 
@@ -137,6 +140,15 @@ class DBImpl : public DB {
 
   void RecordBackgroundError(const Status& s);
 
+  // Force the memtable to be compacted and wait until it is.
+  Status FlushMemTable();
+
+  // Whether the memtables have keys in [smallest, largest]. Sets *newer to
+  // whether any of them was written after "sequence".
+  bool MemTableOverlaps(const Slice& smallest, const Slice& largest,
+                        SequenceNumber sequence, bool* newer)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   void MaybeScheduleCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   static void BGWork(void* db);
   void BackgroundCall();
@@ -195,6 +207,10 @@ class DBImpl : public DB {
   // Has a background compaction been scheduled or is running?
   bool background_compaction_scheduled_ GUARDED_BY(mutex_);
 
+  // Is a bulk load being ingested? No compactions are scheduled and no
+  // snapshots are taken meanwhile.
+  bool bulk_load_ingesting_ GUARDED_BY(mutex_);
+
   ManualCompaction* manual_compaction_ GUARDED_BY(mutex_);
 
   VersionSet* const versions_ GUARDED_BY(mutex_);
@@ -40,6 +40,34 @@ struct LEVELDB_EXPORT Range {
   Slice limit;  // Not included in the range
 };
 
+// A set of entries written into a table file of its own by DB::NewBulkLoad,
+// to be added to the DB by DB::IngestBulkLoad.
+class LEVELDB_EXPORT BulkLoad {
+ public:
+  BulkLoad() = default;
+
+  BulkLoad(const BulkLoad&) = delete;
+  BulkLoad& operator=(const BulkLoad&) = delete;
+
+  // Deletes the table file if it was not ingested.
+  virtual ~BulkLoad();
+
+  // Set the entry for "key" to "value". Keys must be added in strictly
+  // increasing order.
+  virtual void Put(const Slice& key, const Slice& value) = 0;
+
+  // Remove the entry (if any) for "key". Keys must be added in strictly
+  // increasing order.
+  virtual void Delete(const Slice& key) = 0;
+
+  // Number of entries added so far.
+  virtual uint64_t NumEntries() const = 0;
+
+  // Returns non-ok iff some error has been detected, such as keys that are
+  // not increasing.
+  virtual Status status() const = 0;
+};
+
 // A DB is a persistent ordered map from keys to values.
 // A DB is safe for concurrent access from multiple threads without
 // any external synchronization.
@@ -77,6 +105,26 @@ class LEVELDB_EXPORT DB {
   // Note: consider setting options.sync = true.
   virtual Status Write(const WriteOptions& options, WriteBatch* updates) = 0;
 
+  // Start writing sorted entries into a table file of their own, which
+  // IngestBulkLoad adds to the database without going through the log and
+  // memtable, at the deepest level where it does not overlap other tables.
+  // This is faster than Write when there are many entries.
+  //
+  // The entries are ordered after all writes made before this call. No keys
+  // in the range of the bulk load may be written until it is ingested.
+  // Snapshots taken before this call never see its entries.
+  //
+  // Stores a heap-allocated bulk load in *result, which the caller should
+  // delete when it is no longer needed, and before this db is deleted.
+  virtual Status NewBulkLoad(BulkLoad** result);
+
+  // Finish the table file of "bulk_load" and add its entries to the database,
+  // first flushing the memtable if it overlaps them. Returns OK on success,
+  // and InvalidArgument if the entries are not sorted, overlap writes made
+  // since the bulk load was started that are still in the memtable, or if a
+  // snapshot taken since it was started is still held.
+  virtual Status IngestBulkLoad(BulkLoad* bulk_load);
+
   // If the database contains an entry for "key" store the
   // corresponding value in *value and return OK.
   //
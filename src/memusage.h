@@ -5,6 +5,7 @@
 #ifndef BITCOIN_MEMUSAGE_H
 #define BITCOIN_MEMUSAGE_H
 
+#include <flatmap.h>
 #include <indirectmap.h>
 #include <prevector.h>
 #include <support/allocators/pool.h>
@@ -202,6 +203,12 @@ static inline size_t DynamicUsage(const std::unordered_map<Key,
     return usage_resource + usage_chunks + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+static inline size_t DynamicUsage(const FlatMap<Key, T, Hash, KeyEqual>& m)
+{
+    return MallocUsage(m.allocated_memory());
+}
+
 } // namespace memusage
 
 #endif // BITCOIN_MEMUSAGE_H
@@ -35,6 +35,11 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Op
 
     if (auto value{args.GetBoolArg("-reindex")}) opts.reindex = *value;
 
+    opts.block_map_files = args.GetIntArg("-blockmapfiles", DEFAULT_BLOCK_MAP_FILES);
+    if (opts.block_map_files < 0) {
+        return util::Error{_("-blockmapfiles cannot be configured with a negative value.")};
+    }
+
     return {};
 }
 } // namespace node
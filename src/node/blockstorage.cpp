@@ -31,11 +31,13 @@
 #include <util/batchpriority.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/mappedfile.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <map>
 #include <unordered_map>
 
@@ -761,7 +763,19 @@ bool BlockManager::FlushBlockFile(int blockfile_num, bool fFinalize, bool finali
     assert(static_cast<int>(m_blockfile_info.size()) > blockfile_num);
 
     FlatFilePos block_pos_old(blockfile_num, m_blockfile_info[blockfile_num].nSize);
-    if (!BlockFileSeq().Flush(block_pos_old, fFinalize)) {
+    bool flushed;
+    if (fFinalize) {
+        // Finalizing truncates the pre-allocated space off the file. Reads
+        // through a mapping check their range with m_mapped_files_mutex held,
+        // so drop the mapping and truncate under it. Views handed out earlier
+        // only cover blocks, which are kept.
+        LOCK(m_mapped_files_mutex);
+        m_mapped_files.remove_if([&](const auto& entry) { return entry.first == blockfile_num; });
+        flushed = BlockFileSeq().Flush(block_pos_old, /*finalize=*/true);
+    } else {
+        flushed = BlockFileSeq().Flush(block_pos_old, /*finalize=*/false);
+    }
+    if (!flushed) {
         m_opts.notifications.flushError(_("Flushing block file to disk failed. This is likely the result of an I/O error."));
         success = false;
     }
@@ -810,6 +824,8 @@ uint64_t BlockManager::CalculateCurrentUsage()
 
 void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
 {
+    // Don't keep the space of deleted files in use through their mappings.
+    WITH_LOCK(m_mapped_files_mutex, m_mapped_files.remove_if([&](const auto& entry) { return setFilesToPrune.count(entry.first); }));
     std::error_code ec;
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
@@ -1142,6 +1158,61 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
     return true;
 }
 
+std::shared_ptr<const MappedFile> BlockManager::GetMappedBlockFile(int file_num, size_t min_size) const
+{
+    AssertLockHeld(m_mapped_files_mutex);
+    if (m_opts.block_map_files <= 0) return nullptr;
+    auto it{std::find_if(m_mapped_files.begin(), m_mapped_files.end(), [&](const auto& entry) { return entry.first == file_num; })};
+    if (it != m_mapped_files.end()) {
+        m_mapped_files.splice(m_mapped_files.begin(), m_mapped_files, it);
+        // The file may have grown since it was mapped. Outstanding views keep
+        // the old mapping alive until they are done with it.
+        if (it->second->Size() >= min_size) return it->second;
+        m_mapped_files.pop_front();
+    }
+    std::shared_ptr<const MappedFile> file{MappedFile::Open(BlockFileSeq().FileName(FlatFilePos{file_num, 0}))};
+    if (!file || file->Size() < min_size) return nullptr;
+    m_mapped_files.emplace_front(file_num, file);
+    if (m_mapped_files.size() > size_t(m_opts.block_map_files)) m_mapped_files.pop_back();
+    return file;
+}
+
+std::optional<RawBlockData> BlockManager::ReadMappedRawBlock(const FlatFilePos& pos) const
+{
+    const size_t header_pos{pos.nPos - BLOCK_SERIALIZATION_HEADER_SIZE};
+    // Held until the range of the block has been checked against the mapping,
+    // so that the file can't be truncated below the mapping meanwhile.
+    LOCK(m_mapped_files_mutex);
+    auto file{GetMappedBlockFile(pos.nFile, pos.nPos)};
+    if (!file) return std::nullopt;
+
+    MessageStartChars blk_start;
+    unsigned int blk_size;
+    SpanReader{UCharSpanCast(file->Data().subspan(header_pos, BLOCK_SERIALIZATION_HEADER_SIZE))} >> blk_start >> blk_size;
+    // Leave reporting corrupt data to the regular read path.
+    if (blk_start != GetParams().MessageStart() || blk_size > MAX_SIZE) return std::nullopt;
+    if (file->Size() - pos.nPos < blk_size) {
+        file = GetMappedBlockFile(pos.nFile, size_t{pos.nPos} + blk_size);
+        if (!file) return std::nullopt;
+    }
+    const auto data{file->Data().subspan(pos.nPos, blk_size)};
+    return RawBlockData{std::move(file), data};
+}
+
+bool BlockManager::ReadRawBlockFromDisk(RawBlockData& block, const FlatFilePos& pos) const
+{
+    if (pos.nPos >= BLOCK_SERIALIZATION_HEADER_SIZE) {
+        if (auto mapped{ReadMappedRawBlock(pos)}) {
+            block = std::move(*mapped);
+            return true;
+        }
+    }
+    std::vector<uint8_t> buffer;
+    if (!ReadRawBlockFromDisk(buffer, pos)) return false;
+    block = RawBlockData{std::move(buffer)};
+    return true;
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight)
 {
     unsigned int nBlockSize = ::GetSerializeSize(TX_WITH_WITNESS(block));
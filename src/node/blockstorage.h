@@ -19,12 +19,14 @@
 #include <uint256.h>
 #include <util/fs.h>
 #include <util/hasher.h>
+#include <util/mappedfile.h>
 
 #include <array>
 #include <atomic>
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <list>
 #include <map>
 #include <memory>
 #include <optional>
@@ -76,6 +78,39 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE = std::tuple_size_v<MessageStartChars> + sizeof(unsigned int);
 
+/** Default for -blockmapfiles, the number of blk?????.dat files kept memory mapped for reading raw blocks */
+static constexpr int DEFAULT_BLOCK_MAP_FILES{sizeof(void*) > 4 ? 64 : 0};
+
+/**
+ * A serialized block as read by BlockManager::ReadRawBlockFromDisk(). The
+ * bytes are either a view into a memory mapped block file, which this keeps
+ * mapped for as long as it lives, or a buffer owned by this object.
+ */
+class RawBlockData
+{
+public:
+    RawBlockData() = default;
+    RawBlockData(std::shared_ptr<const MappedFile> file, Span<const std::byte> data)
+        : m_file{std::move(file)}, m_data{data} {}
+    explicit RawBlockData(std::vector<uint8_t>&& buffer)
+        : m_buffer{std::move(buffer)}, m_data{MakeByteSpan(m_buffer)} {}
+
+    // The view may point into m_buffer, which moving preserves but copying does not.
+    RawBlockData(RawBlockData&&) = default;
+    RawBlockData& operator=(RawBlockData&&) = default;
+    RawBlockData(const RawBlockData&) = delete;
+    RawBlockData& operator=(const RawBlockData&) = delete;
+
+    Span<const std::byte> Data() const { return m_data; }
+    //! Whether Data() views a memory mapped file rather than a copy.
+    bool IsMapped() const { return m_file != nullptr; }
+
+private:
+    std::shared_ptr<const MappedFile> m_file;
+    std::vector<uint8_t> m_buffer;
+    Span<const std::byte> m_data;
+};
+
 // Because validation code takes pointers to the map's CBlockIndex objects, if
 // we ever switch to another associative container, we need to either use a
 // container that has stable addressing (true of all std associative
@@ -148,7 +183,7 @@ private:
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /** Return false if block file or undo file flushing fails. */
-    [[nodiscard]] bool FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo);
+    [[nodiscard]] bool FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo) EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
 
     /** Return false if undo file flushing fails. */
     [[nodiscard]] bool FlushUndoFile(int block_file, bool finalize = false);
@@ -171,6 +206,19 @@ private:
 
     AutoFile OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false) const;
 
+    mutable Mutex m_mapped_files_mutex;
+    //! Memory mapped block files by file number, most recently used first.
+    mutable std::list<std::pair<int, std::shared_ptr<const MappedFile>>> m_mapped_files GUARDED_BY(m_mapped_files_mutex);
+
+    /**
+     * Get a mapping of block file file_num that is at least min_size bytes
+     * long, mapping (or remapping, if it has grown) the file if needed.
+     * Returns nullptr if mapping is disabled or fails.
+     */
+    std::shared_ptr<const MappedFile> GetMappedBlockFile(int file_num, size_t min_size) const EXCLUSIVE_LOCKS_REQUIRED(m_mapped_files_mutex);
+    //! Read a raw block through a file mapping, see ReadRawBlockFromDisk().
+    std::optional<RawBlockData> ReadMappedRawBlock(const FlatFilePos& pos) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
+
     /**
      * Write a block to disk. The pos argument passed to this function is modified by this call. Before this call, it should
      * point to an unused file location where separator fields will be written, followed by the serialized CBlock data.
@@ -395,12 +443,18 @@ public:
     /**
      *  Actually unlink the specified files
      */
-    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const;
+    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
 
     /** Functions for disk access for blocks */
     bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) const;
     bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const;
     bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
+    /**
+     * Read a serialized block, without copying it if possible: the result
+     * views the block in its memory mapped block file (see -blockmapfiles),
+     * falling back to reading it into a buffer when mapping is disabled or fails.
+     */
+    bool ReadRawBlockFromDisk(RawBlockData& block, const FlatFilePos& pos) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
 
     bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const;
 
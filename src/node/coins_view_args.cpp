@@ -12,5 +12,7 @@ void ReadCoinsViewArgs(const ArgsManager& args, CoinsViewOptions& options)
 {
     if (auto value = args.GetIntArg("-dbbatchsize")) options.batch_write_bytes = *value;
     if (auto value = args.GetIntArg("-dbcrashratio")) options.simulate_crash_ratio = *value;
+    if (auto value = args.GetBoolArg("-dbbackgroundflush")) options.background_flush = *value;
+    if (auto value = args.GetIntArg("-dbbulkloadmincoins")) options.bulk_load_min_coins = *value;
 }
 } // namespace node
@@ -38,6 +38,7 @@ class SignalInterrupt;
 }
 
 namespace node {
+class BlockTemplateCache;
 class KernelNotifications;
 
 //! NodeContext struct containing references to chain state and connection
@@ -65,6 +66,8 @@ struct NodeContext {
     std::unique_ptr<CBlockPolicyEstimator> fee_estimator;
     std::unique_ptr<PeerManager> peerman;
     std::unique_ptr<ChainstateManager> chainman;
+    //! Keeps the getblocktemplate block template up to date with the mempool
+    std::unique_ptr<BlockTemplateCache> block_template_cache;
     std::unique_ptr<BanMan> banman;
     ArgsManager* args{nullptr}; // Currently a raw pointer because the memory is not managed by this struct
     std::vector<BaseIndex*> indexes; // raw pointers because memory is not managed by this struct
@@ -95,6 +95,8 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& argsman, const CChainP
 
     mempool_opts.persist_v1_dat = argsman.GetBoolArg("-persistmempoolv1", mempool_opts.persist_v1_dat);
 
+    mempool_opts.cluster_mempool = argsman.GetBoolArg("-clustermempool", mempool_opts.cluster_mempool);
+
     ApplyArgsManOptions(argsman, mempool_opts.limits);
 
     return {};
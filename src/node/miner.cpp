@@ -7,6 +7,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <cluster_linearize.h>
 #include <coins.h>
 #include <common/args.h>
 #include <consensus/amount.h>
@@ -14,12 +15,15 @@
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/sha256.h>
 #include <deploymentstatus.h>
+#include <hash.h>
 #include <logging.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <pow.h>
 #include <primitives/transaction.h>
+#include <util/check.h>
 #include <util/moneystr.h>
 #include <util/time.h>
 #include <validation.h>
@@ -101,6 +105,8 @@ void BlockAssembler::resetBlock()
     // These counters do not include coinbase tx
     nBlockTx = 0;
     nFees = 0;
+
+    m_lowest_package_feerate = FeeFrac{};
 }
 
 std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn)
@@ -140,7 +146,11 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     int nDescendantsUpdated = 0;
     if (m_mempool) {
         LOCK(m_mempool->cs);
-        addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+        if (m_mempool->m_opts.cluster_mempool) {
+            addChunkTxs(*m_mempool, nPackagesSelected);
+        } else {
+            addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+        }
     }
 
     const auto time_1{SteadyClock::now()};
@@ -423,9 +433,402 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
         }
 
         ++nPackagesSelected;
+        const FeeFrac package_feerate{packageFees, static_cast<int32_t>(packageSize)};
+        if (m_lowest_package_feerate.IsEmpty() || package_feerate << m_lowest_package_feerate) {
+            m_lowest_package_feerate = package_feerate;
+        }
 
         // Update transactions that depend on each of these
         nDescendantsUpdated += UpdatePackagesForAdded(mempool, ancestors, mapModifiedTx);
     }
 }
+
+// Each cluster's linearization is mined as a sequence of chunks with non-increasing
+// feerates, so repeatedly taking the best next chunk of any cluster includes chunks in
+// decreasing feerate order without tracking modified ancestor state.
+void BlockAssembler::addChunkTxs(const CTxMemPool& mempool, int& nPackagesSelected)
+{
+    AssertLockHeld(mempool.cs);
+
+    // The next chunk to consider from each cluster, and the position of its first transaction.
+    struct ClusterCursor {
+        const TxMempoolCluster* cluster;
+        size_t chunk{0};
+        size_t tx{0};
+    };
+    const auto worse = [](const ClusterCursor& a, const ClusterCursor& b) {
+        const auto cmp{a.cluster->m_chunks[a.chunk].feerate <=> b.cluster->m_chunks[b.chunk].feerate};
+        if (cmp != 0) return cmp < 0;
+        return a.cluster->m_id > b.cluster->m_id;
+    };
+    std::vector<ClusterCursor> heap;
+    for (const TxMempoolCluster* cluster : mempool.GetLinearizedClusters()) {
+        heap.push_back({cluster});
+    }
+    std::make_heap(heap.begin(), heap.end(), worse);
+
+    // Limit the number of attempts to add transactions to the block when it is
+    // close to full, as in addPackageTxs.
+    const int64_t MAX_CONSECUTIVE_FAILURES = 1000;
+    int64_t nConsecutiveFailed = 0;
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), worse);
+        ClusterCursor& cursor{heap.back()};
+        const cluster_linearize::Chunk chunk{cursor.cluster->m_chunks[cursor.chunk]};
+
+        if (chunk.feerate.fee < m_options.blockMinFeeRate.GetFee(chunk.feerate.size)) {
+            // Everything else we might consider has a lower fee rate
+            return;
+        }
+
+        std::vector<CTxMemPool::txiter> sortedEntries;
+        int64_t packageSigOpsCost = 0;
+        for (size_t i = cursor.tx; i < cursor.tx + chunk.count; ++i) {
+            sortedEntries.push_back(mempool.mapTx.iterator_to(*cursor.cluster->m_txs[i]));
+            packageSigOpsCost += sortedEntries.back()->GetSigOpCost();
+        }
+
+        // Later chunks of the cluster may spend this one, so a chunk that cannot be
+        // included ends its cluster.
+        if (!TestPackage(chunk.feerate.size, packageSigOpsCost)) {
+            heap.pop_back();
+            ++nConsecutiveFailed;
+
+            if (nConsecutiveFailed > MAX_CONSECUTIVE_FAILURES && nBlockWeight >
+                    m_options.nBlockMaxWeight - 4000) {
+                // Give up if we're close to full and haven't succeeded in a while
+                break;
+            }
+            continue;
+        }
+
+        if (!TestPackageTransactions(CTxMemPool::setEntries(sortedEntries.begin(), sortedEntries.end()))) {
+            heap.pop_back();
+            continue;
+        }
+
+        // This chunk will make it in; reset the failed counter.
+        nConsecutiveFailed = 0;
+
+        // The linearization already orders the chunk's transactions validly.
+        for (CTxMemPool::txiter it : sortedEntries) {
+            AddToBlock(it);
+        }
+        ++nPackagesSelected;
+        if (m_lowest_package_feerate.IsEmpty() || chunk.feerate << m_lowest_package_feerate) {
+            m_lowest_package_feerate = chunk.feerate;
+        }
+
+        cursor.tx += chunk.count;
+        if (++cursor.chunk < cursor.cluster->m_chunks.size()) {
+            std::push_heap(heap.begin(), heap.end(), worse);
+        } else {
+            heap.pop_back();
+        }
+    }
+}
+
+/** Build all levels of the merkle tree over leaves, as computed by ComputeMerkleRoot. */
+static std::vector<std::vector<uint256>> BuildMerkleLevels(std::vector<uint256> leaves)
+{
+    std::vector<std::vector<uint256>> levels;
+    levels.push_back(std::move(leaves));
+    while (levels.back().size() > 1) {
+        const std::vector<uint256>& level{levels.back()};
+        std::vector<uint256> parents((level.size() + 1) / 2);
+        // Hash the complete pairs in one batch; an odd last node is paired with itself.
+        SHA256D64(parents[0].begin(), level[0].begin(), level.size() / 2);
+        if (level.size() % 2) parents.back() = Hash(level.back(), level.back());
+        levels.push_back(std::move(parents));
+    }
+    return levels;
+}
+
+/** Append a leaf to the merkle tree levels, recomputing only the rightmost node of each level. */
+static void AppendMerkleLeaf(std::vector<std::vector<uint256>>& levels, const uint256& leaf)
+{
+    levels[0].push_back(leaf);
+    for (size_t depth = 0; levels[depth].size() > 1; ++depth) {
+        if (depth + 1 == levels.size()) levels.emplace_back();
+        const std::vector<uint256>& level{levels[depth]};
+        const size_t parent{(level.size() - 1) / 2};
+        const uint256 hash{Hash(level[2 * parent], level[std::min(2 * parent + 1, level.size() - 1)])};
+        std::vector<uint256>& parents{levels[depth + 1]};
+        if (parent < parents.size()) {
+            parents[parent] = hash;
+        } else {
+            parents.push_back(hash);
+        }
+    }
+}
+
+BlockTemplateCache::BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool, const BlockAssembler::Options& options)
+    : m_chainman{chainman},
+      m_mempool{mempool},
+      m_options{ClampOptions(options)}
+{
+}
+
+std::shared_ptr<const CBlockTemplate> BlockTemplateCache::Get(const CScript& scriptPubKeyIn, std::chrono::seconds max_stale)
+{
+    LOCK(::cs_main);
+    Chainstate& chainstate{m_chainman.ActiveChainstate()};
+    const CBlockIndex* tip{Assert(chainstate.m_chain.Tip())};
+    LOCK2(m_mempool.cs, m_mutex);
+    return GetLocked(chainstate, *tip, scriptPubKeyIn, max_stale);
+}
+
+std::shared_ptr<const CBlockTemplate> BlockTemplateCache::GetLocked(Chainstate& chainstate, const CBlockIndex& tip, const CScript& scriptPubKeyIn, std::chrono::seconds max_stale)
+{
+    if (!m_template || m_template->block.hashPrevBlock != tip.GetBlockHash() || m_script != scriptPubKeyIn) {
+        Rebuild(chainstate, scriptPubKeyIn);
+        return m_template;
+    }
+    // With notifications still queued, the mempool counts changes they have not reported yet. Only
+    // once all have arrived does a difference mean a change without one, such as a prioritisation.
+    if (!m_dirty && m_notified_sequence == m_mempool.GetSequence() && m_expected_updates != m_mempool.GetTransactionsUpdated()) {
+        m_dirty = true;
+    }
+    // Queued additions are appended by a later call.
+    if (!m_dirty && !ApplyAdded(tip)) m_dirty = true;
+    if (!m_dirty || NodeClock::now() - m_build_time < max_stale) {
+        return m_template;
+    }
+    Rebuild(chainstate, scriptPubKeyIn);
+    return m_template;
+}
+
+std::optional<BlockTemplateDiff> BlockTemplateCache::GetUpdate(const CScript& scriptPubKeyIn, uint64_t base_id, CAmount min_fee_increase, std::chrono::seconds max_stale)
+{
+    LOCK(::cs_main);
+    Chainstate& chainstate{m_chainman.ActiveChainstate()};
+    const CBlockIndex* tip{Assert(chainstate.m_chain.Tip())};
+    LOCK2(m_mempool.cs, m_mutex);
+    const std::shared_ptr<const CBlockTemplate> current{GetLocked(chainstate, *tip, scriptPubKeyIn, max_stale)};
+    const CAmount fees{-current->vTxFees[0]};
+
+    auto base{std::find_if(m_published.begin(), m_published.end(), [&](const PublishedTemplate& published) { return published.id == base_id; })};
+    if (base != m_published.end() && (base->prev_hash != current->block.hashPrevBlock || base->script != scriptPubKeyIn)) {
+        base = m_published.end();
+    }
+    if (base != m_published.end() && (base->source == current || fees - base->fees < min_fee_increase)) {
+        return std::nullopt;
+    }
+
+    BlockTemplateDiff diff;
+    diff.id = ++m_last_published_id;
+    diff.fees = fees;
+    PublishedTemplate published{.id = diff.id, .prev_hash = current->block.hashPrevBlock, .script = scriptPubKeyIn, .source = current, .txs = {}, .fees = fees};
+    published.txs.reserve(current->block.vtx.size() - 1);
+
+    // Keep the base's order for the transactions still in the template, and add the others after
+    // them. This is a valid block order: both templates contain the in-mempool ancestors of each of
+    // their transactions, which were in the mempool for the base as well, as it is on the same tip.
+    // Transactions are matched by witness hash, so a changed witness removes and re-adds one. If
+    // one of them is the parent of a kept transaction, it would follow its child, so all
+    // transactions are added instead.
+    std::unordered_set<uint256, SaltedTxidHasher> current_wtxids;
+    for (size_t i = 1; i < current->block.vtx.size(); ++i) {
+        current_wtxids.insert(current->block.vtx[i]->GetWitnessHash());
+    }
+    std::unordered_set<uint256, SaltedTxidHasher> kept_wtxids;
+    if (base != m_published.end()) {
+        for (const CTransactionRef& tx : base->txs) {
+            if (current_wtxids.count(tx->GetWitnessHash())) kept_wtxids.insert(tx->GetWitnessHash());
+        }
+        std::unordered_set<Txid, SaltedTxidHasher> added_txids;
+        for (size_t i = 1; i < current->block.vtx.size(); ++i) {
+            if (!kept_wtxids.count(current->block.vtx[i]->GetWitnessHash())) added_txids.insert(current->block.vtx[i]->GetHash());
+        }
+        const bool added_parent{std::any_of(base->txs.begin(), base->txs.end(), [&](const CTransactionRef& tx) {
+            return kept_wtxids.count(tx->GetWitnessHash()) &&
+                   std::any_of(tx->vin.begin(), tx->vin.end(), [&](const CTxIn& txin) { return added_txids.count(txin.prevout.hash); });
+        })};
+        if (added_parent) {
+            kept_wtxids.clear();
+            base = m_published.end();
+        }
+    }
+    if (base != m_published.end()) {
+        diff.base_id = base->id;
+        for (const CTransactionRef& tx : base->txs) {
+            if (kept_wtxids.count(tx->GetWitnessHash())) {
+                published.txs.push_back(tx);
+            } else {
+                diff.removed.push_back(tx->GetHash());
+            }
+        }
+    }
+    for (size_t i = 1; i < current->block.vtx.size(); ++i) {
+        if (kept_wtxids.count(current->block.vtx[i]->GetWitnessHash())) continue;
+        published.txs.push_back(current->block.vtx[i]);
+        diff.added.push_back(current->block.vtx[i]);
+    }
+
+    CBlock block{current->block};
+    block.vtx.resize(1);
+    block.vtx.insert(block.vtx.end(), published.txs.begin(), published.txs.end());
+    if (GetWitnessCommitmentIndex(block) != NO_WITNESS_COMMITMENT) {
+        RegenerateCommitments(block, m_chainman);
+    } else {
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+    }
+    diff.header = block.GetBlockHeader();
+    diff.coinbase = block.vtx[0];
+
+    m_published.push_back(std::move(published));
+    if (m_published.size() > MAX_PUBLISHED_TEMPLATES) m_published.pop_front();
+    return diff;
+}
+
+void BlockTemplateCache::Rebuild(Chainstate& chainstate, const CScript& scriptPubKeyIn)
+{
+    BlockAssembler assembler{chainstate, &m_mempool, m_options};
+    std::shared_ptr<CBlockTemplate> block_template{assembler.CreateNewBlock(scriptPubKeyIn)};
+
+    m_template_txids.clear();
+    std::vector<uint256> witness_leaves{uint256::ZERO}; // the coinbase's witness hash is 0
+    for (size_t i = 1; i < block_template->block.vtx.size(); ++i) {
+        m_template_txids.insert(block_template->block.vtx[i]->GetHash());
+        witness_leaves.push_back(block_template->block.vtx[i]->GetWitnessHash());
+    }
+    m_witness_tree = BuildMerkleLevels(std::move(witness_leaves));
+    m_block_weight = assembler.GetBlockWeightUsed();
+    m_block_sigops_cost = assembler.GetBlockSigOpsCostUsed();
+    m_fees = -block_template->vTxFees[0];
+    m_lowest_package_feerate = assembler.LowestPackageFeerate();
+    m_script = scriptPubKeyIn;
+    m_build_time = NodeClock::now();
+    m_build_sequence = m_mempool.GetSequence();
+    m_notified_sequence = m_build_sequence;
+    m_expected_updates = m_mempool.GetTransactionsUpdated();
+    m_dirty = false;
+    m_added.clear();
+    m_template = std::move(block_template);
+    ++m_rebuilds;
+}
+
+bool BlockTemplateCache::ApplyAdded(const CBlockIndex& tip)
+{
+    if (m_added.empty()) return true;
+
+    const int height{tip.nHeight + 1};
+    const int64_t lock_time_cutoff{tip.GetMedianTimePast()};
+    std::shared_ptr<CBlockTemplate> updated;
+    CAmount added_fees{0};
+    bool rebuild{false};
+    for (const CTransactionRef& tx : m_added) {
+        const auto it{m_mempool.GetIter(tx->GetHash())};
+        if (!it || m_template_txids.count(tx->GetHash())) continue;
+        const CTxMemPoolEntry& entry{**it};
+
+        // BlockAssembler considers a transaction on its own once its parents are in the block,
+        // and together with its ancestors otherwise.
+        const bool parents_in_template{std::all_of(entry.GetMemPoolParentsConst().begin(), entry.GetMemPoolParentsConst().end(),
+                                                   [&](const CTxMemPoolEntry& parent) { return m_template_txids.count(parent.GetTx().GetHash()) > 0; })};
+        const FeeFrac feerate{parents_in_template ? FeeFrac{entry.GetModifiedFee(), static_cast<int32_t>(entry.GetTxSize())} :
+                                                    FeeFrac{entry.GetModFeesWithAncestors(), static_cast<int32_t>(entry.GetSizeWithAncestors())}};
+        const uint64_t sigops_cost{static_cast<uint64_t>(parents_in_template ? entry.GetSigOpCost() : entry.GetSigOpCostWithAncestors())};
+        if (feerate.fee < m_options.blockMinFeeRate.GetFee(feerate.size)) continue;
+
+        const bool fits{m_block_weight + WITNESS_SCALE_FACTOR * static_cast<uint64_t>(feerate.size) < m_options.nBlockMaxWeight &&
+                        m_block_sigops_cost + sigops_cost < MAX_BLOCK_SIGOPS_COST};
+        if (parents_in_template && fits) {
+            if (!IsFinalTx(entry.GetTx(), height, lock_time_cutoff)) continue;
+            if (!updated) updated = std::make_shared<CBlockTemplate>(*m_template);
+            updated->block.vtx.emplace_back(entry.GetSharedTx());
+            updated->vTxFees.push_back(entry.GetFee());
+            updated->vTxSigOpsCost.push_back(entry.GetSigOpCost());
+            m_block_weight += entry.GetTxWeight();
+            m_block_sigops_cost += entry.GetSigOpCost();
+            added_fees += entry.GetFee();
+            m_template_txids.insert(tx->GetHash());
+            AppendMerkleLeaf(m_witness_tree, tx->GetWitnessHash());
+            if (m_lowest_package_feerate.IsEmpty() || feerate << m_lowest_package_feerate) {
+                m_lowest_package_feerate = feerate;
+            }
+            ++m_appends;
+        } else if (fits || (!m_lowest_package_feerate.IsEmpty() && feerate >> m_lowest_package_feerate)) {
+            // BlockAssembler would select this package, possibly instead of others.
+            rebuild = true;
+            break;
+        }
+    }
+    m_added.clear();
+
+    if (updated) {
+        // Pay the added fees to the coinbase, and commit to the new witness root in the same
+        // way as ChainstateManager::GenerateCoinbaseCommitment (with an all-zero witness nonce).
+        m_fees += added_fees;
+        updated->vTxFees[0] = -m_fees;
+        CMutableTransaction coinbase{*updated->block.vtx[0]};
+        coinbase.vout[0].nValue += added_fees;
+        const int commitpos{GetWitnessCommitmentIndex(updated->block)};
+        if (commitpos != NO_WITNESS_COMMITMENT) {
+            uint256 commitment{m_witness_tree.back()[0]};
+            CHash256().Write(commitment).Write(uint256::ZERO).Finalize(commitment);
+            CScript& script{coinbase.vout[commitpos].scriptPubKey};
+            std::copy(commitment.begin(), commitment.end(), script.begin() + (MINIMUM_WITNESS_COMMITMENT - uint256::size()));
+            updated->vchCoinbaseCommitment.assign(script.begin(), script.end());
+        }
+        updated->block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+        m_template = std::move(updated);
+
+        BlockAssembler::m_last_block_num_txs = m_template->block.vtx.size() - 1;
+        BlockAssembler::m_last_block_weight = m_block_weight;
+    }
+    return !rebuild;
+}
+
+uint64_t BlockTemplateCache::GetRebuildCount() const
+{
+    return WITH_LOCK(m_mutex, return m_rebuilds);
+}
+
+uint64_t BlockTemplateCache::GetAppendCount() const
+{
+    return WITH_LOCK(m_mutex, return m_appends);
+}
+
+void BlockTemplateCache::TransactionAddedToMempool(const NewMempoolTransactionInfo& tx, uint64_t mempool_sequence)
+{
+    LOCK(m_mutex);
+    // Nothing to update, or already reflected in the template.
+    if (!m_template || mempool_sequence < m_build_sequence) return;
+    ++m_expected_updates;
+    m_notified_sequence = std::max(m_notified_sequence, mempool_sequence + 1);
+    if (m_dirty) return;
+    if (m_added.size() >= MAX_PENDING_TEMPLATE_TXS) {
+        // Not requested in a while; rebuild rather than queueing without bound.
+        m_dirty = true;
+        m_added.clear();
+        return;
+    }
+    m_added.push_back(tx.info.m_tx);
+}
+
+void BlockTemplateCache::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    LOCK(m_mutex);
+    if (!m_template || mempool_sequence < m_build_sequence) return;
+    ++m_expected_updates;
+    m_notified_sequence = std::max(m_notified_sequence, mempool_sequence + 1);
+    if (m_template_txids.count(tx->GetHash())) m_dirty = true;
+}
+
+void BlockTemplateCache::BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    if (role == ChainstateRole::BACKGROUND) return;
+    LOCK(m_mutex);
+    // Drop a template the block builds on; the next Get() builds on top of the new tip. Blocks
+    // notified late, which the template already builds on, are ignored. Other tip changes are
+    // found by Get().
+    if (m_template && pindex->pprev && m_template->block.hashPrevBlock == pindex->pprev->GetBlockHash()) {
+        m_template.reset();
+        m_template_txids.clear();
+        m_added.clear();
+        m_dirty = true;
+    }
+}
 } // namespace node
@@ -8,11 +8,22 @@
 
 #include <policy/policy.h>
 #include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <sync.h>
 #include <txmempool.h>
+#include <uint256.h>
+#include <util/feefrac.h>
+#include <util/time.h>
+#include <validationinterface.h>
 
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <optional>
 #include <stdint.h>
+#include <unordered_set>
+#include <vector>
 
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/indexed_by.hpp>
@@ -31,6 +42,16 @@ namespace Consensus { struct Params; };
 
 namespace node {
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Maximum number of new mempool transactions queued for appending to a cached block template */
+static constexpr size_t MAX_PENDING_TEMPLATE_TXS{10000};
+/** Number of templates returned by BlockTemplateCache::GetUpdate() that later updates can be based on */
+static constexpr size_t MAX_PUBLISHED_TEMPLATES{16};
+/** Default minimum increase in template fees for a block template update to be published */
+static constexpr CAmount DEFAULT_TEMPLATE_UPDATE_MIN_FEE{10000};
+/** How often to check for block template updates to publish */
+static constexpr std::chrono::seconds TEMPLATE_UPDATE_INTERVAL{1};
+/** Age up to which a cached block template is served despite mempool changes that would rebuild it */
+static constexpr std::chrono::seconds TEMPLATE_MAX_STALE{5};
 
 struct CBlockTemplate
 {
@@ -40,6 +61,30 @@ struct CBlockTemplate
     std::vector<unsigned char> vchCoinbaseCommitment;
 };
 
+/** A block template as a change to an earlier one (see BlockTemplateCache::GetUpdate()).
+ *
+ *  The block's transactions are the coinbase, then the base template's transactions (excluding its
+ *  coinbase) without the removed ones, in their original order, then the added ones. */
+struct BlockTemplateDiff
+{
+    //! Id of this template, to base later updates on
+    uint64_t id{0};
+    //! Id of the template this is a change to, or 0 if all transactions are added
+    uint64_t base_id{0};
+    //! Block header, with the merkle root of the resulting transactions
+    CBlockHeader header;
+    //! Total fees of the template's transactions
+    CAmount fees{0};
+    CTransactionRef coinbase;
+    std::vector<Txid> removed;
+    std::vector<CTransactionRef> added;
+
+    SERIALIZE_METHODS(BlockTemplateDiff, obj)
+    {
+        READWRITE(obj.id, obj.base_id, obj.header, obj.fees, obj.coinbase, obj.removed, obj.added);
+    }
+};
+
 // Container for tracking updates to ancestor feerate as we include (parent)
 // transactions in a block
 struct CTxMemPoolModifiedEntry {
@@ -143,6 +188,8 @@ private:
     uint64_t nBlockSigOpsCost;
     CAmount nFees;
     std::unordered_set<Txid, SaltedTxidHasher> inBlock;
+    //! Modified fee and size of the lowest feerate package added to the block
+    FeeFrac m_lowest_package_feerate;
 
     // Chain context for the block
     int nHeight;
@@ -167,6 +214,14 @@ public:
     /** Construct a new block template with coinbase to scriptPubKeyIn */
     std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn);
 
+    /** Modified fee and size of the lowest feerate package added by the last CreateNewBlock
+      * call (IsEmpty() if no transactions were added) */
+    const FeeFrac& LowestPackageFeerate() const { return m_lowest_package_feerate; }
+    /** Block weight and sigops cost (including the coinbase reservation) used by the last
+      * CreateNewBlock call */
+    uint64_t GetBlockWeightUsed() const { return nBlockWeight; }
+    uint64_t GetBlockSigOpsCostUsed() const { return nBlockSigOpsCost; }
+
     inline static std::optional<int64_t> m_last_block_num_txs{};
     inline static std::optional<int64_t> m_last_block_weight{};
 
@@ -184,6 +239,10 @@ private:
       * Increments nPackagesSelected / nDescendantsUpdated with corresponding
       * statistics from the package selection (for logging statistics). */
     void addPackageTxs(const CTxMemPool& mempool, int& nPackagesSelected, int& nDescendantsUpdated) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Add transactions chunk by chunk from the mempool's cluster linearizations (with
+      * -clustermempool), always taking the highest feerate chunk that is next in its cluster.
+      * Increments nPackagesSelected with the number of chunks added. */
+    void addChunkTxs(const CTxMemPool& mempool, int& nPackagesSelected) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 
     // helper functions for addPackageTxs()
     /** Remove confirmed (inBlock) entries from given set */
@@ -199,6 +258,103 @@ private:
     void SortForBlock(const CTxMemPool::setEntries& package, std::vector<CTxMemPool::txiter>& sortedEntries);
 };
 
+/** Keeps the last block template up to date with mempool and chain tip notifications, so
+ *  repeated template requests only run BlockAssembler after a material change.
+ *
+ *  Notifications are recorded as they arrive and applied when a template is requested:
+ *  - A new tip, a different coinbase script, the removal of a transaction in the template, or
+ *    any mempool change not announced through the validation interface (such as
+ *    prioritisetransaction) rebuilds the template.
+ *  - A new transaction whose in-mempool parents are all in the template is appended to it if it
+ *    fits in the remaining block space.
+ *  - Any other new transaction rebuilds the template only if BlockAssembler would select it:
+ *    when its ancestor package feerate is higher than that of the lowest feerate package in the
+ *    template, or when the package fits in the remaining block space.
+ */
+class BlockTemplateCache final : public CValidationInterface
+{
+public:
+    explicit BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool, const BlockAssembler::Options& options);
+
+    /** Return a template on top of the current tip with coinbase to scriptPubKeyIn.
+     *  Mempool changes are applied as their notifications arrive, without waiting for queued ones.
+     *  A template younger than max_stale is returned (with any possible appends) instead of
+     *  being rebuilt for mempool changes; a new tip or coinbase script always rebuilds it. */
+    std::shared_ptr<const CBlockTemplate> Get(const CScript& scriptPubKeyIn, std::chrono::seconds max_stale = std::chrono::seconds{0})
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Return the template from Get() as a change to the template base_id earlier returned by this
+     *  function. A base that is unknown (such as 0), on another tip, or whose order cannot be kept
+     *  (a re-added transaction spends a kept one's output) gives a diff that adds all transactions. Returns std::nullopt if the template is unchanged from a base on the current
+     *  tip, or its fees increased by less than min_fee_increase. */
+    std::optional<BlockTemplateDiff> GetUpdate(const CScript& scriptPubKeyIn, uint64_t base_id, CAmount min_fee_increase,
+                                               std::chrono::seconds max_stale = std::chrono::seconds{0})
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Number of times Get() ran BlockAssembler, and appended transactions to the template */
+    uint64_t GetRebuildCount() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    uint64_t GetAppendCount() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    // CValidationInterface
+    void TransactionAddedToMempool(const NewMempoolTransactionInfo& tx, uint64_t mempool_sequence) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    /** A template returned by GetUpdate() */
+    struct PublishedTemplate {
+        uint64_t id;
+        uint256 prev_hash;
+        CScript script;
+        //! The template from Get() it was created from
+        std::shared_ptr<const CBlockTemplate> source;
+        //! Transactions excluding the coinbase, in the order of the published diffs
+        std::vector<CTransactionRef> txs;
+        CAmount fees;
+    };
+
+    /** Get() with the locks held */
+    std::shared_ptr<const CBlockTemplate> GetLocked(Chainstate& chainstate, const CBlockIndex& tip, const CScript& scriptPubKeyIn, std::chrono::seconds max_stale)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_mempool.cs, m_mutex);
+    /** Run BlockAssembler and reset the tracked state to the new template */
+    void Rebuild(Chainstate& chainstate, const CScript& scriptPubKeyIn) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_mempool.cs, m_mutex);
+    /** Append the pending mempool additions that fit; returns false if a rebuild is needed */
+    bool ApplyAdded(const CBlockIndex& tip) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_mempool.cs, m_mutex);
+
+    ChainstateManager& m_chainman;
+    const CTxMemPool& m_mempool;
+    const BlockAssembler::Options m_options;
+
+    mutable Mutex m_mutex;
+    std::shared_ptr<const CBlockTemplate> m_template GUARDED_BY(m_mutex);
+    CScript m_script GUARDED_BY(m_mutex);
+    std::unordered_set<Txid, SaltedTxidHasher> m_template_txids GUARDED_BY(m_mutex);
+    //! Levels of the witness merkle tree of m_template, leaves first, so appends update its root in O(log n)
+    std::vector<std::vector<uint256>> m_witness_tree GUARDED_BY(m_mutex);
+    //! Block resource usage and fees of m_template, as tracked by BlockAssembler
+    uint64_t m_block_weight GUARDED_BY(m_mutex){0};
+    uint64_t m_block_sigops_cost GUARDED_BY(m_mutex){0};
+    CAmount m_fees GUARDED_BY(m_mutex){0};
+    FeeFrac m_lowest_package_feerate GUARDED_BY(m_mutex);
+    NodeClock::time_point m_build_time GUARDED_BY(m_mutex);
+    //! Mempool sequence number when m_template was built; earlier notifications are already reflected in it
+    uint64_t m_build_sequence GUARDED_BY(m_mutex){0};
+    //! Mempool sequence number following the latest notification; CTxMemPool::GetSequence() once all arrived
+    uint64_t m_notified_sequence GUARDED_BY(m_mutex){0};
+    //! Expected CTxMemPool::GetTransactionsUpdated() value if all mempool changes since the build were notified
+    unsigned int m_expected_updates GUARDED_BY(m_mutex){0};
+    //! Whether a mempool change since the build requires a rebuild
+    bool m_dirty GUARDED_BY(m_mutex){true};
+    //! Transactions added to the mempool since the build, not yet considered for the template
+    std::vector<CTransactionRef> m_added GUARDED_BY(m_mutex);
+    //! Most recent templates returned by GetUpdate(), oldest first
+    std::deque<PublishedTemplate> m_published GUARDED_BY(m_mutex);
+    uint64_t m_last_published_id GUARDED_BY(m_mutex){0};
+    uint64_t m_rebuilds GUARDED_BY(m_mutex){0};
+    uint64_t m_appends GUARDED_BY(m_mutex){0};
+};
+
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
 
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
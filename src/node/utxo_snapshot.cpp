@@ -4,7 +4,12 @@
 
 #include <node/utxo_snapshot.h>
 
+#include <coins.h>
+#include <compressor.h>
+#include <consensus/amount.h>
+#include <hash.h>
 #include <logging.h>
+#include <primitives/transaction.h>
 #include <streams.h>
 #include <sync.h>
 #include <tinyformat.h>
@@ -13,13 +18,142 @@
 #include <util/fs.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <limits>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace node {
 
+namespace {
+std::array<unsigned char, 4> ChunkChecksum(Span<const unsigned char> data)
+{
+    const uint256 hash{Hash(data)};
+    std::array<unsigned char, 4> checksum;
+    std::copy_n(hash.begin(), checksum.size(), checksum.begin());
+    return checksum;
+}
+} // namespace
+
+void SnapshotChunkWriter::WriteChunk()
+{
+    SnapshotChunk chunk;
+    chunk.coins_count = m_coins_count;
+    chunk.data.assign(UCharCast(m_data.data()), UCharCast(m_data.data() + m_data.size()));
+    chunk.checksum = ChunkChecksum(chunk.data);
+    m_file << chunk;
+    m_data.clear();
+    m_coins_count = 0;
+    m_last_txid.reset();
+}
+
+void SnapshotChunkWriter::AddCoins(const Txid& txid, const std::vector<std::pair<uint32_t, Coin>>& coins)
+{
+    // Outputs of a transaction nearly always share height and coinbase flag,
+    // which are then written once for all of them.
+    for (auto group_begin{coins.begin()}; group_begin != coins.end();) {
+        const Coin& first{group_begin->second};
+        const auto group_end{std::find_if(group_begin, coins.end(), [&](const auto& coin) {
+            return coin.second.nHeight != first.nHeight || coin.second.fCoinBase != first.fCoinBase;
+        })};
+        // Coins are ordered by txid, so a txid shares its first bytes with the
+        // previous one, which are not written again.
+        const uint256& hash{txid.ToUint256()};
+        const size_t shared{m_last_txid ? static_cast<size_t>(std::mismatch(hash.begin(), hash.end(), m_last_txid->begin()).first - hash.begin()) : 0};
+        ser_writedata8(m_data, shared);
+        m_data.write(MakeByteSpan(hash).subspan(shared));
+        m_last_txid = hash;
+
+        const uint32_t code{static_cast<uint32_t>(first.nHeight) * 2 + first.fCoinBase};
+        m_data << VARINT(code);
+        WriteCompactSize(m_data, group_end - group_begin);
+        std::optional<uint32_t> prev_n;
+        for (auto it{group_begin}; it != group_end; ++it) {
+            const auto& [n, coin]{*it};
+            WriteCompactSize(m_data, prev_n ? n - *prev_n - 1 : n);
+            m_data << Using<TxOutCompression>(coin.out);
+            prev_n = n;
+        }
+        m_coins_count += group_end - group_begin;
+        group_begin = group_end;
+    }
+    if (m_data.size() >= SNAPSHOT_CHUNK_TARGET_SIZE) WriteChunk();
+}
+
+void SnapshotChunkWriter::Finish()
+{
+    if (m_coins_count > 0) WriteChunk();
+}
+
+bool DecodeSnapshotChunk(const SnapshotChunk& chunk, uint32_t max_height,
+                         std::vector<std::pair<COutPoint, Coin>>& coins, std::string& error)
+{
+    if (ChunkChecksum(chunk.data) != chunk.checksum) {
+        error = "chunk checksum mismatch";
+        return false;
+    }
+    coins.clear();
+    // Every coin takes up at least a few bytes of the data.
+    coins.reserve(std::min<uint64_t>(chunk.coins_count, chunk.data.size()));
+    try {
+        SpanReader reader{chunk.data};
+        uint256 hash;
+        while (!reader.empty()) {
+            const uint8_t shared{ser_readdata8(reader)};
+            if (shared > (coins.empty() ? 0 : hash.size())) {
+                error = "bad txid prefix length";
+                return false;
+            }
+            reader.read(MakeWritableByteSpan(hash).subspan(shared));
+            const Txid txid{Txid::FromUint256(hash)};
+            uint32_t code;
+            reader >> VARINT(code);
+            const uint32_t height{code >> 1};
+            if (height > max_height) {
+                error = strprintf("bad coin height (%u) in group of %s", height, txid.ToString());
+                return false;
+            }
+            const uint64_t group_size{ReadCompactSize(reader)};
+            if (group_size == 0 || group_size > chunk.coins_count - coins.size()) {
+                error = strprintf("bad coins count in group of %s", txid.ToString());
+                return false;
+            }
+            uint64_t n{0};
+            for (uint64_t i = 0; i < group_size; ++i) {
+                n += ReadCompactSize(reader) + (i > 0);
+                if (n >= std::numeric_limits<decltype(COutPoint::n)>::max()) {
+                    error = strprintf("bad output index in group of %s", txid.ToString());
+                    return false;
+                }
+                CTxOut out;
+                reader >> Using<TxOutCompression>(out);
+                if (!MoneyRange(out.nValue)) {
+                    error = strprintf("bad coin value in group of %s", txid.ToString());
+                    return false;
+                }
+                COutPoint outpoint{txid, static_cast<uint32_t>(n)};
+                if (!coins.empty() && !(coins.back().first < outpoint)) {
+                    error = strprintf("coin %s out of order", outpoint.ToString());
+                    return false;
+                }
+                coins.emplace_back(std::move(outpoint), Coin{std::move(out), static_cast<int>(height), static_cast<bool>(code & 1)});
+            }
+        }
+    } catch (const std::ios_base::failure& e) {
+        error = strprintf("bad chunk data (%s)", e.what());
+        return false;
+    }
+    if (coins.size() != chunk.coins_count) {
+        error = "bad coins count in chunk";
+        return false;
+    }
+    return true;
+}
+
 bool WriteSnapshotBaseBlockhash(Chainstate& snapshot_chainstate)
 {
     AssertLockHeld(::cs_main);
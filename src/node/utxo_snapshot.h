@@ -7,17 +7,24 @@
 #define BITCOIN_NODE_UTXO_SNAPSHOT_H
 
 #include <chainparams.h>
+#include <coins.h>
 #include <kernel/chainparams.h>
 #include <kernel/cs_main.h>
+#include <primitives/transaction.h>
 #include <serialize.h>
+#include <streams.h>
 #include <sync.h>
 #include <uint256.h>
 #include <util/chaintype.h>
 #include <util/fs.h>
 
+#include <array>
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 // UTXO set snapshot magic bytes
 static constexpr std::array<uint8_t, 5> SNAPSHOT_MAGIC_BYTES = {'u', 't', 'x', 'o', 0xff};
@@ -25,12 +32,17 @@ static constexpr std::array<uint8_t, 5> SNAPSHOT_MAGIC_BYTES = {'u', 't', 'x', '
 class Chainstate;
 
 namespace node {
+//! Snapshot version with the coins of each transaction one after another.
+static constexpr uint16_t SNAPSHOT_VERSION_PLAIN{1};
+//! Snapshot version with the coins in compressed, checksummed chunks, see SnapshotChunk.
+static constexpr uint16_t SNAPSHOT_VERSION_CHUNKED{2};
+
 //! Metadata describing a serialized version of a UTXO set from which an
 //! assumeutxo Chainstate can be constructed.
 class SnapshotMetadata
 {
-    const uint16_t m_version{1};
-    const std::set<uint16_t> m_supported_versions{1};
+    uint16_t m_version{SNAPSHOT_VERSION_PLAIN};
+    const std::set<uint16_t> m_supported_versions{SNAPSHOT_VERSION_PLAIN, SNAPSHOT_VERSION_CHUNKED};
 public:
     //! The hash of the block that reflects the tip of the chain for the
     //! UTXO set contained in this snapshot.
@@ -46,11 +58,16 @@ public:
     SnapshotMetadata(
         const uint256& base_blockhash,
         const int base_blockheight,
-        uint64_t coins_count) :
+        uint64_t coins_count,
+        uint16_t version = SNAPSHOT_VERSION_PLAIN) :
+            m_version(version),
             m_base_blockhash(base_blockhash),
             m_base_blockheight(base_blockheight),
             m_coins_count(coins_count) { }
 
+    //! The format version of the coins following the metadata.
+    uint16_t GetVersion() const { return m_version; }
+
     template <typename Stream>
     inline void Serialize(Stream& s) const {
         s << SNAPSHOT_MAGIC_BYTES;
@@ -76,6 +93,7 @@ public:
         if (m_supported_versions.find(version) == m_supported_versions.end()) {
             throw std::ios_base::failure(strprintf("Version of snapshot %s does not match any of the supported versions.", version));
         }
+        m_version = version;
 
         // Read the network magic (pchMessageStart)
         MessageStartChars message;
@@ -96,6 +114,69 @@ public:
     }
 };
 
+//! Size of the coin data after which a chunk is ended when writing a snapshot.
+static constexpr size_t SNAPSHOT_CHUNK_TARGET_SIZE{4 << 20};
+
+/**
+ * A chunk of the coins of a version 2 snapshot, which can be checked and
+ * decoded independently of the other chunks.
+ *
+ * A chunk is serialized as the number of coins in it, the coin data (with
+ * its size), and the first 4 bytes of the double SHA256 of the coin data.
+ *
+ * The coin data is a sequence of groups of coins that share a txid, height
+ * and coinbase flag: the number of leading bytes the txid shares with the
+ * previous group's txid in the chunk, the rest of the txid,
+ * VARINT(height * 2 + coinbase), the number of coins in the group and, for
+ * each coin, the difference of its output index to the previous one's minus
+ * one (the first coin has its output index) and its compressed output. Coins
+ * are ordered by outpoint, within and across chunks, so that the chainstate
+ * database can be written in key order.
+ */
+struct SnapshotChunk {
+    uint64_t coins_count{0};
+    std::vector<unsigned char> data;
+    std::array<unsigned char, 4> checksum{};
+
+    SERIALIZE_METHODS(SnapshotChunk, obj)
+    {
+        READWRITE(COMPACTSIZE(obj.coins_count), obj.data, obj.checksum);
+    }
+};
+
+/** Writes the coins of a version 2 snapshot in chunks. */
+class SnapshotChunkWriter
+{
+    AutoFile& m_file;
+    DataStream m_data;
+    uint64_t m_coins_count{0};
+    //! The txid of the last group of coins in the current chunk
+    std::optional<uint256> m_last_txid;
+
+    void WriteChunk();
+
+public:
+    explicit SnapshotChunkWriter(AutoFile& file) : m_file{file} {}
+
+    //! Add the coins of a transaction, which must come after all coins added
+    //! before, ordered by output index.
+    void AddCoins(const Txid& txid, const std::vector<std::pair<uint32_t, Coin>>& coins);
+
+    //! Write out the last chunk. Must be called once all coins were added.
+    void Finish();
+};
+
+/**
+ * Check the checksum of a chunk and decode its coins.
+ *
+ * @param[in]  max_height  The height of the snapshot base block, which no coin may be above.
+ * @param[out] coins       The coins of the chunk, ordered by outpoint.
+ * @param[out] error       Why the chunk is invalid, if it is.
+ * @return  false if the chunk is corrupt or has invalid coins
+ */
+bool DecodeSnapshotChunk(const SnapshotChunk& chunk, uint32_t max_height,
+                         std::vector<std::pair<COutPoint, Coin>>& coins, std::string& error);
+
 //! The file in the snapshot chainstate dir which stores the base blockhash. This is
 //! needed to reconstruct snapshot chainstates on init.
 //!
@@ -7,14 +7,18 @@
 
 #include <rest.h>
 
+#include <addresstype.h>
 #include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
+#include <common/json_writer.h>
 #include <core_io.h>
 #include <flatfile.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
+#include <index/scriptutxoindex.h>
 #include <index/txindex.h>
+#include <key_io.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <primitives/block.h>
@@ -26,6 +30,7 @@
 #include <rpc/server_util.h>
 #include <streams.h>
 #include <sync.h>
+#include <txdb.h>
 #include <txmempool.h>
 #include <util/any.h>
 #include <util/check.h>
@@ -33,12 +38,16 @@
 #include <validation.h>
 
 #include <any>
+#include <array>
+#include <map>
+#include <optional>
 #include <vector>
 
 #include <univalue.h>
 
 using node::GetTransaction;
 using node::NodeContext;
+using node::RawBlockData;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
@@ -313,21 +322,20 @@ static bool rest_block(const std::any& context,
         pos = pblockindex->GetBlockPos();
     }
 
-    std::vector<uint8_t> block_data{};
+    RawBlockData block_data{};
     if (!chainman.m_blockman.ReadRawBlockFromDisk(block_data, pos)) {
         return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
 
     switch (rf) {
     case RESTResponseFormat::BINARY: {
-        const std::string binaryBlock{block_data.begin(), block_data.end()};
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, block_data.Data());
         return true;
     }
 
     case RESTResponseFormat::HEX: {
-        const std::string strHex{HexStr(block_data) + "\n"};
+        const std::string strHex{HexStr(block_data.Data()) + "\n"};
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
@@ -335,12 +343,12 @@ static bool rest_block(const std::any& context,
 
     case RESTResponseFormat::JSON: {
         CBlock block{};
-        DataStream block_stream{block_data};
-        block_stream >> TX_WITH_WITNESS(block);
-        UniValue objBlock = blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
-        std::string strJSON = objBlock.write() + "\n";
+        SpanReader{UCharSpanCast(block_data.Data())} >> TX_WITH_WITNESS(block);
+        req->WriteReplyJSON("", [&](JSONWriter& writer) {
+            WriteBlockJSON(writer, chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
+        });
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        req->WriteReply(HTTP_OK, "\n");
         return true;
     }
 
@@ -644,6 +652,62 @@ static bool rest_deploymentinfo(const std::any& context, HTTPRequest* req, const
 
 }
 
+RPCHelpMan getscripthistory();
+
+static bool rest_scripthistory(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+
+    std::string script_str;
+    const RESTResponseFormat rf = ParseDataFormat(script_str, str_uri_part);
+    if (script_str.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/scripthistory/<address|scriptpubkey>.json");
+    }
+
+    switch (rf) {
+    case RESTResponseFormat::JSON: {
+        JSONRPCRequest jsonRequest;
+        jsonRequest.context = context;
+        jsonRequest.params = UniValue(UniValue::VARR);
+        jsonRequest.params.push_back(script_str);
+
+        // The query parameters map to the RPC arguments after the script, in order.
+        std::array<std::optional<std::string>, 4> raw_params;
+        try {
+            raw_params = {req->GetQueryParameter("start_height"), req->GetQueryParameter("stop_height"),
+                          req->GetQueryParameter("count"), req->GetQueryParameter("cursor")};
+        } catch (const std::runtime_error& e) {
+            return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+        }
+        for (size_t i = 0; i < 3; ++i) {
+            if (!raw_params[i]) {
+                jsonRequest.params.push_back(NullUniValue);
+                continue;
+            }
+            const auto parsed{ToIntegral<int>(*raw_params[i])};
+            if (!parsed) {
+                return RESTERR(req, HTTP_BAD_REQUEST, "Invalid number: " + *raw_params[i]);
+            }
+            jsonRequest.params.push_back(*parsed);
+        }
+        if (raw_params[3]) jsonRequest.params.push_back(*raw_params[3]);
+
+        UniValue result;
+        try {
+            result = getscripthistory().HandleRequest(jsonRequest);
+        } catch (const UniValue& error) {
+            return RESTERR(req, HTTP_BAD_REQUEST, error.find_value("message").get_str());
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, result.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+    }
+}
+
 static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
 {
     if (!CheckWarmup(req))
@@ -685,7 +749,10 @@ static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::s
             if (verbose && mempool_sequence) {
                 return RESTERR(req, HTTP_BAD_REQUEST, "Verbose results cannot contain mempool sequence values. (hint: set \"verbose=false\")");
             }
-            str_json = MempoolToJSON(*mempool, verbose, mempool_sequence).write() + "\n";
+            req->WriteReplyJSON("", [&](JSONWriter& writer) {
+                WriteMempoolJSON(writer, *mempool, verbose, mempool_sequence);
+            });
+            str_json = "\n";
         } else {
             str_json = MempoolInfoToJSON(*mempool).write() + "\n";
         }
@@ -862,28 +929,48 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
     decltype(chainman.ActiveHeight()) active_height;
     uint256 active_hash;
     {
-        auto process_utxos = [&vOutPoints, &outs, &hits, &active_height, &active_hash, &chainman](const CCoinsView& view, const CTxMemPool* mempool) EXCLUSIVE_LOCKS_REQUIRED(chainman.GetMutex()) {
+        auto process_utxos = [&vOutPoints, &outs, &hits](const CCoinsView& view, const CTxMemPool* mempool) {
             for (const COutPoint& vOutPoint : vOutPoints) {
                 Coin coin;
                 bool hit = (!mempool || !mempool->isSpent(vOutPoint)) && view.GetCoin(vOutPoint, coin);
                 hits.push_back(hit);
                 if (hit) outs.emplace_back(std::move(coin));
             }
-            active_height = chainman.ActiveHeight();
-            active_hash = chainman.ActiveTip()->GetBlockHash();
+        };
+        // Prefer the coins snapshot, so as not to wait for a block being
+        // connected. Its best block may be the tip before that block.
+        auto process_snapshot = [&](const CTxMemPool* mempool) {
+            const auto snapshot{chainman.GetCoinsSnapshot()};
+            if (!snapshot) return false;
+            if (mempool) {
+                CCoinsViewMemPool viewMempool(snapshot.get(), *mempool);
+                process_utxos(viewMempool, mempool);
+            } else {
+                process_utxos(*snapshot, nullptr);
+            }
+            active_height = snapshot->GetHeight();
+            active_hash = snapshot->GetBestBlock();
+            return true;
         };
 
         if (fCheckMemPool) {
             const CTxMemPool* mempool = GetMemPool(context, req);
             if (!mempool) return false;
-            // use db+mempool as cache backend in case user likes to query mempool
-            LOCK2(cs_main, mempool->cs);
-            CCoinsViewCache& viewChain = chainman.ActiveChainstate().CoinsTip();
-            CCoinsViewMemPool viewMempool(&viewChain, *mempool);
-            process_utxos(viewMempool, mempool);
-        } else {
+            // use db+mempool as cache backend in case user likes to query mempool,
+            // reading the snapshot under the mempool lock to be consistent with it
+            if (!WITH_LOCK(mempool->cs, return process_snapshot(mempool))) {
+                LOCK2(cs_main, mempool->cs);
+                CCoinsViewCache& viewChain = chainman.ActiveChainstate().CoinsTip();
+                CCoinsViewMemPool viewMempool(&viewChain, *mempool);
+                process_utxos(viewMempool, mempool);
+                active_height = chainman.ActiveHeight();
+                active_hash = chainman.ActiveTip()->GetBlockHash();
+            }
+        } else if (!process_snapshot(nullptr)) {
             LOCK(cs_main);
             process_utxos(chainman.ActiveChainstate().CoinsTip(), nullptr);
+            active_height = chainman.ActiveHeight();
+            active_hash = chainman.ActiveTip()->GetBlockHash();
         }
 
         for (size_t i = 0; i < hits.size(); ++i) {
@@ -951,6 +1038,69 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
     }
 }
 
+static bool rest_getutxos_by_script(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+
+    std::string script_str;
+    const RESTResponseFormat rf = ParseDataFormat(script_str, str_uri_part);
+    if (script_str.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/getutxosbyscript/<address|scriptpubkey>.json");
+    }
+    if (rf != RESTResponseFormat::JSON) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+
+    CScript script;
+    if (const CTxDestination dest{DecodeDestination(script_str)}; IsValidDestination(dest)) {
+        script = GetScriptForDestination(dest);
+    } else if (IsHex(script_str)) {
+        const std::vector<unsigned char> script_bytes{ParseHex(script_str)};
+        script = CScript(script_bytes.begin(), script_bytes.end());
+    } else {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address or scriptPubKey: " + script_str);
+    }
+
+    if (!g_script_utxo_index) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Requires scriptutxoindex");
+    }
+    if (!g_script_utxo_index->BlockUntilSyncedToCurrentChain()) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Script UTXO index is still syncing");
+    }
+    std::map<COutPoint, Coin> coins;
+    uint256 best_block;
+    if (!g_script_utxo_index->FindUTXOs({script}, coins, best_block)) {
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Unable to read the script UTXO index");
+    }
+    ChainstateManager* maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) return false;
+    const CBlockIndex* tip{Assert(WITH_LOCK(cs_main, return maybe_chainman->m_blockman.LookupBlockIndex(best_block)))};
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("chainHeight", tip->nHeight);
+    result.pushKV("chaintipHash", best_block.GetHex());
+
+    UniValue utxos(UniValue::VARR);
+    for (const auto& [outpoint, coin] : coins) {
+        UniValue utxo(UniValue::VOBJ);
+        utxo.pushKV("txid", outpoint.hash.GetHex());
+        utxo.pushKV("vout", (int32_t)outpoint.n);
+        utxo.pushKV("height", (int32_t)coin.nHeight);
+        utxo.pushKV("coinbase", coin.IsCoinBase());
+        utxo.pushKV("value", ValueFromAmount(coin.out.nValue));
+
+        UniValue o(UniValue::VOBJ);
+        ScriptToUniv(coin.out.scriptPubKey, /*out=*/o, /*include_hex=*/true, /*include_address=*/true);
+        utxo.pushKV("scriptPubKey", std::move(o));
+        utxos.push_back(std::move(utxo));
+    }
+    result.pushKV("utxos", std::move(utxos));
+
+    req->WriteHeader("Content-Type", "application/json");
+    req->WriteReply(HTTP_OK, result.write() + "\n");
+    return true;
+}
+
 static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
                        const std::string& str_uri_part)
 {
@@ -1013,10 +1163,13 @@ static const struct {
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/", rest_mempool},
       {"/rest/headers/", rest_headers},
+      // Before /rest/getutxos, which is a prefix of it.
+      {"/rest/getutxosbyscript/", rest_getutxos_by_script},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/deploymentinfo/", rest_deploymentinfo},
       {"/rest/deploymentinfo", rest_deploymentinfo},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/scripthistory/", rest_scripthistory},
 };
 
 void StartREST(const std::any& context)
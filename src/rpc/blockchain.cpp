@@ -8,9 +8,12 @@
 #include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
+#include <checkqueue.h>
 #include <clientversion.h>
 #include <coins.h>
 #include <common/args.h>
+#include <common/json_writer.h>
+#include <common/system.h>
 #include <consensus/amount.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
@@ -21,6 +24,9 @@
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/scripthistoryindex.h>
+#include <index/scriptutxoindex.h>
+#include <key_io.h>
 #include <kernel/coinstats.h>
 #include <logging/timer.h>
 #include <net.h>
@@ -51,15 +57,23 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <condition_variable>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <optional>
 
 using kernel::CCoinsStats;
 using kernel::CoinStatsHashType;
 
 using node::BlockManager;
 using node::NodeContext;
+using node::RawBlockData;
+using node::SNAPSHOT_VERSION_CHUNKED;
+using node::SNAPSHOT_VERSION_PLAIN;
+using node::SnapshotChunkWriter;
 using node::SnapshotMetadata;
 
 struct CUpdatedBlock
@@ -132,48 +146,85 @@ static const CBlockIndex* ParseHashOrHeight(const UniValue& param, ChainstateMan
     }
 }
 
-UniValue blockheaderToJSON(const CBlockIndex& tip, const CBlockIndex& blockindex)
+/** Write the members of blockheaderToJSON()'s object. */
+static void BlockHeaderFields(JSONWriter& writer, const CBlockIndex& tip, const CBlockIndex& blockindex)
 {
     // Serialize passed information without accessing chain state of the active chain!
     AssertLockNotHeld(cs_main); // For performance reasons
 
-    UniValue result(UniValue::VOBJ);
-    result.pushKV("hash", blockindex.GetBlockHash().GetHex());
+    writer.Key("hash");
+    writer.String(blockindex.GetBlockHash().GetHex());
     const CBlockIndex* pnext;
     int confirmations = ComputeNextBlockAndDepth(tip, blockindex, pnext);
-    result.pushKV("confirmations", confirmations);
-    result.pushKV("height", blockindex.nHeight);
-    result.pushKV("version", blockindex.nVersion);
-    result.pushKV("versionHex", strprintf("%08x", blockindex.nVersion));
-    result.pushKV("merkleroot", blockindex.hashMerkleRoot.GetHex());
-    result.pushKV("time", blockindex.nTime);
-    result.pushKV("mediantime", blockindex.GetMedianTimePast());
-    result.pushKV("nonce", blockindex.nNonce);
-    result.pushKV("bits", strprintf("%08x", blockindex.nBits));
-    result.pushKV("difficulty", GetDifficulty(blockindex));
-    result.pushKV("chainwork", blockindex.nChainWork.GetHex());
-    result.pushKV("nTx", blockindex.nTx);
-
-    if (blockindex.pprev)
-        result.pushKV("previousblockhash", blockindex.pprev->GetBlockHash().GetHex());
-    if (pnext)
-        result.pushKV("nextblockhash", pnext->GetBlockHash().GetHex());
+    writer.Key("confirmations");
+    writer.Int(confirmations);
+    writer.Key("height");
+    writer.Int(blockindex.nHeight);
+    writer.Key("version");
+    writer.Int(blockindex.nVersion);
+    writer.Key("versionHex");
+    writer.String(strprintf("%08x", blockindex.nVersion));
+    writer.Key("merkleroot");
+    writer.String(blockindex.hashMerkleRoot.GetHex());
+    writer.Key("time");
+    writer.Int(blockindex.nTime);
+    writer.Key("mediantime");
+    writer.Int(blockindex.GetMedianTimePast());
+    writer.Key("nonce");
+    writer.Int(blockindex.nNonce);
+    writer.Key("bits");
+    writer.String(strprintf("%08x", blockindex.nBits));
+    writer.Key("difficulty");
+    writer.Value(GetDifficulty(blockindex));
+    writer.Key("chainwork");
+    writer.String(blockindex.nChainWork.GetHex());
+    writer.Key("nTx");
+    writer.Int(blockindex.nTx);
+
+    if (blockindex.pprev) {
+        writer.Key("previousblockhash");
+        writer.String(blockindex.pprev->GetBlockHash().GetHex());
+    }
+    if (pnext) {
+        writer.Key("nextblockhash");
+        writer.String(pnext->GetBlockHash().GetHex());
+    }
+}
+
+UniValue blockheaderToJSON(const CBlockIndex& tip, const CBlockIndex& blockindex)
+{
+    UniValue result(UniValue::VOBJ);
+    UniValueWriter writer{result};
+    BlockHeaderFields(writer, tip, blockindex);
     return result;
 }
 
 UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity)
 {
-    UniValue result = blockheaderToJSON(tip, blockindex);
+    UniValue result;
+    UniValueWriter writer{result};
+    WriteBlockJSON(writer, blockman, block, tip, blockindex, verbosity);
+    return result;
+}
 
-    result.pushKV("strippedsize", (int)::GetSerializeSize(TX_NO_WITNESS(block)));
-    result.pushKV("size", (int)::GetSerializeSize(TX_WITH_WITNESS(block)));
-    result.pushKV("weight", (int)::GetBlockWeight(block));
-    UniValue txs(UniValue::VARR);
+void WriteBlockJSON(JSONWriter& writer, BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity)
+{
+    writer.BeginObject();
+    BlockHeaderFields(writer, tip, blockindex);
+
+    writer.Key("strippedsize");
+    writer.Int(::GetSerializeSize(TX_NO_WITNESS(block)));
+    writer.Key("size");
+    writer.Int(::GetSerializeSize(TX_WITH_WITNESS(block)));
+    writer.Key("weight");
+    writer.Int(::GetBlockWeight(block));
+    writer.Key("tx");
+    writer.BeginArray();
 
     switch (verbosity) {
         case TxVerbosity::SHOW_TXID:
             for (const CTransactionRef& tx : block.vtx) {
-                txs.push_back(tx->GetHash().GetHex());
+                writer.String(tx->GetHash().GetHex());
             }
             break;
 
@@ -184,19 +235,15 @@ UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIn
             const bool have_undo{is_not_pruned && blockman.UndoReadFromDisk(blockUndo, blockindex)};
 
             for (size_t i = 0; i < block.vtx.size(); ++i) {
-                const CTransactionRef& tx = block.vtx.at(i);
                 // coinbase transaction (i.e. i == 0) doesn't have undo data
                 const CTxUndo* txundo = (have_undo && i > 0) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
-                UniValue objTx(UniValue::VOBJ);
-                TxToUniv(*tx, /*block_hash=*/uint256(), /*entry=*/objTx, /*include_hex=*/true, txundo, verbosity);
-                txs.push_back(std::move(objTx));
+                TxToJSON(*block.vtx.at(i), /*block_hash=*/uint256(), writer, /*include_hex=*/true, txundo, verbosity);
             }
             break;
     }
 
-    result.pushKV("tx", std::move(txs));
-
-    return result;
+    writer.EndArray();
+    writer.EndObject();
 }
 
 static RPCHelpMan getblockcount()
@@ -250,6 +297,36 @@ void RPCNotifyBlockChange(const CBlockIndex* pindex)
     cond_blockchange.notify_all();
 }
 
+/**
+ * Wait until `done` holds for the latest block, or for at most `timeout` milliseconds
+ * unless it is 0, and return the latest block. If the server supports it, the request
+ * is parked instead of blocking the calling thread.
+ */
+static UniValue WaitForBlockChange(const JSONRPCRequest& request, int timeout, std::function<bool(const CUpdatedBlock&)> done)
+{
+    auto ready{[done] { return WITH_LOCK(cs_blockchange, return done(latestblock)) || !IsRPCRunning(); }};
+    auto result{[] {
+        const CUpdatedBlock block{WITH_LOCK(cs_blockchange, return latestblock)};
+        UniValue ret(UniValue::VOBJ);
+        ret.pushKV("hash", block.hash.GetHex());
+        ret.pushKV("height", block.height);
+        return ret;
+    }};
+    if (request.park && !ready()) {
+        request.park(ready, timeout ? std::optional{std::chrono::milliseconds{timeout}} : std::nullopt, result);
+        // Ignored, but has to match the documented result type
+        return result();
+    }
+    {
+        WAIT_LOCK(cs_blockchange, lock);
+        if(timeout)
+            cond_blockchange.wait_for(lock, std::chrono::milliseconds(timeout), [&done]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {return done(latestblock) || !IsRPCRunning(); });
+        else
+            cond_blockchange.wait(lock, [&done]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {return done(latestblock) || !IsRPCRunning(); });
+    }
+    return result();
+}
+
 static RPCHelpMan waitfornewblock()
 {
     return RPCHelpMan{"waitfornewblock",
@@ -274,20 +351,10 @@ static RPCHelpMan waitfornewblock()
     if (!request.params[0].isNull())
         timeout = request.params[0].getInt<int>();
 
-    CUpdatedBlock block;
-    {
-        WAIT_LOCK(cs_blockchange, lock);
-        block = latestblock;
-        if(timeout)
-            cond_blockchange.wait_for(lock, std::chrono::milliseconds(timeout), [&block]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {return latestblock.height != block.height || latestblock.hash != block.hash || !IsRPCRunning(); });
-        else
-            cond_blockchange.wait(lock, [&block]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {return latestblock.height != block.height || latestblock.hash != block.hash || !IsRPCRunning(); });
-        block = latestblock;
-    }
-    UniValue ret(UniValue::VOBJ);
-    ret.pushKV("hash", block.hash.GetHex());
-    ret.pushKV("height", block.height);
-    return ret;
+    const CUpdatedBlock block{WITH_LOCK(cs_blockchange, return latestblock)};
+    return WaitForBlockChange(request, timeout, [block](const CUpdatedBlock& latest) {
+        return latest.height != block.height || latest.hash != block.hash;
+    });
 },
     };
 }
@@ -320,20 +387,7 @@ static RPCHelpMan waitforblock()
     if (!request.params[1].isNull())
         timeout = request.params[1].getInt<int>();
 
-    CUpdatedBlock block;
-    {
-        WAIT_LOCK(cs_blockchange, lock);
-        if(timeout)
-            cond_blockchange.wait_for(lock, std::chrono::milliseconds(timeout), [&hash]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {return latestblock.hash == hash || !IsRPCRunning();});
-        else
-            cond_blockchange.wait(lock, [&hash]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {return latestblock.hash == hash || !IsRPCRunning(); });
-        block = latestblock;
-    }
-
-    UniValue ret(UniValue::VOBJ);
-    ret.pushKV("hash", block.hash.GetHex());
-    ret.pushKV("height", block.height);
-    return ret;
+    return WaitForBlockChange(request, timeout, [hash](const CUpdatedBlock& latest) { return latest.hash == hash; });
 },
     };
 }
@@ -367,19 +421,7 @@ static RPCHelpMan waitforblockheight()
     if (!request.params[1].isNull())
         timeout = request.params[1].getInt<int>();
 
-    CUpdatedBlock block;
-    {
-        WAIT_LOCK(cs_blockchange, lock);
-        if(timeout)
-            cond_blockchange.wait_for(lock, std::chrono::milliseconds(timeout), [&height]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {return latestblock.height >= height || !IsRPCRunning();});
-        else
-            cond_blockchange.wait(lock, [&height]() EXCLUSIVE_LOCKS_REQUIRED(cs_blockchange) {return latestblock.height >= height || !IsRPCRunning(); });
-        block = latestblock;
-    }
-    UniValue ret(UniValue::VOBJ);
-    ret.pushKV("hash", block.hash.GetHex());
-    ret.pushKV("height", block.height);
-    return ret;
+    return WaitForBlockChange(request, timeout, [height](const CUpdatedBlock& latest) { return latest.height >= height; });
 },
     };
 }
@@ -596,9 +638,9 @@ static CBlock GetBlockChecked(BlockManager& blockman, const CBlockIndex& blockin
     return block;
 }
 
-static std::vector<uint8_t> GetRawBlockChecked(BlockManager& blockman, const CBlockIndex& blockindex)
+static RawBlockData GetRawBlockChecked(BlockManager& blockman, const CBlockIndex& blockindex)
 {
-    std::vector<uint8_t> data{};
+    RawBlockData data{};
     FlatFilePos pos{};
     {
         LOCK(cs_main);
@@ -758,15 +800,14 @@ static RPCHelpMan getblock()
         }
     }
 
-    const std::vector<uint8_t> block_data{GetRawBlockChecked(chainman.m_blockman, *pblockindex)};
+    const RawBlockData block_data{GetRawBlockChecked(chainman.m_blockman, *pblockindex)};
 
     if (verbosity <= 0) {
-        return HexStr(block_data);
+        return HexStr(block_data.Data());
     }
 
-    DataStream block_stream{block_data};
     CBlock block{};
-    block_stream >> TX_WITH_WITNESS(block);
+    SpanReader{UCharSpanCast(block_data.Data())} >> TX_WITH_WITNESS(block);
 
     TxVerbosity tx_verbosity;
     if (verbosity == 1) {
@@ -777,6 +818,12 @@ static RPCHelpMan getblock()
         tx_verbosity = TxVerbosity::SHOW_DETAILS_AND_PREVOUT;
     }
 
+    if (request.write_result) {
+        request.write_result([&](JSONWriter& writer) {
+            WriteBlockJSON(writer, chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
+        });
+        return NullUniValue;
+    }
     return blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
 },
     };
@@ -858,7 +905,7 @@ CoinStatsHashType ParseHashType(const std::string& hash_type_input)
  *
  * @param[in] index_requested Signals if the coinstatsindex should be used (when available).
  */
-static std::optional<kernel::CCoinsStats> GetUTXOStats(CCoinsView* view, node::BlockManager& blockman,
+static std::optional<kernel::CCoinsStats> GetUTXOStats(CCoinsViewDB* view, node::BlockManager& blockman,
                                                        kernel::CoinStatsHashType hash_type,
                                                        const std::function<void()>& interruption_point = {},
                                                        const CBlockIndex* pindex = nullptr,
@@ -880,7 +927,7 @@ static std::optional<kernel::CCoinsStats> GetUTXOStats(CCoinsView* view, node::B
     // best block.
     CHECK_NONFATAL(!pindex || pindex->GetBlockHash() == view->GetBestBlock());
 
-    return kernel::ComputeUTXOStats(hash_type, view, blockman, interruption_point);
+    return kernel::ComputeUTXOStats(hash_type, *view, blockman, std::clamp(GetNumCores(), 1, MAX_UTXO_STATS_THREADS), interruption_point);
 }
 
 static RPCHelpMan gettxoutsetinfo()
@@ -949,7 +996,7 @@ static RPCHelpMan gettxoutsetinfo()
     Chainstate& active_chainstate = chainman.ActiveChainstate();
     active_chainstate.ForceFlushStateToDisk();
 
-    CCoinsView* coins_view;
+    CCoinsViewDB* coins_view;
     BlockManager* blockman;
     {
         LOCK(::cs_main);
@@ -1075,7 +1122,6 @@ static RPCHelpMan gettxout()
 {
     NodeContext& node = EnsureAnyNodeContext(request.context);
     ChainstateManager& chainman = EnsureChainman(node);
-    LOCK(cs_main);
 
     UniValue ret(UniValue::VOBJ);
 
@@ -1085,29 +1131,48 @@ static RPCHelpMan gettxout()
     if (!request.params[2].isNull())
         fMempool = request.params[2].get_bool();
 
+    const CTxMemPool* mempool{fMempool ? &EnsureMemPool(node) : nullptr};
     Coin coin;
-    Chainstate& active_chainstate = chainman.ActiveChainstate();
-    CCoinsViewCache* coins_view = &active_chainstate.CoinsTip();
+    uint256 best_block;
+    int best_height;
+    // Look up the coin in view and, if requested, the mempool. Returns whether it is unspent.
+    auto lookup = [&](CCoinsView& view, int height) {
+        best_block = view.GetBestBlock();
+        best_height = height;
+        if (!mempool) return view.GetCoin(out, coin);
+        AssertLockHeld(mempool->cs);
+        CCoinsViewMemPool mempool_view(&view, *mempool);
+        return mempool_view.GetCoin(out, coin) && !mempool->isSpent(out);
+    };
 
-    if (fMempool) {
-        const CTxMemPool& mempool = EnsureMemPool(node);
-        LOCK(mempool.cs);
-        CCoinsViewMemPool view(coins_view, mempool);
-        if (!view.GetCoin(out, coin) || mempool.isSpent(out)) {
-            return UniValue::VNULL;
-        }
-    } else {
-        if (!coins_view->GetCoin(out, coin)) {
-            return UniValue::VNULL;
+    // Use the coins snapshot if there is one, so as not to wait for a block
+    // being connected. It is read under the mempool lock, under which the
+    // mempool is updated as blocks are connected, to be consistent with it.
+    std::optional<bool> unspent;
+    if (mempool) {
+        LOCK(mempool->cs);
+        if (const auto snapshot{chainman.GetCoinsSnapshot()}) unspent = lookup(*snapshot, snapshot->GetHeight());
+    } else if (const auto snapshot{chainman.GetCoinsSnapshot()}) {
+        unspent = lookup(*snapshot, snapshot->GetHeight());
+    }
+    if (!unspent) {
+        LOCK(cs_main);
+        CCoinsViewCache& coins_view = chainman.ActiveChainstate().CoinsTip();
+        const int height{chainman.m_blockman.LookupBlockIndex(coins_view.GetBestBlock())->nHeight};
+        if (mempool) {
+            LOCK(mempool->cs);
+            unspent = lookup(coins_view, height);
+        } else {
+            unspent = lookup(coins_view, height);
         }
     }
+    if (!*unspent) return UniValue::VNULL;
 
-    const CBlockIndex* pindex = active_chainstate.m_blockman.LookupBlockIndex(coins_view->GetBestBlock());
-    ret.pushKV("bestblock", pindex->GetBlockHash().GetHex());
+    ret.pushKV("bestblock", best_block.GetHex());
     if (coin.nHeight == MEMPOOL_HEIGHT) {
         ret.pushKV("confirmations", 0);
     } else {
-        ret.pushKV("confirmations", (int64_t)(pindex->nHeight - coin.nHeight + 1));
+        ret.pushKV("confirmations", (int64_t)(best_height - coin.nHeight + 1));
     }
     ret.pushKV("value", ValueFromAmount(coin.out.nValue));
     UniValue o(UniValue::VOBJ);
@@ -2025,36 +2090,114 @@ static RPCHelpMan getblockstats()
 }
 
 namespace {
-//! Search for a given set of pubkey scripts
-bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>& should_abort, int64_t& count, CCoinsViewCursor* cursor, const std::set<CScript>& needles, std::map<COutPoint, Coin>& out_results, std::function<void()>& interruption_point)
-{
-    scan_progress = 0;
-    count = 0;
-    while (cursor->Valid()) {
-        COutPoint key;
-        Coin coin;
-        if (!cursor->GetKey(key) || !cursor->GetValue(coin)) return false;
-        if (++count % 8192 == 0) {
-            interruption_point();
-            if (should_abort) {
-                // allow to abort the scan via the abort reference
+//! Number of txid prefixes (the first two bytes of a txid) that coin cursors are split by
+constexpr uint32_t NUM_TXID_PREFIXES{0x10000};
+
+//! State shared by the threads of a scantxoutset scan
+struct ScanState {
+    std::atomic<int>& scan_progress;
+    const std::atomic<bool>& should_abort;
+    const std::function<void()>& interruption_point;
+    const std::set<CScript>& needles;
+    //! Number of txid prefixes each thread has gone through
+    std::vector<std::atomic<uint32_t>> prefixes_done;
+    //! Set when a thread fails or is interrupted, to stop the others
+    std::atomic<bool> stop{false};
+    std::atomic<bool> interrupted{false};
+
+    void UpdateProgress()
+    {
+        uint32_t done{0};
+        for (const auto& prefixes : prefixes_done) done += prefixes.load(std::memory_order_relaxed);
+        scan_progress = (int)(done * 100.0 / NUM_TXID_PREFIXES + 0.5);
+    }
+};
+
+//! Search for a given set of pubkey scripts in the coins of one cursor
+struct ScanTask {
+    ScanState* state;
+    size_t shard;
+    CCoinsViewCursor* cursor;
+    std::map<COutPoint, Coin>* results;
+    int64_t* count;
+
+    bool operator()()
+    {
+        const uint32_t begin_prefix = shard * NUM_TXID_PREFIXES / state->prefixes_done.size();
+        const uint32_t end_prefix = (shard + 1) * NUM_TXID_PREFIXES / state->prefixes_done.size();
+        while (cursor->Valid()) {
+            COutPoint key;
+            Coin coin;
+            if (!cursor->GetKey(key) || !cursor->GetValue(coin)) {
+                state->stop = true;
                 return false;
             }
+            if (++*count % 8192 == 0) {
+                try {
+                    state->interruption_point();
+                } catch (...) {
+                    // Rethrown from the calling thread
+                    state->interrupted = true;
+                    state->stop = true;
+                }
+                if (state->should_abort || state->stop) {
+                    // allow to abort the scan via the abort reference
+                    return false;
+                }
+            }
+            if (*count % 256 == 0) {
+                // update progress reference every 256 item
+                const uint32_t high = 0x100 * *UCharCast(key.hash.begin()) + *(UCharCast(key.hash.begin()) + 1);
+                state->prefixes_done[shard] = high - begin_prefix;
+                state->UpdateProgress();
+            }
+            if (state->needles.count(coin.out.scriptPubKey)) {
+                results->emplace(key, coin);
+            }
+            cursor->Next();
         }
-        if (count % 256 == 0) {
-            // update progress reference every 256 item
-            uint32_t high = 0x100 * *UCharCast(key.hash.begin()) + *(UCharCast(key.hash.begin()) + 1);
-            scan_progress = (int)(high * 100.0 / 65536.0 + 0.5);
-        }
-        if (needles.count(coin.out.scriptPubKey)) {
-            out_results.emplace(key, coin);
-        }
-        cursor->Next();
+        state->prefixes_done[shard] = end_prefix - begin_prefix;
+        state->UpdateProgress();
+        return true;
+    }
+};
+} // namespace
+
+bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>& should_abort, int64_t& count,
+                      const std::vector<std::unique_ptr<CCoinsViewCursor>>& cursors, const std::set<CScript>& needles,
+                      std::map<COutPoint, Coin>& out_results, const std::function<void()>& interruption_point)
+{
+    scan_progress = 0;
+    count = 0;
+    ScanState state{scan_progress, should_abort, interruption_point, needles, std::vector<std::atomic<uint32_t>>(cursors.size())};
+
+    // Each thread collects its own results, merged once all are done.
+    std::vector<std::map<COutPoint, Coin>> results(cursors.size());
+    std::vector<int64_t> counts(cursors.size());
+    std::vector<ScanTask> tasks;
+    for (size_t shard = 0; shard < cursors.size(); ++shard) {
+        tasks.push_back(ScanTask{&state, shard, cursors[shard].get(), &results[shard], &counts[shard]});
+    }
+    bool ok{true};
+    if (cursors.size() > 1) {
+        CCheckQueue<ScanTask> queue(/*batch_size=*/1, cursors.size() - 1,
+                                    /*work_stealing=*/false, /*thread_name=*/"scantxout");
+        CCheckQueueControl<ScanTask> control(&queue);
+        control.Add(std::move(tasks));
+        ok = control.Wait();
+    } else {
+        for (ScanTask& task : tasks) ok = task() && ok;
+    }
+    if (state.interrupted) interruption_point();
+
+    for (size_t shard = 0; shard < cursors.size(); ++shard) {
+        count += counts[shard];
+        out_results.merge(results[shard]);
     }
+    if (!ok) return false;
     scan_progress = 100;
     return true;
 }
-} // namespace
 
 /** RAII object to prevent concurrency issue when scanning the txout set */
 static std::atomic<int> g_scan_progress;
@@ -2148,7 +2291,7 @@ static RPCHelpMan scantxoutset()
         {
             RPCResult{"when action=='start'; only returns after scan completes", RPCResult::Type::OBJ, "", "", {
                 {RPCResult::Type::BOOL, "success", "Whether the scan was completed"},
-                {RPCResult::Type::NUM, "txouts", "The number of unspent transaction outputs scanned"},
+                {RPCResult::Type::NUM, "txouts", "The number of unspent transaction outputs scanned, or found if -scriptutxoindex is enabled"},
                 {RPCResult::Type::NUM, "height", "The current block height (index)"},
                 {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at the tip of the chain"},
                 {RPCResult::Type::ARR, "unspents", "",
@@ -2230,18 +2373,33 @@ static RPCHelpMan scantxoutset()
         std::map<COutPoint, Coin> coins;
         g_should_abort_scan = false;
         int64_t count = 0;
-        std::unique_ptr<CCoinsViewCursor> pcursor;
         const CBlockIndex* tip;
+        bool res;
         NodeContext& node = EnsureAnyNodeContext(request.context);
-        {
-            ChainstateManager& chainman = EnsureChainman(node);
-            LOCK(cs_main);
-            Chainstate& active_chainstate = chainman.ActiveChainstate();
-            active_chainstate.ForceFlushStateToDisk();
-            pcursor = CHECK_NONFATAL(active_chainstate.CoinsDB().Cursor());
-            tip = CHECK_NONFATAL(active_chainstate.m_chain.Tip());
+        ChainstateManager& chainman = EnsureChainman(node);
+        if (g_script_utxo_index && g_script_utxo_index->BlockUntilSyncedToCurrentChain()) {
+            // Look the scripts up in the index instead of scanning the whole
+            // UTXO set. Only the matching outputs are read.
+            uint256 best_block;
+            if (!g_script_utxo_index->FindUTXOs(needles, coins, best_block)) {
+                throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read the script UTXO index");
+            }
+            tip = CHECK_NONFATAL(WITH_LOCK(cs_main, return chainman.m_blockman.LookupBlockIndex(best_block)));
+            count = coins.size();
+            res = true;
+        } else {
+            std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+            {
+                LOCK(cs_main);
+                Chainstate& active_chainstate = chainman.ActiveChainstate();
+                active_chainstate.ForceFlushStateToDisk();
+                // Split the UTXO set into one range of txids per thread, all read
+                // from the same snapshot of the database.
+                cursors = active_chainstate.CoinsDB().ShardedCursors(std::clamp(GetNumCores(), 1, MAX_SCANTXOUTSET_THREADS));
+                tip = CHECK_NONFATAL(active_chainstate.m_chain.Tip());
+            }
+            res = FindScriptPubKey(g_scan_progress, g_should_abort_scan, count, cursors, needles, coins, node.rpc_interruption_point);
         }
-        bool res = FindScriptPubKey(g_scan_progress, g_should_abort_scan, count, pcursor.get(), needles, coins, node.rpc_interruption_point);
         result.pushKV("success", res);
         result.pushKV("txouts", count);
         result.pushKV("height", tip->nHeight);
@@ -2595,6 +2753,126 @@ static RPCHelpMan getblockfilter()
     };
 }
 
+//! Default and maximum number of outputs returned by one getscripthistory call
+static constexpr int DEFAULT_SCRIPT_HISTORY_COUNT{1000};
+static constexpr int MAX_SCRIPT_HISTORY_COUNT{10000};
+
+RPCHelpMan getscripthistory()
+{
+    return RPCHelpMan{"getscripthistory",
+        "\nReturn the outputs paying to an address or scriptPubKey, and the inputs spending them, in block chain order (requires scripthistoryindex).\n"
+        "If there are more than count outputs, the result has a cursor to pass to the next call to continue.\n",
+        {
+            {"script", RPCArg::Type::STR, RPCArg::Optional::NO, "The address, or the scriptPubKey in hex"},
+            {"start_height", RPCArg::Type::NUM, RPCArg::Default{0}, "Height of the first block to return outputs of"},
+            {"stop_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"chain tip"}, "Height of the last block to return outputs of"},
+            {"count", RPCArg::Type::NUM, RPCArg::Default{DEFAULT_SCRIPT_HISTORY_COUNT}, strprintf("The maximum number of outputs to return (1 to %d)", MAX_SCRIPT_HISTORY_COUNT)},
+            {"cursor", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "The cursor returned by a previous call with the same script and heights"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::STR_HEX, "scriptPubKey", "The scriptPubKey looked up"},
+                {RPCResult::Type::ARR, "history", "The outputs paying to the scriptPubKey",
+                {
+                    {RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "height", "Height of the block that created the output"},
+                        {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                        {RPCResult::Type::NUM, "vout", "The output number"},
+                        {RPCResult::Type::STR_AMOUNT, "amount", "The output value in " + CURRENCY_UNIT},
+                        {RPCResult::Type::OBJ, "spent_by", /*optional=*/true, "The input spending the output, if it is spent",
+                        {
+                            {RPCResult::Type::STR_HEX, "txid", "The spending transaction id"},
+                            {RPCResult::Type::NUM, "vin", "The input number"},
+                            {RPCResult::Type::NUM, "height", "Height of the block that spent the output"},
+                        }},
+                    }},
+                }},
+                {RPCResult::Type::STR_HEX, "cursor", /*optional=*/true, "Only present if there are more outputs. Pass it to the next call to get them"},
+            }},
+        RPCExamples{
+            HelpExampleCli("getscripthistory", "\"bcrt1q4u4nsgk6ug0sqz7r3rj9tykjxrsl0yy4d0wwte\"") +
+            HelpExampleCli("getscripthistory", "\"bcrt1q4u4nsgk6ug0sqz7r3rj9tykjxrsl0yy4d0wwte\" 100 150 10") +
+            HelpExampleRpc("getscripthistory", "\"bcrt1q4u4nsgk6ug0sqz7r3rj9tykjxrsl0yy4d0wwte\", 100, 150, 10")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!g_script_history_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Requires scripthistoryindex");
+    }
+
+    const std::string& script_str{request.params[0].get_str()};
+    CScript script;
+    if (const CTxDestination dest{DecodeDestination(script_str)}; IsValidDestination(dest)) {
+        script = GetScriptForDestination(dest);
+    } else if (IsHex(script_str)) {
+        const std::vector<unsigned char> script_bytes{ParseHex(script_str)};
+        script = CScript(script_bytes.begin(), script_bytes.end());
+    } else {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or scriptPubKey: " + script_str);
+    }
+
+    const int start_height{request.params[1].isNull() ? 0 : request.params[1].getInt<int>()};
+    const int stop_height{request.params[2].isNull() ? std::numeric_limits<int>::max() : request.params[2].getInt<int>()};
+    if (start_height < 0 || stop_height < start_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid start_height or stop_height");
+    }
+    const int count{request.params[3].isNull() ? DEFAULT_SCRIPT_HISTORY_COUNT : request.params[3].getInt<int>()};
+    if (count < 1 || count > MAX_SCRIPT_HISTORY_COUNT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("count must be between 1 and %d", MAX_SCRIPT_HISTORY_COUNT));
+    }
+    std::optional<ScriptHistoryPosition> after;
+    if (!request.params[4].isNull()) {
+        DataStream cursor{ParseHexV(request.params[4], "cursor")};
+        try {
+            cursor >> after.emplace();
+        } catch (const std::ios_base::failure&) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+    }
+
+    if (!g_script_history_index->BlockUntilSyncedToCurrentChain()) {
+        const IndexSummary summary{g_script_history_index->GetSummary()};
+        throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("Unable to get data because scripthistoryindex is still syncing. Current height: %d", summary.best_block_height));
+    }
+
+    std::vector<ScriptHistoryEntry> entries;
+    bool more;
+    if (!g_script_history_index->LookUpHistory(script, start_height, stop_height, after, count, entries, more)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read the script history");
+    }
+
+    UniValue history(UniValue::VARR);
+    for (const ScriptHistoryEntry& entry : entries) {
+        UniValue output(UniValue::VOBJ);
+        output.pushKV("height", entry.pos.height);
+        output.pushKV("txid", entry.pos.txid.GetHex());
+        output.pushKV("vout", entry.pos.vout);
+        output.pushKV("amount", ValueFromAmount(entry.amount));
+        if (entry.spent_by) {
+            UniValue spent_by(UniValue::VOBJ);
+            spent_by.pushKV("txid", entry.spent_by->txid.GetHex());
+            spent_by.pushKV("vin", entry.spent_by->vin);
+            spent_by.pushKV("height", entry.spent_by->height);
+            output.pushKV("spent_by", std::move(spent_by));
+        }
+        history.push_back(std::move(output));
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("scriptPubKey", HexStr(script));
+    ret.pushKV("history", std::move(history));
+    if (more) {
+        DataStream cursor;
+        cursor << entries.back().pos;
+        ret.pushKV("cursor", HexStr(cursor));
+    }
+    return ret;
+},
+    };
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2607,6 +2885,9 @@ static RPCHelpMan dumptxoutset()
         "Write the serialized UTXO set to a file.",
         {
             {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "Path to the output file. If relative, will be prefixed by datadir."},
+            {"version", RPCArg::Type::NUM, RPCArg::Default{SNAPSHOT_VERSION_PLAIN}, "The snapshot format version. Version 2 snapshots are smaller and\n"
+                "faster to load, as coins are compressed further and in checksummed chunks that are decoded in parallel,\n"
+                "but can not be loaded by older nodes."},
         },
         RPCResult{
             RPCResult::Type::OBJ, "", "",
@@ -2621,11 +2902,16 @@ static RPCHelpMan dumptxoutset()
         },
         RPCExamples{
             HelpExampleCli("dumptxoutset", "utxo.dat")
+            + HelpExampleCli("dumptxoutset", "utxo.dat 2")
         },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
     const ArgsManager& args{EnsureAnyArgsman(request.context)};
     const fs::path path = fsbridge::AbsPathJoin(args.GetDataDirNet(), fs::u8path(request.params[0].get_str()));
+    const int version{request.params[1].isNull() ? SNAPSHOT_VERSION_PLAIN : request.params[1].getInt<int>()};
+    if (version != SNAPSHOT_VERSION_PLAIN && version != SNAPSHOT_VERSION_CHUNKED) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Unsupported snapshot version %d", version));
+    }
     // Write to a temporary path and then move into `path` on completion
     // to avoid confusion due to an interruption.
     const fs::path temppath = fsbridge::AbsPathJoin(args.GetDataDirNet(), fs::u8path(request.params[0].get_str() + ".incomplete"));
@@ -2647,7 +2933,7 @@ static RPCHelpMan dumptxoutset()
 
     NodeContext& node = EnsureAnyNodeContext(request.context);
     UniValue result = CreateUTXOSnapshot(
-        node, node.chainman->ActiveChainstate(), afile, path, temppath);
+        node, node.chainman->ActiveChainstate(), afile, path, temppath, version);
     fs::rename(temppath, path);
 
     result.pushKV("path", path.utf8string());
@@ -2661,7 +2947,8 @@ UniValue CreateUTXOSnapshot(
     Chainstate& chainstate,
     AutoFile& afile,
     const fs::path& path,
-    const fs::path& temppath)
+    const fs::path& temppath,
+    uint16_t version)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor;
     std::optional<CCoinsStats> maybe_stats;
@@ -2697,10 +2984,13 @@ UniValue CreateUTXOSnapshot(
         tip->nHeight, tip->GetBlockHash().ToString(),
         fs::PathToString(path), fs::PathToString(temppath)));
 
-    SnapshotMetadata metadata{tip->GetBlockHash(), tip->nHeight, maybe_stats->coins_count};
+    SnapshotMetadata metadata{tip->GetBlockHash(), tip->nHeight, maybe_stats->coins_count, version};
 
     afile << metadata;
 
+    std::optional<SnapshotChunkWriter> chunk_writer;
+    if (version == SNAPSHOT_VERSION_CHUNKED) chunk_writer.emplace(afile);
+
     COutPoint key;
     Txid last_hash;
     Coin coin;
@@ -2716,6 +3006,11 @@ UniValue CreateUTXOSnapshot(
     // them to file using the below lambda function.
     // See also https://github.com/bitcoin/bitcoin/issues/25675
     auto write_coins_to_file = [&](AutoFile& afile, const Txid& last_hash, const std::vector<std::pair<uint32_t, Coin>>& coins, size_t& written_coins_count) {
+        if (chunk_writer) {
+            chunk_writer->AddCoins(last_hash, coins);
+            written_coins_count += coins.size();
+            return;
+        }
         afile << last_hash;
         WriteCompactSize(afile, coins.size());
         for (const auto& [n, coin] : coins) {
@@ -2744,6 +3039,7 @@ UniValue CreateUTXOSnapshot(
     if (!coins.empty()) {
         write_coins_to_file(afile, last_hash, coins, written_coins_count);
     }
+    if (chunk_writer) chunk_writer->Finish();
 
     CHECK_NONFATAL(written_coins_count == maybe_stats->coins_count);
 
@@ -2919,6 +3215,61 @@ return RPCHelpMan{
     };
 }
 
+static RPCHelpMan getcoinsflushinfo()
+{
+    return RPCHelpMan{"getcoinsflushinfo",
+        "\nReturns statistics about writes of the coins cache to the coins database of the active chainstate.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::BOOL, "background", "whether flushes may be written in the background (see -dbbackgroundflush)"},
+                {RPCResult::Type::BOOL, "in_progress", "whether a background write is in progress"},
+                {RPCResult::Type::NUM, "flushes", "the number of completed writes since startup"},
+                {RPCResult::Type::OBJ, "last", /*optional=*/true, "the last completed write, if any",
+                {
+                    {RPCResult::Type::BOOL, "background", "whether it was written in the background"},
+                    {RPCResult::Type::NUM, "duration_ms", "how long the write took, in milliseconds"},
+                    {RPCResult::Type::NUM, "coins", "the number of changed coins written"},
+                    {RPCResult::Type::NUM, "bytes", "the estimated number of bytes written"},
+                }},
+                {RPCResult::Type::NUM, "total_bytes", "the estimated number of bytes written by all completed writes"},
+            }},
+        RPCExamples{
+            HelpExampleCli("getcoinsflushinfo", "")
+            + HelpExampleRpc("getcoinsflushinfo", "")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    // The coins database can be replaced once cs_main is released, so copy what is needed under it.
+    CoinsFlushStats stats;
+    bool background;
+    {
+        LOCK(::cs_main);
+        const CCoinsViewDB& coins_db{chainman.ActiveChainstate().CoinsDB()};
+        stats = coins_db.GetFlushStats();
+        background = coins_db.BackgroundFlushEnabled();
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("background", background);
+    ret.pushKV("in_progress", stats.in_progress);
+    ret.pushKV("flushes", stats.flushes);
+    if (stats.flushes > 0) {
+        UniValue last(UniValue::VOBJ);
+        last.pushKV("background", stats.last_background);
+        last.pushKV("duration_ms", count_milliseconds(stats.last_duration));
+        last.pushKV("coins", stats.last_coins);
+        last.pushKV("bytes", stats.last_bytes);
+        ret.pushKV("last", std::move(last));
+    }
+    ret.pushKV("total_bytes", stats.total_bytes);
+    return ret;
+},
+    };
+}
+
 
 void RegisterBlockchainRPCCommands(CRPCTable& t)
 {
@@ -2943,9 +3294,11 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &scantxoutset},
         {"blockchain", &scanblocks},
         {"blockchain", &getblockfilter},
+        {"blockchain", &getscripthistory},
         {"blockchain", &dumptxoutset},
         {"blockchain", &loadtxoutset},
         {"blockchain", &getchainstates},
+        {"blockchain", &getcoinsflushinfo},
         {"hidden", &invalidateblock},
         {"hidden", &reconsiderblock},
         {"hidden", &waitfornewblock},
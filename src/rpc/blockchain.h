@@ -13,12 +13,22 @@
 #include <validation.h>
 
 #include <any>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
 #include <stdint.h>
 #include <vector>
 
 class CBlock;
 class CBlockIndex;
+class CCoinsViewCursor;
 class Chainstate;
+class Coin;
+class COutPoint;
+class CScript;
+class JSONWriter;
 class UniValue;
 namespace node {
 struct NodeContext;
@@ -26,6 +36,12 @@ struct NodeContext;
 
 static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
 
+//! Maximum number of threads scantxoutset scans the UTXO set with
+static constexpr int MAX_SCANTXOUTSET_THREADS{16};
+
+//! Maximum number of threads gettxoutsetinfo computes UTXO set statistics with
+static constexpr int MAX_UTXO_STATS_THREADS{16};
+
 /**
  * Get the difficulty of the net wrt to the given block index.
  *
@@ -40,12 +56,31 @@ void RPCNotifyBlockChange(const CBlockIndex*);
 /** Block description to JSON */
 UniValue blockToJSON(node::BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity) LOCKS_EXCLUDED(cs_main);
 
+/** Write the object blockToJSON() returns, e.g. to a JSONTextWriter */
+void WriteBlockJSON(JSONWriter& writer, node::BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity) LOCKS_EXCLUDED(cs_main);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex& tip, const CBlockIndex& blockindex) LOCKS_EXCLUDED(cs_main);
 
 /** Used by getblockstats to get feerates at different percentiles by weight  */
 void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight);
 
+/**
+ * Search the coins of cursors for outputs paying to any of needles, with one
+ * thread per cursor, the calling thread taking the first. The cursors must be
+ * the ones returned by CCoinsViewDB::ShardedCursors(), whose txid ranges are
+ * used to report progress.
+ *
+ * @param[out] scan_progress  Percentage of the coins scanned so far
+ * @param[in] should_abort  Stops the scan when set
+ * @param[out] count  Number of coins scanned
+ * @param[in] interruption_point  Called regularly from all threads; if it throws, the scan stops and it is called again from the calling thread
+ * @return false if the scan was aborted or a coin could not be read
+ */
+bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>& should_abort, int64_t& count,
+                      const std::vector<std::unique_ptr<CCoinsViewCursor>>& cursors, const std::set<CScript>& needles,
+                      std::map<COutPoint, Coin>& out_results, const std::function<void()>& interruption_point);
+
 /**
  * Helper to create UTXO snapshots given a chainstate and a file handle.
  * @return a UniValue map containing metadata about the snapshot.
@@ -55,6 +90,7 @@ UniValue CreateUTXOSnapshot(
     Chainstate& chainstate,
     AutoFile& afile,
     const fs::path& path,
-    const fs::path& tmppath);
+    const fs::path& tmppath,
+    uint16_t version);
 
 #endif // BITCOIN_RPC_BLOCKCHAIN_H
@@ -75,6 +75,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listtransactions", 3, "include_watchonly" },
     { "walletpassphrase", 1, "timeout" },
     { "getblocktemplate", 0, "template_request" },
+    { "getblocktemplatediff", 0, "baseid" },
+    { "getblocktemplatediff", 1, "minfeeincrease" },
+    { "getblocktemplatediff", 2, "timeout" },
     { "listsinceblock", 1, "target_confirmations" },
     { "listsinceblock", 2, "include_watchonly" },
     { "listsinceblock", 3, "include_removed" },
@@ -92,7 +95,11 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "scanblocks", 3, "stop_height" },
     { "scanblocks", 5, "options" },
     { "scanblocks", 5, "filter_false_positives" },
+    { "getscripthistory", 1, "start_height" },
+    { "getscripthistory", 2, "stop_height" },
+    { "getscripthistory", 3, "count" },
     { "scantxoutset", 1, "scanobjects" },
+    { "dumptxoutset", 1, "version" },
     { "addmultisigaddress", 0, "nrequired" },
     { "addmultisigaddress", 1, "keys" },
     { "createmultisig", 0, "nrequired" },
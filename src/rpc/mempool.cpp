@@ -8,6 +8,7 @@
 #include <kernel/mempool_persist.h>
 
 #include <chainparams.h>
+#include <common/json_writer.h>
 #include <core_io.h>
 #include <kernel/mempool_entry.h>
 #include <node/mempool_persist_args.h>
@@ -276,101 +277,126 @@ static std::vector<RPCResult> MempoolEntryDescription()
     };
 }
 
-static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+/** Write the members of the object describing a mempool entry. */
+static void EntryFields(const CTxMemPool& pool, JSONWriter& writer, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
 {
     AssertLockHeld(pool.cs);
 
-    info.pushKV("vsize", (int)e.GetTxSize());
-    info.pushKV("weight", (int)e.GetTxWeight());
-    info.pushKV("time", count_seconds(e.GetTime()));
-    info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
-    info.pushKV("wtxid", e.GetTx().GetWitnessHash().ToString());
-
-    UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", ValueFromAmount(e.GetFee()));
-    fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
-    info.pushKV("fees", std::move(fees));
+    writer.Key("vsize");
+    writer.Int(e.GetTxSize());
+    writer.Key("weight");
+    writer.Int(e.GetTxWeight());
+    writer.Key("time");
+    writer.Int(count_seconds(e.GetTime()));
+    writer.Key("height");
+    writer.Int(e.GetHeight());
+    writer.Key("descendantcount");
+    writer.Int(e.GetCountWithDescendants());
+    writer.Key("descendantsize");
+    writer.Int(e.GetSizeWithDescendants());
+    writer.Key("ancestorcount");
+    writer.Int(e.GetCountWithAncestors());
+    writer.Key("ancestorsize");
+    writer.Int(e.GetSizeWithAncestors());
+    writer.Key("wtxid");
+    writer.String(e.GetTx().GetWitnessHash().ToString());
+
+    writer.Key("fees");
+    writer.BeginObject();
+    writer.Key("base");
+    writer.Value(ValueFromAmount(e.GetFee()));
+    writer.Key("modified");
+    writer.Value(ValueFromAmount(e.GetModifiedFee()));
+    writer.Key("ancestor");
+    writer.Value(ValueFromAmount(e.GetModFeesWithAncestors()));
+    writer.Key("descendant");
+    writer.Value(ValueFromAmount(e.GetModFeesWithDescendants()));
+    writer.EndObject();
 
     const CTransaction& tx = e.GetTx();
     std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
-    {
-        if (pool.exists(GenTxid::Txid(txin.prevout.hash)))
+    for (const CTxIn& txin : tx.vin) {
+        if (pool.exists(GenTxid::Txid(txin.prevout.hash))) {
             setDepends.insert(txin.prevout.hash.ToString());
+        }
     }
-
-    UniValue depends(UniValue::VARR);
-    for (const std::string& dep : setDepends)
-    {
-        depends.push_back(dep);
+    writer.Key("depends");
+    writer.BeginArray();
+    for (const std::string& dep : setDepends) {
+        writer.String(dep);
     }
+    writer.EndArray();
 
-    info.pushKV("depends", std::move(depends));
-
-    UniValue spent(UniValue::VARR);
+    writer.Key("spentby");
+    writer.BeginArray();
     for (const CTxMemPoolEntry& child : e.GetMemPoolChildrenConst()) {
-        spent.push_back(child.GetTx().GetHash().ToString());
+        writer.String(child.GetTx().GetHash().ToString());
     }
-
-    info.pushKV("spentby", std::move(spent));
+    writer.EndArray();
 
     // Add opt-in RBF status
-    bool rbfStatus = false;
-    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
+    const RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
     if (rbfState == RBFTransactionState::UNKNOWN) {
         throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
-    } else if (rbfState == RBFTransactionState::REPLACEABLE_BIP125) {
-        rbfStatus = true;
     }
+    writer.Key("bip125-replaceable");
+    writer.Bool(rbfState == RBFTransactionState::REPLACEABLE_BIP125);
+    writer.Key("unbroadcast");
+    writer.Bool(pool.IsUnbroadcastTx(tx.GetHash()));
+}
 
-    info.pushKV("bip125-replaceable", rbfStatus);
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
+static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    UniValueWriter writer{info};
+    EntryFields(pool, writer, e);
 }
 
-UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
+void WriteMempoolJSON(JSONWriter& writer, const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
 {
     if (verbose) {
         if (include_mempool_sequence) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbose results cannot contain mempool sequence values.");
         }
         LOCK(pool.cs);
-        UniValue o(UniValue::VOBJ);
+        writer.BeginObject();
         for (const CTxMemPoolEntry& e : pool.entryAll()) {
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e);
-            // Mempool has unique entries so there is no advantage in using
-            // UniValue::pushKV, which checks if the key already exists in O(N).
-            // UniValue::pushKVEnd is used instead which currently is O(1).
-            o.pushKVEnd(e.GetTx().GetHash().ToString(), std::move(info));
+            writer.Key(e.GetTx().GetHash().ToString());
+            writer.BeginObject();
+            EntryFields(pool, writer, e);
+            writer.EndObject();
         }
-        return o;
+        writer.EndObject();
     } else {
-        UniValue a(UniValue::VARR);
+        if (include_mempool_sequence) {
+            writer.BeginObject();
+            writer.Key("txids");
+        }
+        writer.BeginArray();
         uint64_t mempool_sequence;
         {
             LOCK(pool.cs);
             for (const CTxMemPoolEntry& e : pool.entryAll()) {
-                a.push_back(e.GetTx().GetHash().ToString());
+                writer.String(e.GetTx().GetHash().ToString());
             }
             mempool_sequence = pool.GetSequence();
         }
-        if (!include_mempool_sequence) {
-            return a;
-        } else {
-            UniValue o(UniValue::VOBJ);
-            o.pushKV("txids", std::move(a));
-            o.pushKV("mempool_sequence", mempool_sequence);
-            return o;
+        writer.EndArray();
+        if (include_mempool_sequence) {
+            writer.Key("mempool_sequence");
+            writer.Int(mempool_sequence);
+            writer.EndObject();
         }
     }
 }
 
+UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
+{
+    UniValue result;
+    UniValueWriter writer{result};
+    WriteMempoolJSON(writer, pool, verbose, include_mempool_sequence);
+    return result;
+}
+
 static RPCHelpMan getrawmempool()
 {
     return RPCHelpMan{"getrawmempool",
@@ -416,7 +442,14 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
-    return MempoolToJSON(EnsureAnyMemPool(request.context), fVerbose, include_mempool_sequence);
+    const CTxMemPool& mempool{EnsureAnyMemPool(request.context)};
+    if (request.write_result) {
+        request.write_result([&](JSONWriter& writer) {
+            WriteMempoolJSON(writer, mempool, fVerbose, include_mempool_sequence);
+        });
+        return NullUniValue;
+    }
+    return MempoolToJSON(mempool, fVerbose, include_mempool_sequence);
 },
     };
 }
@@ -669,7 +702,17 @@ UniValue MempoolInfoToJSON(const CTxMemPool& pool)
     ret.pushKV("loaded", pool.GetLoadTried());
     ret.pushKV("size", (int64_t)pool.size());
     ret.pushKV("bytes", (int64_t)pool.GetTotalTxSize());
-    ret.pushKV("usage", (int64_t)pool.DynamicMemoryUsage());
+    const CTxMemPool::MemoryUsage usage{pool.GetMemoryUsage()};
+    ret.pushKV("usage", (int64_t)usage.Total());
+    UniValue usage_breakdown(UniValue::VOBJ);
+    usage_breakdown.pushKV("entries", (int64_t)usage.entries);
+    usage_breakdown.pushKV("transactions", (int64_t)usage.transactions);
+    usage_breakdown.pushKV("links", (int64_t)usage.links);
+    usage_breakdown.pushKV("spends", (int64_t)usage.spends);
+    usage_breakdown.pushKV("deltas", (int64_t)usage.deltas);
+    usage_breakdown.pushKV("randomized", (int64_t)usage.randomized);
+    usage_breakdown.pushKV("clusters", (int64_t)usage.clusters);
+    ret.pushKV("usagebreakdown", std::move(usage_breakdown));
     ret.pushKV("total_fee", ValueFromAmount(pool.GetTotalFee()));
     ret.pushKV("maxmempool", pool.m_opts.max_size_bytes);
     ret.pushKV("mempoolminfee", ValueFromAmount(std::max(pool.GetMinFee(), pool.m_opts.min_relay_feerate).GetFeePerK()));
@@ -692,6 +735,16 @@ static RPCHelpMan getmempoolinfo()
                 {RPCResult::Type::NUM, "size", "Current tx count"},
                 {RPCResult::Type::NUM, "bytes", "Sum of all virtual transaction sizes as defined in BIP 141. Differs from actual serialized size because witness data is discounted"},
                 {RPCResult::Type::NUM, "usage", "Total memory usage for the mempool"},
+                {RPCResult::Type::OBJ, "usagebreakdown", "Memory usage for the mempool, split up by what it is used for. The fields add up to usage",
+                {
+                    {RPCResult::Type::NUM, "entries", "The mempool entries and their indexes"},
+                    {RPCResult::Type::NUM, "transactions", "The transactions"},
+                    {RPCResult::Type::NUM, "links", "Links between in-mempool parents and children that do not fit in their entries"},
+                    {RPCResult::Type::NUM, "spends", "The index of spent outputs"},
+                    {RPCResult::Type::NUM, "deltas", "Fee deltas set through prioritisetransaction"},
+                    {RPCResult::Type::NUM, "randomized", "The list of transactions in random order, used for relay"},
+                    {RPCResult::Type::NUM, "clusters", "Cluster linearizations, only used with -clustermempool"},
+                }},
                 {RPCResult::Type::STR_AMOUNT, "total_fee", "Total fees for the mempool in " + CURRENCY_UNIT + ", ignoring modified fees through prioritisetransaction"},
                 {RPCResult::Type::NUM, "maxmempool", "Maximum memory usage for the mempool"},
                 {RPCResult::Type::STR_AMOUNT, "mempoolminfee", "Minimum fee rate in " + CURRENCY_UNIT + "/kvB for tx to be accepted. Is the maximum of minrelaytxfee and minimum mempool fee"},
@@ -6,6 +6,7 @@
 #define BITCOIN_RPC_MEMPOOL_H
 
 class CTxMemPool;
+class JSONWriter;
 class UniValue;
 
 /** Mempool information to JSON */
@@ -14,4 +15,7 @@ UniValue MempoolInfoToJSON(const CTxMemPool& pool);
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
 
+/** Write the value MempoolToJSON() returns, e.g. to a JSONTextWriter */
+void WriteMempoolJSON(JSONWriter& writer, const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
+
 #endif // BITCOIN_RPC_MEMPOOL_H
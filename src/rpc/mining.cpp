@@ -31,6 +31,7 @@
 #include <script/signingprovider.h>
 #include <txmempool.h>
 #include <univalue.h>
+#include <util/moneystr.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
 #include <util/string.h>
@@ -795,32 +796,20 @@ static RPCHelpMan getblocktemplate()
         throw JSONRPCError(RPC_INVALID_PARAMETER, "getblocktemplate must be called with the segwit rule set (call with {\"rules\": [\"segwit\"]})");
     }
 
-    // Update block
-    static CBlockIndex* pindexPrev;
-    static int64_t time_start;
-    static std::unique_ptr<CBlockTemplate> pblocktemplate;
-    if (pindexPrev != active_chain.Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - time_start > 5))
-    {
-        // Clear pindexPrev so future calls make a new block, despite any failures from here on
-        pindexPrev = nullptr;
-
-        // Store the pindexBest used before CreateNewBlock, to avoid races
+    // Update block. The cache appends new mempool transactions to the template as they arrive,
+    // and rebuilds it for other mempool changes at most every 5 seconds, or for a new tip.
+    static std::shared_ptr<const CBlockTemplate> pblocktemplate;
+    CScript scriptDummy = CScript() << OP_TRUE;
+    std::shared_ptr<const CBlockTemplate> new_template{EnsureBlockTemplateCache(node).Get(scriptDummy, node::TEMPLATE_MAX_STALE)};
+    if (new_template != pblocktemplate) {
         nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
-        CBlockIndex* pindexPrevNew = active_chain.Tip();
-        time_start = GetTime();
-
-        // Create new block
-        CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler{active_chainstate, &mempool}.CreateNewBlock(scriptDummy);
-        if (!pblocktemplate)
-            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-
-        // Need to update only after we know CreateNewBlock succeeded
-        pindexPrev = pindexPrevNew;
+        pblocktemplate = std::move(new_template);
     }
-    CHECK_NONFATAL(pindexPrev);
-    CBlock* pblock = &pblocktemplate->block; // pointer for convenience
+    const CBlockIndex* pindexPrev = active_chain.Tip();
+    CHECK_NONFATAL(pblocktemplate->block.hashPrevBlock == pindexPrev->GetBlockHash());
+    // Copy of the template block, with header fields updated below
+    CBlock block{pblocktemplate->block};
+    CBlock* pblock = &block; // pointer for convenience
 
     // Update nTime
     UpdateTime(pblock, consensusParams, pindexPrev);
@@ -974,6 +963,111 @@ static RPCHelpMan getblocktemplate()
     };
 }
 
+static RPCHelpMan getblocktemplatediff()
+{
+    return RPCHelpMan{"getblocktemplatediff",
+        "\nReturns the block template used by getblocktemplate as a change to a template earlier returned by this call.\n"
+        "Waits up to timeout seconds until there is a new tip, or the template fees increased by at least minfeeincrease.\n"
+        "The block's transactions are the coinbase, then the base template's transactions without the removed ones, in their original order, then the added ones.\n"
+        "The same updates are published by -zmqpubtemplatediff.\n",
+        {
+            {"baseid", RPCArg::Type::NUM, RPCArg::Default{0}, "The id of an earlier template to return the changes to. The changes to an empty template are returned if it is 0, unknown, or built on an earlier tip."},
+            {"minfeeincrease", RPCArg::Type::AMOUNT, RPCArg::Default{FormatMoney(node::DEFAULT_TEMPLATE_UPDATE_MIN_FEE)}, "The minimum increase in template fees over the base template, in " + CURRENCY_UNIT},
+            {"timeout", RPCArg::Type::NUM, RPCArg::Default{0}, "Time in seconds to wait for an update"},
+        },
+        {
+            RPCResult{"If there is no update before the timeout", RPCResult::Type::NONE, "", ""},
+            RPCResult{"Otherwise", RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::NUM, "id", "The id of this template, to request changes to it"},
+                {RPCResult::Type::NUM, "baseid", "The id of the template the changes are to, or 0 if all transactions are added"},
+                {RPCResult::Type::STR_HEX, "previousblockhash", "The hash of the block the template builds on"},
+                {RPCResult::Type::NUM, "fees", "The total fees of the template's transactions (in satoshis)"},
+                {RPCResult::Type::ARR, "removed", "The removed transactions",
+                {
+                    {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                }},
+                {RPCResult::Type::ARR, "added", "The added transactions, in block order",
+                {
+                    {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                }},
+                {RPCResult::Type::STR_HEX, "data", "The serialized update: id, base id, block header, fees, coinbase transaction, removed txids and added transactions"},
+            }},
+        },
+        RPCExamples{
+            HelpExampleCli("getblocktemplatediff", "")
+            + HelpExampleCli("getblocktemplatediff", "12 0.001 60")
+            + HelpExampleRpc("getblocktemplatediff", "12, 0.001, 60")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+    node::BlockTemplateCache& cache = EnsureBlockTemplateCache(node);
+
+    const uint64_t base_id{request.params[0].isNull() ? 0 : request.params[0].getInt<uint64_t>()};
+    const CAmount min_fee_increase{request.params[1].isNull() ? node::DEFAULT_TEMPLATE_UPDATE_MIN_FEE : AmountFromValue(request.params[1])};
+    const int64_t timeout{request.params[2].isNull() ? 0 : request.params[2].getInt<int64_t>()};
+    if (timeout < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative timeout");
+    }
+
+    if (!chainman.GetParams().IsTestChain()) {
+        const CConnman& connman = EnsureConnman(node);
+        if (connman.GetNodeCount(ConnectionDirection::Both) == 0) {
+            throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, PACKAGE_NAME " is not connected!");
+        }
+
+        if (chainman.IsInitialBlockDownload()) {
+            throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, PACKAGE_NAME " is in initial sync and waiting for blocks...");
+        }
+    }
+
+    // Same coinbase script as getblocktemplate, so both are served from the same cached template.
+    const CScript scriptDummy = CScript() << OP_TRUE;
+    const auto deadline{std::chrono::steady_clock::now() + std::chrono::seconds{timeout}};
+    std::optional<node::BlockTemplateDiff> diff;
+    while (true) {
+        const uint256 best_block{WITH_LOCK(g_best_block_mutex, return g_best_block)};
+        diff = cache.GetUpdate(scriptDummy, base_id, min_fee_increase, node::TEMPLATE_MAX_STALE);
+        if (diff) break;
+
+        // Wait for a new tip, and check for mempool changes in between.
+        const auto now{std::chrono::steady_clock::now()};
+        if (now >= deadline) return NullUniValue;
+        WAIT_LOCK(g_best_block_mutex, lock);
+        g_best_block_cv.wait_until(lock, std::min(deadline, now + node::TEMPLATE_UPDATE_INTERVAL), [&]() EXCLUSIVE_LOCKS_REQUIRED(g_best_block_mutex) {
+            return g_best_block != best_block || !IsRPCRunning();
+        });
+        if (!IsRPCRunning()) {
+            throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "Shutting down");
+        }
+    }
+
+    UniValue removed(UniValue::VARR);
+    for (const Txid& txid : diff->removed) {
+        removed.push_back(txid.GetHex());
+    }
+    UniValue added(UniValue::VARR);
+    for (const CTransactionRef& tx : diff->added) {
+        added.push_back(tx->GetHash().GetHex());
+    }
+    DataStream ssDiff;
+    ssDiff << TX_WITH_WITNESS(*diff);
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("id", diff->id);
+    result.pushKV("baseid", diff->base_id);
+    result.pushKV("previousblockhash", diff->header.hashPrevBlock.GetHex());
+    result.pushKV("fees", diff->fees);
+    result.pushKV("removed", std::move(removed));
+    result.pushKV("added", std::move(added));
+    result.pushKV("data", HexStr(ssDiff));
+    return result;
+},
+    };
+}
+
 class submitblock_StateCatcher final : public CValidationInterface
 {
 public:
@@ -1108,6 +1202,7 @@ void RegisterMiningRPCCommands(CRPCTable& t)
         {"mining", &prioritisetransaction},
         {"mining", &getprioritisedtransactions},
         {"mining", &getblocktemplate},
+        {"mining", &getblocktemplatediff},
         {"mining", &submitblock},
         {"mining", &submitheader},
 
@@ -9,6 +9,9 @@
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/prevoutindex.h>
+#include <index/scripthistoryindex.h>
+#include <index/scriptutxoindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <interfaces/echo.h>
@@ -392,6 +395,18 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
     }
 
+    if (g_prevout_index) {
+        result.pushKVs(SummaryToJSON(g_prevout_index->GetSummary(), index_name));
+    }
+
+    if (g_script_history_index) {
+        result.pushKVs(SummaryToJSON(g_script_history_index->GetSummary(), index_name));
+    }
+
+    if (g_script_utxo_index) {
+        result.pushKVs(SummaryToJSON(g_script_utxo_index->GetSummary(), index_name));
+    }
+
     ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
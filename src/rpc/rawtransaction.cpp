@@ -9,6 +9,7 @@
 #include <consensus/amount.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <index/prevoutindex.h>
 #include <index/txindex.h>
 #include <key_io.h>
 #include <node/blockstorage.h>
@@ -305,7 +306,7 @@ static RPCHelpMan getrawtransaction()
                                 {RPCResult::Type::OBJ, "", "utxo being spent",
                                 {
                                     {RPCResult::Type::ELISION, "", "Same output as verbosity = 1"},
-                                    {RPCResult::Type::OBJ, "prevout", /*optional=*/true, "The previous output, omitted if block undo data is not available",
+                                    {RPCResult::Type::OBJ, "prevout", /*optional=*/true, "The previous output, omitted if block undo data is not available and the transaction is not in the prevout index",
                                     {
                                         {RPCResult::Type::BOOL, "generated", "Coinbase or not"},
                                         {RPCResult::Type::NUM, "height", "The height of the prevout"},
@@ -401,6 +402,29 @@ static RPCHelpMan getrawtransaction()
         return result;
     }
 
+    // The prevout index has the undo data of the transaction itself, so
+    // neither the block nor its undo data has to be read. Its entry is only
+    // trusted for transactions of the active chain that the index has
+    // processed, as the coin heights may differ in other blocks, and an entry
+    // written for a block that was since disconnected is only replaced once
+    // the index reaches the block now confirming the transaction. Otherwise
+    // the block and its undo data are read below.
+    CTxUndo txundo;
+    if (g_prevout_index && !tx->IsCoinBase() && blockindex) {
+        g_prevout_index->BlockUntilSyncedToCurrentChain();
+        const uint256 index_best_block{g_prevout_index->GetSummary().best_block_hash};
+        bool index_has_block;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* index_tip{chainman.m_blockman.LookupBlockIndex(index_best_block)};
+            index_has_block = chainman.ActiveChain().Contains(blockindex) && index_tip && index_tip->GetAncestor(blockindex->nHeight) == blockindex;
+        }
+        if (index_has_block && g_prevout_index->FindPrevouts(tx->GetHash(), txundo)) {
+            TxToJSON(*tx, hash_block, result, chainman.ActiveChainstate(), &txundo, TxVerbosity::SHOW_DETAILS_AND_PREVOUT);
+            return result;
+        }
+    }
+
     CBlockUndo blockUndo;
     CBlock block;
 
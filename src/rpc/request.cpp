@@ -67,6 +67,21 @@ UniValue JSONRPCReplyObj(UniValue result, UniValue error, std::optional<UniValue
     return reply;
 }
 
+std::pair<std::string, std::string> JSONRPCReplyEnvelope(const std::optional<UniValue>& id, JSONRPCVersion jsonrpc_version)
+{
+    std::string before{"{"};
+    if (jsonrpc_version == JSONRPCVersion::V2) before += "\"jsonrpc\":\"2.0\",";
+    before += "\"result\":";
+    std::string after;
+    if (jsonrpc_version == JSONRPCVersion::V1_LEGACY) after += ",\"error\":null";
+    if (id.has_value()) {
+        after += ",\"id\":";
+        after += id->write();
+    }
+    after += '}';
+    return {std::move(before), std::move(after)};
+}
+
 UniValue JSONRPCError(int code, const std::string& message)
 {
     UniValue error(UniValue::VOBJ);
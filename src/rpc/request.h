@@ -7,11 +7,16 @@
 #define BITCOIN_RPC_REQUEST_H
 
 #include <any>
+#include <chrono>
+#include <functional>
 #include <optional>
 #include <string>
+#include <utility>
 
 #include <univalue.h>
 
+class JSONWriter;
+
 enum class JSONRPCVersion {
     V1_LEGACY,
     V2
@@ -19,6 +24,8 @@ enum class JSONRPCVersion {
 
 UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params, const UniValue& id);
 UniValue JSONRPCReplyObj(UniValue result, UniValue error, std::optional<UniValue> id, JSONRPCVersion jsonrpc_version);
+/** The text of JSONRPCReplyObj() for a successful result before and after the result, for results written as JSON text */
+std::pair<std::string, std::string> JSONRPCReplyEnvelope(const std::optional<UniValue>& id, JSONRPCVersion jsonrpc_version);
 UniValue JSONRPCError(int code, const std::string& message);
 
 /** Generate a new RPC authentication cookie and write it to disk */
@@ -42,6 +49,20 @@ public:
     std::string peerAddr;
     std::any context;
     JSONRPCVersion m_json_version = JSONRPCVersion::V1_LEGACY;
+    /**
+     * If set, methods that wait for an event may call this instead of blocking the thread
+     * that executes them: the request is answered with `result()` once `ready()` returns
+     * true, or once the optional timeout elapsed, and the return value of the method is
+     * ignored.
+     */
+    std::function<void(std::function<bool()> ready, std::optional<std::chrono::milliseconds> timeout, std::function<UniValue()> result)> park;
+    /**
+     * If set, methods with large results may pass this a function that writes the result
+     * to a JSONWriter, instead of building a UniValue: the request is answered with what
+     * it writes, e.g. straight into the HTTP reply, and the return value of the method is
+     * ignored.
+     */
+    std::function<void(const std::function<void(JSONWriter&)>& write)> write_result;
 
     void parse(const UniValue& valRequest);
     [[nodiscard]] bool IsNotification() const { return !id.has_value() && m_json_version == JSONRPCVersion::V2; };
@@ -23,8 +23,10 @@
 
 #include <cassert>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 static GlobalMutex g_rpc_warmup_mutex;
@@ -519,12 +521,22 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
 static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& request, UniValue& result, bool last_handler)
 {
     try {
-        RPCCommandExecution execution(request.strMethod);
+        auto execution{std::make_shared<RPCCommandExecution>(request.strMethod)};
+        // A parked request stays listed in getrpcinfo until it has been answered
+        JSONRPCRequest parking_request;
+        const JSONRPCRequest* req{&request};
+        if (request.park) {
+            parking_request = request;
+            parking_request.park = [park = request.park, execution](std::function<bool()> ready, std::optional<std::chrono::milliseconds> timeout, std::function<UniValue()> result) {
+                park(std::move(ready), timeout, [execution, result = std::move(result)] { return result(); });
+            };
+            req = &parking_request;
+        }
         // Execute, convert arguments to array if necessary
-        if (request.params.isObject()) {
-            return command.actor(transformNamedArguments(request, command.argNames), result, last_handler);
+        if (req->params.isObject()) {
+            return command.actor(transformNamedArguments(*req, command.argNames), result, last_handler);
         } else {
-            return command.actor(request, result, last_handler);
+            return command.actor(*req, result, last_handler);
         }
     } catch (const UniValue::type_error& e) {
         throw JSONRPCError(RPC_TYPE_ERROR, e.what());
@@ -16,6 +16,7 @@ class ChainstateManager;
 class PeerManager;
 class BanMan;
 namespace node {
+class BlockTemplateCache;
 struct NodeContext;
 } // namespace node
 
@@ -34,5 +35,6 @@ CConnman& EnsureConnman(const node::NodeContext& node);
 PeerManager& EnsurePeerman(const node::NodeContext& node);
 AddrMan& EnsureAddrman(const node::NodeContext& node);
 AddrMan& EnsureAnyAddrman(const std::any& context);
+node::BlockTemplateCache& EnsureBlockTemplateCache(const node::NodeContext& node);
 
 #endif // BITCOIN_RPC_SERVER_UTIL_H
@@ -7,6 +7,7 @@
 #include <clientversion.h>
 #include <core_io.h>
 #include <common/args.h>
+#include <common/json_writer.h>
 #include <consensus/amount.h>
 #include <script/interpreter.h>
 #include <key_io.h>
@@ -633,11 +634,25 @@ UniValue RPCHelpMan::HandleRequest(const JSONRPCRequest& request) const
     if (!arg_mismatch.empty()) {
         throw JSONRPCError(RPC_TYPE_ERROR, strprintf("Wrong type passed:\n%s", arg_mismatch.write(4)));
     }
+    const bool doc_check{gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)};
+    // Written results are checked too, by writing them to a UniValue as well.
+    std::optional<UniValue> written;
+    std::optional<JSONRPCRequest> checked_request;
+    if (doc_check && request.write_result) {
+        checked_request = request;
+        checked_request->write_result = [&](const std::function<void(JSONWriter&)>& write) {
+            UniValueWriter writer{written.emplace()};
+            write(writer);
+            request.write_result(write);
+        };
+    }
+    const JSONRPCRequest& req{checked_request ? *checked_request : request};
     CHECK_NONFATAL(m_req == nullptr);
-    m_req = &request;
-    UniValue ret = m_fun(*this, request);
+    m_req = &req;
+    UniValue ret = m_fun(*this, req);
     m_req = nullptr;
-    if (gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)) {
+    if (doc_check) {
+        if (written) ret = std::move(*written);
         UniValue mismatch{UniValue::VARR};
         for (const auto& res : m_results.m_results) {
             UniValue match{res.MatchesType(ret)};
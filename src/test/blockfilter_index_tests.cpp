@@ -269,6 +269,30 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
     filter_index.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_parallel_sync, BuildChainTestingSetup)
+{
+    BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, true);
+    BOOST_REQUIRE(filter_index.Init());
+
+    // Blocks are processed out of order on the workers, but the filter headers
+    // must still chain up as if the blocks were indexed one at a time.
+    BOOST_REQUIRE(filter_index.StartBackgroundSync(/*worker_threads=*/3));
+    IndexWaitSynced(filter_index, *Assert(m_node.shutdown));
+
+    uint256 last_header;
+    {
+        LOCK(cs_main);
+        for (const CBlockIndex* block_index = m_node.chainman->ActiveChain().Genesis();
+             block_index != nullptr;
+             block_index = m_node.chainman->ActiveChain().Next(block_index)) {
+            BOOST_CHECK(CheckFilterLookups(filter_index, block_index, last_header, m_node.chainman->m_blockman));
+        }
+    }
+
+    filter_index.Interrupt();
+    filter_index.Stop();
+}
+
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_init_destroy, BasicTestingSetup)
 {
     BlockFilterIndex* filter_index;
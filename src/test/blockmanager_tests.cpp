@@ -12,6 +12,8 @@
 #include <util/chaintype.h>
 #include <validation.h>
 
+#include <algorithm>
+
 #include <boost/test/unit_test.hpp>
 #include <test/util/logging.h>
 #include <test/util/setup_common.h>
@@ -20,6 +22,7 @@ using node::BLOCK_SERIALIZATION_HEADER_SIZE;
 using node::BlockManager;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
+using node::RawBlockData;
 
 // use BasicTestingSetup here for the data directory configuration, setup, and cleanup
 BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BasicTestingSetup)
@@ -52,6 +55,40 @@ BOOST_AUTO_TEST_CASE(blockmanager_find_block_pos)
     BOOST_CHECK_EQUAL(actual.nPos, BLOCK_SERIALIZATION_HEADER_SIZE + ::GetSerializeSize(TX_WITH_WITNESS(params->GenesisBlock())) + BLOCK_SERIALIZATION_HEADER_SIZE);
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_read_mapped_raw_block)
+{
+    const auto params {CreateChainParams(ArgsManager{}, ChainType::MAIN)};
+    KernelNotifications notifications{*Assert(m_node.shutdown), m_node.exit_status};
+    for (const int map_files : {0, 1}) {
+        const BlockManager::Options blockman_opts{
+            .chainparams = *params,
+            .blocks_dir = m_args.GetBlocksDirPath(),
+            .notifications = notifications,
+            .block_map_files = map_files,
+        };
+        BlockManager blockman{*Assert(m_node.shutdown), blockman_opts};
+        const FlatFilePos first{blockman.SaveBlockToDisk(params->GenesisBlock(), 0)};
+
+        std::vector<uint8_t> copy;
+        BOOST_CHECK(blockman.ReadRawBlockFromDisk(copy, first));
+        RawBlockData data;
+        BOOST_CHECK(blockman.ReadRawBlockFromDisk(data, first));
+        BOOST_CHECK_EQUAL(data.IsMapped(), map_files > 0);
+        BOOST_CHECK(std::ranges::equal(MakeByteSpan(copy), data.Data()));
+
+        // A block appended after the file was mapped is read through a new
+        // mapping, while the earlier view stays valid.
+        const FlatFilePos second{blockman.SaveBlockToDisk(params->GenesisBlock(), 1)};
+        RawBlockData second_data;
+        BOOST_CHECK(blockman.ReadRawBlockFromDisk(second_data, second));
+        BOOST_CHECK(std::ranges::equal(second_data.Data(), data.Data()));
+
+        // A position that doesn't point after a block header fails either way.
+        BOOST_CHECK(!blockman.ReadRawBlockFromDisk(data, FlatFilePos{first.nFile, first.nPos + 1}));
+        BOOST_CHECK(!blockman.ReadRawBlockFromDisk(data, FlatFilePos{first.nFile, 0}));
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(blockmanager_scan_unlink_already_pruned_files, TestChain100Setup)
 {
     // Cap last block file size, and mine new block in a new block file.
@@ -156,9 +156,9 @@ typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
 /** This test case checks that the CCheckQueue works properly
  * with each specified size_t Checks pushed.
  */
-static void Correct_Queue_range(std::vector<size_t> range)
+static void Correct_Queue_range(std::vector<size_t> range, bool work_stealing = false)
 {
-    auto small_queue = std::make_unique<Correct_Queue>(QUEUE_BATCH_SIZE, SCRIPT_CHECK_THREADS);
+    auto small_queue = std::make_unique<Correct_Queue>(QUEUE_BATCH_SIZE, SCRIPT_CHECK_THREADS, work_stealing);
     // Make vChecks here to save on malloc (this test can be slow...)
     std::vector<FakeCheckCheckCompletion> vChecks;
     vChecks.reserve(9);
@@ -286,6 +286,56 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_UniqueCheck)
     }
 }
 
+/** Test that the work stealing scheduler runs every check exactly once, and
+ *  catches failures and recovers from them like the shared queue. */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_WorkStealing)
+{
+    std::vector<size_t> range;
+    for (size_t i = 0; i < 20000; i += 1 + InsecureRandRange(1000)) {
+        range.push_back(i);
+    }
+    Correct_Queue_range(range, /*work_stealing=*/true);
+
+    auto unique_queue = std::make_unique<Unique_Queue>(QUEUE_BATCH_SIZE, SCRIPT_CHECK_THREADS, /*work_stealing=*/true);
+    const size_t COUNT{10000};
+    {
+        WITH_LOCK(UniqueCheck::m, UniqueCheck::results.clear());
+        CCheckQueueControl<UniqueCheck> control(unique_queue.get());
+        size_t total{COUNT};
+        while (total) {
+            std::vector<UniqueCheck> vChecks;
+            for (size_t k = InsecureRandRange(100); k > 0 && total; --k) {
+                vChecks.emplace_back(--total);
+            }
+            control.Add(std::move(vChecks));
+        }
+        BOOST_REQUIRE(control.Wait());
+    }
+    {
+        LOCK(UniqueCheck::m);
+        BOOST_REQUIRE_EQUAL(UniqueCheck::results.size(), COUNT);
+        for (size_t i = 0; i < COUNT; ++i) {
+            BOOST_REQUIRE_EQUAL(UniqueCheck::results.count(i), 1U);
+        }
+    }
+
+    auto fail_queue = std::make_unique<Failing_Queue>(QUEUE_BATCH_SIZE, SCRIPT_CHECK_THREADS, /*work_stealing=*/true);
+    for (auto times = 0; times < 100; ++times) {
+        const size_t failing{InsecureRandRange(1000)};
+        for (const bool fails : {true, false}) {
+            CCheckQueueControl<FailingCheck> control(fail_queue.get());
+            for (size_t i = 0; i < 1000; i += 10) {
+                std::vector<FailingCheck> vChecks;
+                for (size_t k = i; k < i + 10; ++k) {
+                    vChecks.emplace_back(fails && k == failing);
+                }
+                control.Add(std::move(vChecks));
+            }
+            BOOST_REQUIRE(control.Wait() != fails);
+        }
+    }
+}
+
 
 // Test that blocks which might allocate lots of memory free their memory aggressively.
 //
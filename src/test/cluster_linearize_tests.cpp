@@ -0,0 +1,97 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cluster_linearize.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace cluster_linearize;
+
+BOOST_FIXTURE_TEST_SUITE(cluster_linearize_tests, BasicTestingSetup)
+
+/** Check that every transaction appears exactly once, after all of its parents. */
+static void CheckTopological(const DepGraph& graph, const std::vector<uint32_t>& linearization)
+{
+    BOOST_REQUIRE_EQUAL(linearization.size(), graph.TxCount());
+    std::vector<bool> done(graph.TxCount(), false);
+    for (const uint32_t tx : linearization) {
+        BOOST_CHECK(!done[tx]);
+        for (const uint32_t parent : graph.Parents(tx)) BOOST_CHECK(done[parent]);
+        done[tx] = true;
+    }
+}
+
+/** Check that the chunks cover the linearization with non-increasing feerates. */
+static void CheckChunks(const DepGraph& graph, const std::vector<uint32_t>& linearization, const std::vector<Chunk>& chunks)
+{
+    size_t pos{0};
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        FeeFrac feerate;
+        for (uint32_t j = 0; j < chunks[i].count; ++j) feerate += graph.FeeRate(linearization.at(pos++));
+        BOOST_CHECK(feerate == chunks[i].feerate);
+        if (i > 0) BOOST_CHECK(!(chunks[i].feerate >> chunks[i - 1].feerate));
+    }
+    BOOST_CHECK_EQUAL(pos, linearization.size());
+}
+
+BOOST_AUTO_TEST_CASE(linearize_cpfp)
+{
+    // A low feerate parent with a high feerate child, and an unrelated transaction in between.
+    DepGraph graph;
+    graph.AddTransaction({1000, 100});
+    graph.AddTransaction({5000, 100});
+    graph.AddTransaction({20000, 100});
+    graph.AddParent(0);
+
+    const std::vector<uint32_t> linearization{Linearize(graph)};
+    BOOST_CHECK(linearization == (std::vector<uint32_t>{0, 2, 1}));
+    const std::vector<Chunk> chunks{ChunkLinearization(graph, linearization)};
+    BOOST_REQUIRE_EQUAL(chunks.size(), 2U);
+    BOOST_CHECK(chunks[0].feerate == FeeFrac(21000, 200));
+    BOOST_CHECK_EQUAL(chunks[0].count, 2U);
+    BOOST_CHECK(chunks[1].feerate == FeeFrac(5000, 100));
+    BOOST_CHECK_EQUAL(chunks[1].count, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(linearize_parent_added_later)
+{
+    // Parents may be added after their children; the low feerate parent is still mined first,
+    // together with its child.
+    DepGraph graph;
+    graph.AddTransaction({10000, 100});
+    graph.AddParent(1);
+    graph.AddTransaction({100, 100});
+
+    const std::vector<uint32_t> linearization{Linearize(graph)};
+    BOOST_CHECK(linearization == (std::vector<uint32_t>{1, 0}));
+    const std::vector<Chunk> chunks{ChunkLinearization(graph, linearization)};
+    BOOST_REQUIRE_EQUAL(chunks.size(), 1U);
+    BOOST_CHECK(chunks[0].feerate == FeeFrac(10100, 200));
+}
+
+BOOST_AUTO_TEST_CASE(linearize_random)
+{
+    for (int i = 0; i < 200; ++i) {
+        // Include a few graphs too large to be sorted by ancestor set feerate.
+        const uint32_t count{i < 190 ? uint32_t(InsecureRandRange(64)) + 1 : MAX_ANCESTOR_SORT_TXS + 1 + uint32_t(InsecureRandRange(64))};
+        DepGraph graph;
+        graph.Reserve(count);
+        for (uint32_t tx = 0; tx < count; ++tx) {
+            graph.AddTransaction({int64_t(InsecureRandRange(100000)), int32_t(InsecureRandRange(1000)) + 1});
+            // Depend on random transactions with a higher index, which keeps the graph acyclic.
+            for (uint32_t parent = tx + 1; parent < count; ++parent) {
+                if (InsecureRandRange(16) == 0) graph.AddParent(parent);
+            }
+        }
+        const std::vector<uint32_t> linearization{Linearize(graph)};
+        CheckTopological(graph, linearization);
+        CheckChunks(graph, linearization, ChunkLinearization(graph, linearization));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -282,6 +282,10 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
 
     CCoinsViewDB db_base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
     SimulationTest(&db_base, true);
+
+    CCoinsViewDB bulk_load_base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {.bulk_load_min_coins = 1}};
+    bulk_load_base.SetBulkLoad(true);
+    SimulationTest(&bulk_load_base, true);
 }
 
 // Store of all necessary tx and undo data for next test
@@ -1084,13 +1088,219 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_background_write)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {.background_flush = true}};
+    CCoinsViewCache cache{&base};
+    const uint256 first_block{InsecureRand256()};
+
+    // Write a coin synchronously, so that there is something to spend.
+    const COutPoint spent{Txid::FromUint256(InsecureRand256()), 0};
+    cache.AddCoin(spent, Coin{CTxOut{1, CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/false);
+    cache.SetBestBlock(first_block);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(base.GetFlushStats().flushes, 1U);
+
+    const COutPoint unmodified{Txid::FromUint256(InsecureRand256()), 0};
+    const COutPoint added{Txid::FromUint256(InsecureRand256()), 0};
+    cache.AddCoin(unmodified, Coin{CTxOut{2, CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/false);
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK(cache.HaveCoinInCache(unmodified));
+    BOOST_CHECK(cache.SpendCoin(spent));
+    cache.AddCoin(added, Coin{CTxOut{3, CScript{} << OP_TRUE}, 2, false}, /*possible_overwrite=*/false);
+    const uint256 second_block{InsecureRand256()};
+    cache.SetBestBlock(second_block);
+
+    auto batch{std::make_shared<CoinsWriteBatch>()};
+    cache.TakeModified(batch->coins, /*keep_unmodified=*/true);
+    batch->best_block = cache.GetBestBlock();
+    BOOST_CHECK_EQUAL(batch->coins.size(), 2U);
+    // The unmodified coin stays cached, the modified ones moved to the batch.
+    BOOST_CHECK(cache.HaveCoinInCache(unmodified));
+    BOOST_CHECK(!cache.HaveCoinInCache(spent));
+    BOOST_CHECK(!cache.HaveCoinInCache(added));
+
+    BOOST_CHECK(base.BatchWriteInBackground(batch));
+    // Whether or not the write has landed yet, the view is the new state.
+    BOOST_CHECK(!base.HaveCoin(spent));
+    BOOST_CHECK(base.HaveCoin(added));
+    BOOST_CHECK(base.GetBestBlock() == second_block);
+    BOOST_CHECK(!cache.HaveCoin(spent));
+    BOOST_CHECK_EQUAL(cache.AccessCoin(added).out.nValue, 3);
+
+    BOOST_CHECK(base.WaitForBackgroundWrite());
+    const CoinsFlushStats stats{base.GetFlushStats()};
+    BOOST_CHECK(!stats.in_progress);
+    BOOST_CHECK(stats.last_background);
+    BOOST_CHECK_EQUAL(stats.last_coins, 2U);
+    BOOST_CHECK_EQUAL(stats.flushes, 3U);
+    BOOST_CHECK(stats.last_bytes > 0);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+    BOOST_CHECK(base.GetBestBlock() == second_block);
+    BOOST_CHECK(!base.HaveCoin(spent));
+    Coin coin;
+    BOOST_CHECK(base.GetCoin(added, coin));
+    BOOST_CHECK_EQUAL(coin.out.nValue, 3);
+
+    // Wiping also drops the unmodified coins.
+    CoinsWriteBatch empty;
+    cache.TakeModified(empty.coins, /*keep_unmodified=*/false);
+    BOOST_CHECK(empty.coins.empty());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    BOOST_CHECK(cache.HaveCoin(unmodified));
+
+    // A view taken during a background write stops holding on to the batch
+    // once it has been written.
+    BOOST_CHECK(cache.SpendCoin(added));
+    const uint256 third_block{InsecureRand256()};
+    cache.SetBestBlock(third_block);
+    batch = std::make_shared<CoinsWriteBatch>();
+    cache.TakeModified(batch->coins, /*keep_unmodified=*/false);
+    batch->best_block = third_block;
+    const std::weak_ptr<CoinsWriteBatch> written{batch};
+    BOOST_CHECK(base.BatchWriteInBackground(std::move(batch)));
+    const auto view{base.GetSnapshot(/*height=*/3)};
+    BOOST_CHECK(base.WaitForBackgroundWrite());
+    // The next write joins the thread of the previous one, dropping its reference.
+    cache.SetBestBlock(InsecureRand256());
+    batch = std::make_shared<CoinsWriteBatch>();
+    batch->best_block = cache.GetBestBlock();
+    BOOST_CHECK(base.BatchWriteInBackground(std::move(batch)));
+    BOOST_CHECK(written.expired());
+    BOOST_CHECK(view->GetBestBlock() == third_block);
+    BOOST_CHECK(!view->HaveCoin(added));
+    BOOST_CHECK(view->HaveCoin(unmodified));
+    BOOST_CHECK(base.WaitForBackgroundWrite());
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_bulk_load)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {.bulk_load_min_coins = 100}};
+    base.SetBulkLoad(true);
+    CCoinsViewCache cache{&base};
+    std::map<COutPoint, CAmount> coins;
+    for (int i = 0; i < 1000; ++i) {
+        const COutPoint outpoint{Txid::FromUint256(InsecureRand256()), uint32_t(InsecureRandRange(3))};
+        coins.emplace(outpoint, i + 1);
+    }
+    // Output indexes whose keys do not sort like the indexes themselves.
+    const Txid txid{Txid::FromUint256(InsecureRand256())};
+    for (const uint32_t n : {0U, 127U, 128U, 16511U, 16512U, 100000U}) {
+        coins.emplace(COutPoint{txid, n}, n + 1);
+    }
+    for (const auto& [outpoint, amount] : coins) {
+        cache.AddCoin(outpoint, Coin{CTxOut{amount, CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/false);
+    }
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_REQUIRE(cache.Flush());
+
+    // Spend and change half of the coins, which overlap the ones written.
+    bool spend{false};
+    for (auto it{coins.begin()}; it != coins.end();) {
+        if ((spend = !spend)) {
+            BOOST_CHECK(cache.SpendCoin(it->first));
+            it = coins.erase(it);
+        } else {
+            it->second += 1;
+            cache.AddCoin(it->first, Coin{CTxOut{it->second, CScript{} << OP_TRUE}, 2, false}, /*possible_overwrite=*/true);
+            ++it;
+        }
+    }
+    const uint256 best_block{InsecureRand256()};
+    cache.SetBestBlock(best_block);
+    BOOST_REQUIRE(cache.Flush());
+    BOOST_CHECK(base.GetBestBlock() == best_block);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+
+    const auto read_all{[&] {
+        std::map<COutPoint, CAmount> found;
+        for (auto cursor{base.Cursor()}; cursor->Valid(); cursor->Next()) {
+            COutPoint key;
+            Coin coin;
+            BOOST_REQUIRE(cursor->GetKey(key) && cursor->GetValue(coin));
+            BOOST_CHECK(found.emplace(key, coin.out.nValue).second);
+        }
+        return found;
+    }};
+    BOOST_CHECK(read_all() == coins);
+
+    // Views of the database taken before a large flush keep seeing the coins
+    // as they were.
+    const auto view{base.GetSnapshot(/*height=*/2)};
+    const std::map<COutPoint, CAmount> old_coins{coins};
+    for (auto& [outpoint, amount] : coins) {
+        amount += 1;
+        cache.AddCoin(outpoint, Coin{CTxOut{amount, CScript{} << OP_TRUE}, 3, false}, /*possible_overwrite=*/true);
+    }
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_REQUIRE(cache.Flush());
+    BOOST_CHECK(read_all() == coins);
+    for (const auto& [outpoint, amount] : old_coins) {
+        Coin coin;
+        BOOST_REQUIRE(view->GetCoin(outpoint, coin));
+        BOOST_CHECK_EQUAL(coin.out.nValue, amount);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_sharded_cursors)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewCache cache{&base};
+    std::map<COutPoint, CAmount> coins;
+    for (int i = 0; i < 1000; ++i) {
+        const COutPoint outpoint{Txid::FromUint256(InsecureRand256()), uint32_t(InsecureRandRange(3))};
+        coins.emplace(outpoint, i + 1);
+        cache.AddCoin(outpoint, Coin{CTxOut{i + 1, CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/true);
+    }
+    // Txids at the edges of the key space.
+    for (const uint8_t first_byte : {0x00, 0xff}) {
+        uint256 txid;
+        *txid.begin() = first_byte;
+        coins.emplace(COutPoint{Txid::FromUint256(txid), 0}, 1);
+        cache.AddCoin(COutPoint{Txid::FromUint256(txid), 0}, Coin{CTxOut{1, CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/true);
+    }
+    uint256 best_block{InsecureRand256()};
+    cache.SetBestBlock(best_block);
+    BOOST_REQUIRE(cache.Flush());
+
+    for (const size_t count : {1, 2, 3, 7, 16}) {
+        auto cursors{base.ShardedCursors(count)};
+        BOOST_REQUIRE_EQUAL(cursors.size(), count);
+
+        // Changes after the cursors are created are not seen by them.
+        const COutPoint added{Txid::FromUint256(InsecureRand256()), 0};
+        cache.AddCoin(added, Coin{CTxOut{1, CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/false);
+        cache.SetBestBlock(InsecureRand256());
+        BOOST_REQUIRE(cache.Flush());
+
+        std::map<COutPoint, CAmount> found;
+        for (size_t shard = 0; shard < count; ++shard) {
+            BOOST_CHECK(cursors[shard]->GetBestBlock() == best_block);
+            for (; cursors[shard]->Valid(); cursors[shard]->Next()) {
+                COutPoint key;
+                Coin coin;
+                BOOST_REQUIRE(cursors[shard]->GetKey(key) && cursors[shard]->GetValue(coin));
+                const uint32_t prefix = 0x100 * *UCharCast(key.hash.begin()) + *(UCharCast(key.hash.begin()) + 1);
+                BOOST_CHECK(prefix >= shard * 0x10000 / count && prefix < (shard + 1) * 0x10000 / count);
+                BOOST_CHECK(found.emplace(key, coin.out.nValue).second);
+            }
+        }
+        BOOST_CHECK(found == coins);
+
+        coins.emplace(added, 1);
+        best_block = cache.GetBestBlock();
+    }
+}
+
 BOOST_AUTO_TEST_CASE(coins_resource_is_used)
 {
-    CCoinsMapMemoryResource resource;
+    // Only the node based map uses a pool resource; test it directly so this
+    // also runs when CCoinsMap is configured to be the flat map.
+    CCoinsNodeMap::allocator_type::ResourceType resource;
     PoolResourceTester::CheckAllDataAccountedFor(resource);
 
     {
-        CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
+        CCoinsNodeMap map{0, CCoinsNodeMap::hasher{}, CCoinsNodeMap::key_equal{}, &resource};
         BOOST_TEST(memusage::DynamicUsage(map) >= resource.ChunkSizeBytes());
 
         map.reserve(1000);
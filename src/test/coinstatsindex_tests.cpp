@@ -76,6 +76,50 @@ BOOST_FIXTURE_TEST_CASE(coinstatsindex_initial_sync, TestChain100Setup)
     coin_stats_index.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(coinstats_parallel, TestChain100Setup)
+{
+    const CScript script_pub_key{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, script_pub_key, 1 * COIN, /*submit=*/false)};
+    CreateAndProcessBlock({spend}, script_pub_key);
+
+    CoinStatsIndex coin_stats_index{interfaces::MakeChain(m_node), 1 << 20, true};
+    BOOST_REQUIRE(coin_stats_index.Init());
+    BOOST_REQUIRE(coin_stats_index.StartBackgroundSync());
+    IndexWaitSynced(coin_stats_index, *Assert(m_node.shutdown));
+
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    WITH_LOCK(cs_main, chainstate.ForceFlushStateToDisk());
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return chainstate.m_chain.Tip())};
+    const auto index_stats{coin_stats_index.LookUpStats(*tip)};
+    BOOST_REQUIRE(index_stats);
+
+    // Splitting the coins over threads gives the same statistics and MuHash
+    // as computing them on one thread, and as the index.
+    for (const auto hash_type : {kernel::CoinStatsHashType::MUHASH, kernel::CoinStatsHashType::NONE}) {
+        const auto serial{kernel::ComputeUTXOStats(hash_type, &chainstate.CoinsDB(), m_node.chainman->m_blockman)};
+        BOOST_REQUIRE(serial);
+        for (const int num_threads : {1, 2, 3, 8}) {
+            const auto parallel{kernel::ComputeUTXOStats(hash_type, chainstate.CoinsDB(), m_node.chainman->m_blockman, num_threads)};
+            BOOST_REQUIRE(parallel);
+            BOOST_CHECK_EQUAL(parallel->nHeight, tip->nHeight);
+            BOOST_CHECK_EQUAL(parallel->hashBlock, tip->GetBlockHash());
+            BOOST_CHECK_EQUAL(parallel->nTransactions, serial->nTransactions);
+            BOOST_CHECK_EQUAL(parallel->nTransactionOutputs, serial->nTransactionOutputs);
+            BOOST_CHECK_EQUAL(parallel->nBogoSize, serial->nBogoSize);
+            BOOST_CHECK_EQUAL(parallel->coins_count, serial->coins_count);
+            BOOST_CHECK(parallel->total_amount == serial->total_amount);
+            BOOST_CHECK_EQUAL(parallel->hashSerialized, serial->hashSerialized);
+        }
+        if (hash_type == kernel::CoinStatsHashType::MUHASH) {
+            BOOST_CHECK_EQUAL(serial->hashSerialized, index_stats->hashSerialized);
+        }
+        BOOST_CHECK_EQUAL(serial->nTransactionOutputs, index_stats->nTransactionOutputs);
+    }
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    coin_stats_index.Stop();
+}
+
 // Test shutdown between BlockConnected and ChainStateFlushed notifications,
 // make sure index is not corrupted and is able to reload.
 BOOST_FIXTURE_TEST_CASE(coinstatsindex_unclean_shutdown, TestChain100Setup)
@@ -8,7 +8,10 @@
 #include <uint256.h>
 #include <util/string.h>
 
+#include <array>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -160,6 +163,93 @@ BOOST_AUTO_TEST_CASE(dbwrapper_batch)
     }
 }
 
+// Keys that sort like (prefix, i)
+static std::pair<uint8_t, std::array<uint8_t, 2>> BulkLoadKey(uint8_t prefix, uint16_t i)
+{
+    return {prefix, {uint8_t(i >> 8), uint8_t(i)}};
+}
+
+// Test bulk load operations
+BOOST_AUTO_TEST_CASE(dbwrapper_bulk_load)
+{
+    // Perform tests both obfuscated and non-obfuscated.
+    for (const bool obfuscate : {false, true}) {
+        fs::path ph = m_args.GetDataDirBase() / (obfuscate ? "dbwrapper_bulk_load_obfuscate_true" : "dbwrapper_bulk_load_obfuscate_false");
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = obfuscate});
+
+        uint256 in_a = InsecureRand256();
+        uint256 in_b = InsecureRand256();
+        uint256 res;
+        BOOST_CHECK(dbw.Write(BulkLoadKey('a', 0), in_a));
+        BOOST_CHECK(dbw.Write(BulkLoadKey('b', 1), in_b));
+        BOOST_CHECK(dbw.Write(BulkLoadKey('b', 2), in_b));
+
+        // Overwrite, erase and add entries of the memtable.
+        std::vector<uint256> in_c;
+        auto bulk_load{dbw.NewBulkLoad()};
+        bulk_load->Write(BulkLoadKey('a', 0), in_b);
+        bulk_load->Erase(BulkLoadKey('b', 1));
+        for (int i = 0; i < 1000; ++i) {
+            in_c.push_back(InsecureRand256());
+            bulk_load->Write(BulkLoadKey('c', i), in_c.back());
+        }
+        BOOST_CHECK(bulk_load->SizeEstimate() > 1000 * 32);
+        BOOST_CHECK(dbw.WriteBulkLoad(*bulk_load));
+
+        BOOST_CHECK(dbw.Read(BulkLoadKey('a', 0), res));
+        BOOST_CHECK_EQUAL(res.ToString(), in_b.ToString());
+        BOOST_CHECK(!dbw.Exists(BulkLoadKey('b', 1)));
+        BOOST_CHECK(dbw.Read(BulkLoadKey('b', 2), res));
+        BOOST_CHECK_EQUAL(res.ToString(), in_b.ToString());
+        for (int i = 0; i < 1000; ++i) {
+            BOOST_CHECK(dbw.Read(BulkLoadKey('c', i), res));
+            BOOST_CHECK_EQUAL(res.ToString(), in_c[i].ToString());
+        }
+
+        // Later writes are read over the bulk load.
+        BOOST_CHECK(dbw.Write(BulkLoadKey('c', 0), in_a));
+        BOOST_CHECK(dbw.Read(BulkLoadKey('c', 0), res));
+        BOOST_CHECK_EQUAL(res.ToString(), in_a.ToString());
+
+        // Unsorted entries are rejected, and leave the database unchanged.
+        bulk_load = dbw.NewBulkLoad();
+        bulk_load->Write(BulkLoadKey('d', 1), in_a);
+        bulk_load->Write(BulkLoadKey('d', 0), in_a);
+        BOOST_CHECK(!dbw.WriteBulkLoad(*bulk_load));
+        BOOST_CHECK(!dbw.Exists(BulkLoadKey('d', 0)));
+        BOOST_CHECK(!dbw.Exists(BulkLoadKey('d', 1)));
+
+        // So are entries overlapping writes made since the bulk load was started.
+        bulk_load = dbw.NewBulkLoad();
+        bulk_load->Write(BulkLoadKey('e', 0), in_a);
+        bulk_load->Write(BulkLoadKey('e', 2), in_a);
+        BOOST_CHECK(dbw.Write(BulkLoadKey('e', 1), in_b));
+        BOOST_CHECK(!dbw.WriteBulkLoad(*bulk_load));
+        BOOST_CHECK(!dbw.Exists(BulkLoadKey('e', 0)));
+        BOOST_CHECK(dbw.Read(BulkLoadKey('e', 1), res));
+        BOOST_CHECK_EQUAL(res.ToString(), in_b.ToString());
+
+        // Snapshots taken before a bulk load was started do not see it.
+        const auto old_snapshot{dbw.NewSnapshot()};
+        bulk_load = dbw.NewBulkLoad();
+        bulk_load->Write(BulkLoadKey('a', 0), in_a);
+        bulk_load->Write(BulkLoadKey('f', 0), in_a);
+        BOOST_CHECK(dbw.WriteBulkLoad(*bulk_load));
+        BOOST_CHECK(dbw.Read(BulkLoadKey('a', 0), res));
+        BOOST_CHECK_EQUAL(res.ToString(), in_a.ToString());
+        BOOST_CHECK(dbw.Read(BulkLoadKey('a', 0), res, old_snapshot.get()));
+        BOOST_CHECK_EQUAL(res.ToString(), in_b.ToString());
+        BOOST_CHECK(!dbw.Read(BulkLoadKey('f', 0), res, old_snapshot.get()));
+
+        // Snapshots taken after it was started would, so it is rejected.
+        bulk_load = dbw.NewBulkLoad();
+        bulk_load->Write(BulkLoadKey('g', 0), in_a);
+        const auto new_snapshot{dbw.NewSnapshot()};
+        BOOST_CHECK(!dbw.WriteBulkLoad(*bulk_load));
+        BOOST_CHECK(!dbw.Exists(BulkLoadKey('g', 0)));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
 {
     // Perform tests both obfuscated and non-obfuscated.
@@ -0,0 +1,184 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <flatmap.h>
+#include <memusage.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+struct MixHasher {
+    size_t operator()(uint64_t x) const { return x * 0x9E3779B97F4A7C15ULL; }
+};
+
+//! Hasher that puts every key in the same group, to exercise long probe sequences.
+struct CollidingHasher {
+    size_t operator()(uint64_t x) const { return x & 0x7f; }
+};
+
+using TestMap = FlatMap<uint64_t, std::string, MixHasher>;
+
+CScript TestScript(uint32_t i)
+{
+    return CScript() << std::vector<unsigned char>(i % 80, 0x51);
+}
+
+template <typename Map>
+void CheckEqual(const Map& map, const std::unordered_map<uint64_t, std::string>& ref)
+{
+    BOOST_REQUIRE_EQUAL(map.size(), ref.size());
+    size_t iterated{0};
+    for (const auto& [key, value] : map) {
+        auto it = ref.find(key);
+        BOOST_REQUIRE(it != ref.end());
+        BOOST_CHECK_EQUAL(it->second, value);
+        ++iterated;
+    }
+    BOOST_CHECK_EQUAL(iterated, ref.size());
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(flatmap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(basic_operations)
+{
+    TestMap map;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(1) == map.end());
+    BOOST_CHECK(map.begin() == map.end());
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+
+    auto [it, inserted] = map.try_emplace(1, "one");
+    BOOST_CHECK(inserted);
+    BOOST_CHECK_EQUAL(it->second, "one");
+    std::tie(it, inserted) = map.try_emplace(1, "uno");
+    BOOST_CHECK(!inserted);
+    BOOST_CHECK_EQUAL(it->second, "one");
+
+    map[2] = "two";
+    map.emplace(std::piecewise_construct, std::forward_as_tuple(3), std::forward_as_tuple("three"));
+    BOOST_CHECK_EQUAL(map.size(), 3U);
+    BOOST_CHECK_EQUAL(map.count(2), 1U);
+    BOOST_CHECK(map.contains(3));
+    BOOST_CHECK(!map.contains(4));
+    BOOST_CHECK(memusage::DynamicUsage(map) > 0);
+
+    BOOST_CHECK_EQUAL(map.erase(2), 1U);
+    BOOST_CHECK_EQUAL(map.erase(2), 0U);
+    BOOST_CHECK_EQUAL(map.size(), 2U);
+
+    const size_t capacity{map.bucket_count()};
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+    BOOST_CHECK_EQUAL(map.bucket_count(), capacity);
+
+    TestMap moved{std::move(map)};
+    BOOST_CHECK(moved.empty());
+    moved[7] = "seven";
+    BOOST_CHECK_EQUAL(moved.find(7)->second, "seven");
+}
+
+BOOST_AUTO_TEST_CASE(growth_and_reserve)
+{
+    TestMap map;
+    map.reserve(1000);
+    const size_t capacity{map.bucket_count()};
+    BOOST_CHECK(capacity >= 1000);
+    for (uint64_t i = 0; i < 1000; ++i) map.try_emplace(i, std::to_string(i));
+    // Reserved space must not be reallocated.
+    BOOST_CHECK_EQUAL(map.bucket_count(), capacity);
+    for (uint64_t i = 1000; i < 5000; ++i) map.try_emplace(i, std::to_string(i));
+    BOOST_CHECK(map.bucket_count() > capacity);
+    for (uint64_t i = 0; i < 5000; ++i) {
+        auto it = map.find(i);
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(it->second, std::to_string(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tombstones_do_not_grow_table)
+{
+    // Repeated insert/erase cycles at constant size must be absorbed by
+    // rehashing in place rather than by growing the table.
+    FlatMap<uint64_t, std::string, CollidingHasher> map;
+    for (uint64_t i = 0; i < 8; ++i) map.try_emplace(i, "");
+    const size_t capacity{map.bucket_count()};
+    for (uint64_t i = 8; i < 10000; ++i) {
+        map.try_emplace(i, "");
+        BOOST_CHECK_EQUAL(map.erase(i - 8), 1U);
+    }
+    BOOST_CHECK_EQUAL(map.size(), 8U);
+    BOOST_CHECK_EQUAL(map.bucket_count(), capacity);
+    for (uint64_t i = 9992; i < 10000; ++i) BOOST_CHECK(map.contains(i));
+}
+
+BOOST_AUTO_TEST_CASE(random_operations)
+{
+    TestMap map;
+    std::unordered_map<uint64_t, std::string> ref;
+    for (int i = 0; i < 20000; ++i) {
+        const uint64_t key{InsecureRandRange(3000)};
+        switch (InsecureRandRange(4)) {
+        case 0:
+        case 1: {
+            const std::string value{std::to_string(InsecureRand32())};
+            const bool inserted{map.try_emplace(key, value).second};
+            BOOST_CHECK_EQUAL(inserted, ref.try_emplace(key, value).second);
+            break;
+        }
+        case 2:
+            BOOST_CHECK_EQUAL(map.erase(key), ref.erase(key));
+            break;
+        case 3: {
+            auto it = map.find(key);
+            BOOST_CHECK_EQUAL(it == map.end(), ref.count(key) == 0);
+            if (it != map.end()) BOOST_CHECK_EQUAL(it->second, ref.at(key));
+            break;
+        }
+        }
+    }
+    CheckEqual(map, ref);
+
+    // Erase roughly half of the elements while iterating, as CCoinsViewCache::Sync does.
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->first % 2) {
+            ref.erase(it->first);
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    CheckEqual(map, ref);
+}
+
+BOOST_AUTO_TEST_CASE(coins_entries)
+{
+    CCoinsFlatMap map{0, SaltedOutpointHasher{/*deterministic=*/true}, CCoinsFlatMap::key_equal{}};
+    std::vector<COutPoint> outpoints;
+    for (uint32_t i = 0; i < 500; ++i) {
+        outpoints.emplace_back(Txid::FromUint256(InsecureRand256()), i);
+        CTxOut txout{i, TestScript(i)};
+        map.emplace(std::piecewise_construct, std::forward_as_tuple(outpoints.back()), std::forward_as_tuple(Coin{std::move(txout), 1, false}, CCoinsCacheEntry::DIRTY));
+    }
+    BOOST_CHECK_EQUAL(map.size(), outpoints.size());
+    for (uint32_t i = 0; i < outpoints.size(); ++i) {
+        const auto it = map.find(outpoints[i]);
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(it->second.coin.out.nValue, CAmount{i});
+        BOOST_CHECK(it->second.coin.out.scriptPubKey == TestScript(i));
+        BOOST_CHECK_EQUAL(it->second.flags, CCoinsCacheEntry::DIRTY);
+    }
+    BOOST_CHECK(map.find(COutPoint{Txid::FromUint256(InsecureRand256()), 0}) == map.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
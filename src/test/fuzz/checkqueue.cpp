@@ -31,8 +31,9 @@ FUZZ_TARGET(checkqueue)
     FuzzedDataProvider fuzzed_data_provider(buffer.data(), buffer.size());
 
     const unsigned int batch_size = fuzzed_data_provider.ConsumeIntegralInRange<unsigned int>(0, 1024);
-    CCheckQueue<DumbCheck> check_queue_1{batch_size, /*worker_threads_num=*/0};
-    CCheckQueue<DumbCheck> check_queue_2{batch_size, /*worker_threads_num=*/0};
+    const bool work_stealing = fuzzed_data_provider.ConsumeBool();
+    CCheckQueue<DumbCheck> check_queue_1{batch_size, /*worker_threads_num=*/0, work_stealing};
+    CCheckQueue<DumbCheck> check_queue_2{batch_size, /*worker_threads_num=*/0, work_stealing};
     std::vector<DumbCheck> checks_1;
     std::vector<DumbCheck> checks_2;
     const int size = fuzzed_data_provider.ConsumeIntegralInRange<int>(0, 1024);
@@ -122,9 +122,11 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getblockheader",
     "getblockstats",
     "getblocktemplate",
+    "getblocktemplatediff",
     "getchaintips",
     "getchainstates",
     "getchaintxstats",
+    "getcoinsflushinfo",
     "getconnectioncount",
     "getdeploymentinfo",
     "getdescriptorinfo",
@@ -0,0 +1,146 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <inputfetcher.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+/** Read-only coins view backed by a fixed map, safe for concurrent reads. */
+class MapCoinsView : public CCoinsView
+{
+public:
+    std::map<COutPoint, Coin> m_coins;
+    mutable std::atomic<int> m_reads{0};
+    COutPoint m_throw_on{};
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override
+    {
+        ++m_reads;
+        if (outpoint == m_throw_on) throw std::runtime_error("read error");
+        auto it = m_coins.find(outpoint);
+        if (it == m_coins.end()) return false;
+        coin = it->second;
+        return true;
+    }
+};
+
+COutPoint RandomOutPoint()
+{
+    return COutPoint{Txid::FromUint256(InsecureRand256()), 0};
+}
+
+CTransactionRef SpendingTx(const std::vector<COutPoint>& prevouts)
+{
+    CMutableTransaction tx;
+    for (const auto& prevout : prevouts) tx.vin.emplace_back(prevout);
+    tx.vout.emplace_back(1, CScript() << OP_TRUE);
+    return MakeTransactionRef(std::move(tx));
+}
+
+CBlock MakeBlock(const std::vector<std::vector<COutPoint>>& spends)
+{
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.emplace_back();
+    coinbase.vout.emplace_back(1, CScript() << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+    for (const auto& prevouts : spends) block.vtx.push_back(SpendingTx(prevouts));
+    return block;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(inputfetcher_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(fetch_inputs)
+{
+    MapCoinsView db;
+    std::vector<COutPoint> in_db;
+    for (int i = 0; i < 100; ++i) {
+        in_db.push_back(RandomOutPoint());
+        db.m_coins.emplace(in_db.back(), Coin{CTxOut{i + 1, CScript() << OP_TRUE}, 1, false});
+    }
+    const COutPoint not_in_db{RandomOutPoint()};
+
+    CCoinsViewCache cache{&db};
+    // One coin is already cached, and must not be read again.
+    BOOST_CHECK(cache.HaveCoin(in_db[0]));
+    const int reads_before{db.m_reads};
+
+    std::vector<COutPoint> first{in_db.begin(), in_db.begin() + 50};
+    first.push_back(not_in_db);
+    CBlock block{MakeBlock({first, {in_db.begin() + 50, in_db.end()}})};
+    // Spend an output created earlier in the block.
+    block.vtx.push_back(SpendingTx({COutPoint{block.vtx[1]->GetHash(), 0}}));
+
+    InputFetcher fetcher{/*worker_threads_num=*/3};
+    const auto stats{fetcher.FetchInputs(cache, db, block)};
+    BOOST_CHECK_EQUAL(stats.intra_block, 1U);
+    BOOST_CHECK_EQUAL(stats.cache_hits, 1U);
+    BOOST_CHECK_EQUAL(stats.fetched, 99U);
+    BOOST_CHECK_EQUAL(stats.missing, 1U);
+    BOOST_CHECK_EQUAL(db.m_reads - reads_before, 100);
+
+    for (const auto& outpoint : in_db) {
+        BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+        BOOST_CHECK(cache.AccessCoin(outpoint).out == db.m_coins.at(outpoint).out);
+    }
+    BOOST_CHECK(!cache.HaveCoinInCache(not_in_db));
+    cache.SanityCheck();
+
+    // Everything is cached now, so a second pass reads nothing.
+    const auto again{fetcher.FetchInputs(cache, db, block)};
+    BOOST_CHECK_EQUAL(again.cache_hits, 100U);
+    BOOST_CHECK_EQUAL(again.fetched, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(fetch_inputs_keeps_cached_state)
+{
+    MapCoinsView db;
+    const COutPoint spent{RandomOutPoint()};
+    const COutPoint failing{RandomOutPoint()};
+    db.m_coins.emplace(spent, Coin{CTxOut{1, CScript() << OP_TRUE}, 1, false});
+    db.m_coins.emplace(failing, Coin{CTxOut{2, CScript() << OP_TRUE}, 1, false});
+    db.m_throw_on = failing;
+
+    // A coin spent in the cache but not yet flushed must not be resurrected
+    // from the database.
+    CCoinsViewCache cache{&db};
+    BOOST_CHECK(cache.SpendCoin(spent));
+
+    InputFetcher fetcher{/*worker_threads_num=*/2};
+    const auto stats{fetcher.FetchInputs(cache, db, MakeBlock({{spent, failing}}))};
+    BOOST_CHECK_EQUAL(stats.fetched, 1U);
+    // Read errors are left to the regular lookup path.
+    BOOST_CHECK_EQUAL(stats.missing, 1U);
+    BOOST_CHECK(!cache.HaveCoinInCache(spent));
+    BOOST_CHECK(!cache.HaveCoinInCache(failing));
+    cache.SanityCheck();
+}
+
+BOOST_AUTO_TEST_CASE(no_threads)
+{
+    MapCoinsView db;
+    const COutPoint outpoint{RandomOutPoint()};
+    db.m_coins.emplace(outpoint, Coin{CTxOut{1, CScript() << OP_TRUE}, 1, false});
+    CCoinsViewCache cache{&db};
+    InputFetcher fetcher{/*worker_threads_num=*/0};
+    BOOST_CHECK(!fetcher.HasThreads());
+    const auto stats{fetcher.FetchInputs(cache, db, MakeBlock({{outpoint}}))};
+    BOOST_CHECK_EQUAL(stats.fetched, 0U);
+    BOOST_CHECK_EQUAL(db.m_reads, 0);
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoint));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
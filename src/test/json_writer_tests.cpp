@@ -0,0 +1,182 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <common/json_writer.h>
+#include <core_io.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <rpc/blockchain.h>
+#include <rpc/mempool.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static void WriteTokens(JSONWriter& writer, const std::string& all_chars, const UniValue& inner)
+{
+    writer.BeginObject();
+    writer.Key("empty_obj");
+    writer.BeginObject();
+    writer.EndObject();
+    writer.Key("empty_arr");
+    writer.BeginArray();
+    writer.EndArray();
+    writer.Key("arr");
+    writer.BeginArray();
+    writer.Int(std::numeric_limits<int64_t>::min());
+    writer.Int(std::numeric_limits<int64_t>::max());
+    writer.Int(0);
+    writer.Bool(true);
+    writer.Bool(false);
+    writer.Null();
+    writer.String("");
+    writer.BeginObject();
+    writer.Key("a");
+    writer.Int(1);
+    writer.Key(all_chars);
+    writer.String(all_chars);
+    writer.EndObject();
+    writer.Value(UniValue{1.5});
+    writer.EndArray();
+    writer.Key("b");
+    writer.BeginObject();
+    writer.Members(inner);
+    writer.EndObject();
+    writer.EndObject();
+}
+
+BOOST_FIXTURE_TEST_SUITE(json_writer_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(json_writer_univalue)
+{
+    std::string all_chars;
+    for (int c = 0; c < 256; ++c) all_chars += static_cast<char>(c);
+
+    UniValue inner{UniValue::VOBJ};
+    inner.pushKV("a", 1);
+    inner.pushKV(all_chars, all_chars);
+    UniValue expected{UniValue::VOBJ};
+    expected.pushKV("empty_obj", UniValue{UniValue::VOBJ});
+    expected.pushKV("empty_arr", UniValue{UniValue::VARR});
+    UniValue arr{UniValue::VARR};
+    arr.push_back(std::numeric_limits<int64_t>::min());
+    arr.push_back(std::numeric_limits<int64_t>::max());
+    arr.push_back(0);
+    arr.push_back(true);
+    arr.push_back(false);
+    arr.push_back(NullUniValue);
+    arr.push_back("");
+    arr.push_back(inner);
+    arr.push_back(1.5);
+    expected.pushKV("arr", arr);
+    expected.pushKV("b", inner);
+
+    std::string json;
+    JSONTextWriter text_writer{json};
+    WriteTokens(text_writer, all_chars, inner);
+    BOOST_CHECK_EQUAL(json, expected.write());
+
+    UniValue value;
+    UniValueWriter value_writer{value};
+    WriteTokens(value_writer, all_chars, inner);
+    BOOST_CHECK_EQUAL(value.write(), expected.write());
+
+    // Members written into an existing object replace its keys.
+    UniValue obj{UniValue::VOBJ};
+    obj.pushKV("a", 2);
+    obj.pushKV("c", 3);
+    UniValueWriter obj_writer{obj};
+    obj_writer.Members(inner);
+    UniValue obj_expected{UniValue::VOBJ};
+    obj_expected.pushKV("a", 1);
+    obj_expected.pushKV("c", 3);
+    obj_expected.pushKV(all_chars, all_chars);
+    BOOST_CHECK_EQUAL(obj.write(), obj_expected.write());
+}
+
+BOOST_AUTO_TEST_CASE(json_writer_sink)
+{
+    UniValue expected{UniValue::VARR};
+    const std::string str(1000, 'x');
+    for (int i = 0; i < 200; ++i) expected.push_back(str);
+
+    std::string sunk;
+    size_t calls{0};
+    std::string json;
+    JSONTextWriter writer{json, [&](std::string_view text) {
+        BOOST_CHECK(!text.empty());
+        sunk += text;
+        ++calls;
+    }};
+    writer.BeginArray();
+    for (int i = 0; i < 200; ++i) {
+        writer.String(str);
+        BOOST_CHECK_LT(json.size(), JSONTextWriter::FLUSH_SIZE + str.size() + 3);
+    }
+    writer.EndArray();
+    writer.Flush();
+    BOOST_CHECK(json.empty());
+    BOOST_CHECK_GT(calls, 1U);
+    BOOST_CHECK_EQUAL(sunk, expected.write());
+}
+
+BOOST_FIXTURE_TEST_CASE(json_writer_block_and_mempool, TestChain100Setup)
+{
+    // Outputs of several types, and a block spending them with undo data.
+    const CScript p2pk{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const CScript p2wpkh{GetScriptForDestination(WitnessV0KeyHash(coinbaseKey.GetPubKey()))};
+    const CScript op_return{CScript() << OP_RETURN << std::vector<unsigned char>{'"', '\\', 0, 0x7f, 0xff}};
+    const CTransactionRef fanout{MakeTransactionRef(CreateValidMempoolTransaction(
+        {m_coinbase_txns[0]}, {COutPoint{m_coinbase_txns[0]->GetHash(), 0}}, /*input_height=*/1, {coinbaseKey},
+        {CTxOut{10 * COIN, p2pk}, CTxOut{10 * COIN, p2wpkh}, CTxOut{0, op_return}}, /*submit=*/false))};
+    const CBlock fanout_block{CreateAndProcessBlock({CMutableTransaction{*fanout}}, p2pk)};
+    const int fanout_height{WITH_LOCK(::cs_main, return m_node.chainman->ActiveHeight())};
+    const CBlock spend_block{CreateAndProcessBlock({CreateValidMempoolTransaction(
+        {fanout}, {COutPoint{fanout->GetHash(), 0}, COutPoint{fanout->GetHash(), 1}}, fanout_height, {coinbaseKey},
+        {CTxOut{19 * COIN, p2wpkh}}, /*submit=*/false)}, p2pk)};
+
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip())};
+    for (const CBlock& block : {fanout_block, spend_block}) {
+        const CBlockIndex* index{WITH_LOCK(::cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(block.GetHash()))};
+        for (const TxVerbosity verbosity : {TxVerbosity::SHOW_TXID, TxVerbosity::SHOW_DETAILS, TxVerbosity::SHOW_DETAILS_AND_PREVOUT}) {
+            std::string json;
+            JSONTextWriter writer{json};
+            WriteBlockJSON(writer, m_node.chainman->m_blockman, block, *tip, *index, verbosity);
+            BOOST_CHECK_EQUAL(json, blockToJSON(m_node.chainman->m_blockman, block, *tip, *index, verbosity).write());
+        }
+        for (const CTransactionRef& tx : block.vtx) {
+            UniValue expected{UniValue::VOBJ};
+            TxToUniv(*tx, block.GetHash(), expected);
+            std::string json;
+            JSONTextWriter writer{json};
+            TxToJSON(*tx, block.GetHash(), writer);
+            BOOST_CHECK_EQUAL(json, expected.write());
+        }
+    }
+
+    // A parent and child in the mempool.
+    const CTransactionRef parent{MakeTransactionRef(CreateValidMempoolTransaction(
+        m_coinbase_txns[1], /*input_vout=*/0, /*input_height=*/2, coinbaseKey, p2pk, /*output_amount=*/10 * COIN))};
+    CreateValidMempoolTransaction(parent, /*input_vout=*/0, /*input_height=*/tip->nHeight + 1, coinbaseKey, p2pk, /*output_amount=*/9 * COIN);
+    const CTxMemPool& mempool{*m_node.mempool};
+    BOOST_CHECK_EQUAL(WITH_LOCK(mempool.cs, return mempool.size()), 2U);
+    for (const auto& [verbose, mempool_sequence] : std::vector<std::pair<bool, bool>>{{false, false}, {false, true}, {true, false}}) {
+        std::string json;
+        JSONTextWriter writer{json};
+        WriteMempoolJSON(writer, mempool, verbose, mempool_sequence);
+        BOOST_CHECK_EQUAL(json, MempoolToJSON(mempool, verbose, mempool_sequence).write());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -804,4 +804,160 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTestsDiamond)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolAncestorWalkTest)
+{
+    size_t ancestors, descendants, ancestor_size;
+    CAmount ancestor_fees;
+
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // The diamond of MempoolAncestryTestsDiamond, with another child [te] of [tc] and [td].
+    CTransactionRef ta, tb, tc, td, te;
+    ta = make_tx(/*output_values=*/{10 * COIN});
+    tb = make_tx(/*output_values=*/{5 * COIN, 3 * COIN}, /*inputs=*/ {ta});
+    tc = make_tx(/*output_values=*/{1 * COIN, 1 * COIN}, /*inputs=*/{tb}, /*input_indices=*/{1});
+    td = make_tx(/*output_values=*/{6 * COIN}, /*inputs=*/{tb, tc}, /*input_indices=*/{0, 0});
+    te = make_tx(/*output_values=*/{6 * COIN}, /*inputs=*/{tc, td}, /*input_indices=*/{1, 0});
+    for (const auto& tx : {ta, tb, tc, td}) {
+        pool.addUnchecked(entry.Fee(10000LL).FromTx(tx));
+    }
+
+    // Ancestors reachable along several paths are counted once, with or without searching for
+    // parents, and against the ancestor count limit.
+    const CTxMemPoolEntry& entry_d{**pool.GetIter(td->GetHash())};
+    const CTxMemPoolEntry entry_e{entry.Fee(10000LL).FromTx(te)};
+    CTxMemPool::Limits limits{CTxMemPool::Limits::NoLimits()};
+    BOOST_CHECK_EQUAL(pool.CalculateMemPoolAncestors(entry_d, limits).value().size(), 3U);
+    BOOST_CHECK_EQUAL(pool.CalculateMemPoolAncestors(entry_d, limits, /*fSearchForParents=*/false).value().size(), 3U);
+    BOOST_CHECK_EQUAL(pool.CalculateMemPoolAncestors(entry_e, limits).value().size(), 4U);
+    limits.ancestor_count = 5;
+    BOOST_CHECK(pool.CalculateMemPoolAncestors(entry_e, limits).has_value());
+    limits.ancestor_count = 4;
+    BOOST_CHECK_EQUAL(util::ErrorString(pool.CalculateMemPoolAncestors(entry_e, limits)).original, "too many unconfirmed ancestors [limit: 4]");
+    limits = CTxMemPool::Limits::NoLimits();
+    limits.descendant_count = 4;
+    BOOST_CHECK_EQUAL(util::ErrorString(pool.CalculateMemPoolAncestors(entry_e, limits)).original.substr(0, 21), "too many descendants ");
+
+    // Cached ancestry results follow mempool changes.
+    pool.GetTransactionAncestry(td->GetHash(), ancestors, descendants, &ancestor_size, &ancestor_fees);
+    BOOST_CHECK_EQUAL(ancestors, 4ULL);
+    BOOST_CHECK_EQUAL(descendants, 4ULL);
+    BOOST_CHECK_EQUAL(ancestor_fees, 40000);
+    pool.GetTransactionAncestry(td->GetHash(), ancestors, descendants, &ancestor_size, &ancestor_fees);
+    BOOST_CHECK_EQUAL(ancestor_fees, 40000);
+    pool.PrioritiseTransaction(ta->GetHash(), 1000);
+    pool.GetTransactionAncestry(td->GetHash(), ancestors, descendants, &ancestor_size, &ancestor_fees);
+    BOOST_CHECK_EQUAL(ancestor_fees, 41000);
+    pool.addUnchecked(entry.Fee(10000LL).FromTx(te));
+    pool.GetTransactionAncestry(td->GetHash(), ancestors, descendants);
+    BOOST_CHECK_EQUAL(descendants, 5ULL);
+    pool.removeRecursive(*td, REMOVAL_REASON_DUMMY);
+    pool.GetTransactionAncestry(tc->GetHash(), ancestors, descendants);
+    BOOST_CHECK_EQUAL(ancestors, 3ULL);
+    BOOST_CHECK_EQUAL(descendants, 3ULL);
+    pool.GetTransactionAncestry(td->GetHash(), ancestors, descendants);
+    BOOST_CHECK_EQUAL(ancestors, 0ULL);
+    BOOST_CHECK_EQUAL(descendants, 0ULL);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolMemoryUsageTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Up to two parent or child links are stored in the entry itself.
+    CTransactionRef parent{make_tx(/*output_values=*/{COIN, COIN, COIN})};
+    pool.addUnchecked(entry.FromTx(parent));
+    for (uint32_t i = 0; i < 2; ++i) {
+        pool.addUnchecked(entry.FromTx(make_tx(/*output_values=*/{COIN}, /*inputs=*/{parent}, /*input_indices=*/{i})));
+    }
+    CTxMemPool::MemoryUsage usage{pool.GetMemoryUsage()};
+    BOOST_CHECK_EQUAL(usage.links, 0U);
+    BOOST_CHECK_GT(usage.entries, 0U);
+    BOOST_CHECK_GT(usage.transactions, 0U);
+    BOOST_CHECK_EQUAL(usage.Total(), pool.DynamicMemoryUsage());
+
+    // A third child moves the parent's children out of line.
+    CTransactionRef child{make_tx(/*output_values=*/{COIN}, /*inputs=*/{parent}, /*input_indices=*/{2})};
+    pool.addUnchecked(entry.FromTx(child));
+    usage = pool.GetMemoryUsage();
+    BOOST_CHECK_GT(usage.links, 0U);
+    BOOST_CHECK_EQUAL(usage.Total(), pool.DynamicMemoryUsage());
+
+    // Removing the parent removes everything, and with it all link memory.
+    pool.removeRecursive(*parent, MemPoolRemovalReason::REPLACED);
+    usage = pool.GetMemoryUsage();
+    BOOST_CHECK_EQUAL(pool.size(), 0U);
+    BOOST_CHECK_EQUAL(usage.entries, 0U);
+    BOOST_CHECK_EQUAL(usage.transactions, 0U);
+    BOOST_CHECK_EQUAL(usage.links, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolClusterTest)
+{
+    CTxMemPool::Options mempool_opts{MemPoolOptionsForTest(m_node)};
+    mempool_opts.cluster_mempool = true;
+    CTxMemPool pool{mempool_opts};
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // [ta] <- [tb].0 <- [td]      [tc]
+    // tb pays for its low feerate parent ta, and td pays less than any other transaction.
+    CTransactionRef ta = make_tx(/*output_values=*/{10 * COIN});
+    CTransactionRef tb = make_tx(/*output_values=*/{4 * COIN, 4 * COIN}, /*inputs=*/{ta});
+    CTransactionRef tc = make_tx(/*output_values=*/{8 * COIN});
+    CTransactionRef td = make_tx(/*output_values=*/{3 * COIN}, /*inputs=*/{tb});
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(ta));
+    pool.addUnchecked(entry.Fee(50000LL).FromTx(tb));
+    pool.addUnchecked(entry.Fee(10000LL).FromTx(tc));
+    pool.addUnchecked(entry.Fee(100LL).FromTx(td));
+
+    BOOST_CHECK_EQUAL(pool.GetLinearizedClusters().size(), 2U);
+    const TxMempoolCluster* cluster{pool.GetEntry(ta->GetHash())->m_cluster};
+    BOOST_CHECK(pool.GetEntry(tb->GetHash())->m_cluster == cluster);
+    BOOST_CHECK(pool.GetEntry(td->GetHash())->m_cluster == cluster);
+    BOOST_CHECK(pool.GetEntry(tc->GetHash())->m_cluster != cluster);
+    BOOST_REQUIRE_EQUAL(cluster->m_txs.size(), 3U);
+    BOOST_CHECK(cluster->m_txs[0]->GetTx().GetHash() == ta->GetHash());
+    BOOST_CHECK(cluster->m_txs[1]->GetTx().GetHash() == tb->GetHash());
+    BOOST_CHECK(cluster->m_txs[2]->GetTx().GetHash() == td->GetHash());
+    // ta and tb form one chunk, td is a chunk of its own.
+    BOOST_REQUIRE_EQUAL(cluster->m_chunks.size(), 2U);
+    BOOST_CHECK_EQUAL(cluster->m_chunks[0].count, 2U);
+    BOOST_CHECK(cluster->m_chunks[0].feerate == FeeFrac(51000, GetVirtualTransactionSize(*ta) + GetVirtualTransactionSize(*tb)));
+    BOOST_CHECK_EQUAL(cluster->m_chunks[1].count, 1U);
+
+    // Trimming evicts the lowest feerate chunk only.
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
+    BOOST_CHECK(pool.exists(GenTxid::Txid(ta->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tb->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tc->GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(td->GetHash())));
+    BOOST_CHECK_EQUAL(cluster->m_txs.size(), 2U);
+    BOOST_CHECK_EQUAL(cluster->m_chunks.size(), 1U);
+
+    // Confirming ta and tb splits the rest of their cluster in two.
+    CTransactionRef te = make_tx(/*output_values=*/{3 * COIN}, /*inputs=*/{tb}, /*input_indices=*/{0});
+    CTransactionRef tf = make_tx(/*output_values=*/{3 * COIN}, /*inputs=*/{tb}, /*input_indices=*/{1});
+    pool.addUnchecked(entry.Fee(2000LL).FromTx(te));
+    pool.addUnchecked(entry.Fee(3000LL).FromTx(tf));
+    BOOST_CHECK_EQUAL(pool.GetLinearizedClusters().size(), 2U);
+    pool.removeForBlock({ta, tb}, /*nBlockHeight=*/1);
+    BOOST_CHECK_EQUAL(pool.GetLinearizedClusters().size(), 3U);
+    const TxMempoolCluster* cluster_e{pool.GetEntry(te->GetHash())->m_cluster};
+    const TxMempoolCluster* cluster_f{pool.GetEntry(tf->GetHash())->m_cluster};
+    BOOST_CHECK(cluster_e != cluster_f);
+    BOOST_CHECK_EQUAL(cluster_e->m_txs.size(), 1U);
+    BOOST_CHECK_EQUAL(cluster_f->m_txs.size(), 1U);
+
+    // Prioritisation is reflected in the chunk feerates.
+    pool.PrioritiseTransaction(te->GetHash(), 10000);
+    pool.GetLinearizedClusters();
+    BOOST_CHECK(cluster_e->m_chunks[0].feerate == FeeFrac(12000, GetVirtualTransactionSize(*te)));
+    pool.PrioritiseTransaction(te->GetHash(), -10000);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
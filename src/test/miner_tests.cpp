@@ -8,8 +8,10 @@
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
+#include <consensus/validation.h>
 #include <node/miner.h>
 #include <policy/policy.h>
+#include <streams.h>
 #include <test/util/random.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
@@ -22,11 +24,13 @@
 #include <test/util/setup_common.h>
 
 #include <memory>
+#include <numeric>
 
 #include <boost/test/unit_test.hpp>
 
 using node::BlockAssembler;
 using node::CBlockTemplate;
+using node::RegenerateCommitments;
 
 namespace miner_tests {
 struct MinerTestingSetup : public TestingSetup {
@@ -40,13 +44,17 @@ struct MinerTestingSetup : public TestingSetup {
         const std::optional<LockPoints> lock_points{CalculateLockPointsAtTip(tip, view_mempool, tx)};
         return lock_points.has_value() && CheckSequenceLocksAtTip(tip, *lock_points);
     }
+    //! Whether MakeMempool creates mempools with -clustermempool.
+    bool m_cluster_mempool{false};
     CTxMemPool& MakeMempool()
     {
         // Delete the previous mempool to ensure with valgrind that the old
         // pointer is not accessed, when the new one should be accessed
         // instead.
         m_node.mempool.reset();
-        m_node.mempool = std::make_unique<CTxMemPool>(MemPoolOptionsForTest(m_node));
+        CTxMemPool::Options mempool_opts{MemPoolOptionsForTest(m_node)};
+        mempool_opts.cluster_mempool = m_cluster_mempool;
+        m_node.mempool = std::make_unique<CTxMemPool>(mempool_opts);
         return *m_node.mempool;
     }
     BlockAssembler AssemblerForTest(CTxMemPool& tx_mempool);
@@ -652,6 +660,243 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     SetMockTime(0);
 
     TestPrioritisedMining(scriptPubKey, txFirst);
+
+    // Selecting chunks of cluster linearizations gives the same blocks in these cases.
+    m_cluster_mempool = true;
+    TestPackageSelection(scriptPubKey, txFirst);
+    TestPrioritisedMining(scriptPubKey, txFirst);
+}
+
+BOOST_FIXTURE_TEST_CASE(block_template_cache, TestChain100Setup)
+{
+    node::BlockTemplateCache cache{*m_node.chainman, *m_node.mempool, BlockAssembler::Options{}};
+    m_node.validation_signals->RegisterValidationInterface(&cache);
+    const CScript script_pub_key{CScript() << OP_TRUE};
+    const CScript coinbase_key_script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+
+    // Check that the template is valid and commits to its transactions.
+    const auto check_template = [&](const CBlockTemplate& block_template) {
+        LOCK(cs_main);
+        CBlock block{block_template.block};
+        BlockValidationState state;
+        BOOST_CHECK(TestBlockValidity(state, m_node.chainman->GetParams(), m_node.chainman->ActiveChainstate(), block, m_node.chainman->ActiveChain().Tip(),
+                                      /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/false));
+        BOOST_CHECK_MESSAGE(state.IsValid(), state.ToString());
+        const CAmount fees{-block_template.vTxFees[0]};
+        BOOST_CHECK_EQUAL(fees, std::accumulate(block_template.vTxFees.begin() + 1, block_template.vTxFees.end(), CAmount{0}));
+        BOOST_CHECK_EQUAL(block.vtx[0]->vout[0].nValue, fees + GetBlockSubsidy(m_node.chainman->ActiveHeight() + 1, m_node.chainman->GetConsensus()));
+        const CTransactionRef coinbase{block.vtx[0]};
+        RegenerateCommitments(block, *m_node.chainman);
+        BOOST_CHECK(*block.vtx[0] == *coinbase);
+    };
+
+    const auto empty_template{cache.Get(script_pub_key)};
+    BOOST_CHECK_EQUAL(empty_template->block.vtx.size(), 1U);
+    BOOST_CHECK_EQUAL(cache.GetRebuildCount(), 1U);
+    // Without mempool or chain changes, the same template is returned.
+    BOOST_CHECK(cache.Get(script_pub_key) == empty_template);
+
+    // New transactions whose parents are in the template are appended to it, one at a time to
+    // cover merkle trees of each shape.
+    constexpr uint32_t NUM_CHILDREN{6};
+    const CTransactionRef parent{MakeTransactionRef(CreateValidMempoolTransaction(
+        /*input_transactions=*/{m_coinbase_txns[0]}, /*inputs=*/{COutPoint{m_coinbase_txns[0]->GetHash(), 0}}, /*input_height=*/1,
+        /*input_signing_keys=*/{coinbaseKey}, /*outputs=*/std::vector<CTxOut>(NUM_CHILDREN, CTxOut{8 * COIN, coinbase_key_script})))};
+    std::vector<CTransactionRef> children;
+    for (uint32_t i = 0; i <= NUM_CHILDREN; ++i) {
+        m_node.validation_signals->SyncWithValidationInterfaceQueue();
+        const auto block_template{cache.Get(script_pub_key)};
+        BOOST_CHECK_EQUAL(block_template->block.vtx.size(), i + 2);
+        BOOST_CHECK_EQUAL(cache.GetAppendCount(), i + 1);
+        check_template(*block_template);
+        if (i == NUM_CHILDREN) break;
+        children.push_back(MakeTransactionRef(CreateValidMempoolTransaction(parent, i, /*input_height=*/101, coinbaseKey, coinbase_key_script, 8 * COIN - 1000 * (i + 1))));
+    }
+    BOOST_CHECK_EQUAL(cache.GetRebuildCount(), 1U);
+    // Earlier templates are not modified.
+    BOOST_CHECK_EQUAL(empty_template->block.vtx.size(), 1U);
+
+    // Prioritisation is not announced through the validation interface, but still rebuilds the template.
+    m_node.mempool->PrioritiseTransaction(children[0]->GetHash(), COIN);
+    BOOST_CHECK_EQUAL(cache.Get(script_pub_key)->vTxFees.size(), NUM_CHILDREN + 2);
+    BOOST_CHECK_EQUAL(cache.GetRebuildCount(), 2U);
+
+    // Removing a transaction in the template rebuilds it, unless the template is younger than
+    // the allowed staleness.
+    const auto full_template{cache.Get(script_pub_key)};
+    m_node.mempool->removeRecursive(*children.back(), MemPoolRemovalReason::CONFLICT);
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    BOOST_CHECK(cache.Get(script_pub_key, std::chrono::hours{1}) == full_template);
+    BOOST_CHECK_EQUAL(cache.Get(script_pub_key)->block.vtx.size(), NUM_CHILDREN + 1);
+    BOOST_CHECK_EQUAL(cache.GetRebuildCount(), 3U);
+
+    // A new tip always rebuilds the template.
+    CreateAndProcessBlock({}, script_pub_key);
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    const auto tip_template{cache.Get(script_pub_key, std::chrono::hours{1})};
+    BOOST_CHECK_EQUAL(tip_template->block.hashPrevBlock, WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockHash()));
+    BOOST_CHECK_EQUAL(cache.GetRebuildCount(), 4U);
+    check_template(*tip_template);
+
+    // Templates requested before the new transactions are notified leave them out, and get them
+    // appended once they are, without a rebuild.
+    const uint64_t appends{cache.GetAppendCount()};
+    for (size_t i = 0; i < 2; ++i) {
+        CreateValidMempoolTransaction(children[i], 0, /*input_height=*/0, coinbaseKey, coinbase_key_script, children[i]->vout[0].nValue - 10000);
+        BOOST_CHECK_LE(cache.Get(script_pub_key)->block.vtx.size(), tip_template->block.vtx.size() + i + 1);
+    }
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    const auto appended_template{cache.Get(script_pub_key)};
+    BOOST_CHECK_EQUAL(appended_template->block.vtx.size(), tip_template->block.vtx.size() + 2);
+    BOOST_CHECK_EQUAL(cache.GetAppendCount(), appends + 2);
+    BOOST_CHECK_EQUAL(cache.GetRebuildCount(), 4U);
+    check_template(*appended_template);
+
+    m_node.validation_signals->UnregisterValidationInterface(&cache);
+}
+
+BOOST_FIXTURE_TEST_CASE(block_template_cache_updates, TestChain100Setup)
+{
+    node::BlockTemplateCache cache{*m_node.chainman, *m_node.mempool, BlockAssembler::Options{}};
+    m_node.validation_signals->RegisterValidationInterface(&cache);
+    const CScript script_pub_key{CScript() << OP_TRUE};
+    const CScript coinbase_key_script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+
+    // Apply an update to the transactions of its base, and check the resulting block.
+    std::vector<CTransactionRef> txs;
+    const auto apply_update = [&](const node::BlockTemplateDiff& diff) {
+        // Updates survive a serialization roundtrip.
+        DataStream stream;
+        stream << TX_WITH_WITNESS(diff);
+        node::BlockTemplateDiff decoded;
+        stream >> TX_WITH_WITNESS(decoded);
+        BOOST_CHECK_EQUAL(decoded.id, diff.id);
+        BOOST_CHECK_EQUAL(decoded.base_id, diff.base_id);
+        BOOST_CHECK_EQUAL(decoded.header.GetHash(), diff.header.GetHash());
+        BOOST_CHECK(*decoded.coinbase == *diff.coinbase);
+        BOOST_CHECK(decoded.removed == diff.removed);
+        BOOST_CHECK_EQUAL(decoded.added.size(), diff.added.size());
+
+        if (decoded.base_id == 0) txs.clear();
+        for (const Txid& txid : decoded.removed) {
+            const auto it{std::find_if(txs.begin(), txs.end(), [&](const CTransactionRef& tx) { return tx->GetHash() == txid; })};
+            BOOST_REQUIRE(it != txs.end());
+            txs.erase(it);
+        }
+        txs.insert(txs.end(), decoded.added.begin(), decoded.added.end());
+
+        CBlock block{decoded.header};
+        block.vtx.push_back(decoded.coinbase);
+        block.vtx.insert(block.vtx.end(), txs.begin(), txs.end());
+        LOCK2(cs_main, m_node.mempool->cs);
+        BlockValidationState state;
+        BOOST_CHECK(TestBlockValidity(state, m_node.chainman->GetParams(), m_node.chainman->ActiveChainstate(), block, m_node.chainman->ActiveChain().Tip(),
+                                      /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/true));
+        BOOST_CHECK_MESSAGE(state.IsValid(), state.ToString());
+        CAmount fees{0};
+        for (const CTransactionRef& tx : txs) {
+            fees += (*m_node.mempool->GetIter(tx->GetHash()))->GetFee();
+        }
+        BOOST_CHECK_EQUAL(decoded.fees, fees);
+    };
+
+    const auto empty{cache.GetUpdate(script_pub_key, /*base_id=*/0, /*min_fee_increase=*/0)};
+    BOOST_REQUIRE(empty);
+    BOOST_CHECK_EQUAL(empty->base_id, 0U);
+    BOOST_CHECK(empty->added.empty());
+    apply_update(*empty);
+    // An unchanged template is not returned again.
+    BOOST_CHECK(!cache.GetUpdate(script_pub_key, empty->id, /*min_fee_increase=*/0));
+
+    constexpr uint32_t NUM_CHILDREN{3};
+    constexpr CAmount OUTPUT_VALUE{(50 * COIN - 10000) / NUM_CHILDREN};
+    const CTransactionRef parent{MakeTransactionRef(CreateValidMempoolTransaction(
+        /*input_transactions=*/{m_coinbase_txns[0]}, /*inputs=*/{COutPoint{m_coinbase_txns[0]->GetHash(), 0}}, /*input_height=*/1,
+        /*input_signing_keys=*/{coinbaseKey}, /*outputs=*/std::vector<CTxOut>(NUM_CHILDREN, CTxOut{OUTPUT_VALUE, coinbase_key_script})))};
+    std::vector<CTransactionRef> children;
+    for (uint32_t i = 0; i < NUM_CHILDREN - 1; ++i) {
+        children.push_back(MakeTransactionRef(CreateValidMempoolTransaction(parent, i, /*input_height=*/101, coinbaseKey, coinbase_key_script, OUTPUT_VALUE - 1000)));
+    }
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+
+    // Updates wait for the fees to increase by at least the given amount.
+    BOOST_CHECK(!cache.GetUpdate(script_pub_key, empty->id, /*min_fee_increase=*/COIN));
+    const auto added{cache.GetUpdate(script_pub_key, empty->id, /*min_fee_increase=*/0)};
+    BOOST_REQUIRE(added);
+    BOOST_CHECK_EQUAL(added->base_id, empty->id);
+    BOOST_CHECK(added->removed.empty());
+    BOOST_CHECK_EQUAL(added->added.size(), NUM_CHILDREN);
+    BOOST_CHECK_EQUAL(added->added[0]->GetHash(), parent->GetHash());
+    apply_update(*added);
+
+    // Replacing a transaction in the template removes it, and adds the new one at the end, even
+    // where the template itself has it in another position.
+    m_node.mempool->removeRecursive(*children[0], MemPoolRemovalReason::CONFLICT);
+    children.push_back(MakeTransactionRef(CreateValidMempoolTransaction(parent, NUM_CHILDREN - 1, /*input_height=*/101, coinbaseKey, coinbase_key_script, OUTPUT_VALUE - 5000)));
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    const auto replaced{cache.GetUpdate(script_pub_key, added->id, /*min_fee_increase=*/0)};
+    BOOST_REQUIRE(replaced);
+    BOOST_CHECK_EQUAL(replaced->base_id, added->id);
+    BOOST_REQUIRE_EQUAL(replaced->removed.size(), 1U);
+    BOOST_CHECK_EQUAL(replaced->removed[0], children[0]->GetHash());
+    BOOST_REQUIRE_EQUAL(replaced->added.size(), 1U);
+    BOOST_CHECK_EQUAL(replaced->added[0]->GetHash(), children.back()->GetHash());
+    apply_update(*replaced);
+
+    // Earlier bases remain usable, and unknown ones give the whole template.
+    const auto from_empty{cache.GetUpdate(script_pub_key, empty->id, /*min_fee_increase=*/0)};
+    BOOST_REQUIRE(from_empty);
+    BOOST_CHECK_EQUAL(from_empty->base_id, empty->id);
+    BOOST_CHECK_EQUAL(from_empty->added.size(), NUM_CHILDREN);
+    const auto unknown{cache.GetUpdate(script_pub_key, /*base_id=*/1000, /*min_fee_increase=*/0)};
+    BOOST_REQUIRE(unknown);
+    BOOST_CHECK_EQUAL(unknown->base_id, 0U);
+    BOOST_CHECK_EQUAL(unknown->added.size(), NUM_CHILDREN);
+
+    // A transaction re-added with another witness cannot follow its kept child, so the update
+    // adds all transactions instead.
+    const CScript witness_script{CScript() << OP_DROP << OP_TRUE};
+    const CTransactionRef funding{MakeTransactionRef(CreateValidMempoolTransaction(children[1], 0, /*input_height=*/101, coinbaseKey,
+                                                                                   GetScriptForDestination(WitnessV0ScriptHash{witness_script}), OUTPUT_VALUE - 2000))};
+    const auto spend_witness = [&](uint8_t witness_item) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint{funding->GetHash(), 0});
+        tx.vin[0].scriptWitness.stack = {{witness_item}, {witness_script.begin(), witness_script.end()}};
+        tx.vout.emplace_back(OUTPUT_VALUE - 3000, coinbase_key_script);
+        return MakeTransactionRef(tx);
+    };
+    const CTransactionRef witness_parent{spend_witness(1)};
+    BOOST_REQUIRE_EQUAL(WITH_LOCK(cs_main, return m_node.chainman->ProcessTransaction(witness_parent)).m_result_type, MempoolAcceptResult::ResultType::VALID);
+    const CTransactionRef witness_child{MakeTransactionRef(CreateValidMempoolTransaction(witness_parent, 0, /*input_height=*/101, coinbaseKey, coinbase_key_script, OUTPUT_VALUE - 4000))};
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    const auto with_witness{cache.GetUpdate(script_pub_key, replaced->id, /*min_fee_increase=*/0)};
+    BOOST_REQUIRE(with_witness);
+    BOOST_CHECK_EQUAL(with_witness->base_id, replaced->id);
+    apply_update(*with_witness);
+    m_node.mempool->removeRecursive(*witness_parent, MemPoolRemovalReason::CONFLICT);
+    const CTransactionRef new_witness_parent{spend_witness(2)};
+    BOOST_REQUIRE(new_witness_parent->GetHash() == witness_parent->GetHash());
+    BOOST_REQUIRE(new_witness_parent->GetWitnessHash() != witness_parent->GetWitnessHash());
+    for (const CTransactionRef& tx : {new_witness_parent, witness_child}) {
+        BOOST_REQUIRE_EQUAL(WITH_LOCK(cs_main, return m_node.chainman->ProcessTransaction(tx)).m_result_type, MempoolAcceptResult::ResultType::VALID);
+    }
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    const auto new_witness{cache.GetUpdate(script_pub_key, with_witness->id, /*min_fee_increase=*/0)};
+    BOOST_REQUIRE(new_witness);
+    BOOST_CHECK_EQUAL(new_witness->base_id, 0U);
+    BOOST_CHECK_EQUAL(new_witness->added.size(), NUM_CHILDREN + 3);
+    apply_update(*new_witness);
+
+    // A new tip gives the whole template regardless of fees.
+    CreateAndProcessBlock({}, script_pub_key);
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    const auto new_tip{cache.GetUpdate(script_pub_key, new_witness->id, /*min_fee_increase=*/MAX_MONEY)};
+    BOOST_REQUIRE(new_tip);
+    BOOST_CHECK_EQUAL(new_tip->base_id, 0U);
+    BOOST_CHECK_EQUAL(new_tip->header.hashPrevBlock, WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockHash()));
+    apply_update(*new_tip);
+
+    m_node.validation_signals->UnregisterValidationInterface(&cache);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
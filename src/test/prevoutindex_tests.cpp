@@ -0,0 +1,64 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <index/prevoutindex.h>
+#include <interfaces/chain.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(prevoutindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(prevoutindex_initial_sync, TestChain100Setup)
+{
+    const CScript script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction spend_before{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, script, 1 * COIN, /*submit=*/false)};
+    CreateAndProcessBlock({spend_before}, script);
+
+    PrevoutIndex index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(index.Init());
+    CTxUndo tx_undo;
+    BOOST_CHECK(!index.FindPrevouts(spend_before.GetHash(), tx_undo));
+
+    BOOST_REQUIRE(index.StartBackgroundSync());
+    IndexWaitSynced(index, *Assert(m_node.shutdown));
+
+    // Coinbase transactions spend nothing and are not indexed.
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(!index.FindPrevouts(txn->GetHash(), tx_undo));
+    }
+
+    BOOST_REQUIRE(index.FindPrevouts(spend_before.GetHash(), tx_undo));
+    BOOST_REQUIRE_EQUAL(tx_undo.vprevout.size(), 1U);
+    BOOST_CHECK(tx_undo.vprevout[0].out == m_coinbase_txns[0]->vout[0]);
+    BOOST_CHECK_EQUAL(tx_undo.vprevout[0].nHeight, 1U);
+    BOOST_CHECK(tx_undo.vprevout[0].fCoinBase);
+
+    // Transactions in new blocks are indexed, including their spends of outputs
+    // created earlier in the same block.
+    const CMutableTransaction spend_after{CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 2, coinbaseKey, script, 2 * COIN, /*submit=*/false)};
+    const CMutableTransaction spend_chained{CreateValidMempoolTransaction(MakeTransactionRef(spend_after), 0, 0, coinbaseKey, script, 1 * COIN, /*submit=*/false)};
+    CreateAndProcessBlock({spend_after, spend_chained}, script);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    const int height{WITH_LOCK(::cs_main, return m_node.chainman->ActiveHeight())};
+
+    BOOST_REQUIRE(index.FindPrevouts(spend_after.GetHash(), tx_undo));
+    BOOST_REQUIRE_EQUAL(tx_undo.vprevout.size(), 1U);
+    BOOST_CHECK(tx_undo.vprevout[0].out == m_coinbase_txns[1]->vout[0]);
+    BOOST_CHECK_EQUAL(tx_undo.vprevout[0].nHeight, 2U);
+    BOOST_REQUIRE(index.FindPrevouts(spend_chained.GetHash(), tx_undo));
+    BOOST_REQUIRE_EQUAL(tx_undo.vprevout.size(), 1U);
+    BOOST_CHECK(tx_undo.vprevout[0].out == spend_after.vout[0]);
+    BOOST_CHECK_EQUAL(tx_undo.vprevout[0].nHeight, uint32_t(height));
+    BOOST_CHECK(!tx_undo.vprevout[0].fCoinBase);
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
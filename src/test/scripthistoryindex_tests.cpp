@@ -0,0 +1,107 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <index/scripthistoryindex.h>
+#include <interfaces/chain.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+
+BOOST_AUTO_TEST_SUITE(scripthistoryindex_tests)
+
+static constexpr int MAX_HEIGHT{std::numeric_limits<int>::max()};
+
+static std::vector<ScriptHistoryEntry> LookUp(const ScriptHistoryIndex& index, const CScript& script)
+{
+    std::vector<ScriptHistoryEntry> entries;
+    bool more;
+    BOOST_REQUIRE(index.LookUpHistory(script, 0, MAX_HEIGHT, std::nullopt, std::numeric_limits<size_t>::max(), entries, more));
+    BOOST_CHECK(!more);
+    return entries;
+}
+
+BOOST_FIXTURE_TEST_CASE(scripthistoryindex_initial_sync, TestChain100Setup)
+{
+    ScriptHistoryIndex index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(index.Init());
+    BOOST_REQUIRE(index.StartBackgroundSync());
+    IndexWaitSynced(index, *Assert(m_node.shutdown));
+
+    // Every block of the test chain pays its coinbase to the same script, and
+    // the genesis block is excluded.
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    std::vector<ScriptHistoryEntry> entries{LookUp(index, coinbase_script)};
+    BOOST_REQUIRE_EQUAL(entries.size(), m_coinbase_txns.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        BOOST_CHECK_EQUAL(entries[i].pos.height, int(i) + 1);
+        BOOST_CHECK_EQUAL(entries[i].pos.txid, m_coinbase_txns[i]->GetHash());
+        BOOST_CHECK_EQUAL(entries[i].pos.vout, 0U);
+        BOOST_CHECK_EQUAL(entries[i].amount, m_coinbase_txns[i]->vout[0].nValue);
+        BOOST_CHECK(!entries[i].spent_by);
+    }
+
+    // Pages of a height range.
+    bool more;
+    BOOST_REQUIRE(index.LookUpHistory(coinbase_script, 10, 19, std::nullopt, 4, entries, more));
+    BOOST_REQUIRE_EQUAL(entries.size(), 4U);
+    BOOST_CHECK(more);
+    BOOST_CHECK_EQUAL(entries.front().pos.height, 10);
+    BOOST_CHECK_EQUAL(entries.back().pos.height, 13);
+    const ScriptHistoryPosition cursor{entries.back().pos};
+    BOOST_REQUIRE(index.LookUpHistory(coinbase_script, 10, 19, cursor, 4, entries, more));
+    BOOST_REQUIRE_EQUAL(entries.size(), 4U);
+    BOOST_CHECK(more);
+    BOOST_CHECK_EQUAL(entries.front().pos.height, 14);
+    BOOST_REQUIRE(index.LookUpHistory(coinbase_script, 10, 19, entries.back().pos, 4, entries, more));
+    BOOST_REQUIRE_EQUAL(entries.size(), 2U);
+    BOOST_CHECK(!more);
+    BOOST_CHECK_EQUAL(entries.back().pos.height, 19);
+
+    // A spend in a new block shows up on both scripts.
+    const CScript dest_script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, dest_script, 1 * COIN, /*submit=*/false)};
+    CreateAndProcessBlock({spend}, coinbase_script);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    const int spend_height{WITH_LOCK(::cs_main, return m_node.chainman->ActiveHeight())};
+
+    entries = LookUp(index, coinbase_script);
+    BOOST_REQUIRE_EQUAL(entries.size(), m_coinbase_txns.size() + 1);
+    BOOST_REQUIRE(entries[0].spent_by);
+    BOOST_CHECK_EQUAL(entries[0].spent_by->txid, spend.GetHash());
+    BOOST_CHECK_EQUAL(entries[0].spent_by->vin, 0U);
+    BOOST_CHECK_EQUAL(entries[0].spent_by->height, spend_height);
+    entries = LookUp(index, dest_script);
+    BOOST_REQUIRE_EQUAL(entries.size(), 1U);
+    BOOST_CHECK_EQUAL(entries[0].pos.height, spend_height);
+    BOOST_CHECK_EQUAL(entries[0].pos.txid, spend.GetHash());
+    BOOST_CHECK_EQUAL(entries[0].amount, 1 * COIN);
+
+    // Replacing the block with one without the spend rewinds the index.
+    {
+        BlockValidationState state;
+        CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    }
+    CreateAndProcessBlock({}, dest_script);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+
+    entries = LookUp(index, coinbase_script);
+    BOOST_REQUIRE_EQUAL(entries.size(), m_coinbase_txns.size());
+    BOOST_CHECK(!entries[0].spent_by);
+    entries = LookUp(index, dest_script);
+    BOOST_REQUIRE_EQUAL(entries.size(), 1U);
+    BOOST_CHECK_EQUAL(entries[0].pos.height, spend_height);
+    BOOST_CHECK_EQUAL(entries[0].pos.vout, 0U);
+    BOOST_CHECK(entries[0].pos.txid != spend.GetHash());
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,98 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <coins.h>
+#include <index/scriptutxoindex.h>
+#include <interfaces/chain.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+
+BOOST_AUTO_TEST_SUITE(scriptutxoindex_tests)
+
+static std::map<COutPoint, Coin> FindUTXOs(const ScriptUTXOIndex& index, const CScript& script, const uint256& expected_best_block)
+{
+    std::map<COutPoint, Coin> coins;
+    uint256 best_block;
+    BOOST_REQUIRE(index.FindUTXOs({script}, coins, best_block));
+    BOOST_CHECK_EQUAL(best_block, expected_best_block);
+    return coins;
+}
+
+BOOST_FIXTURE_TEST_CASE(scriptutxoindex_initial_sync, TestChain100Setup)
+{
+    ScriptUTXOIndex index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(index.Init());
+    std::map<COutPoint, Coin> coins;
+    uint256 best_block;
+    BOOST_CHECK(!index.FindUTXOs({}, coins, best_block));
+
+    BOOST_REQUIRE(index.StartBackgroundSync());
+    IndexWaitSynced(index, *Assert(m_node.shutdown));
+
+    // Every block of the test chain pays its coinbase to the same script, and
+    // the index matches the UTXO set.
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    uint256 tip_hash{WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip()->GetBlockHash())};
+    coins = FindUTXOs(index, coinbase_script, tip_hash);
+    BOOST_REQUIRE_EQUAL(coins.size(), m_coinbase_txns.size());
+    for (const auto& [outpoint, coin] : coins) {
+        const Coin& expected{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChainstate().CoinsTip().AccessCoin(outpoint))};
+        BOOST_CHECK(!expected.IsSpent());
+        BOOST_CHECK(coin.out == expected.out);
+        BOOST_CHECK_EQUAL(coin.nHeight, expected.nHeight);
+        BOOST_CHECK(coin.IsCoinBase());
+    }
+
+    // A spend in a new block moves the output to the destination script.
+    // An output created and spent in the same block is not indexed.
+    const CScript dest_script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, dest_script, 2 * COIN, /*submit=*/false)};
+    const CMutableTransaction spend_chained{CreateValidMempoolTransaction(MakeTransactionRef(spend), 0, 0, coinbaseKey, dest_script, 1 * COIN, /*submit=*/false)};
+    CreateAndProcessBlock({spend, spend_chained}, coinbase_script);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    const int spend_height{WITH_LOCK(::cs_main, return m_node.chainman->ActiveHeight())};
+    tip_hash = WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip()->GetBlockHash());
+
+    coins = FindUTXOs(index, coinbase_script, tip_hash);
+    BOOST_CHECK_EQUAL(coins.size(), m_coinbase_txns.size());
+    BOOST_CHECK(!coins.count(COutPoint{m_coinbase_txns[0]->GetHash(), 0}));
+    coins = FindUTXOs(index, dest_script, tip_hash);
+    BOOST_REQUIRE_EQUAL(coins.size(), 1U);
+    BOOST_CHECK(coins.begin()->first == COutPoint(spend_chained.GetHash(), 0));
+    BOOST_CHECK_EQUAL(coins.begin()->second.nHeight, uint32_t(spend_height));
+    BOOST_CHECK_EQUAL(coins.begin()->second.out.nValue, 1 * COIN);
+    BOOST_CHECK(!coins.begin()->second.IsCoinBase());
+
+    // Replacing the block with one without the spends rewinds the index.
+    {
+        BlockValidationState state;
+        CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    }
+    CreateAndProcessBlock({}, dest_script);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    tip_hash = WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip()->GetBlockHash());
+
+    coins = FindUTXOs(index, coinbase_script, tip_hash);
+    BOOST_REQUIRE_EQUAL(coins.size(), m_coinbase_txns.size());
+    const auto restored{coins.find(COutPoint{m_coinbase_txns[0]->GetHash(), 0})};
+    BOOST_REQUIRE(restored != coins.end());
+    BOOST_CHECK_EQUAL(restored->second.nHeight, 1U);
+    BOOST_CHECK(restored->second.IsCoinBase());
+    coins = FindUTXOs(index, dest_script, tip_hash);
+    BOOST_REQUIRE_EQUAL(coins.size(), 1U);
+    BOOST_CHECK_EQUAL(coins.begin()->second.nHeight, uint32_t(spend_height));
+    BOOST_CHECK(coins.begin()->second.IsCoinBase());
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -77,4 +77,64 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_compact_format, TestChain100Setup)
+{
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true, false, TxIndexFormat::COMPACT);
+    BOOST_REQUIRE(txindex.Init());
+    BOOST_REQUIRE(txindex.StartBackgroundSync());
+    IndexWaitSynced(txindex, *Assert(m_node.shutdown));
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    for (const auto& txn : Params().GenesisBlock().vtx) {
+        BOOST_CHECK(!txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_REQUIRE(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+        BOOST_CHECK_EQUAL(tx_disk->GetHash(), txn->GetHash());
+    }
+
+    // Once synced, transactions are found as soon as their block is indexed,
+    // including the ones after the coinbase.
+    const CScript script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, script, 1 * COIN, /*submit=*/false)};
+    const CBlock block{CreateAndProcessBlock({spend}, script)};
+    BOOST_CHECK(txindex.BlockUntilSyncedToCurrentChain());
+    for (const auto& txn : block.vtx) {
+        BOOST_REQUIRE(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+        BOOST_CHECK_EQUAL(tx_disk->GetHash(), txn->GetHash());
+        BOOST_CHECK_EQUAL(block_hash, block.GetHash());
+    }
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    txindex.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(txindex_format_migration, TestChain100Setup)
+{
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    {
+        TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, /*f_memory=*/false, /*f_wipe=*/true, TxIndexFormat::LEGACY);
+        BOOST_REQUIRE(txindex.Init());
+        BOOST_REQUIRE(txindex.StartBackgroundSync());
+        IndexWaitSynced(txindex, *Assert(m_node.shutdown));
+        BOOST_CHECK(txindex.FindTx(m_coinbase_txns[0]->GetHash(), block_hash, tx_disk));
+        txindex.Stop();
+    }
+
+    // Opening the legacy index in the compact format starts it over.
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, /*f_memory=*/false, /*f_wipe=*/false, TxIndexFormat::COMPACT);
+    BOOST_REQUIRE(txindex.Init());
+    BOOST_CHECK(!txindex.GetSummary().synced);
+    BOOST_CHECK(!txindex.FindTx(m_coinbase_txns[0]->GetHash(), block_hash, tx_disk));
+
+    BOOST_REQUIRE(txindex.StartBackgroundSync());
+    IndexWaitSynced(txindex, *Assert(m_node.shutdown));
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+    txindex.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
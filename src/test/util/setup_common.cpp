@@ -239,12 +239,14 @@ ChainTestingSetup::ChainTestingSetup(const ChainType chainType, const std::vecto
         .check_block_index = true,
         .notifications = *m_node.notifications,
         .signals = m_node.validation_signals.get(),
-        .worker_threads_num = 2,
+        // As for the node, -par counts the thread calling into the chainstate manager.
+        .worker_threads_num = std::max(0, static_cast<int>(m_node.args->GetIntArg("-par", 3)) - 1),
     };
     const BlockManager::Options blockman_opts{
         .chainparams = chainman_opts.chainparams,
         .blocks_dir = m_args.GetBlocksDirPath(),
         .notifications = chainman_opts.notifications,
+        .block_map_files = static_cast<int>(m_node.args->GetIntArg("-blockmapfiles", 0)),
     };
     m_node.chainman = std::make_unique<ChainstateManager>(*Assert(m_node.shutdown), chainman_opts, blockman_opts);
     m_node.chainman->m_blockman.m_block_tree_db = std::make_unique<BlockTreeDB>(DBParams{
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 //
 #include <chainparams.h>
+#include <coins.h>
 #include <consensus/validation.h>
 #include <random.h>
 #include <rpc/blockchain.h>
@@ -11,6 +12,7 @@
 #include <test/util/coins.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
+#include <txdb.h>
 #include <uint256.h>
 #include <util/check.h>
 #include <validation.h>
@@ -62,6 +64,72 @@ BOOST_AUTO_TEST_CASE(validation_chainstate_resize_caches)
     }
 }
 
+//! Test that the coins snapshot follows the active chainstate as blocks are
+//! connected, and is dropped and restarted around reorganisations.
+BOOST_FIXTURE_TEST_CASE(chainstate_coins_snapshot, TestChain100Setup)
+{
+    ChainstateManager& chainman = *Assert(m_node.chainman);
+    Chainstate& chainstate = chainman.ActiveChainstate();
+
+    // A snapshot is started by a flush outside of initial block download.
+    chainstate.ForceFlushStateToDisk();
+    auto snapshot{chainman.GetCoinsSnapshot()};
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK_EQUAL(snapshot->GetBestBlock(), WITH_LOCK(::cs_main, return chainman.ActiveTip()->GetBlockHash()));
+    BOOST_CHECK_EQUAL(snapshot->GetHeight(), 100);
+
+    // Connect a block spending the first coinbase, without flushing.
+    const COutPoint spent{m_coinbase_txns[0]->GetHash(), 0};
+    const CMutableTransaction tx{CreateValidMempoolTransaction(m_coinbase_txns[0], /*input_vout=*/0, /*input_height=*/1,
+                                                              coinbaseKey, CScript() << OP_TRUE, /*output_amount=*/10 * COIN, /*submit=*/false)};
+    const COutPoint created{tx.GetHash(), 0};
+    CreateAndProcessBlock({tx}, CScript() << OP_TRUE);
+
+    const auto old_snapshot{snapshot};
+    snapshot = chainman.GetCoinsSnapshot();
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK_EQUAL(snapshot->GetHeight(), 101);
+    Coin coin;
+    BOOST_CHECK(!snapshot->HaveCoin(spent));
+    BOOST_CHECK(snapshot->GetCoin(created, coin));
+    BOOST_CHECK_EQUAL(coin.nHeight, 101U);
+    BOOST_CHECK_EQUAL(coin.out.nValue, 10 * COIN);
+    // Views handed out earlier don't change.
+    BOOST_CHECK(old_snapshot->HaveCoin(spent));
+    BOOST_CHECK(!old_snapshot->HaveCoin(created));
+
+    // Connect enough blocks for the changes to be merged, and compare with the tip cache.
+    mineBlocks(CCoinsViewSnapshot::MAX_CHANGES + 1);
+    snapshot = chainman.GetCoinsSnapshot();
+    BOOST_REQUIRE(snapshot);
+    {
+        LOCK(::cs_main);
+        BOOST_CHECK_EQUAL(snapshot->GetBestBlock(), chainstate.CoinsTip().GetBestBlock());
+        BOOST_CHECK_EQUAL(snapshot->GetHeight(), chainman.ActiveHeight());
+        BOOST_CHECK(!snapshot->HaveCoin(spent));
+        BOOST_CHECK(snapshot->HaveCoin(created));
+        for (const auto& coinbase : m_coinbase_txns) {
+            const COutPoint outpoint{coinbase->GetHash(), 0};
+            BOOST_CHECK_EQUAL(snapshot->HaveCoin(outpoint), chainstate.CoinsTip().HaveCoin(outpoint));
+        }
+    }
+
+    // Disconnecting blocks drops the snapshot, unless it was started again by a flush.
+    BlockValidationState state;
+    CBlockIndex* spending_block{WITH_LOCK(::cs_main, return chainman.ActiveChain()[101])};
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, spending_block));
+    snapshot = chainman.GetCoinsSnapshot();
+    BOOST_CHECK(!snapshot || snapshot->GetHeight() == 100);
+
+    chainstate.ForceFlushStateToDisk();
+    snapshot = chainman.GetCoinsSnapshot();
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK_EQUAL(snapshot->GetHeight(), 100);
+    BOOST_CHECK(snapshot->HaveCoin(spent));
+    BOOST_CHECK(!snapshot->HaveCoin(created));
+    BOOST_CHECK(old_snapshot->HaveCoin(spent));
+}
+
 //! Test UpdateTip behavior for both active and background chainstates.
 //!
 //! When run on the background chainstate, UpdateTip should do a subset
@@ -21,12 +21,16 @@
 
 #include <tinyformat.h>
 
+#include <utility>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
 
 using node::BlockManager;
 using node::KernelNotifications;
+using node::SNAPSHOT_VERSION_CHUNKED;
+using node::SnapshotChunk;
+using node::SnapshotChunkWriter;
 using node::SnapshotMetadata;
 
 BOOST_FIXTURE_TEST_SUITE(validation_chainstatemanager_tests, TestingSetup)
@@ -405,6 +409,93 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot, SnapshotTestSetup)
     this->SetupSnapshot();
 }
 
+//! Test activation of a snapshot with the coins in checksummed chunks.
+BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot_chunked, SnapshotTestSetup)
+{
+    ChainstateManager& chainman = *Assert(m_node.chainman);
+    mineBlocks(10);
+
+    BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
+        this, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
+            // Coins count is larger than coins in file
+            metadata.m_coins_count += 1;
+        }, /*reset_chainstate=*/false, /*in_memory_chainstate=*/false, SNAPSHOT_VERSION_CHUNKED));
+    BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
+        this, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
+            // Coins count is smaller than coins in file
+            metadata.m_coins_count -= 1;
+        }, /*reset_chainstate=*/false, /*in_memory_chainstate=*/false, SNAPSHOT_VERSION_CHUNKED));
+    BOOST_CHECK(!chainman.IsSnapshotActive());
+
+    BOOST_REQUIRE(CreateAndActivateUTXOSnapshot(
+        this, NoMalleation, /*reset_chainstate=*/false, /*in_memory_chainstate=*/false, SNAPSHOT_VERSION_CHUNKED));
+    BOOST_CHECK(chainman.IsSnapshotActive());
+
+    LOCK(::cs_main);
+    CCoinsViewCache& snapshot_coins{chainman.ActiveChainstate().CoinsTip()};
+    for (const CTransactionRef& txn : m_coinbase_txns) {
+        const Coin& coin{snapshot_coins.AccessCoin(COutPoint{txn->GetHash(), 0})};
+        BOOST_CHECK(coin.out == txn->vout[0]);
+        BOOST_CHECK(coin.fCoinBase);
+    }
+}
+
+//! Test that chunks of a snapshot decode into the coins written, and that
+//! corrupt chunks are rejected.
+BOOST_FIXTURE_TEST_CASE(snapshot_chunk_roundtrip, BasicTestingSetup)
+{
+    const fs::path path{m_path_root / "chunks.dat"};
+    std::vector<std::pair<COutPoint, Coin>> coins_in;
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        SnapshotChunkWriter writer{file};
+        for (uint8_t i = 1; i <= 3; ++i) {
+            const Txid txid{Txid::FromUint256(uint256{i})};
+            std::vector<std::pair<uint32_t, Coin>> tx_coins;
+            for (uint32_t n : {0U, 2U, 1000U}) {
+                // The last output of each transaction is in a group of its own.
+                Coin coin{CTxOut{n * COIN, CScript() << OP_TRUE << int64_t{n}}, 100 + i + (n == 1000), i == 1};
+                tx_coins.emplace_back(n, coin);
+                coins_in.emplace_back(COutPoint{txid, n}, coin);
+            }
+            writer.AddCoins(txid, tx_coins);
+        }
+        writer.Finish();
+        BOOST_REQUIRE_EQUAL(file.fclose(), 0);
+    }
+
+    AutoFile file{fsbridge::fopen(path, "rb")};
+    SnapshotChunk chunk;
+    file >> chunk;
+    BOOST_CHECK_EQUAL(chunk.coins_count, coins_in.size());
+
+    std::vector<std::pair<COutPoint, Coin>> coins_out;
+    std::string error;
+    BOOST_REQUIRE(node::DecodeSnapshotChunk(chunk, /*max_height=*/104, coins_out, error));
+    BOOST_REQUIRE_EQUAL(coins_out.size(), coins_in.size());
+    for (size_t i = 0; i < coins_in.size(); ++i) {
+        BOOST_CHECK(coins_out[i].first == coins_in[i].first);
+        BOOST_CHECK(coins_out[i].second.out == coins_in[i].second.out);
+        BOOST_CHECK_EQUAL(coins_out[i].second.nHeight, coins_in[i].second.nHeight);
+        BOOST_CHECK_EQUAL(coins_out[i].second.fCoinBase, coins_in[i].second.fCoinBase);
+    }
+
+    // Coins above the snapshot base are rejected.
+    BOOST_CHECK(!node::DecodeSnapshotChunk(chunk, /*max_height=*/103, coins_out, error));
+    BOOST_CHECK(error.starts_with("bad coin height"));
+
+    // So is a chunk with a wrong coins count...
+    SnapshotChunk bad_count{chunk};
+    --bad_count.coins_count;
+    BOOST_CHECK(!node::DecodeSnapshotChunk(bad_count, /*max_height=*/104, coins_out, error));
+
+    // ...or data that does not match its checksum.
+    SnapshotChunk bad_data{chunk};
+    bad_data.data.back() ^= 1;
+    BOOST_CHECK(!node::DecodeSnapshotChunk(bad_data, /*max_height=*/104, coins_out, error));
+    BOOST_CHECK_EQUAL(error, "chunk checksum mismatch");
+}
+
 //! Test LoadBlockIndex behavior when multiple chainstates are in use.
 //!
 //! - First, verify that setBlockIndexCandidates is as expected when using a single,
@@ -12,12 +12,17 @@
 #include <random.h>
 #include <serialize.h>
 #include <uint256.h>
+#include <util/threadnames.h>
+#include <util/time.h>
 #include <util/vector.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <iterator>
+#include <memory>
 #include <utility>
+#include <vector>
 
 static constexpr uint8_t DB_COIN{'C'};
 static constexpr uint8_t DB_BEST_BLOCK{'B'};
@@ -44,6 +49,17 @@ struct CoinEntry {
     SERIALIZE_METHODS(CoinEntry, obj) { READWRITE(obj.key, obj.outpoint->hash, VARINT(obj.outpoint->n)); }
 };
 
+//! Whether the database key of coin a sorts before the one of coin b.
+bool CoinKeyLess(const COutPoint& a, const COutPoint& b)
+{
+    if (a.hash != b.hash) return a.hash < b.hash;
+    // VARINT does not keep the order of large output indexes.
+    DataStream key_a, key_b;
+    key_a << CoinEntry(&a);
+    key_b << CoinEntry(&b);
+    return std::lexicographical_compare(key_a.begin(), key_a.end(), key_b.begin(), key_b.end());
+}
+
 } // namespace
 
 CCoinsViewDB::CCoinsViewDB(DBParams db_params, CoinsViewOptions options) :
@@ -51,8 +67,21 @@ CCoinsViewDB::CCoinsViewDB(DBParams db_params, CoinsViewOptions options) :
     m_options{std::move(options)},
     m_db{std::make_unique<CDBWrapper>(m_db_params)} { }
 
+CCoinsViewDB::~CCoinsViewDB()
+{
+    WaitForSnapshots();
+    if (m_write_thread.joinable()) {
+        m_write_thread.join();
+        if (!WITH_LOCK(m_pending_mutex, return m_background_write_ok)) {
+            LogPrintLevel(BCLog::COINDB, BCLog::Level::Error, "Background write of the coins database failed\n");
+        }
+    }
+}
+
 void CCoinsViewDB::ResizeCache(size_t new_cache_size)
 {
+    WaitForBackgroundWrite();
+    WaitForSnapshots();
     // We can't do this operation with an in-memory DB since we'll lose all the coins upon
     // reset.
     if (!m_db_params.memory_only) {
@@ -66,14 +95,33 @@ void CCoinsViewDB::ResizeCache(size_t new_cache_size)
 }
 
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
+    if (const auto pending{WITH_LOCK(m_pending_mutex, return m_pending)}) {
+        if (const auto it{pending->coins.find(outpoint)}; it != pending->coins.end()) {
+            if (it->second.coin.IsSpent()) return false;
+            coin = it->second.coin;
+            return true;
+        }
+    }
     return m_db->Read(CoinEntry(&outpoint), coin);
 }
 
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
+    if (const auto pending{WITH_LOCK(m_pending_mutex, return m_pending)}) {
+        if (const auto it{pending->coins.find(outpoint)}; it != pending->coins.end()) {
+            return !it->second.coin.IsSpent();
+        }
+    }
     return m_db->Exists(CoinEntry(&outpoint));
 }
 
 uint256 CCoinsViewDB::GetBestBlock() const {
+    if (const auto pending{WITH_LOCK(m_pending_mutex, return m_pending)}) {
+        return pending->best_block;
+    }
+    return ReadBestBlock();
+}
+
+uint256 CCoinsViewDB::ReadBestBlock() const {
     uint256 hashBestChain;
     if (!m_db->Read(DB_BEST_BLOCK, hashBestChain))
         return uint256();
@@ -89,12 +137,164 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) {
+    if (!WaitForBackgroundWrite()) return false;
+    return WriteCoins(mapCoins, hashBlock, erase, /*background=*/false);
+}
+
+bool CCoinsViewDB::BatchWriteInBackground(std::shared_ptr<CoinsWriteBatch> batch)
+{
+    assert(batch && !batch->best_block.IsNull());
+    if (!WaitForBackgroundWrite()) return false;
+    if (m_write_thread.joinable()) m_write_thread.join();
+    {
+        LOCK(m_pending_mutex);
+        m_pending = batch;
+        m_flush_stats.in_progress = true;
+    }
+    m_write_thread = std::thread([this, batch = std::move(batch)] {
+        util::ThreadRename("coinsflush");
+        bool ok{false};
+        try {
+            ok = WriteCoins(batch->coins, batch->best_block, /*erase=*/false, /*background=*/true);
+        } catch (const std::exception& e) {
+            LogPrintLevel(BCLog::COINDB, BCLog::Level::Error, "Background write of the coins database failed: %s\n", e.what());
+        }
+        // Views that read the batch move to a database snapshot that has it,
+        // taken before anything else can be written. Their old snapshots, and
+        // any view freed meanwhile, are released without m_pending_mutex held.
+        std::vector<std::shared_ptr<CCoinsViewSnapshot::Base>> bases;
+        std::vector<std::shared_ptr<const CDBSnapshot>> old_snapshots;
+        {
+            LOCK(m_pending_mutex);
+            if (ok) {
+                for (const auto& view_base : m_pending_views) {
+                    auto base{view_base.lock()};
+                    if (!base) continue;
+                    auto db_snapshot{NewTrackedSnapshot()};
+                    LOCK(base->mutex);
+                    old_snapshots.push_back(std::exchange(base->db_snapshot, std::move(db_snapshot)));
+                    base->pending.reset();
+                    bases.push_back(std::move(base));
+                }
+            }
+            m_pending_views.clear();
+            m_pending.reset();
+            m_flush_stats.in_progress = false;
+            m_background_write_ok = ok;
+        }
+        m_pending_cv.notify_all();
+    });
+    return true;
+}
+
+bool CCoinsViewDB::WaitForBackgroundWrite() const
+{
+    WAIT_LOCK(m_pending_mutex, lock);
+    m_pending_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_pending_mutex) { return m_pending == nullptr; });
+    return m_background_write_ok;
+}
+
+CoinsFlushStats CCoinsViewDB::GetFlushStats() const
+{
+    return WITH_LOCK(m_pending_mutex, return m_flush_stats);
+}
+
+std::shared_ptr<const CDBSnapshot> CCoinsViewDB::NewTrackedSnapshot() const
+{
+    std::shared_ptr<const CDBSnapshot> db_snapshot{m_db->NewSnapshot().release(), [this](const CDBSnapshot* snapshot) {
+        delete snapshot;
+        WITH_LOCK(m_pending_mutex, --m_snapshots);
+        m_pending_cv.notify_all();
+    }};
+    ++m_snapshots;
+    return db_snapshot;
+}
+
+std::shared_ptr<CCoinsViewSnapshot> CCoinsViewDB::GetSnapshot(int height) const
+{
+    LOCK(m_pending_mutex);
+    // Holding m_pending_mutex, a background write can neither start nor
+    // finish, so the pending batch covers anything it has written so far.
+    auto base{std::make_shared<CCoinsViewSnapshot::Base>()};
+    {
+        LOCK(base->mutex);
+        base->db_snapshot = NewTrackedSnapshot();
+        base->pending = m_pending;
+    }
+    if (m_pending) m_pending_views.push_back(base);
+    return std::make_shared<CCoinsViewSnapshot>(std::move(base), *m_db, std::vector<std::shared_ptr<const CCoinsViewSnapshot::Changes>>{},
+                                                m_pending ? m_pending->best_block : ReadBestBlock(), height);
+}
+
+void CCoinsViewDB::WaitForSnapshots() const
+{
+    WAIT_LOCK(m_pending_mutex, lock);
+    m_pending_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_pending_mutex) { return m_snapshots == 0; });
+}
+
+CCoinsViewSnapshot::CCoinsViewSnapshot(std::shared_ptr<const Base> base, const CDBWrapper& db,
+                                       std::vector<std::shared_ptr<const Changes>> changes, const uint256& best_block, int height)
+    : m_base{std::move(base)},
+      m_db{db},
+      m_changes{std::move(changes)},
+      m_best_block{best_block},
+      m_height{height} {}
+
+bool CCoinsViewSnapshot::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    for (auto changes{m_changes.rbegin()}; changes != m_changes.rend(); ++changes) {
+        if (const auto it{(*changes)->find(outpoint)}; it != (*changes)->end()) {
+            if (it->second.IsSpent()) return false;
+            coin = it->second;
+            return true;
+        }
+    }
+    std::shared_ptr<const CDBSnapshot> db_snapshot;
+    std::shared_ptr<const CoinsWriteBatch> pending;
+    {
+        LOCK(m_base->mutex);
+        db_snapshot = m_base->db_snapshot;
+        pending = m_base->pending;
+    }
+    if (pending) {
+        if (const auto it{pending->coins.find(outpoint)}; it != pending->coins.end()) {
+            if (it->second.coin.IsSpent()) return false;
+            coin = it->second.coin;
+            return true;
+        }
+    }
+    return m_db.Read(CoinEntry(&outpoint), coin, db_snapshot.get());
+}
+
+std::shared_ptr<CCoinsViewSnapshot> CCoinsViewSnapshot::Extend(std::shared_ptr<const Changes> changes, const uint256& block_hash, int height) const
+{
+    std::vector<std::shared_ptr<const Changes>> all_changes;
+    if (m_changes.size() < MAX_CHANGES) {
+        all_changes = m_changes;
+    } else {
+        // Merge the changes of all blocks so far, the newest winning.
+        auto merged{std::make_shared<Changes>()};
+        for (const auto& block_changes : m_changes) {
+            for (const auto& [outpoint, coin] : *block_changes) {
+                merged->insert_or_assign(outpoint, coin);
+            }
+        }
+        all_changes.push_back(std::move(merged));
+    }
+    all_changes.push_back(std::move(changes));
+    return std::make_shared<CCoinsViewSnapshot>(m_base, m_db, std::move(all_changes), block_hash, height);
+}
+
+bool CCoinsViewDB::WriteCoins(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase, bool background)
+{
+    const auto start{SteadyClock::now()};
     CDBBatch batch(*m_db);
     size_t count = 0;
     size_t changed = 0;
+    size_t bytes = 0;
     assert(!hashBlock.IsNull());
 
-    uint256 old_tip = GetBestBlock();
+    uint256 old_tip = ReadBestBlock();
     if (old_tip.IsNull()) {
         // We may be in the middle of replaying.
         std::vector<uint256> old_heads = GetHeadBlocks();
@@ -114,26 +314,67 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, boo
     batch.Erase(DB_BEST_BLOCK);
     batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
 
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
-        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
-            CoinEntry entry(&it->first);
-            if (it->second.coin.IsSpent())
-                batch.Erase(entry);
-            else
-                batch.Write(entry, it->second.coin);
-            changed++;
+    // Large flushes are written as a bulk load, in key order, where allowed.
+    // This skips the log and memtable and, for the disjoint key ranges of a
+    // snapshot being loaded, leaves nothing to compact. leveldb rejects the
+    // bulk load if a database snapshot is taken while it is written, so it is
+    // not attempted while any are in use.
+    bool bulk_loaded{false};
+    if (!background && m_bulk_load && m_options.bulk_load_min_coins > 0 && mapCoins.size() >= m_options.bulk_load_min_coins &&
+        WITH_LOCK(m_pending_mutex, return m_snapshots == 0)) {
+        std::vector<CCoinsMap::iterator> dirty;
+        for (auto it{mapCoins.begin()}; it != mapCoins.end(); ++it) {
+            if (it->second.flags & CCoinsCacheEntry::DIRTY) dirty.push_back(it);
         }
-        count++;
-        it = erase ? mapCoins.erase(it) : std::next(it);
-        if (batch.SizeEstimate() > m_options.batch_write_bytes) {
-            LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-            m_db->WriteBatch(batch);
+        if (dirty.size() >= m_options.bulk_load_min_coins) {
+            // The coins bypass the log, so the marker must be on disk before them.
+            bytes += batch.SizeEstimate();
+            m_db->WriteBatch(batch, /*fSync=*/true);
             batch.Clear();
-            if (m_options.simulate_crash_ratio) {
-                static FastRandomContext rng;
-                if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
-                    LogPrintf("Simulating a crash. Goodbye.\n");
-                    _Exit(0);
+
+            std::sort(dirty.begin(), dirty.end(), [](const auto& a, const auto& b) { return CoinKeyLess(a->first, b->first); });
+            const std::unique_ptr<CDBBulkLoad> bulk_load{m_db->NewBulkLoad()};
+            for (const auto& it : dirty) {
+                CoinEntry entry(&it->first);
+                if (it->second.coin.IsSpent())
+                    bulk_load->Erase(entry);
+                else
+                    bulk_load->Write(entry, it->second.coin);
+            }
+            bulk_loaded = m_db->WriteBulkLoad(*bulk_load);
+            if (bulk_loaded) {
+                LogPrint(BCLog::COINDB, "Wrote bulk load of %.2f MiB\n", bulk_load->SizeEstimate() * (1.0 / 1048576.0));
+                bytes += bulk_load->SizeEstimate();
+                changed = dirty.size();
+                count = mapCoins.size();
+                if (erase) mapCoins.clear();
+            }
+        }
+    }
+
+    if (!bulk_loaded) {
+        for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+            if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+                CoinEntry entry(&it->first);
+                if (it->second.coin.IsSpent())
+                    batch.Erase(entry);
+                else
+                    batch.Write(entry, it->second.coin);
+                changed++;
+            }
+            count++;
+            it = erase ? mapCoins.erase(it) : std::next(it);
+            if (batch.SizeEstimate() > m_options.batch_write_bytes) {
+                LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
+                bytes += batch.SizeEstimate();
+                m_db->WriteBatch(batch);
+                batch.Clear();
+                if (m_options.simulate_crash_ratio) {
+                    static FastRandomContext rng;
+                    if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
+                        LogPrintf("Simulating a crash. Goodbye.\n");
+                        _Exit(0);
+                    }
                 }
             }
         }
@@ -144,8 +385,20 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, boo
     batch.Write(DB_BEST_BLOCK, hashBlock);
 
     LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
+    bytes += batch.SizeEstimate();
     bool ret = m_db->WriteBatch(batch);
-    LogPrint(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
+    const auto duration{SteadyClock::now() - start};
+    LogPrint(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database%s in %dms...\n",
+             (unsigned int)changed, (unsigned int)count, background ? " in the background" : "", Ticks<std::chrono::milliseconds>(duration));
+    if (ret) {
+        LOCK(m_pending_mutex);
+        ++m_flush_stats.flushes;
+        m_flush_stats.last_background = background;
+        m_flush_stats.last_duration = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+        m_flush_stats.last_coins = changed;
+        m_flush_stats.last_bytes = bytes;
+        m_flush_stats.total_bytes += bytes;
+    }
     return ret;
 }
 
@@ -162,6 +415,8 @@ public:
     // cache warmup on instantiation.
     CCoinsViewDBCursor(CDBIterator* pcursorIn, const uint256&hashBlockIn):
         CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn) {}
+    CCoinsViewDBCursor(std::shared_ptr<const CDBSnapshot> snapshot, CDBIterator* pcursorIn, const uint256& hashBlockIn, uint32_t end_prefix) :
+        CCoinsViewCursor(hashBlockIn), m_snapshot(std::move(snapshot)), pcursor(pcursorIn), m_end_prefix(end_prefix) {}
     ~CCoinsViewDBCursor() = default;
 
     bool GetKey(COutPoint &key) const override;
@@ -171,14 +426,29 @@ public:
     void Next() override;
 
 private:
+    //! The snapshot pcursor reads from, if any. Declared first so that it outlives pcursor.
+    std::shared_ptr<const CDBSnapshot> m_snapshot;
     std::unique_ptr<CDBIterator> pcursor;
     std::pair<char, COutPoint> keyTmp;
+    //! 16-bit txid prefix the cursor stops at, 0x10000 to iterate to the last coin.
+    uint32_t m_end_prefix{0x10000};
+
+    //! Cache the key pcursor is at, or make Valid() return false if it is past the coins of this cursor.
+    void CacheKey();
 
     friend class CCoinsViewDB;
 };
 
+/** The first two bytes of a txid, as an integer, by which ShardedCursors() splits the coins. */
+static uint32_t TxidPrefix(const Txid& txid)
+{
+    return 0x100 * *UCharCast(txid.begin()) + *(UCharCast(txid.begin()) + 1);
+}
+
 std::unique_ptr<CCoinsViewCursor> CCoinsViewDB::Cursor() const
 {
+    // The cursor reads the database directly, so let any pending write land first.
+    WaitForBackgroundWrite();
     auto i = std::make_unique<CCoinsViewDBCursor>(
         const_cast<CDBWrapper&>(*m_db).NewIterator(), GetBestBlock());
     /* It seems that there are no "const iterators" for LevelDB.  Since we
@@ -186,16 +456,36 @@ std::unique_ptr<CCoinsViewCursor> CCoinsViewDB::Cursor() const
        that restriction.  */
     i->pcursor->Seek(DB_COIN);
     // Cache key of first record
-    if (i->pcursor->Valid()) {
-        CoinEntry entry(&i->keyTmp.second);
-        i->pcursor->GetKey(entry);
-        i->keyTmp.first = entry.key;
-    } else {
-        i->keyTmp.first = 0; // Make sure Valid() and GetKey() return false
-    }
+    i->CacheKey();
     return i;
 }
 
+std::vector<std::unique_ptr<CCoinsViewCursor>> CCoinsViewDB::ShardedCursors(size_t count) const
+{
+    assert(count > 0 && count <= 0x10000);
+    // The cursors read the database directly, so let any pending write land first.
+    WaitForBackgroundWrite();
+    const std::shared_ptr<const CDBSnapshot> snapshot{WITH_LOCK(m_pending_mutex, return NewTrackedSnapshot())};
+    uint256 best_block;
+    if (!m_db->Read(DB_BEST_BLOCK, best_block, snapshot.get())) best_block.SetNull();
+
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    for (size_t shard = 0; shard < count; ++shard) {
+        const uint32_t begin_prefix = shard * 0x10000 / count;
+        const uint32_t end_prefix = (shard + 1) * 0x10000 / count;
+        auto i = std::make_unique<CCoinsViewDBCursor>(
+            snapshot, const_cast<CDBWrapper&>(*m_db).NewIterator(snapshot.get()), best_block, end_prefix);
+        uint256 begin_txid;
+        begin_txid.begin()[0] = begin_prefix >> 8;
+        begin_txid.begin()[1] = begin_prefix & 0xff;
+        const COutPoint begin{Txid::FromUint256(begin_txid), 0};
+        i->pcursor->Seek(CoinEntry(&begin));
+        i->CacheKey();
+        cursors.push_back(std::move(i));
+    }
+    return cursors;
+}
+
 bool CCoinsViewDBCursor::GetKey(COutPoint &key) const
 {
     // Return cached key
@@ -219,8 +509,14 @@ bool CCoinsViewDBCursor::Valid() const
 void CCoinsViewDBCursor::Next()
 {
     pcursor->Next();
+    CacheKey();
+}
+
+void CCoinsViewDBCursor::CacheKey()
+{
     CoinEntry entry(&keyTmp.second);
-    if (!pcursor->Valid() || !pcursor->GetKey(entry)) {
+    if (!pcursor->Valid() || !pcursor->GetKey(entry) ||
+        (entry.key == DB_COIN && TxidPrefix(keyTmp.second.hash) >= m_end_prefix)) {
         keyTmp.first = 0; // Invalidate cached key after last record so that Valid() and GetKey() return false
     } else {
         keyTmp.first = entry.key;
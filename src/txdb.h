@@ -12,10 +12,15 @@
 #include <sync.h>
 #include <util/fs.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 class COutPoint;
@@ -39,6 +44,10 @@ static const int64_t nMaxTxIndexCache = 1024;
 static const int64_t max_filter_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! -dbbackgroundflush default
+static constexpr bool DEFAULT_DB_BACKGROUND_FLUSH{false};
+//! -dbbulkloadmincoins default (0 disables bulk loads)
+static constexpr size_t DEFAULT_DB_BULK_LOAD_MIN_COINS{0};
 
 //! User-controlled performance and debug options.
 struct CoinsViewOptions {
@@ -47,17 +56,136 @@ struct CoinsViewOptions {
     //! If non-zero, randomly exit when the database is flushed with (1/ratio)
     //! probability.
     int simulate_crash_ratio = 0;
+    //! Write coins cache flushes on a background thread instead of the
+    //! flushing thread, where the caller allows it.
+    bool background_flush = DEFAULT_DB_BACKGROUND_FLUSH;
+    //! Write flushes with at least this many changed coins as a bulk load,
+    //! sorted into a table of their own, instead of in batches, where the
+    //! caller allows it, see CCoinsViewDB::SetBulkLoad(). 0 disables this.
+    size_t bulk_load_min_coins = DEFAULT_DB_BULK_LOAD_MIN_COINS;
 };
 
-/** CCoinsView backed by the coin database (chainstate/) */
+/** Dirty coins taken out of a cache, to be written by CCoinsViewDB::BatchWriteInBackground(). */
+struct CoinsWriteBatch {
+    //! Backs coins, so that the batch does not depend on the memory of the cache it was taken from.
+    CCoinsMapMemoryResource resource{};
+    CCoinsMap coins{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
+    uint256 best_block;
+};
+
+/** Statistics about the writes of a CCoinsViewDB, see CCoinsViewDB::GetFlushStats(). */
+struct CoinsFlushStats {
+    //! Number of completed writes.
+    uint64_t flushes{0};
+    //! Whether a background write is still in progress.
+    bool in_progress{false};
+    //! Whether the last completed write ran in the background.
+    bool last_background{false};
+    //! Duration, changed coins and estimated bytes of the last completed write.
+    std::chrono::milliseconds last_duration{0};
+    uint64_t last_coins{0};
+    uint64_t last_bytes{0};
+    //! Estimated bytes written by all completed writes.
+    uint64_t total_bytes{0};
+};
+
+/**
+ * Read-only view of the UTXO set as of a block, for lookups without cs_main.
+ *
+ * It consists of a snapshot of the coin database, including any background
+ * write that was in progress when it was taken, and the coins changed by each
+ * block connected on top of that, which are looked up first, newest block
+ * first. What it returns never changes after construction, so a view can be
+ * used by any number of threads while the chainstate moves on.
+ *
+ * A background write is only held on to until it has landed: the views reading
+ * it are then moved to a database snapshot that includes it, see
+ * CCoinsViewDB::BatchWriteInBackground().
+ *
+ * Views are created by CCoinsViewDB::GetSnapshot() and must not outlive the
+ * CCoinsViewDB, whose ResizeCache() and destructor wait for them to be gone.
+ */
+class CCoinsViewSnapshot final : public CCoinsView
+{
+public:
+    //! Coins created and spent by a block, spent coins being IsSpent().
+    using Changes = std::unordered_map<COutPoint, Coin, SaltedOutpointHasher>;
+    //! Number of blocks of changes after which they are merged into one map,
+    //! bounding the number of lookups per GetCoin().
+    static constexpr size_t MAX_CHANGES{16};
+
+    //! The database state below the changes, shared by a view and the views extended from it.
+    struct Base {
+        mutable Mutex mutex;
+        std::shared_ptr<const CDBSnapshot> db_snapshot GUARDED_BY(mutex);
+        //! Background write in progress when the database snapshot was taken, if any.
+        std::shared_ptr<const CoinsWriteBatch> pending GUARDED_BY(mutex);
+    };
+
+    CCoinsViewSnapshot(std::shared_ptr<const Base> base, const CDBWrapper& db,
+                       std::vector<std::shared_ptr<const Changes>> changes, const uint256& best_block, int height);
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override;
+    uint256 GetBestBlock() const override { return m_best_block; }
+    //! Height of the block returned by GetBestBlock().
+    int GetHeight() const { return m_height; }
+
+    //! Return a view of the UTXO set after a block with the given changes was connected on top of this one.
+    std::shared_ptr<CCoinsViewSnapshot> Extend(std::shared_ptr<const Changes> changes, const uint256& block_hash, int height) const;
+
+private:
+    const std::shared_ptr<const Base> m_base;
+    const CDBWrapper& m_db;
+    const std::vector<std::shared_ptr<const Changes>> m_changes;
+    const uint256 m_best_block;
+    const int m_height;
+};
+
+/**
+ * CCoinsView backed by the coin database (chainstate/)
+ *
+ * Writes can be handed to a background thread with BatchWriteInBackground().
+ * Until such a write completes, lookups are answered from the batch being
+ * written before the database, so the view never exposes a partially written
+ * state, and a crash leaves the database marked as in transition through the
+ * head blocks, exactly as an interrupted synchronous BatchWrite() would.
+ */
 class CCoinsViewDB final : public CCoinsView
 {
 protected:
     DBParams m_db_params;
     CoinsViewOptions m_options;
     std::unique_ptr<CDBWrapper> m_db;
+
+    mutable Mutex m_pending_mutex;
+    //! Signalled when a background write finishes.
+    mutable std::condition_variable m_pending_cv;
+    //! The batch being written in the background, if any.
+    std::shared_ptr<CoinsWriteBatch> m_pending GUARDED_BY(m_pending_mutex);
+    CoinsFlushStats m_flush_stats GUARDED_BY(m_pending_mutex);
+    //! Result of the last background write, read once it has been joined.
+    bool m_background_write_ok GUARDED_BY(m_pending_mutex){true};
+    //! Bases of the views that read m_pending, to be moved to the database once it is written.
+    mutable std::vector<std::weak_ptr<CCoinsViewSnapshot::Base>> m_pending_views GUARDED_BY(m_pending_mutex);
+    //! Number of database snapshots handed out by GetSnapshot() or ShardedCursors() still in use.
+    mutable size_t m_snapshots GUARDED_BY(m_pending_mutex){0};
+    std::thread m_write_thread;
+    //! Whether large synchronous writes may be bulk loads, see SetBulkLoad().
+    std::atomic_bool m_bulk_load{false};
+
+    //! Read the best block as stored in the database, ignoring any pending batch.
+    uint256 ReadBestBlock() const;
+    //! Take a database snapshot that is counted in m_snapshots until it is destroyed.
+    std::shared_ptr<const CDBSnapshot> NewTrackedSnapshot() const EXCLUSIVE_LOCKS_REQUIRED(m_pending_mutex);
+    //! Wait until no view or cursor created from a tracked snapshot is left.
+    void WaitForSnapshots() const EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+    //! Write the dirty entries of mapCoins to the database in chunks of at most
+    //! batch_write_bytes, and account for the write in m_flush_stats.
+    bool WriteCoins(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase, bool background) EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
 public:
     explicit CCoinsViewDB(DBParams db_params, CoinsViewOptions options);
+    ~CCoinsViewDB();
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
@@ -66,6 +194,56 @@ public:
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
 
+    /**
+     * Return count cursors over disjoint ranges of the coins, which together
+     * cover all of them. Cursor i has the coins whose txid starts with a
+     * 16-bit prefix (first byte * 256 + second byte) in the range
+     * [i * 0x10000 / count, (i + 1) * 0x10000 / count).
+     *
+     * The cursors read from the same snapshot of the database, so they are
+     * consistent with each other and each can be used by a different thread.
+     */
+    std::vector<std::unique_ptr<CCoinsViewCursor>> ShardedCursors(size_t count) const EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
+    /**
+     * Write batch to the database on a background thread, after waiting for
+     * any earlier background write to finish. Lookups through this view see
+     * the contents of batch until the write completes. Views from
+     * GetSnapshot() see them too, and once the write has succeeded are moved
+     * to a new database snapshot, so that batch can be freed.
+     *
+     * The caller must make sure nothing reads the coins in batch from the view
+     * it took them from between taking them and calling this.
+     *
+     * @returns false if the earlier background write failed, in which case
+     *          batch is not written.
+     */
+    bool BatchWriteInBackground(std::shared_ptr<CoinsWriteBatch> batch) EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
+    //! Wait for a background write to finish. Returns false if it failed.
+    bool WaitForBackgroundWrite() const EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
+    //! Whether flushes may be written with BatchWriteInBackground().
+    bool BackgroundFlushEnabled() const { return m_options.background_flush; }
+
+    /**
+     * Allow or stop writing flushes of at least bulk_load_min_coins changed
+     * coins as bulk loads. Meant for writing many new coins at once, like
+     * while loading a UTXO snapshot or at the end of -reindex-chainstate.
+     * A bulk load is only written while no database snapshot from
+     * GetSnapshot() or ShardedCursors() is in use.
+     */
+    void SetBulkLoad(bool bulk_load) { m_bulk_load = bulk_load; }
+
+    CoinsFlushStats GetFlushStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
+    /**
+     * Return a read-only view of the coins in this database, including a
+     * background write in progress, which stays the same as the database is
+     * written to. The caller supplies the height of GetBestBlock().
+     */
+    std::shared_ptr<CCoinsViewSnapshot> GetSnapshot(int height) const EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
     //! Whether an unsupported database format is used.
     bool NeedsUpgrade();
     size_t EstimateSize() const override;
@@ -52,8 +52,8 @@ bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
                                       const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove)
 {
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
+    std::set<CTxMemPoolEntryRef, CompareIteratorByHash> stageEntries, descendants;
+    stageEntries.insert(updateIt->GetMemPoolChildrenConst().begin(), updateIt->GetMemPoolChildrenConst().end());
 
     while (!stageEntries.empty()) {
         const CTxMemPoolEntry& descendant = *stageEntries.begin();
@@ -112,6 +112,9 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
     // accounted for in the state of their ancestors)
     std::set<uint256> setAlreadyIncluded(vHashesToUpdate.begin(), vHashesToUpdate.end());
 
+    // Links change without a change of nTransactionsUpdated.
+    if (!vHashesToUpdate.empty()) m_ancestry_cache.clear();
+
     std::set<uint256> descendants_to_remove;
 
     // Iterate in reverse, so that whenever we are looking at a transaction
@@ -158,43 +161,42 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
 util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateAncestorsAndCheckLimits(
     int64_t entry_size,
     size_t entry_count,
-    CTxMemPoolEntry::Parents& staged_ancestors,
+    AncestorWorkList& ancestors,
     const Limits& limits) const
 {
     int64_t totalSizeWithAncestors = entry_size;
-    setEntries ancestors;
-
-    while (!staged_ancestors.empty()) {
-        const CTxMemPoolEntry& stage = staged_ancestors.begin()->get();
-        txiter stageit = mapTx.iterator_to(stage);
 
-        ancestors.insert(stageit);
-        staged_ancestors.erase(stage);
-        totalSizeWithAncestors += stageit->GetTxSize();
+    // Entries before index i have been processed; the others are staged. All of them were
+    // marked visited when added, so each is added once without a set lookup.
+    for (size_t i = 0; i < ancestors.size(); ++i) {
+        const CTxMemPoolEntry& stage = *ancestors[i];
+        totalSizeWithAncestors += stage.GetTxSize();
 
-        if (stageit->GetSizeWithDescendants() + entry_size > limits.descendant_size_vbytes) {
-            return util::Error{Untranslated(strprintf("exceeds descendant size limit for tx %s [limit: %u]", stageit->GetTx().GetHash().ToString(), limits.descendant_size_vbytes))};
-        } else if (stageit->GetCountWithDescendants() + entry_count > static_cast<uint64_t>(limits.descendant_count)) {
-            return util::Error{Untranslated(strprintf("too many descendants for tx %s [limit: %u]", stageit->GetTx().GetHash().ToString(), limits.descendant_count))};
+        if (stage.GetSizeWithDescendants() + entry_size > limits.descendant_size_vbytes) {
+            return util::Error{Untranslated(strprintf("exceeds descendant size limit for tx %s [limit: %u]", stage.GetTx().GetHash().ToString(), limits.descendant_size_vbytes))};
+        } else if (stage.GetCountWithDescendants() + entry_count > static_cast<uint64_t>(limits.descendant_count)) {
+            return util::Error{Untranslated(strprintf("too many descendants for tx %s [limit: %u]", stage.GetTx().GetHash().ToString(), limits.descendant_count))};
         } else if (totalSizeWithAncestors > limits.ancestor_size_vbytes) {
             return util::Error{Untranslated(strprintf("exceeds ancestor size limit [limit: %u]", limits.ancestor_size_vbytes))};
         }
 
-        const CTxMemPoolEntry::Parents& parents = stageit->GetMemPoolParentsConst();
+        const CTxMemPoolEntry::Parents& parents = stage.GetMemPoolParentsConst();
         for (const CTxMemPoolEntry& parent : parents) {
-            txiter parent_it = mapTx.iterator_to(parent);
-
             // If this is a new ancestor, add it.
-            if (ancestors.count(parent_it) == 0) {
-                staged_ancestors.insert(parent);
+            if (!visited(parent)) {
+                ancestors.push_back(&parent);
             }
-            if (staged_ancestors.size() + ancestors.size() + entry_count > static_cast<uint64_t>(limits.ancestor_count)) {
+            if (ancestors.size() + entry_count > static_cast<uint64_t>(limits.ancestor_count)) {
                 return util::Error{Untranslated(strprintf("too many unconfirmed ancestors [limit: %u]", limits.ancestor_count))};
             }
         }
     }
 
-    return ancestors;
+    setEntries result;
+    for (const CTxMemPoolEntry* ancestor : ancestors) {
+        result.insert(mapTx.iterator_to(*ancestor));
+    }
+    return result;
 }
 
 util::Result<void> CTxMemPool::CheckPackageLimits(const Package& package,
@@ -213,12 +215,13 @@ util::Result<void> CTxMemPool::CheckPackageLimits(const Package& package,
         return util::Error{Untranslated(strprintf("package size %u exceeds descendant size limit [limit: %u]", total_vsize, m_opts.limits.descendant_size_vbytes))};
     }
 
-    CTxMemPoolEntry::Parents staged_ancestors;
+    WITH_FRESH_EPOCH(m_epoch);
+    AncestorWorkList staged_ancestors;
     for (const auto& tx : package) {
         for (const auto& input : tx->vin) {
             std::optional<txiter> piter = GetIter(input.prevout.hash);
-            if (piter) {
-                staged_ancestors.insert(**piter);
+            if (piter && !visited(*piter)) {
+                staged_ancestors.push_back(&**piter);
                 if (staged_ancestors.size() + package.size() > static_cast<uint64_t>(m_opts.limits.ancestor_count)) {
                     return util::Error{Untranslated(strprintf("too many unconfirmed parents [limit: %u]", m_opts.limits.ancestor_count))};
                 }
@@ -240,7 +243,8 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
     const Limits& limits,
     bool fSearchForParents /* = true */) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
+    WITH_FRESH_EPOCH(m_epoch);
+    AncestorWorkList staged_ancestors;
     const CTransaction &tx = entry.GetTx();
 
     if (fSearchForParents) {
@@ -249,8 +253,8 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
         // iterate mapTx to find parents.
         for (unsigned int i = 0; i < tx.vin.size(); i++) {
             std::optional<txiter> piter = GetIter(tx.vin[i].prevout.hash);
-            if (piter) {
-                staged_ancestors.insert(**piter);
+            if (piter && !visited(*piter)) {
+                staged_ancestors.push_back(&**piter);
                 if (staged_ancestors.size() + 1 > static_cast<uint64_t>(limits.ancestor_count)) {
                     return util::Error{Untranslated(strprintf("too many unconfirmed parents [limit: %u]", limits.ancestor_count))};
                 }
@@ -259,8 +263,10 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
     } else {
         // If we're not searching for parents, we require this to already be an
         // entry in the mempool and use the entry's cached parents.
-        txiter it = mapTx.iterator_to(entry);
-        staged_ancestors = it->GetMemPoolParentsConst();
+        for (const CTxMemPoolEntry& parent : entry.GetMemPoolParentsConst()) {
+            visited(parent);
+            staged_ancestors.push_back(&parent);
+        }
     }
 
     return CalculateAncestorsAndCheckLimits(entry.GetTxSize(), /*entry_count=*/1, staged_ancestors,
@@ -431,6 +437,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     if (delta) {
         mapTx.modify(newit, [&delta](CTxMemPoolEntry& e) { e.UpdateModifiedFee(delta); });
     }
+    if (m_opts.cluster_mempool) CreateCluster(newit);
 
     // Update cachedInnerUsage to include contained transaction's usage.
     // (When we update the entry for in-mempool parents, memory usage will be
@@ -508,10 +515,12 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     } else
         txns_randomized.clear();
 
+    if (m_opts.cluster_mempool) RemoveFromCluster(it);
+
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
     cachedInnerUsage -= it->DynamicMemoryUsage();
-    cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+    m_links_usage -= it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
     mapTx.erase(it);
     nTransactionsUpdated++;
 }
@@ -653,6 +662,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     uint64_t checkTotal = 0;
     CAmount check_total_fee{0};
     uint64_t innerUsage = 0;
+    uint64_t links_usage{0};
     uint64_t prev_ancestor_count{0};
 
     CCoinsViewCache mempoolDuplicate(const_cast<CCoinsViewCache*>(&active_coins_tip));
@@ -662,7 +672,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         check_total_fee += it->GetFee();
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
-        innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+        links_usage += it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
         CTxMemPoolEntry::Parents setParentCheck;
         for (const CTxIn &txin : tx.vin) {
             // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
@@ -725,6 +735,14 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         // just a sanity check, not definitive that this calc is correct...
         assert(it->GetSizeWithDescendants() >= child_sizes + it->GetTxSize());
 
+        if (m_opts.cluster_mempool) {
+            // Linked transactions are in the same cluster.
+            assert(it->m_cluster && it->m_cluster->m_txs.at(it->m_cluster_pos) == &*it);
+            for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+                assert(parent.m_cluster == it->m_cluster);
+            }
+        }
+
         TxValidationState dummy_state; // Not used. CheckTxInputs() should always pass
         CAmount txfee = 0;
         assert(!tx.IsCoinBase());
@@ -740,9 +758,39 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         assert(&tx == it->second);
     }
 
+    size_t cluster_txs{0};
+    for (const auto& [id, cluster] : m_clusters) {
+        assert(cluster.m_id == id && !cluster.m_txs.empty());
+        cluster_txs += cluster.m_txs.size();
+        assert(cluster.m_dirty == m_dirty_clusters.contains(id));
+        if (cluster.m_dirty) continue;
+        // A linearized cluster is in topological order, and its chunks cover it with
+        // non-increasing feerates.
+        for (size_t i = 0; i < cluster.m_txs.size(); ++i) {
+            for (const CTxMemPoolEntry& parent : cluster.m_txs[i]->GetMemPoolParentsConst()) {
+                assert(parent.m_cluster_pos < i);
+            }
+        }
+        size_t chunk_txs{0};
+        for (size_t i = 0; i < cluster.m_chunks.size(); ++i) {
+            FeeFrac chunk_feerate;
+            for (size_t j = chunk_txs; j < chunk_txs + cluster.m_chunks[i].count; ++j) {
+                chunk_feerate += FeeFrac{cluster.m_txs.at(j)->GetModifiedFee(), cluster.m_txs.at(j)->GetTxSize()};
+            }
+            assert(chunk_feerate == cluster.m_chunks[i].feerate);
+            assert(i == 0 || !(cluster.m_chunks[i].feerate >> cluster.m_chunks[i - 1].feerate));
+            chunk_txs += cluster.m_chunks[i].count;
+        }
+        assert(chunk_txs == cluster.m_txs.size());
+        assert(m_worst_chunks.contains({cluster.m_chunks.back().feerate, id}));
+    }
+    assert(cluster_txs == (m_opts.cluster_mempool ? mapTx.size() : 0));
+    assert(m_worst_chunks.size() == m_clusters.size() - m_dirty_clusters.size());
+
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
     assert(innerUsage == cachedInnerUsage);
+    assert(links_usage == m_links_usage);
 }
 
 bool CTxMemPool::CompareDepthAndScore(const uint256& hasha, const uint256& hashb, bool wtxid)
@@ -870,6 +918,7 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
         txiter it = mapTx.find(hash);
         if (it != mapTx.end()) {
             mapTx.modify(it, [&nFeeDelta](CTxMemPoolEntry& e) { e.UpdateModifiedFee(nFeeDelta); });
+            if (m_opts.cluster_mempool) MarkClusterDirty(*it->m_cluster);
             // Now update all ancestors' modified fees with descendants
             auto ancestors{AssumeCalculateMemPoolAncestors(__func__, *it, Limits::NoLimits(), /*fSearchForParents=*/false)};
             for (txiter ancestorIt : ancestors) {
@@ -1012,10 +1061,23 @@ void CCoinsViewMemPool::Reset()
     m_non_base_coins.clear();
 }
 
-size_t CTxMemPool::DynamicMemoryUsage() const {
+CTxMemPool::MemoryUsage CTxMemPool::GetMemoryUsage() const
+{
     LOCK(cs);
+    MemoryUsage usage;
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + cachedInnerUsage;
+    usage.entries = memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size();
+    usage.transactions = cachedInnerUsage;
+    usage.links = m_links_usage;
+    usage.spends = memusage::DynamicUsage(mapNextTx);
+    usage.deltas = memusage::DynamicUsage(mapDeltas);
+    usage.randomized = memusage::DynamicUsage(txns_randomized);
+    if (m_opts.cluster_mempool) {
+        // Every transaction takes one slot in its cluster's linearization and at most one chunk.
+        usage.clusters = memusage::DynamicUsage(m_clusters) + mapTx.size() * (sizeof(const CTxMemPoolEntry*) + sizeof(cluster_linearize::Chunk)) +
+                         memusage::DynamicUsage(m_worst_chunks) + memusage::DynamicUsage(m_dirty_clusters);
+    }
+    return usage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1061,23 +1123,27 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry)
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Children s;
-    if (add && entry->GetMemPoolChildren().insert(*child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolChildren().erase(*child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Children& children{entry->GetMemPoolChildren()};
+    m_links_usage -= children.DynamicMemoryUsage();
+    if (add) {
+        children.insert(*child);
+    } else {
+        children.erase(*child);
     }
+    m_links_usage += children.DynamicMemoryUsage();
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Parents s;
-    if (add && entry->GetMemPoolParents().insert(*parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolParents().erase(*parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Parents& parents{entry->GetMemPoolParents()};
+    m_links_usage -= parents.DynamicMemoryUsage();
+    if (add && parents.insert(*parent).second) {
+        if (m_opts.cluster_mempool) MergeClusters(entry, parent);
+    } else if (!add) {
+        parents.erase(*parent);
     }
+    m_links_usage += parents.DynamicMemoryUsage();
 }
 
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
@@ -1118,19 +1184,24 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
     while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+        setEntries stage;
+        CFeeRate removed;
+        if (m_opts.cluster_mempool) {
+            removed = StageWorstChunk(stage);
+        } else {
+            indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+            removed = CFeeRate(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+            CalculateDescendants(mapTx.project<0>(it), stage);
+        }
 
         // We set the new mempool min fee to the feerate of the removed set, plus the
         // "minimum reasonable fee rate" (ie some value under which we consider txn
         // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
         // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
         removed += m_opts.incremental_relay_feerate;
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1157,20 +1228,19 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
 
 uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
     // find parent with highest descendant count
-    std::vector<txiter> candidates;
-    setEntries counted;
-    candidates.push_back(entry);
+    WITH_FRESH_EPOCH(m_epoch);
+    AncestorWorkList candidates;
+    visited(entry);
+    candidates.push_back(&*entry);
     uint64_t maximum = 0;
-    while (candidates.size()) {
-        txiter candidate = candidates.back();
-        candidates.pop_back();
-        if (!counted.insert(candidate).second) continue;
-        const CTxMemPoolEntry::Parents& parents = candidate->GetMemPoolParentsConst();
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const CTxMemPoolEntry& candidate = *candidates[i];
+        const CTxMemPoolEntry::Parents& parents = candidate.GetMemPoolParentsConst();
         if (parents.size() == 0) {
-            maximum = std::max(maximum, candidate->GetCountWithDescendants());
+            maximum = std::max(maximum, candidate.GetCountWithDescendants());
         } else {
-            for (const CTxMemPoolEntry& i : parents) {
-                candidates.push_back(mapTx.iterator_to(i));
+            for (const CTxMemPoolEntry& parent : parents) {
+                if (!visited(parent)) candidates.push_back(&parent);
             }
         }
     }
@@ -1179,14 +1249,27 @@ uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
 
 void CTxMemPool::GetTransactionAncestry(const uint256& txid, size_t& ancestors, size_t& descendants, size_t* const ancestorsize, CAmount* const ancestorfees) const {
     LOCK(cs);
-    auto it = mapTx.find(txid);
     ancestors = descendants = 0;
-    if (it != mapTx.end()) {
-        ancestors = it->GetCountWithAncestors();
-        if (ancestorsize) *ancestorsize = it->GetSizeWithAncestors();
-        if (ancestorfees) *ancestorfees = it->GetModFeesWithAncestors();
-        descendants = CalculateDescendantMaximum(it);
+    if (m_ancestry_cache_updates != nTransactionsUpdated) {
+        m_ancestry_cache.clear();
+        m_ancestry_cache_updates = nTransactionsUpdated;
+    }
+    auto cached = m_ancestry_cache.find(txid);
+    if (cached == m_ancestry_cache.end()) {
+        auto it = mapTx.find(txid);
+        if (it == mapTx.end()) return;
+        if (m_ancestry_cache.size() >= MAX_ANCESTRY_CACHE_SIZE) m_ancestry_cache.clear();
+        cached = m_ancestry_cache.emplace(txid, TxAncestry{
+            .ancestors = it->GetCountWithAncestors(),
+            .descendants = CalculateDescendantMaximum(it),
+            .ancestor_size = static_cast<size_t>(it->GetSizeWithAncestors()),
+            .ancestor_fees = it->GetModFeesWithAncestors(),
+        }).first;
     }
+    ancestors = cached->second.ancestors;
+    descendants = cached->second.descendants;
+    if (ancestorsize) *ancestorsize = cached->second.ancestor_size;
+    if (ancestorfees) *ancestorfees = cached->second.ancestor_fees;
 }
 
 bool CTxMemPool::GetLoadTried() const
@@ -1228,6 +1311,180 @@ std::vector<CTxMemPool::txiter> CTxMemPool::GatherClusters(const std::vector<uin
     return clustered_txs;
 }
 
+void CTxMemPool::CreateCluster(txiter entry)
+{
+    AssertLockHeld(cs);
+    const uint64_t id{m_next_cluster_id++};
+    TxMempoolCluster& cluster{m_clusters.try_emplace(id, id).first->second};
+    cluster.m_txs.push_back(&*entry);
+    entry->m_cluster = &cluster;
+    entry->m_cluster_pos = 0;
+    m_dirty_clusters.insert(id);
+}
+
+void CTxMemPool::MergeClusters(txiter entry, txiter parent)
+{
+    AssertLockHeld(cs);
+    TxMempoolCluster* to{Assert(entry->m_cluster)};
+    TxMempoolCluster* from{Assert(parent->m_cluster)};
+    if (to == from) return;
+    // Move the members of the smaller cluster over to the larger one.
+    if (to->m_txs.size() < from->m_txs.size()) std::swap(to, from);
+    MarkClusterDirty(*to);
+    for (const CTxMemPoolEntry* tx : from->m_txs) {
+        tx->m_cluster = to;
+        tx->m_cluster_pos = to->m_txs.size();
+        to->m_txs.push_back(tx);
+    }
+    MarkClusterDirty(*from);
+    m_dirty_clusters.erase(from->m_id);
+    m_clusters.erase(from->m_id);
+}
+
+void CTxMemPool::RemoveFromCluster(txiter entry)
+{
+    AssertLockHeld(cs);
+    TxMempoolCluster* cluster{entry->m_cluster};
+    // Entries evicted by StageWorstChunk have been detached from their cluster already.
+    if (!cluster) return;
+    MarkClusterDirty(*cluster);
+    const CTxMemPoolEntry* last{cluster->m_txs.back()};
+    last->m_cluster_pos = entry->m_cluster_pos;
+    cluster->m_txs[entry->m_cluster_pos] = last;
+    cluster->m_txs.pop_back();
+    entry->m_cluster = nullptr;
+    if (cluster->m_txs.empty()) {
+        m_dirty_clusters.erase(cluster->m_id);
+        m_clusters.erase(cluster->m_id);
+    }
+}
+
+void CTxMemPool::MarkClusterDirty(TxMempoolCluster& cluster) const
+{
+    AssertLockHeld(cs);
+    if (cluster.m_dirty) return;
+    m_worst_chunks.erase({cluster.m_chunks.back().feerate, cluster.m_id});
+    cluster.m_chunks.clear();
+    cluster.m_dirty = true;
+    m_dirty_clusters.insert(cluster.m_id);
+}
+
+void CTxMemPool::LinearizeCluster(TxMempoolCluster& cluster) const
+{
+    AssertLockHeld(cs);
+    Assume(cluster.m_dirty && !cluster.m_txs.empty());
+
+    // Find the transactions connected to the first one. Removals may have disconnected the rest,
+    // which become a new cluster of their own (to be split further when it is linearized).
+    std::vector<bool> connected(cluster.m_txs.size(), false);
+    std::vector<const CTxMemPoolEntry*> todo{cluster.m_txs.front()};
+    connected[0] = true;
+    size_t connected_count{1};
+    const auto visit = [&](const CTxMemPoolEntry& tx) {
+        Assume(tx.m_cluster == &cluster);
+        if (!connected[tx.m_cluster_pos]) {
+            connected[tx.m_cluster_pos] = true;
+            ++connected_count;
+            todo.push_back(&tx);
+        }
+    };
+    while (!todo.empty()) {
+        const CTxMemPoolEntry* tx{todo.back()};
+        todo.pop_back();
+        for (const CTxMemPoolEntry& parent : tx->GetMemPoolParentsConst()) visit(parent);
+        for (const CTxMemPoolEntry& child : tx->GetMemPoolChildrenConst()) visit(child);
+    }
+    if (connected_count < cluster.m_txs.size()) {
+        const uint64_t id{m_next_cluster_id++};
+        TxMempoolCluster& rest{m_clusters.try_emplace(id, id).first->second};
+        std::vector<const CTxMemPoolEntry*> kept;
+        kept.reserve(connected_count);
+        rest.m_txs.reserve(cluster.m_txs.size() - connected_count);
+        for (size_t i = 0; i < cluster.m_txs.size(); ++i) {
+            const CTxMemPoolEntry* tx{cluster.m_txs[i]};
+            if (connected[i]) {
+                tx->m_cluster_pos = kept.size();
+                kept.push_back(tx);
+            } else {
+                tx->m_cluster = &rest;
+                tx->m_cluster_pos = rest.m_txs.size();
+                rest.m_txs.push_back(tx);
+            }
+        }
+        cluster.m_txs = std::move(kept);
+        m_dirty_clusters.insert(id);
+    }
+
+    cluster_linearize::DepGraph graph;
+    graph.Reserve(cluster.m_txs.size());
+    for (const CTxMemPoolEntry* tx : cluster.m_txs) {
+        graph.AddTransaction({tx->GetModifiedFee(), tx->GetTxSize()});
+        for (const CTxMemPoolEntry& parent : tx->GetMemPoolParentsConst()) {
+            graph.AddParent(parent.m_cluster_pos);
+        }
+    }
+    const std::vector<uint32_t> linearization{cluster_linearize::Linearize(graph)};
+    cluster.m_chunks = cluster_linearize::ChunkLinearization(graph, linearization);
+
+    std::vector<const CTxMemPoolEntry*> ordered;
+    ordered.reserve(linearization.size());
+    for (const uint32_t i : linearization) {
+        cluster.m_txs[i]->m_cluster_pos = ordered.size();
+        ordered.push_back(cluster.m_txs[i]);
+    }
+    cluster.m_txs = std::move(ordered);
+    cluster.m_dirty = false;
+    m_worst_chunks.emplace(cluster.m_chunks.back().feerate, cluster.m_id);
+}
+
+void CTxMemPool::LinearizeDirtyClusters() const
+{
+    AssertLockHeld(cs);
+    while (!m_dirty_clusters.empty()) {
+        const uint64_t id{*m_dirty_clusters.begin()};
+        m_dirty_clusters.erase(m_dirty_clusters.begin());
+        LinearizeCluster(m_clusters.at(id));
+    }
+}
+
+std::vector<const TxMempoolCluster*> CTxMemPool::GetLinearizedClusters() const
+{
+    AssertLockHeld(cs);
+    LinearizeDirtyClusters();
+    std::vector<const TxMempoolCluster*> clusters;
+    clusters.reserve(m_clusters.size());
+    for (const auto& [id, cluster] : m_clusters) {
+        clusters.push_back(&cluster);
+    }
+    return clusters;
+}
+
+CFeeRate CTxMemPool::StageWorstChunk(setEntries& stage)
+{
+    AssertLockHeld(cs);
+    LinearizeDirtyClusters();
+    const auto worst{m_worst_chunks.begin()};
+    const FeeFrac feerate{worst->first};
+    TxMempoolCluster& cluster{m_clusters.at(worst->second)};
+    m_worst_chunks.erase(worst);
+
+    // Removing a cluster's last chunk leaves a valid linearization and chunking of the rest, so
+    // the cluster does not need to be linearized again.
+    const size_t remaining{cluster.m_txs.size() - cluster.m_chunks.back().count};
+    for (size_t i = remaining; i < cluster.m_txs.size(); ++i) {
+        stage.insert(mapTx.iterator_to(*cluster.m_txs[i]));
+        cluster.m_txs[i]->m_cluster = nullptr;
+    }
+    cluster.m_txs.resize(remaining);
+    cluster.m_chunks.pop_back();
+    if (cluster.m_txs.empty()) {
+        m_clusters.erase(cluster.m_id);
+    } else {
+        m_worst_chunks.emplace(cluster.m_chunks.back().feerate, cluster.m_id);
+    }
+    return CFeeRate(feerate.fee, feerate.size);
+}
+
 std::optional<std::string> CTxMemPool::CheckConflictTopology(const setEntries& direct_conflicts)
 {
     for (const auto& direct_conflict : direct_conflicts) {
@@ -6,6 +6,7 @@
 #ifndef BITCOIN_TXMEMPOOL_H
 #define BITCOIN_TXMEMPOOL_H
 
+#include <cluster_linearize.h>
 #include <coins.h>
 #include <consensus/amount.h>
 #include <indirectmap.h>
@@ -16,6 +17,7 @@
 #include <kernel/mempool_removal_reason.h> // IWYU pragma: export
 #include <policy/feerate.h>
 #include <policy/packages.h>
+#include <prevector.h>
 #include <primitives/transaction.h>
 #include <sync.h>
 #include <util/epochguard.h>
@@ -37,6 +39,7 @@
 #include <set>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -46,6 +49,9 @@ class ValidationSignals;
 /** Fake height value used in Coin to signify they are only in the memory pool (since 0.8) */
 static const uint32_t MEMPOOL_HEIGHT = 0x7FFFFFFF;
 
+/** Maximum number of transactions with cached CTxMemPool::GetTransactionAncestry() results */
+static constexpr size_t MAX_ANCESTRY_CACHE_SIZE{1000};
+
 /**
  * Test whether the LockPoints height and time are still valid on the current chain
  */
@@ -225,6 +231,25 @@ struct TxMempoolInfo
     int64_t nFeeDelta;
 };
 
+/**
+ * A group of mempool transactions that are connected through spending relationships, kept in a
+ * linearization (an order in which they could be mined) when -clustermempool is set.
+ *
+ * Removals may leave a cluster with several connected components; these are split into separate
+ * clusters the next time the cluster is linearized.
+ */
+struct TxMempoolCluster {
+    const uint64_t m_id;
+    //! Member transactions, in linearization order unless m_dirty is set.
+    std::vector<const CTxMemPoolEntry*> m_txs;
+    //! Chunks of the linearization, highest feerate first. Empty while m_dirty is set.
+    std::vector<cluster_linearize::Chunk> m_chunks;
+    //! Whether members or fees changed since the cluster was last linearized.
+    bool m_dirty{true};
+
+    explicit TxMempoolCluster(uint64_t id) : m_id{id} {}
+};
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain transactions
  * that may be included in the next block.
@@ -305,13 +330,35 @@ protected:
 
     uint64_t totalTxSize GUARDED_BY(cs){0};      //!< sum of all mempool tx's virtual sizes. Differs from serialized tx size since witness data is discounted. Defined in BIP 141.
     CAmount m_total_fee GUARDED_BY(cs){0};       //!< sum of all mempool tx's fees (NOT modified fee)
-    uint64_t cachedInnerUsage GUARDED_BY(cs){0}; //!< sum of dynamic memory usage of all the map elements (NOT the maps themselves)
+    uint64_t cachedInnerUsage GUARDED_BY(cs){0}; //!< sum of dynamic memory usage of all the entries' transactions
+    uint64_t m_links_usage GUARDED_BY(cs){0};    //!< sum of dynamic memory usage of all the entries' parent and child links
 
     mutable int64_t lastRollingFeeUpdate GUARDED_BY(cs){GetTime()};
     mutable bool blockSinceLastRollingFeeBump GUARDED_BY(cs){false};
     mutable double rollingMinimumFeeRate GUARDED_BY(cs){0}; //!< minimum fee to get into the pool, decreases exponentially
     mutable Epoch m_epoch GUARDED_BY(cs){};
 
+    //! Result of GetTransactionAncestry() for a transaction in the mempool
+    struct TxAncestry {
+        size_t ancestors;
+        size_t descendants;
+        size_t ancestor_size;
+        CAmount ancestor_fees;
+    };
+    //! GetTransactionAncestry() results, only valid while nTransactionsUpdated equals
+    //! m_ancestry_cache_updates. Invalidated lazily: cleared by the first lookup after a change.
+    mutable std::unordered_map<uint256, TxAncestry, SaltedTxidHasher> m_ancestry_cache GUARDED_BY(cs);
+    mutable unsigned int m_ancestry_cache_updates GUARDED_BY(cs){0};
+
+    // Cluster state for -clustermempool. Clusters are linearized lazily, when blocks are
+    // assembled or the mempool is trimmed, hence mutable.
+    mutable std::unordered_map<uint64_t, TxMempoolCluster> m_clusters GUARDED_BY(cs);
+    mutable uint64_t m_next_cluster_id GUARDED_BY(cs){0};
+    //! Ids of the clusters that have to be split and linearized again.
+    mutable std::set<uint64_t> m_dirty_clusters GUARDED_BY(cs);
+    //! Feerate of the last chunk of every linearized cluster, with the cluster's id.
+    mutable std::set<std::pair<FeeFrac, uint64_t>> m_worst_chunks GUARDED_BY(cs);
+
     // In-memory counter for external mempool tracking purposes.
     // This number is incremented once every time a transaction
     // is added or removed from the mempool for any reason.
@@ -396,7 +443,7 @@ public:
 
     using Limits = kernel::MemPoolLimits;
 
-    uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 private:
     typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
 
@@ -406,28 +453,50 @@ private:
 
     std::vector<indexed_transaction_set::const_iterator> GetSortedDepthAndScore() const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Put a newly added entry in a cluster of its own. */
+    void CreateCluster(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Merge the clusters of two transactions that were linked as parent and child. */
+    void MergeClusters(txiter entry, txiter parent) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Remove an entry from its cluster, deleting the cluster if it becomes empty. */
+    void RemoveFromCluster(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Drop a cluster's linearization, so that it is recomputed when next needed. */
+    void MarkClusterDirty(TxMempoolCluster& cluster) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Move transactions not connected to the cluster's first transaction to a new cluster,
+     *  then linearize and chunk what is left. */
+    void LinearizeCluster(TxMempoolCluster& cluster) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void LinearizeDirtyClusters() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Detach the lowest feerate chunk of the mempool from its cluster and add its
+     *  transactions to stage. As the last chunk of its cluster, it has no descendants
+     *  outside of itself. Returns the chunk's feerate. */
+    CFeeRate StageWorstChunk(setEntries& stage) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /**
      * Track locally submitted transactions to periodically retry initial broadcast.
      */
     std::set<uint256> m_unbroadcast_txids GUARDED_BY(cs);
 
 
+    /** Work list of an ancestor traversal: the entries found so far, in the order they were
+     *  found. Stored inline up to beyond the default ancestor limit. */
+    using AncestorWorkList = prevector<32, const CTxMemPoolEntry*>;
+
     /**
      * Helper function to calculate all in-mempool ancestors of staged_ancestors and apply ancestor
      * and descendant limits (including staged_ancestors themselves, entry_size and entry_count).
      *
      * @param[in]   entry_size          Virtual size to include in the limits.
      * @param[in]   entry_count         How many entries to include in the limits.
-     * @param[in]   staged_ancestors    Should contain entries in the mempool.
+     * @param[in,out] ancestors         Distinct entries in the mempool, marked visited in the
+     *                                  current epoch. Extended with all their ancestors.
      * @param[in]   limits              Maximum number and size of ancestors and descendants
      *
      * @return all in-mempool ancestors, or an error if any ancestor or descendant limits were hit
      */
     util::Result<setEntries> CalculateAncestorsAndCheckLimits(int64_t entry_size,
                                                               size_t entry_count,
-                                                              CTxMemPoolEntry::Parents &staged_ancestors,
+                                                              AncestorWorkList& ancestors,
                                                               const Limits& limits
-                                                              ) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+                                                              ) const EXCLUSIVE_LOCKS_REQUIRED(cs, m_epoch);
 
 public:
     indirectmap<COutPoint, const CTransaction*> mapNextTx GUARDED_BY(cs);
@@ -556,7 +625,7 @@ public:
      */
     util::Result<setEntries> CalculateMemPoolAncestors(const CTxMemPoolEntry& entry,
                                    const Limits& limits,
-                                   bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+                                   bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 
     /**
      * Same as CalculateMemPoolAncestors, but always returns a (non-optional) setEntries.
@@ -584,6 +653,10 @@ public:
      * more transactions as a DoS protection. */
     std::vector<txiter> GatherClusters(const std::vector<uint256>& txids) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Linearize the clusters that changed since they were last used and return all clusters.
+     *  Returns an empty vector unless -clustermempool is set. */
+    std::vector<const TxMempoolCluster*> GetLinearizedClusters() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Calculate all in-mempool ancestors of a set of transactions not already in the mempool and
      * check ancestor and descendant limits. Heuristics are used to estimate the ancestor and
      * descendant count of all entries if the package were to be added to the mempool.  The limits
@@ -597,7 +670,7 @@ public:
      * @returns {} or the error reason if a limit is hit.
      */
     util::Result<void> CheckPackageLimits(const Package& package,
-                                          int64_t total_vsize) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+                                          int64_t total_vsize) const EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 
     /** Populate setDescendants with all in-mempool descendants of hash.
      *  Assumes that setDescendants includes all in-mempool descendants of anything
@@ -686,7 +759,20 @@ public:
     std::vector<CTxMemPoolEntryRef> entryAll() const EXCLUSIVE_LOCKS_REQUIRED(cs);
     std::vector<TxMempoolInfo> infoAll() const;
 
-    size_t DynamicMemoryUsage() const;
+    /** Memory used by the mempool, split up by what it is used for. */
+    struct MemoryUsage {
+        size_t entries{0};      //!< nodes of mapTx, holding the entries and their index links
+        size_t transactions{0}; //!< the transactions referenced by the entries
+        size_t links{0};        //!< parent and child links that do not fit in the entries
+        size_t spends{0};       //!< mapNextTx
+        size_t deltas{0};       //!< mapDeltas
+        size_t randomized{0};   //!< txns_randomized
+        size_t clusters{0};     //!< cluster linearizations, only with -clustermempool
+
+        size_t Total() const { return entries + transactions + links + spends + deltas + randomized + clusters; }
+    };
+    MemoryUsage GetMemoryUsage() const;
+    size_t DynamicMemoryUsage() const { return GetMemoryUsage().Total(); }
 
     /** Adds a transaction to the unbroadcast set */
     void AddUnbroadcastTx(const uint256& txid)
@@ -810,6 +896,11 @@ public:
         return m_epoch.visited(it->m_epoch_marker);
     }
 
+    bool visited(const CTxMemPoolEntry& entry) const EXCLUSIVE_LOCKS_REQUIRED(cs, m_epoch)
+    {
+        return m_epoch.visited(entry.m_epoch_marker);
+    }
+
     bool visited(std::optional<txiter> it) const EXCLUSIVE_LOCKS_REQUIRED(cs, m_epoch)
     {
         assert(m_epoch.guarded()); // verify guard even when it==nullopt
@@ -0,0 +1,46 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_MAPPEDFILE_H
+#define BITCOIN_UTIL_MAPPEDFILE_H
+
+#include <span.h>
+#include <util/fs.h>
+
+#include <cstddef>
+#include <memory>
+
+/**
+ * Read-only memory mapping of a whole file, as it was when it was mapped.
+ *
+ * The mapping stays valid when the file is unlinked, but reading a part of it
+ * that has since been truncated away is fatal, so callers must only read
+ * ranges they know to still be in the file.
+ */
+class MappedFile
+{
+public:
+    /**
+     * Map the file at path.
+     * @returns nullptr if the file is empty or can't be opened or mapped, or
+     *          if mapping files is not supported on this platform.
+     */
+    static std::unique_ptr<MappedFile> Open(const fs::path& path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    Span<const std::byte> Data() const { return {m_data, m_size}; }
+    size_t Size() const { return m_size; }
+
+private:
+    MappedFile(const std::byte* data, size_t size) : m_data{data}, m_size{size} {}
+
+    const std::byte* m_data;
+    size_t m_size;
+};
+
+#endif // BITCOIN_UTIL_MAPPEDFILE_H
@@ -57,6 +57,7 @@
 #include <util/result.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
+#include <util/threadnames.h>
 #include <util/time.h>
 #include <util/trace.h>
 #include <util/translation.h>
@@ -66,11 +67,16 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <functional>
+#include <map>
 #include <numeric>
 #include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <unordered_set>
 #include <utility>
 
 using kernel::CCoinsStats;
@@ -664,6 +670,12 @@ private:
     // only invoke this on transactions that have otherwise passed policy checks.
     bool PolicyScriptChecks(const ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Run the policy script checks of all transactions in a package on the script check worker
+    // threads. Returns true only if every check passed; on false the checks must be repeated with
+    // PolicyScriptChecks() to find and report the failing transaction. Returns false without doing
+    // any work if there are no worker threads.
+    bool PackagePolicyScriptChecks(std::vector<Workspace>& workspaces) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Re-run the script checks, using consensus flags, and try to cache the
     // result in the scriptcache. This should be done after
     // PolicyScriptChecks(). This requires that all inputs either be in our
@@ -1116,6 +1128,29 @@ bool MemPoolAccept::PolicyScriptChecks(const ATMPArgs& args, Workspace& ws)
     return true;
 }
 
+bool MemPoolAccept::PackagePolicyScriptChecks(std::vector<Workspace>& workspaces)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    // The queue is shared with ConnectBlock, which cannot run concurrently as it requires cs_main
+    // as well, so package validation never delays block validation by occupying the workers.
+    CCheckQueue<CScriptCheck>& queue{m_active_chainstate.m_chainman.GetCheckQueue()};
+    if (workspaces.size() < 2 || !queue.HasThreads()) return false;
+
+    CCheckQueueControl<CScriptCheck> control(&queue);
+    for (Workspace& ws : workspaces) {
+        std::vector<CScriptCheck> checks;
+        TxValidationState state_dummy; // Failures are reported by PolicyScriptChecks
+        if (!CheckInputScripts(*ws.m_ptx, state_dummy, m_view, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheSigStore=*/true,
+                               /*cacheFullScriptStore=*/false, ws.m_precomputed_txdata, &checks)) {
+            return false;
+        }
+        control.Add(std::move(checks));
+    }
+    return control.Wait();
+}
+
 bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws)
 {
     AssertLockHeld(cs_main);
@@ -1426,9 +1461,13 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         return PackageMempoolAcceptResult(package_state, std::move(results));
     }
 
+    // Check the scripts of all transactions at once on the worker threads. If that fails, fall
+    // back to checking one transaction at a time, which identifies the failing transaction and
+    // leaves the results exactly as if the package had been checked sequentially.
+    const bool package_scripts_ok{PackagePolicyScriptChecks(workspaces)};
     for (Workspace& ws : workspaces) {
         ws.m_package_feerate = package_feerate;
-        if (!PolicyScriptChecks(args, ws)) {
+        if (!package_scripts_ok && !PolicyScriptChecks(args, ws)) {
             // Exit early to avoid doing pointless work. Update the failed tx result; the rest are unfinished.
             package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
             results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
@@ -1800,6 +1839,8 @@ void Chainstate::InitCoinsDB(
         leveldb_name += node::SNAPSHOT_CHAINSTATE_SUFFIX;
     }
 
+    DropCoinsSnapshot();
+
     m_coins_views = std::make_unique<CoinsViews>(
         DBParams{
             .path = m_chainman.m_options.datadir / leveldb_name,
@@ -2749,9 +2790,30 @@ bool Chainstate::FlushStateToDisk(
             }
             // Flush the chainstate (which may refer to block index entries).
             const auto empty_cache{(mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical || fFlushForPrune};
-            if (empty_cache ? !CoinsTip().Flush() : !CoinsTip().Sync()) {
+            // Explicit and prune-driven flushes must be on disk when we return.
+            // Otherwise, the write can be left to a background thread: the
+            // coins database answers lookups from the batch until it lands.
+            if (CoinsDB().BackgroundFlushEnabled() && mode != FlushStateMode::ALWAYS && !fFlushForPrune) {
+                // Let the previous background write finish before taking
+                // coins out of the cache for the next one.
+                if (!CoinsDB().WaitForBackgroundWrite()) {
+                    return FatalError(m_chainman.GetNotifications(), state, _("Failed to write to coin database."));
+                }
+                auto batch{std::make_shared<CoinsWriteBatch>()};
+                // Only the modified coins have to leave the cache to bring it
+                // under the limit; keep the rest warm unless that isn't enough.
+                CoinsTip().TakeModified(batch->coins, /*keep_unmodified=*/true);
+                if (empty_cache && GetCoinsCacheSizeState() >= CoinsCacheSizeState::LARGE) {
+                    CoinsTip().TakeModified(batch->coins, /*keep_unmodified=*/false);
+                }
+                batch->best_block = CoinsTip().GetBestBlock();
+                if (!CoinsDB().BatchWriteInBackground(std::move(batch))) {
+                    return FatalError(m_chainman.GetNotifications(), state, _("Failed to write to coin database."));
+                }
+            } else if (empty_cache ? !CoinsTip().Flush() : !CoinsTip().Sync()) {
                 return FatalError(m_chainman.GetNotifications(), state, _("Failed to write to coin database."));
             }
+            ResetCoinsSnapshot();
             m_last_flush = nNow;
             full_flush_completed = true;
             TRACE5(utxocache, flush,
@@ -2789,6 +2851,73 @@ void Chainstate::PruneAndFlush()
     }
 }
 
+void Chainstate::DropCoinsSnapshot()
+{
+    LOCK(m_chainman.m_coins_snapshot_mutex);
+    m_chainman.m_coins_snapshot.reset();
+    m_chainman.m_flushed_coins_snapshot.reset();
+}
+
+void Chainstate::ResetCoinsSnapshot()
+{
+    AssertLockHeld(::cs_main);
+    if (this != m_chainman.m_active_chainstate) return;
+    std::shared_ptr<CCoinsViewSnapshot> snapshot;
+    const CBlockIndex* best_block{nullptr};
+    // Carrying the view forward during initial block download would hold on to
+    // a copy of every coin changed since the last flush.
+    if (!m_chainman.IsInitialBlockDownload()) {
+        // The best block of the cache may be ahead of m_chain while a block is being connected.
+        best_block = m_blockman.LookupBlockIndex(CoinsTip().GetBestBlock());
+        if (best_block) snapshot = CoinsDB().GetSnapshot(best_block->nHeight);
+    }
+    LOCK(m_chainman.m_coins_snapshot_mutex);
+    if (snapshot && best_block != m_chain.Tip()) {
+        // The mempool has not been updated for best_block yet.
+        m_chainman.m_flushed_coins_snapshot = std::move(snapshot);
+    } else {
+        m_chainman.m_coins_snapshot = std::move(snapshot);
+        m_chainman.m_flushed_coins_snapshot.reset();
+    }
+}
+
+void Chainstate::UpdateCoinsSnapshot(const CBlock& block, const CBlockIndex& pindex)
+{
+    AssertLockHeld(::cs_main);
+    if (this != m_chainman.m_active_chainstate) return;
+    std::shared_ptr<CCoinsViewSnapshot> snapshot;
+    {
+        LOCK(m_chainman.m_coins_snapshot_mutex);
+        // A flush while the block was being connected started a view that has it.
+        snapshot = std::exchange(m_chainman.m_flushed_coins_snapshot, nullptr);
+        if (!snapshot || snapshot->GetBestBlock() != pindex.GetBlockHash()) snapshot = m_chainman.m_coins_snapshot;
+    }
+    if (!snapshot) return;
+    if (snapshot->GetBestBlock() == pindex.GetBlockHash()) {
+        // Nothing to carry forward.
+    } else if (m_chainman.IsInitialBlockDownload() || !pindex.pprev || snapshot->GetBestBlock() != pindex.pprev->GetBlockHash()) {
+        snapshot.reset();
+    } else {
+        // Record the same changes as UpdateCoins() makes.
+        auto changes{std::make_shared<CCoinsViewSnapshot::Changes>()};
+        for (const auto& tx : block.vtx) {
+            if (!tx->IsCoinBase()) {
+                for (const CTxIn& txin : tx->vin) {
+                    (*changes)[txin.prevout] = Coin{};
+                }
+            }
+            for (uint32_t i = 0; i < tx->vout.size(); ++i) {
+                if (!tx->vout[i].scriptPubKey.IsUnspendable()) {
+                    (*changes)[COutPoint{tx->GetHash(), i}] = Coin{tx->vout[i], pindex.nHeight, tx->IsCoinBase()};
+                }
+            }
+        }
+        snapshot = snapshot->Extend(std::move(changes), pindex.GetBlockHash(), pindex.nHeight);
+    }
+    LOCK(m_chainman.m_coins_snapshot_mutex);
+    m_chainman.m_coins_snapshot = std::move(snapshot);
+}
+
 /** Private helper function that concatenates warning messages. */
 static void AppendWarning(bilingual_str& res, const bilingual_str& warn)
 {
@@ -2902,6 +3031,8 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
         bool flushed = view.Flush();
         assert(flushed);
     }
+    // The coins snapshot only tracks blocks being connected.
+    if (this == m_chainman.m_active_chainstate) DropCoinsSnapshot();
     LogPrint(BCLog::BENCH, "- Disconnect block: %.2fms\n",
              Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
 
@@ -2940,6 +3071,9 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     return true;
 }
 
+static SteadyClock::duration time_fetch_inputs{};
+static uint64_t num_inputs_cached{0};
+static uint64_t num_inputs_prefetched{0};
 static SteadyClock::duration time_connect_total{};
 static SteadyClock::duration time_flush{};
 static SteadyClock::duration time_chainstate{};
@@ -3019,6 +3153,18 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms\n",
              Ticks<MillisecondsDouble>(time_2 - time_1));
     {
+        // Read the inputs that are not cached yet from disk in parallel, so the
+        // serial ConnectBlock below does not wait on each of them in turn.
+        const auto input_stats{m_chainman.GetInputFetcher().FetchInputs(CoinsTip(), CoinsDB(), blockConnecting)};
+        const auto time_fetched{SteadyClock::now()};
+        time_fetch_inputs += time_fetched - time_2;
+        num_inputs_cached += input_stats.cache_hits;
+        num_inputs_prefetched += input_stats.fetched;
+        LogPrint(BCLog::BENCH, "  - Fetch inputs: %.2fms (%u cached, %u fetched, %u not found) [%.2fs, %u cached, %u fetched]\n",
+                 Ticks<MillisecondsDouble>(time_fetched - time_2),
+                 input_stats.cache_hits, input_stats.fetched, input_stats.missing,
+                 Ticks<SecondsDouble>(time_fetch_inputs), num_inputs_cached, num_inputs_prefetched);
+
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
         if (m_chainman.m_options.signals) {
@@ -3061,6 +3207,8 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
         m_mempool->removeForBlock(blockConnecting.vtx, pindexNew->nHeight);
         disconnectpool.removeForBlock(blockConnecting.vtx);
     }
+    // Publish the block to readers of the coins snapshot once the mempool reflects it.
+    UpdateCoinsSnapshot(blockConnecting, *pindexNew);
     // Update m_chain & related variables.
     m_chain.SetTip(*pindexNew);
     UpdateTip(pindexNew);
@@ -4505,6 +4653,8 @@ bool Chainstate::LoadChainTip()
     }
     m_chain.SetTip(*pindex);
     PruneBlockIndexCandidates();
+    // Nothing has been written to the freshly loaded coins cache yet.
+    if (coins_cache.GetCacheSize() == 0) ResetCoinsSnapshot();
 
     tip = m_chain.Tip();
     LogPrintf("Loaded best chain: hashBestChain=%s height=%d date=%s progress=%f\n",
@@ -4869,6 +5019,209 @@ bool Chainstate::LoadGenesisBlock()
     return true;
 }
 
+namespace {
+/**
+ * Pipeline for reading a block file in LoadExternalBlockFile().
+ *
+ * A reader thread scans the file sequentially and frames blocks, exactly as
+ * the serial loop used to: it locates the magic, reads the size and the
+ * header, and copies out the serialized block. Worker threads deserialize
+ * and run the context-free CheckBlock() on the framed blocks. The accept
+ * stage (the thread calling LoadExternalBlockFile) takes the blocks back in
+ * file order and does everything that needs cs_main.
+ *
+ * Blocks whose parent is neither known to the caller nor seen earlier in the
+ * file are not deserialized by the workers: the accept stage will most
+ * likely only store their position. Unless keep_undecoded is set, such blocks
+ * are not even copied out, and the accept stage reads them from disk in the
+ * rare case it does need one.
+ *
+ * The number of blocks between the reader and the accept stage is bounded,
+ * so a slow accept stage throttles the reader instead of growing memory.
+ */
+class BlockFileImport
+{
+public:
+    /** A block framed by the reader. */
+    struct Item {
+        //! Offset of the serialized block (after magic and size) in the file.
+        uint64_t block_pos{0};
+        CBlockHeader header;
+        uint256 hash;
+        //! Whether the workers should deserialize the block.
+        bool decode{false};
+        //! Set by the workers unless deserialization failed or was skipped.
+        std::shared_ptr<CBlock> block;
+        //! The deserialization error, if any.
+        std::string error;
+        //! Offset at which scanning would resume after this block.
+        uint64_t rewind_pos{0};
+        //! The serialized block, released once deserialized. Empty if the
+        //! block was not decoded and keep_undecoded was not set.
+        DataStream data;
+    };
+
+    using ParentKnownFn = std::function<bool(const uint256&)>;
+
+    BlockFileImport(AutoFile& file, const CChainParams& params, int num_workers, bool keep_undecoded, ParentKnownFn parent_known)
+        : m_params{params}, m_max_in_flight{2 * size_t(num_workers) + 8}, m_keep_undecoded{keep_undecoded}, m_parent_known{std::move(parent_known)}
+    {
+        m_threads.emplace_back([this, &file] {
+            util::ThreadRename("loadblk.read");
+            Read(file);
+        });
+        for (int n = 0; n < num_workers; ++n) {
+            m_threads.emplace_back([this, n] {
+                util::ThreadRename(strprintf("loadblk.%i", n));
+                Decode();
+            });
+        }
+    }
+
+    ~BlockFileImport()
+    {
+        WITH_LOCK(m_mutex, m_stop = true);
+        m_cv.notify_all();
+        for (auto& thread : m_threads) thread.join();
+    }
+
+    //! Next block in file order, or nullopt at the end of the file.
+    std::optional<Item> Next() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_decoded.count(m_next_accept) || (m_read_done && m_next_accept == m_next_read);
+        });
+        const auto it{m_decoded.find(m_next_accept)};
+        if (it == m_decoded.end()) return std::nullopt;
+        Item item{std::move(it->second)};
+        m_decoded.erase(it);
+        ++m_next_accept;
+        m_cv.notify_all();
+        return item;
+    }
+
+private:
+    const CChainParams& m_params;
+    const size_t m_max_in_flight;
+    const bool m_keep_undecoded;
+    const ParentKnownFn m_parent_known;
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Framed blocks waiting for a worker, with their sequence numbers.
+    std::deque<std::pair<uint64_t, Item>> m_to_decode GUARDED_BY(m_mutex);
+    //! Decoded blocks by sequence number, waiting for the accept stage.
+    std::map<uint64_t, Item> m_decoded GUARDED_BY(m_mutex);
+    uint64_t m_next_read GUARDED_BY(m_mutex){0};
+    uint64_t m_next_accept GUARDED_BY(m_mutex){0};
+    bool m_read_done GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+
+    void Read(AutoFile& file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        //! Hashes of the blocks framed so far.
+        std::unordered_set<uint256, SaltedTxidHasher> seen;
+        try {
+            BufferedFile blkdat{file, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8};
+            // nRewind indicates where to resume scanning in case something goes wrong,
+            // such as a block fails to deserialize.
+            uint64_t nRewind = blkdat.GetPos();
+            while (!blkdat.eof()) {
+                blkdat.SetPos(nRewind);
+                nRewind++; // start one byte further next time, in case of failure
+                blkdat.SetLimit(); // remove former limit
+                unsigned int nSize = 0;
+                try {
+                    // locate a header
+                    MessageStartChars buf;
+                    blkdat.FindByte(std::byte(m_params.MessageStart()[0]));
+                    nRewind = blkdat.GetPos() + 1;
+                    blkdat >> buf;
+                    if (buf != m_params.MessageStart()) {
+                        continue;
+                    }
+                    // read size
+                    blkdat >> nSize;
+                    if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                        continue;
+                } catch (const std::exception&) {
+                    // no valid block header found; don't complain
+                    // (this happens at the end of every blk.dat file)
+                    break;
+                }
+                try {
+                    Item item;
+                    item.block_pos = blkdat.GetPos();
+                    blkdat.SetLimit(item.block_pos + nSize);
+                    blkdat >> item.header;
+                    nRewind = item.block_pos + nSize;
+                    item.rewind_pos = nRewind;
+                    item.hash = item.header.GetHash();
+                    item.decode = item.hash == m_params.GetConsensus().hashGenesisBlock ||
+                                  seen.count(item.header.hashPrevBlock) || m_parent_known(item.header.hashPrevBlock);
+                    seen.insert(item.hash);
+                    if (item.decode || m_keep_undecoded) {
+                        // Copy out the whole block for a worker to deserialize.
+                        blkdat.SetPos(item.block_pos);
+                        item.data.resize(nSize);
+                        blkdat.read(item.data);
+                    }
+
+                    WAIT_LOCK(m_mutex, lock);
+                    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || m_next_read - m_next_accept < m_max_in_flight; });
+                    if (m_stop) break;
+                    m_to_decode.emplace_back(m_next_read++, std::move(item));
+                    m_cv.notify_all();
+                } catch (const std::exception& e) {
+                    // See the comment on unexpected data in LoadExternalBlockFile().
+                    LogPrint(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", __func__, (nRewind - 1), e.what());
+                }
+            }
+        } catch (const std::exception& e) {
+            LogPrintLevel(BCLog::REINDEX, BCLog::Level::Error, "%s: error reading external block file: %s\n", __func__, e.what());
+        }
+        WITH_LOCK(m_mutex, m_read_done = true);
+        m_cv.notify_all();
+    }
+
+    void Decode() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        while (true) {
+            std::pair<uint64_t, Item> work;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_to_decode.empty() || m_read_done; });
+                if (m_stop || m_to_decode.empty()) return;
+                work = std::move(m_to_decode.front());
+                m_to_decode.pop_front();
+            }
+            Item& item{work.second};
+            try {
+                if (item.decode) {
+                    auto block{std::make_shared<CBlock>()};
+                    item.data >> TX_WITH_WITNESS(*block);
+                    // Do the context-free checks (merkle root etc.) here, so that
+                    // AcceptBlock finds the block already checked. If they fail,
+                    // AcceptBlock repeats them to report the failure.
+                    BlockValidationState state;
+                    CheckBlock(*block, state, m_params.GetConsensus());
+                    item.block = std::move(block);
+                    item.data = DataStream{};
+                }
+            } catch (const std::exception& e) {
+                item.error = e.what();
+            }
+            {
+                LOCK(m_mutex);
+                m_decoded.emplace(work.first, std::move(item));
+            }
+            m_cv.notify_all();
+        }
+    }
+};
+} // namespace
+
 void ChainstateManager::LoadExternalBlockFile(
     AutoFile& file_in,
     FlatFilePos* dbp,
@@ -4882,48 +5235,20 @@ void ChainstateManager::LoadExternalBlockFile(
 
     int nLoaded = 0;
     try {
-        BufferedFile blkdat{file_in, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8};
-        // nRewind indicates where to resume scanning in case something goes wrong,
-        // such as a block fails to deserialize.
-        uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
+        // Framing and deserialization run ahead on other threads, with the
+        // scanning rules of the original serial loop, see BlockFileImport.
+        BlockFileImport import{file_in, params, std::max(1, m_options.worker_threads_num), /*keep_undecoded=*/!dbp, [this](const uint256& hash) {
+            return WITH_LOCK(::cs_main, return m_blockman.LookupBlockIndex(hash) != nullptr);
+        }};
+        while (auto item{import.Next()}) {
             if (m_interrupt) return;
 
-            blkdat.SetPos(nRewind);
-            nRewind++; // start one byte further next time, in case of failure
-            blkdat.SetLimit(); // remove former limit
-            unsigned int nSize = 0;
             try {
-                // locate a header
-                MessageStartChars buf;
-                blkdat.FindByte(std::byte(params.MessageStart()[0]));
-                nRewind = blkdat.GetPos() + 1;
-                blkdat >> buf;
-                if (buf != params.MessageStart()) {
-                    continue;
-                }
-                // read size
-                blkdat >> nSize;
-                if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
-                    continue;
-            } catch (const std::exception&) {
-                // no valid block header found; don't complain
-                // (this happens at the end of every blk.dat file)
-                break;
-            }
-            try {
-                // read block header
-                const uint64_t nBlockPos{blkdat.GetPos()};
+                const uint64_t nBlockPos{item->block_pos};
                 if (dbp)
                     dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                CBlockHeader header;
-                blkdat >> header;
-                const uint256 hash{header.GetHash()};
-                // Skip the rest of this block (this may read from disk into memory); position to the marker before the
-                // next block, but it's still possible to rewind to the start of the current block (without a disk read).
-                nRewind = nBlockPos + nSize;
-                blkdat.SkipTo(nRewind);
+                const CBlockHeader& header{item->header};
+                const uint256& hash{item->hash};
 
                 std::shared_ptr<CBlock> pblock{}; // needs to remain available after the cs_main lock is released to avoid duplicate reads from disk
 
@@ -4942,11 +5267,20 @@ void ChainstateManager::LoadExternalBlockFile(
                     // process in case the block isn't known yet
                     const CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
                     if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
-                        // This block can be processed immediately; rewind to its start, read and deserialize it.
-                        blkdat.SetPos(nBlockPos);
-                        pblock = std::make_shared<CBlock>();
-                        blkdat >> TX_WITH_WITNESS(*pblock);
-                        nRewind = blkdat.GetPos();
+                        // This block can be processed immediately; a worker has usually deserialized it already.
+                        if (item->block) {
+                            pblock = std::move(item->block);
+                        } else if (!item->error.empty()) {
+                            throw std::ios_base::failure{item->error};
+                        } else if (!item->data.empty()) {
+                            pblock = std::make_shared<CBlock>();
+                            item->data >> TX_WITH_WITNESS(*pblock);
+                        } else {
+                            pblock = std::make_shared<CBlock>();
+                            if (!m_blockman.ReadBlockFromDisk(*pblock, *dbp)) {
+                                throw std::ios_base::failure{"failed to read block"};
+                            }
+                        }
 
                         BlockValidationState state;
                         if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr, true)) {
@@ -4959,7 +5293,6 @@ void ChainstateManager::LoadExternalBlockFile(
                         LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
                     }
                 }
-
                 // Activate the genesis block so normal node progress can continue
                 if (hash == params.GetConsensus().hashGenesisBlock) {
                     bool genesis_activation_failure = false;
@@ -5038,7 +5371,7 @@ void ChainstateManager::LoadExternalBlockFile(
                 // the reindex process is not the place to attempt to clean and/or compact the block files. if so desired, a studious node operator
                 // may use knowledge of the fact that the block files are not entirely pristine in order to prepare a set of pristine, and
                 // perhaps ordered, block files for later reindexing.
-                LogPrint(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", __func__, (nRewind - 1), e.what());
+                LogPrint(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", __func__, (item->rewind_pos - 1), e.what());
             }
         }
     } catch (const std::runtime_error& e) {
@@ -5356,6 +5689,8 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // The coins database is reopened, which has to wait for all views reading from it.
+    DropCoinsSnapshot();
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n",
@@ -5590,6 +5925,7 @@ bool ChainstateManager::ActivateSnapshot(
     Assert(m_active_chainstate->m_mempool->size() == 0);
     Assert(!m_snapshot_chainstate->m_mempool);
     m_snapshot_chainstate->m_mempool = m_active_chainstate->m_mempool;
+    WITH_LOCK(m_coins_snapshot_mutex, m_coins_snapshot.reset(); m_flushed_coins_snapshot.reset());
     m_active_chainstate->m_mempool = nullptr;
     m_active_chainstate = m_snapshot_chainstate.get();
     m_blockman.m_snapshot_height = this->GetSnapshotBaseHeight();
@@ -5602,7 +5938,7 @@ bool ChainstateManager::ActivateSnapshot(
     return true;
 }
 
-static void FlushSnapshotToDisk(CCoinsViewCache& coins_cache, bool snapshot_loaded)
+static void FlushSnapshotToDisk(CCoinsViewCache& coins_cache, CCoinsViewDB& coins_db, bool snapshot_loaded)
 {
     LOG_TIME_MILLIS_WITH_CATEGORY_MSG_ONCE(
         strprintf("%s (%.2f MB)",
@@ -5610,7 +5946,12 @@ static void FlushSnapshotToDisk(CCoinsViewCache& coins_cache, bool snapshot_load
                   coins_cache.DynamicMemoryUsage() / (1000 * 1000)),
         BCLog::LogFlags::ALL);
 
+    // Flushes of a full cache may be written as a bulk load. The snapshot is
+    // sorted by txid, so each one is a key range of its own that goes
+    // straight to the bottom level of the database.
+    coins_db.SetBulkLoad(true);
     coins_cache.Flush();
+    coins_db.SetBulkLoad(false);
 }
 
 struct StopHashingException : public std::exception
@@ -5626,6 +5967,16 @@ static void SnapshotUTXOHashBreakpoint(const util::SignalInterrupt& interrupt)
     if (interrupt) throw StopHashingException();
 }
 
+/** Check and decode a chunk of a version 2 snapshot on a worker thread. */
+struct SnapshotChunkDecodeCheck {
+    const node::SnapshotChunk* chunk;
+    uint32_t max_height;
+    std::vector<std::pair<COutPoint, Coin>>* coins;
+    std::string* error;
+
+    bool operator()() const { return node::DecodeSnapshotChunk(*chunk, max_height, *coins, *error); }
+};
+
 bool ChainstateManager::PopulateAndValidateSnapshot(
     Chainstate& snapshot_chainstate,
     AutoFile& coins_file,
@@ -5634,6 +5985,7 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     // It's okay to release cs_main before we're done using `coins_cache` because we know
     // that nothing else will be referencing the newly created snapshot_chainstate yet.
     CCoinsViewCache& coins_cache = *WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsTip());
+    CCoinsViewDB& coins_db = *WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
 
     uint256 base_blockhash = metadata.m_base_blockhash;
 
@@ -5672,75 +6024,139 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     LogPrintf("[snapshot] loading %d coins from snapshot %s\n", coins_left, base_blockhash.ToString());
     int64_t coins_processed{0};
 
-    while (coins_left > 0) {
-        try {
-            Txid txid;
-            coins_file >> txid;
-            size_t coins_per_txid{0};
-            coins_per_txid = ReadCompactSize(coins_file);
+    // Add a coin to the snapshot chainstate, flushing the cache to disk every
+    // so often. Returns false if interrupted.
+    auto add_coin = [&](COutPoint&& outpoint, Coin&& coin) {
+        coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
 
-            if (coins_per_txid > coins_left) {
-                LogPrintf("[snapshot] mismatch in coins count in snapshot metadata and actual snapshot data\n");
+        --coins_left;
+        ++coins_processed;
+
+        if (coins_processed % 1000000 == 0) {
+            LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
+                coins_processed,
+                static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
+                coins_cache.DynamicMemoryUsage() / (1000 * 1000));
+        }
+
+        // Batch write and flush (if we need to) every so often.
+        //
+        // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
+        // means <5MB of memory imprecision.
+        if (coins_processed % 120000 == 0) {
+            if (m_interrupt) {
                 return false;
             }
 
-            for (size_t i = 0; i < coins_per_txid; i++) {
-                COutPoint outpoint;
-                Coin coin;
-                outpoint.n = static_cast<uint32_t>(ReadCompactSize(coins_file));
-                outpoint.hash = txid;
-                coins_file >> coin;
-                if (coin.nHeight > base_height ||
-                    outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
-                ) {
-                    LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
-                              coins_count - coins_left);
-                    return false;
-                }
-                if (!MoneyRange(coin.out.nValue)) {
-                    LogPrintf("[snapshot] bad snapshot data after deserializing %d coins - bad tx out value\n",
-                              coins_count - coins_left);
-                    return false;
-                }
-                coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
+            const auto snapshot_cache_state = WITH_LOCK(::cs_main,
+                return snapshot_chainstate.GetCoinsCacheSizeState());
 
-                --coins_left;
-                ++coins_processed;
+            if (snapshot_cache_state >= CoinsCacheSizeState::CRITICAL) {
+                // This is a hack - we don't know what the actual best block is, but that
+                // doesn't matter for the purposes of flushing the cache here. We'll set this
+                // to its correct value (`base_blockhash`) below after the coins are loaded.
+                coins_cache.SetBestBlock(GetRandHash());
 
-                if (coins_processed % 1000000 == 0) {
-                    LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
-                        coins_processed,
-                        static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
-                        coins_cache.DynamicMemoryUsage() / (1000 * 1000));
-                }
+                // No need to acquire cs_main since this chainstate isn't being used yet.
+                FlushSnapshotToDisk(coins_cache, coins_db, /*snapshot_loaded=*/false);
+            }
+        }
+        return true;
+    };
 
-                // Batch write and flush (if we need to) every so often.
-                //
-                // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
-                // means <5MB of memory imprecision.
-                if (coins_processed % 120000 == 0) {
-                    if (m_interrupt) {
+    if (metadata.GetVersion() == node::SNAPSHOT_VERSION_CHUNKED) {
+        // Chunks are read a batch at a time and checked and decoded in
+        // parallel, after which their coins are added in order.
+        const size_t chunks_per_batch{static_cast<size_t>(std::max(0, m_options.worker_threads_num)) + 1};
+        CCheckQueue<SnapshotChunkDecodeCheck> decode_queue{/*batch_size=*/1, m_options.worker_threads_num,
+                                                           /*work_stealing=*/false,
+                                                           /*thread_name=*/"snapload"};
+        std::optional<COutPoint> last_outpoint;
+
+        while (coins_left > 0) {
+            std::vector<node::SnapshotChunk> chunks;
+            uint64_t batch_coins{0};
+            try {
+                while (chunks.size() < chunks_per_batch && batch_coins < coins_left) {
+                    coins_file >> chunks.emplace_back();
+                    const uint64_t chunk_coins{chunks.back().coins_count};
+                    if (chunk_coins == 0 || chunk_coins > coins_left - batch_coins) {
+                        LogPrintf("[snapshot] mismatch in coins count in snapshot metadata and actual snapshot data\n");
                         return false;
                     }
+                    batch_coins += chunk_coins;
+                }
+            } catch (const std::ios_base::failure&) {
+                LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
+                          coins_processed);
+                return false;
+            }
+
+            std::vector<std::vector<std::pair<COutPoint, Coin>>> chunk_coins(chunks.size());
+            std::vector<std::string> errors(chunks.size());
+            std::vector<SnapshotChunkDecodeCheck> checks;
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                checks.push_back(SnapshotChunkDecodeCheck{&chunks[i], static_cast<uint32_t>(base_height), &chunk_coins[i], &errors[i]});
+            }
+            CCheckQueueControl<SnapshotChunkDecodeCheck> control(&decode_queue);
+            control.Add(std::move(checks));
+            if (!control.Wait()) {
+                const auto error{std::find_if(errors.begin(), errors.end(), [](const std::string& e) { return !e.empty(); })};
+                LogPrintf("[snapshot] bad snapshot data after deserializing %d coins - %s\n",
+                          coins_processed, error != errors.end() ? *error : "unknown error");
+                return false;
+            }
 
-                    const auto snapshot_cache_state = WITH_LOCK(::cs_main,
-                        return snapshot_chainstate.GetCoinsCacheSizeState());
+            for (auto& coins : chunk_coins) {
+                if (last_outpoint && !(*last_outpoint < coins.front().first)) {
+                    LogPrintf("[snapshot] bad snapshot data after deserializing %d coins - coin %s out of order\n",
+                              coins_processed, coins.front().first.ToString());
+                    return false;
+                }
+                last_outpoint = coins.back().first;
+                for (auto& [outpoint, coin] : coins) {
+                    if (!add_coin(std::move(outpoint), std::move(coin))) return false;
+                }
+            }
+        }
+    } else {
+        while (coins_left > 0) {
+            try {
+                Txid txid;
+                coins_file >> txid;
+                size_t coins_per_txid{0};
+                coins_per_txid = ReadCompactSize(coins_file);
 
-                    if (snapshot_cache_state >= CoinsCacheSizeState::CRITICAL) {
-                        // This is a hack - we don't know what the actual best block is, but that
-                        // doesn't matter for the purposes of flushing the cache here. We'll set this
-                        // to its correct value (`base_blockhash`) below after the coins are loaded.
-                        coins_cache.SetBestBlock(GetRandHash());
+                if (coins_per_txid > coins_left) {
+                    LogPrintf("[snapshot] mismatch in coins count in snapshot metadata and actual snapshot data\n");
+                    return false;
+                }
 
-                        // No need to acquire cs_main since this chainstate isn't being used yet.
-                        FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
+                for (size_t i = 0; i < coins_per_txid; i++) {
+                    COutPoint outpoint;
+                    Coin coin;
+                    outpoint.n = static_cast<uint32_t>(ReadCompactSize(coins_file));
+                    outpoint.hash = txid;
+                    coins_file >> coin;
+                    if (coin.nHeight > base_height ||
+                        outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
+                    ) {
+                        LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
+                                  coins_count - coins_left);
+                        return false;
+                    }
+                    if (!MoneyRange(coin.out.nValue)) {
+                        LogPrintf("[snapshot] bad snapshot data after deserializing %d coins - bad tx out value\n",
+                                  coins_count - coins_left);
+                        return false;
                     }
+                    if (!add_coin(std::move(outpoint), std::move(coin))) return false;
                 }
+            } catch (const std::ios_base::failure&) {
+                LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
+                          coins_processed);
+                return false;
             }
-        } catch (const std::ios_base::failure&) {
-            LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
-                      coins_processed);
-            return false;
         }
     }
 
@@ -5771,19 +6187,15 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
         base_blockhash.ToString());
 
     // No need to acquire cs_main since this chainstate isn't being used yet.
-    FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/true);
+    FlushSnapshotToDisk(coins_cache, coins_db, /*snapshot_loaded=*/true);
 
     assert(coins_cache.GetBestBlock() == base_blockhash);
 
-    // As above, okay to immediately release cs_main here since no other context knows
-    // about the snapshot_chainstate.
-    CCoinsViewDB* snapshot_coinsdb = WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
-
     std::optional<CCoinsStats> maybe_stats;
 
     try {
         maybe_stats = ComputeUTXOStats(
-            CoinStatsHashType::HASH_SERIALIZED, snapshot_coinsdb, m_blockman, [&interrupt = m_interrupt] { SnapshotUTXOHashBreakpoint(interrupt); });
+            CoinStatsHashType::HASH_SERIALIZED, &coins_db, m_blockman, [&interrupt = m_interrupt] { SnapshotUTXOHashBreakpoint(interrupt); });
     } catch (StopHashingException const&) {
         return false;
     }
@@ -5895,6 +6307,7 @@ SnapshotCompletionResult ChainstateManager::MaybeCompleteSnapshotValidation()
         LogPrintf("[snapshot] !!! %s\n", user_error.original);
         LogPrintf("[snapshot] deleting snapshot, reverting to validated chain, and stopping node\n");
 
+        WITH_LOCK(m_coins_snapshot_mutex, m_coins_snapshot.reset(); m_flushed_coins_snapshot.reset());
         m_active_chainstate = m_ibd_chainstate.get();
         m_snapshot_chainstate->m_disabled = true;
         assert(!this->IsUsable(m_snapshot_chainstate.get()));
@@ -6035,6 +6448,7 @@ void ChainstateManager::MaybeRebalanceCaches()
 
 void ChainstateManager::ResetChainstates()
 {
+    WITH_LOCK(m_coins_snapshot_mutex, m_coins_snapshot.reset(); m_flushed_coins_snapshot.reset());
     m_ibd_chainstate.reset();
     m_snapshot_chainstate.reset();
     m_active_chainstate = nullptr;
@@ -6054,7 +6468,8 @@ static ChainstateManager::Options&& Flatten(ChainstateManager::Options&& opts)
 }
 
 ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Options options, node::BlockManager::Options blockman_options)
-    : m_script_check_queue{/*batch_size=*/128, options.worker_threads_num},
+    : m_script_check_queue{/*batch_size=*/128, options.worker_threads_num, options.work_stealing},
+      m_input_fetcher{options.worker_threads_num},
       m_interrupt{interrupt},
       m_options{Flatten(std::move(options))},
       m_blockman{interrupt, std::move(blockman_options)}
@@ -6097,6 +6512,7 @@ Chainstate& ChainstateManager::ActivateExistingSnapshot(uint256 base_blockhash)
     Assert(m_active_chainstate->m_mempool->size() == 0);
     Assert(!m_snapshot_chainstate->m_mempool);
     m_snapshot_chainstate->m_mempool = m_active_chainstate->m_mempool;
+    WITH_LOCK(m_coins_snapshot_mutex, m_coins_snapshot.reset(); m_flushed_coins_snapshot.reset());
     m_active_chainstate->m_mempool = nullptr;
     m_active_chainstate = m_snapshot_chainstate.get();
     return *m_snapshot_chainstate;
@@ -6170,6 +6586,7 @@ bool ChainstateManager::DeleteSnapshotChainstate()
                   fs::PathToString(snapshot_datadir));
         return false;
     }
+    WITH_LOCK(m_coins_snapshot_mutex, m_coins_snapshot.reset(); m_flushed_coins_snapshot.reset());
     m_active_chainstate = m_ibd_chainstate.get();
     m_active_chainstate->m_mempool = m_snapshot_chainstate->m_mempool;
     m_snapshot_chainstate.reset();
@@ -13,6 +13,7 @@
 #include <kernel/chain.h>
 #include <consensus/amount.h>
 #include <deploymentstatus.h>
+#include <inputfetcher.h>
 #include <kernel/chainparams.h>
 #include <kernel/chainstatemanager_opts.h>
 #include <kernel/cs_main.h> // IWYU pragma: export
@@ -503,6 +504,19 @@ protected:
     //! Manages the UTXO set, which is a reflection of the contents of `m_chain`.
     std::unique_ptr<CoinsViews> m_coins_views;
 
+    //! Start ChainstateManager::GetCoinsSnapshot() afresh from the coins database, after a flush
+    //! left it with the same coins as the tip cache. Only done for the active chainstate, once it
+    //! is out of initial block download.
+    void ResetCoinsSnapshot() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+    //! Carry the coins snapshot forward after block was connected as pindex, or drop it if it
+    //! cannot be. Called once the mempool has been updated for the block, with its lock held,
+    //! so that readers holding the mempool lock see both at the same block.
+    void UpdateCoinsSnapshot(const CBlock& block, const CBlockIndex& pindex) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+    //! Drop the coins snapshot, which may read from the coins database of this chainstate.
+    void DropCoinsSnapshot();
+
     //! This toggle exists for use when doing background validation for UTXO
     //! snapshots.
     //!
@@ -622,7 +636,11 @@ public:
     }
 
     //! Destructs all objects related to accessing the UTXO set.
-    void ResetCoinsViews() { m_coins_views.reset(); }
+    void ResetCoinsViews()
+    {
+        DropCoinsSnapshot();
+        m_coins_views.reset();
+    }
 
     //! Does this chainstate have a UTXO set attached?
     bool HasCoinsViews() const { return (bool)m_coins_views; }
@@ -882,6 +900,16 @@ private:
     //! most-work chain.
     Chainstate* m_active_chainstate GUARDED_BY(::cs_main) {nullptr};
 
+    //! Protects the pointer m_coins_snapshot, not the view it points to, which never changes.
+    mutable Mutex m_coins_snapshot_mutex;
+
+    //! Read-only view of the UTXO set of the active chainstate, see GetCoinsSnapshot(). It reads
+    //! from a coins database, so it is declared after the chainstates to be destroyed before them.
+    std::shared_ptr<CCoinsViewSnapshot> m_coins_snapshot GUARDED_BY(m_coins_snapshot_mutex);
+    //! View started by a flush while a block was being connected, held back until the mempool
+    //! has been updated for the block, see Chainstate::UpdateCoinsSnapshot().
+    std::shared_ptr<CCoinsViewSnapshot> m_flushed_coins_snapshot GUARDED_BY(m_coins_snapshot_mutex);
+
     CBlockIndex* m_best_invalid GUARDED_BY(::cs_main){nullptr};
 
     //! Internal helper for ActivateSnapshot().
@@ -927,6 +955,9 @@ private:
     //! A queue for script verifications that have to be performed by worker threads.
     CCheckQueue<CScriptCheck> m_script_check_queue;
 
+    //! Worker threads that read block inputs from the coins database before ConnectBlock.
+    InputFetcher m_input_fetcher;
+
 public:
     using Options = kernel::ChainstateManagerOpts;
 
@@ -1279,6 +1310,26 @@ public:
 
     CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
 
+    /**
+     * Return a read-only view of the UTXO set at the tip of the active
+     * chainstate, for lookups without cs_main. The view does not change as
+     * blocks are connected: it is the tip as of the call, or the one before if
+     * a block is being connected. A new tip is published under the mempool
+     * lock, after the mempool was updated for it, so a view taken with that
+     * lock held is consistent with the mempool.
+     *
+     * Returns nullptr if no view is available, in which case CoinsTip() has to
+     * be used under cs_main instead. A view is started whenever the coins cache
+     * is flushed outside of initial block download, and carried forward as
+     * blocks are connected. Disconnecting a block drops it until the next flush.
+     */
+    std::shared_ptr<CCoinsViewSnapshot> GetCoinsSnapshot() const EXCLUSIVE_LOCKS_REQUIRED(!m_coins_snapshot_mutex)
+    {
+        return WITH_LOCK(m_coins_snapshot_mutex, return m_coins_snapshot);
+    }
+
+    InputFetcher& GetInputFetcher() { return m_input_fetcher; }
+
     ~ChainstateManager();
 };
 
@@ -56,6 +56,8 @@ public:
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Notifies of a new tip, and periodically of a possibly improved block template
+    virtual bool NotifyBlockTemplate();
 
 protected:
     void* psocket{nullptr};
@@ -26,7 +26,12 @@ public:
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
 
-    static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(std::vector<uint8_t>&, const CBlockIndex&)> get_block_by_index);
+    static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(std::vector<uint8_t>&, const CBlockIndex&)> get_block_by_index,
+                                                             std::function<bool(std::vector<uint8_t>&, uint64_t&)> get_template_update);
+
+    /** Let notifiers publish the current block template if it improved. Called periodically
+     *  from the scheduler thread, which also runs the validation interface callbacks. */
+    void NotifyBlockTemplate();
 
 protected:
     bool Initialize();
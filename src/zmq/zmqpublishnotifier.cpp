@@ -45,6 +45,7 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_TEMPLATEDIFF = "templatediff";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -261,6 +262,17 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     return SendZmqMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
 
+bool CZMQPublishTemplateDiffNotifier::NotifyBlockTemplate()
+{
+    std::vector<uint8_t> diff{};
+    uint64_t id{m_template_id};
+    if (!m_get_template_update(diff, id)) return true;
+
+    LogPrint(BCLog::ZMQ, "Publish templatediff %d (base %d) to %s\n", id, m_template_id, this->address);
+    m_template_id = id;
+    return SendZmqMessage(MSG_TEMPLATEDIFF, diff.data(), diff.size());
+}
+
 // Helper function to send a 'sequence' topic message with the following structure:
 //    <32-byte hash> | <1-byte label> | <8-byte LE sequence> (optional)
 static bool SendSequenceMsg(CZMQAbstractPublishNotifier& notifier, uint256 hash, char label, std::optional<uint64_t> sequence = {})
@@ -63,6 +63,19 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishTemplateDiffNotifier : public CZMQAbstractPublishNotifier
+{
+private:
+    //! Given the id of the last published template, returns whether there is an update to it, and its serialization and id
+    const std::function<bool(std::vector<uint8_t>&, uint64_t&)> m_get_template_update;
+    uint64_t m_template_id{0};
+
+public:
+    CZMQPublishTemplateDiffNotifier(std::function<bool(std::vector<uint8_t>&, uint64_t&)> get_template_update)
+        : m_get_template_update{std::move(get_template_update)} {}
+    bool NotifyBlockTemplate() override;
+};
+
 class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier
 {
 public:
@@ -53,9 +53,11 @@ class AssumeutxoTest(BitcoinTestFramework):
         """Use the pregenerated, deterministic chain up to height 199."""
         self.num_nodes = 3
         self.rpc_timeout = 120
+        # n1 writes the coins cache flushes of the loaded snapshot as bulk
+        # loads.
         self.extra_args = [
             [],
-            ["-fastprune", "-prune=1", "-blockfilterindex=1", "-coinstatsindex=1"],
+            ["-fastprune", "-prune=1", "-blockfilterindex=1", "-coinstatsindex=1", "-dbbulkloadmincoins=1"],
             ["-persistmempool=0","-txindex=1", "-blockfilterindex=1", "-coinstatsindex=1"],
         ]
 
@@ -83,7 +85,7 @@ class AssumeutxoTest(BitcoinTestFramework):
         assert_raises_rpc_error(parsing_error_code, "Unable to parse metadata: Invalid UTXO set snapshot magic bytes. Please check if this is indeed a snapshot file or if you are using an outdated snapshot format.", self.nodes[1].loadtxoutset, bad_snapshot_path)
 
         self.log.info("  - snapshot file with unsupported version")
-        for version in [0, 2]:
+        for version in [0, 3]:
             with open(bad_snapshot_path, 'wb') as f:
                 f.write(valid_snapshot_contents[:5] + version.to_bytes(2, "little") + valid_snapshot_contents[7:])
             assert_raises_rpc_error(parsing_error_code, f"Unable to parse metadata: Version of snapshot {version} does not match any of the supported versions.", self.nodes[1].loadtxoutset, bad_snapshot_path)
@@ -244,6 +246,11 @@ class AssumeutxoTest(BitcoinTestFramework):
         self.log.info(f"Creating a UTXO snapshot at height {SNAPSHOT_BASE_HEIGHT}")
         dump_output = n0.dumptxoutset('utxos.dat')
 
+        self.log.info("Creating a UTXO snapshot with the coins in chunks (version 2)")
+        dump_output_v2 = n0.dumptxoutset('utxos_v2.dat', 2)
+        assert_equal(dump_output_v2['coins_written'], dump_output['coins_written'])
+        assert_equal(dump_output_v2['txoutset_hash'], dump_output['txoutset_hash'])
+
         self.log.info("Test loading snapshot when headers are not synced")
         self.test_headers_not_synced(dump_output['path'])
 
@@ -420,16 +427,24 @@ class AssumeutxoTest(BitcoinTestFramework):
         assert_equal(loaded['coins_loaded'], SNAPSHOT_BASE_HEIGHT)
         assert_equal(loaded['base_height'], SNAPSHOT_BASE_HEIGHT)
 
-        for reindex_arg in ['-reindex=1', '-reindex-chainstate=1']:
+        # The version 2 snapshot is loaded in between, and the node then
+        # continues from the version 1 snapshot as before.
+        for reindex_arg, snapshot_path in [
+            ('-reindex=1', dump_output['path']),
+            ('-reindex-chainstate=1', dump_output_v2['path']),
+            ('-reindex-chainstate=1', dump_output['path']),
+        ]:
             self.log.info(f"Check that restarting with {reindex_arg} will delete the snapshot chainstate")
             self.restart_node(2, extra_args=[reindex_arg, *self.extra_args[2]])
             assert_equal(1, len(n2.getchainstates()["chainstates"]))
             for i in range(1, 300):
                 block = n0.getblock(n0.getblockhash(i), 0)
                 n2.submitheader(block)
-            loaded = n2.loadtxoutset(dump_output['path'])
+            self.log.info(f"Loading snapshot into third node from {snapshot_path}")
+            loaded = n2.loadtxoutset(snapshot_path)
             assert_equal(loaded['coins_loaded'], SNAPSHOT_BASE_HEIGHT)
             assert_equal(loaded['base_height'], SNAPSHOT_BASE_HEIGHT)
+            assert_equal(n2.gettxoutsetinfo()['hash_serialized_3'], dump_output['txoutset_hash'])
 
         normal, snapshot = n2.getchainstates()['chainstates']
         assert_equal(normal['blocks'], START_HEIGHT)
@@ -471,9 +486,9 @@ class AssumeutxoTest(BitcoinTestFramework):
                 # Ensure indexes have synced for the assumeutxo node
                 self.wait_until(lambda: n.getindexinfo() == completed_idx_state)
 
-        self.log.info("Test -reindex-chainstate of an assumeutxo-synced node")
+        self.log.info("Test -reindex-chainstate of an assumeutxo-synced node, writing the rebuilt chainstate as a bulk load")
         self.restart_node(2, extra_args=[
-            '-reindex-chainstate=1', *self.extra_args[2]])
+            '-reindex-chainstate=1', '-dbbulkloadmincoins=1', *self.extra_args[2]])
         assert_equal(n2.getblockchaininfo()["blocks"], FINAL_HEIGHT)
         self.wait_until(lambda: n2.getblockcount() == FINAL_HEIGHT)
 
@@ -242,6 +242,13 @@ class CoinStatsIndexTest(BitcoinTestFramework):
         res12 = index_node.gettxoutsetinfo('muhash')
         assert_equal(res12, res10)
 
+        self.log.info("Test that the index is rebuilt the same with -indexworkers")
+
+        self.restart_node(1, extra_args=["-coinstatsindex", "-reindex", "-indexworkers=3"])
+        self.sync_index_node()
+        res13 = index_node.gettxoutsetinfo('muhash')
+        assert_equal(res13, res10)
+
     def _test_use_index_option(self):
         self.log.info("Test use_index option for nodes running the index")
 
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test scripthistoryindex and the getscripthistory RPC and REST interface.
+
+Test that the history of a script follows new blocks, reorgs and restarts,
+and that its pages add up to the whole history.
+"""
+
+from decimal import Decimal
+import http.client
+import json
+import urllib.parse
+
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+from test_framework.wallet import (
+    MiniWallet,
+    getnewdestination,
+)
+
+
+class ScriptHistoryIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-scripthistoryindex", "-rest"],
+            [],
+        ]
+
+    def sync_index(self):
+        height = self.nodes[0].getblockcount()
+        expected = {'scripthistoryindex': {'synced': True, 'best_block_height': height}}
+        self.wait_until(lambda: self.nodes[0].getindexinfo() == expected)
+
+    def rest_history(self, script, status=200, **query):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        uri = f"/rest/scripthistory/{script}.json"
+        if query:
+            uri += f"?{urllib.parse.urlencode(query)}"
+        conn.request('GET', uri)
+        resp = conn.getresponse()
+        assert_equal(resp.status, status)
+        body = resp.read().decode('utf-8')
+        return json.loads(body, parse_float=Decimal) if status == 200 else body
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.wallet = MiniWallet(node)
+        address = self.wallet.get_address()
+        script_hex = self.wallet.get_scriptPubKey().hex()
+
+        self.log.info("Test that the history has the coinbase outputs of the wallet")
+        self.generate(self.wallet, COINBASE_MATURITY + 1)
+        self.sync_index()
+        res = node.getscripthistory(address)
+        assert_equal(res['scriptPubKey'], script_hex)
+        assert 'cursor' not in res
+        history = res['history']
+        assert_equal([entry['height'] for entry in history], list(range(1, COINBASE_MATURITY + 2)))
+        assert all('spent_by' not in entry for entry in history)
+        assert_equal(node.getscripthistory(script_hex), res)
+
+        self.log.info("Test that a spend shows up on the spent output")
+        spend = self.wallet.send_self_transfer(from_node=node)
+        spent = node.decoderawtransaction(spend['hex'])['vin'][0]
+        self.generate(node, 1)
+        self.sync_index()
+        spend_height = node.getblockcount()
+        history = node.getscripthistory(address)['history']
+        spent_entry = next(entry for entry in history if entry['txid'] == spent['txid'] and entry['vout'] == spent['vout'])
+        assert_equal(spent_entry['spent_by'], {'txid': spend['txid'], 'vin': 0, 'height': spend_height})
+        assert_equal(history[-1]['txid'], spend['txid'])
+        assert_equal(history[-1]['height'], spend_height)
+
+        self.log.info("Test pagination and height ranges")
+        pages = []
+        cursor = None
+        while True:
+            res = node.getscripthistory(address, 0, None, 30, cursor) if cursor else node.getscripthistory(address, count=30)
+            pages += res['history']
+            if 'cursor' not in res:
+                break
+            cursor = res['cursor']
+        assert_equal(pages, history)
+        res = node.getscripthistory(address, 10, 19)
+        assert_equal([entry['height'] for entry in res['history']], list(range(10, 20)))
+
+        self.log.info("Test the REST interface")
+        assert_equal(self.rest_history(address), node.getscripthistory(address))
+        res = self.rest_history(script_hex, start_height=10, stop_height=19, count=4)
+        assert_equal(res, node.getscripthistory(address, 10, 19, 4))
+        res2 = self.rest_history(address, start_height=10, stop_height=19, count=4, cursor=res['cursor'])
+        assert_equal(res2['history'][0]['height'], 14)
+        assert "Invalid number" in self.rest_history(address, status=400, count="x")
+        assert "Invalid cursor" in self.rest_history(address, status=400, cursor="00")
+
+        self.log.info("Test that a reorg rewinds the spend")
+        node.invalidateblock(node.getbestblockhash())
+        self.generateblock(node, output=getnewdestination()[2], transactions=[], sync_fun=self.no_op)
+        self.sync_index()
+        history = node.getscripthistory(address)['history']
+        spent_entry = next(entry for entry in history if entry['txid'] == spent['txid'] and entry['vout'] == spent['vout'])
+        assert 'spent_by' not in spent_entry
+        assert_equal(history[-1]['height'], COINBASE_MATURITY + 1)
+
+        self.log.info("Test that the index is kept across restarts")
+        self.restart_node(0)
+        self.sync_index()
+        assert_equal(node.getscripthistory(address)['history'], history)
+
+        self.log.info("Test errors")
+        assert_raises_rpc_error(-8, "Invalid cursor", node.getscripthistory, address, 0, None, 10, "00")
+        assert_raises_rpc_error(-8, "count must be between 1 and 10000", node.getscripthistory, address, 0, None, 0)
+        assert_raises_rpc_error(-8, "Invalid start_height or stop_height", node.getscripthistory, address, 10, 9)
+        assert_raises_rpc_error(-5, "Invalid address or scriptPubKey", node.getscripthistory, "notanaddress")
+        assert_raises_rpc_error(-1, "Requires scripthistoryindex", self.nodes[1].getscripthistory, address)
+
+
+if __name__ == '__main__':
+    ScriptHistoryIndexTest().main()
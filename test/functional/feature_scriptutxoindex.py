@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test scriptutxoindex, scantxoutset with it and the getutxosbyscript REST interface.
+
+Test that the unspent outputs found in the index match those found by scanning
+the UTXO set on a node without the index, across new blocks, reorgs and
+restarts.
+"""
+
+from decimal import Decimal
+import http.client
+import json
+import urllib.parse
+
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import (
+    MiniWallet,
+    getnewdestination,
+)
+
+
+class ScriptUTXOIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-scriptutxoindex", "-rest"],
+            ["-rest"],
+        ]
+
+    def sync_index(self):
+        self.sync_blocks()
+        height = self.nodes[0].getblockcount()
+        expected = {'scriptutxoindex': {'synced': True, 'best_block_height': height}}
+        self.wait_until(lambda: self.nodes[0].getindexinfo() == expected)
+
+    def rest_utxos(self, node, script, status=200):
+        url = urllib.parse.urlparse(node.url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', f"/rest/getutxosbyscript/{script}.json")
+        resp = conn.getresponse()
+        assert_equal(resp.status, status)
+        body = resp.read().decode('utf-8')
+        return json.loads(body, parse_float=Decimal) if status == 200 else body
+
+    def assert_scans_match(self, descriptors):
+        with_index = self.nodes[0].scantxoutset("start", descriptors)
+        without_index = self.nodes[1].scantxoutset("start", descriptors)
+        # Only the outputs found are counted when using the index.
+        assert_equal(with_index['txouts'], len(with_index['unspents']))
+        for res in (with_index, without_index):
+            del res['txouts']
+        assert_equal(with_index, without_index)
+        return with_index
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.wallet = MiniWallet(node)
+        descriptor = self.wallet.get_descriptor()
+        address = self.wallet.get_address()
+
+        self.log.info("Test that scantxoutset finds the coinbase outputs of the wallet in the index")
+        self.generate(self.wallet, COINBASE_MATURITY + 1)
+        self.sync_index()
+        res = self.assert_scans_match([descriptor])
+        assert_equal(len(res['unspents']), COINBASE_MATURITY + 1)
+
+        self.log.info("Test that spent outputs are removed and new ones added")
+        _, spk, other_address = getnewdestination()
+        self.wallet.send_to(from_node=node, scriptPubKey=spk, amount=1000000)
+        self.generate(node, 1)
+        self.sync_index()
+        res = self.assert_scans_match([descriptor, f"addr({other_address})"])
+        assert_equal(len(res['unspents']), COINBASE_MATURITY + 2)
+        assert_equal(sum(u['amount'] for u in res['unspents'] if u['scriptPubKey'] == spk.hex()), Decimal("0.01"))
+
+        self.log.info("Test the REST interface")
+        rest = self.rest_utxos(node, address)
+        assert_equal(rest['chainHeight'], node.getblockcount())
+        assert_equal(rest['chaintipHash'], node.getbestblockhash())
+        scan = node.scantxoutset("start", [descriptor])
+        assert_equal(sorted((u['txid'], u['vout'], u['value']) for u in rest['utxos']),
+                     sorted((u['txid'], u['vout'], u['amount']) for u in scan['unspents']))
+        assert_equal(self.rest_utxos(node, self.wallet.get_scriptPubKey().hex()), rest)
+        assert_equal(self.rest_utxos(node, other_address)['utxos'][0]['scriptPubKey']['address'], other_address)
+        assert "Invalid address or scriptPubKey" in self.rest_utxos(node, "notanaddress", status=400)
+        assert "Requires scriptutxoindex" in self.rest_utxos(self.nodes[1], address, status=404)
+
+        self.log.info("Test that a reorg restores the spent outputs")
+        for n in self.nodes:
+            n.invalidateblock(n.getbestblockhash())
+        self.generateblock(node, output=getnewdestination()[2], transactions=[])
+        self.sync_index()
+        res = self.assert_scans_match([descriptor, f"addr({other_address})"])
+        assert_equal(len(res['unspents']), COINBASE_MATURITY + 1)
+
+        self.log.info("Test that the index is kept across restarts")
+        self.restart_node(0)
+        self.sync_index()
+        self.assert_scans_match([descriptor, f"addr({other_address})"])
+
+
+if __name__ == '__main__':
+    ScriptUTXOIndexTest().main()
@@ -8,12 +8,17 @@ from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import assert_equal, str_to_b64str
 
 import http.client
+import json
+import re
+import socket
 import urllib.parse
 
 class HTTPBasicsTest (BitcoinTestFramework):
     def set_test_params(self):
         self.num_nodes = 3
         self.supports_cli = False
+        # node2 runs several event loops and a single worker thread
+        self.extra_args = [[], [], ["-rpceventthreads=4", "-rpcthreads=1"]]
 
     def setup_network(self):
         self.setup_nodes()
@@ -104,6 +109,46 @@ class HTTPBasicsTest (BitcoinTestFramework):
         out1 = conn.getresponse()
         assert_equal(out1.status, http.client.BAD_REQUEST)
 
+        self.log.info("Check that pipelined requests are answered in order")
+        body = '{"method": "getblockcount", "id": %d}'
+        request = f"POST / HTTP/1.1\r\nHost: {urlNode2.hostname}\r\nAuthorization: {headers['Authorization']}\r\nContent-Length: %d\r\n\r\n%s"
+        with socket.create_connection((urlNode2.hostname, urlNode2.port)) as sock:
+            sock.sendall(b"".join((request % (len(body % i), body % i)).encode() for i in range(3)))
+            data = b""
+            responses = []
+            while len(responses) < 3:
+                data += sock.recv(4096)
+                while b"\r\n\r\n" in data:
+                    head, rest = data.split(b"\r\n\r\n", 1)
+                    length = int(re.search(rb"Content-Length: (\d+)", head, re.IGNORECASE).group(1))
+                    if len(rest) < length:
+                        break
+                    assert head.startswith(b"HTTP/1.1 200")
+                    responses.append(json.loads(rest[:length]))
+                    data = rest[length:]
+            assert_equal([r["id"] for r in responses], [0, 1, 2])
+
+        self.log.info("Check that long polls do not hold on to the only worker thread")
+        height = self.nodes[2].getblockcount()
+        poll_conns = []
+        for _ in range(3):
+            poll_conn = http.client.HTTPConnection(urlNode2.hostname, urlNode2.port)
+            poll_conn.request('POST', '/', '{"method": "waitfornewblock"}', headers)
+            poll_conns.append(poll_conn)
+        timeout_conn = http.client.HTTPConnection(urlNode2.hostname, urlNode2.port)
+        timeout_conn.request('POST', '/', '{"method": "waitforblockheight", "params": [1000, 100]}', headers)
+        out1 = timeout_conn.getresponse().read()
+        assert_equal(json.loads(out1)["result"]["height"], height)
+        # Parked requests are still listed as active commands
+        active_commands = [c["method"] for c in self.nodes[2].getrpcinfo()["active_commands"]]
+        assert_equal(active_commands.count("waitfornewblock"), 3)
+        assert_equal(self.nodes[2].getblockcount(), height)
+        self.generate(self.nodes[2], 1, sync_fun=self.no_op)
+        for poll_conn in poll_conns:
+            out1 = poll_conn.getresponse().read()
+            assert_equal(json.loads(out1)["result"]["height"], height + 1)
+            poll_conn.close()
+
 
 if __name__ == '__main__':
     HTTPBasicsTest ().main ()
@@ -3,6 +3,7 @@
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the ZMQ notification interface."""
+from decimal import Decimal
 import os
 import struct
 import tempfile
@@ -20,12 +21,14 @@ from test_framework.blocktools import (
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.messages import (
+    BlockTemplateDiff,
     CBlock,
     hash256,
     tx_from_hex,
 )
 from test_framework.util import (
     assert_equal,
+    assert_raises,
     assert_raises_rpc_error,
     p2p_port,
 )
@@ -86,8 +89,8 @@ class ZMQTestSetupBlock:
     Generates a block on the specified node on instantiation and provides a
     method to check whether a ZMQ notification matches, i.e. the event was
     caused by this generated block.  Assumes that a notification either contains
-    the generated block's hash, it's (coinbase) transaction id, the raw block or
-    raw transaction data.
+    the generated block's hash (possibly serialized, as in a block template on top
+    of it), it's (coinbase) transaction id, the raw block or raw transaction data.
     """
     def __init__(self, test_framework, node):
         self.block_hash = test_framework.generate(node, 1, sync_fun=test_framework.no_op)[0]
@@ -99,6 +102,7 @@ class ZMQTestSetupBlock:
     def caused_notification(self, notification):
         return (
             self.block_hash in notification
+            or bytes.fromhex(self.block_hash)[::-1].hex() in notification
             or self.tx_hash in notification
             or self.raw_block in notification
             or self.raw_tx in notification
@@ -127,6 +131,7 @@ class ZMQTest (BitcoinTestFramework):
                 self.log.info("Skipping ipc test, because UNIX sockets are not supported.")
             self.test_sequence()
             self.test_mempool_sync()
+            self.test_template_diff()
             self.test_reorg()
             self.test_multiple_interfaces()
             self.test_ipv6()
@@ -137,7 +142,7 @@ class ZMQTest (BitcoinTestFramework):
 
     # Restart node with the specified zmq notifications enabled, subscribe to
     # all of them and return the corresponding ZMQSubscriber objects.
-    def setup_zmq_test(self, services, *, recv_timeout=60, sync_blocks=True, ipv6=False):
+    def setup_zmq_test(self, services, *, recv_timeout=60, sync_blocks=True, ipv6=False, extra_args=[]):
         subscribers = []
         for topic, address in services:
             socket = self.ctx.socket(zmq.SUB)
@@ -145,7 +150,7 @@ class ZMQTest (BitcoinTestFramework):
                 socket.setsockopt(zmq.IPV6, 1)
             subscribers.append(ZMQSubscriber(socket, topic.encode()))
 
-        self.restart_node(0, [f"-zmqpub{topic}={address.replace('ipc://', 'unix:')}" for topic, address in services])
+        self.restart_node(0, [f"-zmqpub{topic}={address.replace('ipc://', 'unix:')}" for topic, address in services] + extra_args)
 
         for i, sub in enumerate(subscribers):
             sub.socket.connect(services[i][1])
@@ -562,6 +567,49 @@ class ZMQTest (BitcoinTestFramework):
 
         self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE)
 
+    def test_template_diff(self):
+        self.log.info("Testing 'templatediff' publisher")
+        [templatediff] = self.setup_zmq_test([("templatediff", f"tcp://127.0.0.1:{self.zmq_port_base}")],
+                                             sync_blocks=False, extra_args=["-zmqpubtemplatediffminfee=0.0001"])
+
+        def receive_diff():
+            diff = BlockTemplateDiff()
+            diff.deserialize(BytesIO(templatediff.receive()))
+            return diff
+
+        # A new tip publishes the whole template.
+        self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)
+        full = receive_diff()
+        assert_equal(full.base_id, 0)
+        assert_equal(f"{full.header.hashPrevBlock:064x}", self.nodes[0].getbestblockhash())
+        block = full.apply([])
+        assert_equal(block.calc_merkle_root(), full.header.hashMerkleRoot)
+
+        # A transaction with enough fees publishes its addition.
+        tx = self.wallet.send_self_transfer(from_node=self.nodes[0])
+        added = receive_diff()
+        assert_equal(added.base_id, full.id)
+        assert_equal([tx.rehash() for tx in added.added], [tx["txid"]])
+        block = added.apply(block.vtx[1:])
+        assert_equal(block.calc_merkle_root(), added.header.hashMerkleRoot)
+
+        # Smaller fee increases are not published on their own.
+        tx_low = self.wallet.send_self_transfer(from_node=self.nodes[0], fee_rate=Decimal("0.00005"))
+        templatediff.socket.set(zmq.RCVTIMEO, 3000)
+        assert_raises(zmq.error.Again, templatediff.receive)
+        templatediff.socket.set(zmq.RCVTIMEO, 60000)
+        tx_high = self.wallet.send_self_transfer(from_node=self.nodes[0])
+        improved = receive_diff()
+        assert_equal(improved.base_id, added.id)
+        assert_equal(sorted(tx.rehash() for tx in improved.added), sorted([tx_low["txid"], tx_high["txid"]]))
+        block = improved.apply(block.vtx[1:])
+        assert_equal(block.calc_merkle_root(), improved.header.hashMerkleRoot)
+
+        # The updated block is valid.
+        block.solve()
+        assert_equal(self.nodes[0].submitblock(block.serialize().hex()), None)
+        assert_equal(receive_diff().base_id, 0)
+
     def test_multiple_interfaces(self):
         # Set up two subscribers with different addresses
         # (note that after the reorg test, syncing would fail due to different
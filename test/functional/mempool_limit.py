@@ -15,6 +15,7 @@ from test_framework.util import (
     assert_equal,
     assert_fee_amount,
     assert_greater_than,
+    assert_greater_than_or_equal,
     assert_raises_rpc_error,
 )
 from test_framework.wallet import (
@@ -261,6 +262,14 @@ class MempoolLimitTest(BitcoinTestFramework):
 
         fill_mempool(self, node)
 
+        self.log.info('Check that the memory usage breakdown adds up to the total, within maxmempool')
+        info = node.getmempoolinfo()
+        assert_equal(sum(info['usagebreakdown'].values()), info['usage'])
+        assert_greater_than_or_equal(info['maxmempool'], info['usage'])
+        assert_greater_than(info['usagebreakdown']['entries'], 0)
+        assert_greater_than(info['usagebreakdown']['transactions'], 0)
+        assert_equal(info['usagebreakdown']['clusters'], 0)
+
         # Deliberately try to create a tx with a fee less than the minimum mempool fee to assert that it does not get added to the mempool
         self.log.info('Create a mempool tx that will not pass mempoolminfee')
         assert_raises_rpc_error(-26, "mempool min fee not met", miniwallet.send_self_transfer, from_node=node, fee_rate=relayfee)
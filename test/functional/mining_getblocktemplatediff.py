@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test getblocktemplatediff."""
+
+from decimal import Decimal
+from io import BytesIO
+import threading
+import time
+
+from test_framework.messages import (
+    BlockTemplateDiff,
+    COIN,
+)
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_greater_than_or_equal,
+    assert_raises_rpc_error,
+    get_rpc_proxy,
+)
+from test_framework.wallet import MiniWallet
+
+# node::TEMPLATE_MAX_STALE
+TEMPLATE_MAX_STALE = 5
+
+
+class GetBlockTemplateDiffTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.supports_cli = False
+
+    def get_update(self, *args, node=None):
+        """Call getblocktemplatediff, check that its fields match the serialized update,
+        and apply it to the transactions of the last update."""
+        result = (node or self.nodes[0]).getblocktemplatediff(*args)
+        if result is None:
+            return None
+        diff = BlockTemplateDiff()
+        diff.deserialize(BytesIO(bytes.fromhex(result["data"])))
+        assert_equal(diff.id, result["id"])
+        assert_equal(diff.base_id, result["baseid"])
+        assert_equal(diff.fees, result["fees"])
+        assert_equal(f"{diff.header.hashPrevBlock:064x}", result["previousblockhash"])
+        assert_equal([f"{txid:064x}" for txid in diff.removed], result["removed"])
+        assert_equal([tx.rehash() for tx in diff.added], result["added"])
+
+        self.block = diff.apply(self.block.vtx[1:] if self.block else [])
+        assert_equal(self.block.calc_merkle_root(), diff.header.hashMerkleRoot)
+        return result
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.wallet = MiniWallet(node)
+        self.block = None
+
+        self.log.info("Check that the first update contains the whole template")
+        self.generate(node, 1)
+        mock_time = int(time.time())
+        node.setmocktime(mock_time)
+        full = self.get_update()
+        assert_equal(full["baseid"], 0)
+        assert_equal(full["previousblockhash"], node.getbestblockhash())
+        assert_equal(full["added"], [])
+
+        self.log.info("Check that an unchanged template gives no update")
+        assert_equal(node.getblocktemplatediff(full["id"], 0), None)
+        start = time.time()
+        assert_equal(node.getblocktemplatediff(full["id"], 0, 1), None)
+        assert_greater_than_or_equal(time.time() - start, 1)
+        assert_raises_rpc_error(-8, "Negative timeout", node.getblocktemplatediff, full["id"], 0, -1)
+
+        self.log.info("Check that updates wait for the fees to increase enough")
+        utxo = self.wallet.get_utxo()
+        tx_low = self.wallet.send_self_transfer(from_node=node, utxo_to_spend=utxo, fee_rate=Decimal("0.0001"))
+        assert_equal(node.getblocktemplatediff(full["id"]), None)
+        added = self.get_update(full["id"], 0)
+        assert_equal(added["baseid"], full["id"])
+        assert_equal(added["removed"], [])
+        assert_equal(added["added"], [tx_low["txid"]])
+        assert_equal(added["fees"], int(tx_low["fee"] * COIN))
+
+        self.log.info("Check that a replaced transaction is removed")
+        tx_high = self.wallet.send_self_transfer(from_node=node, utxo_to_spend=utxo, fee_rate=Decimal("0.01"))
+        # The template is only rebuilt for the removal once it is older than TEMPLATE_MAX_STALE.
+        assert_equal(node.getblocktemplatediff(added["id"], 0), None)
+        mock_time += TEMPLATE_MAX_STALE
+        node.setmocktime(mock_time)
+        replaced = self.get_update(added["id"])
+        assert_equal(replaced["baseid"], added["id"])
+        assert_equal(replaced["removed"], [tx_low["txid"]])
+        assert_equal(replaced["added"], [tx_high["txid"]])
+
+        self.log.info("Check that a waiting call returns once the template improves")
+        rpc = get_rpc_proxy(node.url, 1, timeout=600, coveragedir=node.coverage_dir)
+        results = []
+        thread = threading.Thread(target=lambda: results.append(self.get_update(replaced["id"], 0, 600, node=rpc)))
+        thread.start()
+        tx_chain = self.wallet.send_self_transfer_chain(from_node=node, chain_length=3)
+        thread.join(timeout=60)
+        assert not thread.is_alive()
+        waited = results[0]
+        assert_equal(waited["baseid"], replaced["id"])
+        # The chain may have been only partially accepted when the template was updated.
+        assert_equal(waited["added"], [tx["txid"] for tx in tx_chain][:len(waited["added"])])
+        last = waited
+        while (update := self.get_update(last["id"], 0)) is not None:
+            last = update
+        assert_equal(sorted(tx.rehash() for tx in self.block.vtx[1:]),
+                     sorted(tx["txid"] for tx in node.getblocktemplate({"rules": ["segwit"]})["transactions"]))
+
+        self.log.info("Check that the updated block is valid")
+        self.block.solve()
+        assert_equal(node.submitblock(self.block.serialize().hex()), None)
+        mined_hash = self.block.hash
+        assert_equal(node.getbestblockhash(), mined_hash)
+        assert_equal(node.getrawmempool(), [])
+
+        self.log.info("Check that a new tip gives the whole template, regardless of fees")
+        new_tip = self.get_update(last["id"], 21000000)
+        assert_equal(new_tip["baseid"], 0)
+        assert_equal(new_tip["previousblockhash"], mined_hash)
+        assert_equal(node.getblocktemplatediff(new_tip["id"], 0), None)
+
+        self.log.info("Check that an unknown base gives the whole template")
+        unknown = self.get_update(1000, 0)
+        assert_equal(unknown["baseid"], 0)
+
+
+if __name__ == '__main__':
+    GetBlockTemplateDiffTest().main()
@@ -56,6 +56,10 @@ class DumptxoutsetTest(BitcoinTestFramework):
         assert_raises_rpc_error(
             -8, "Couldn't open file {}.incomplete for writing".format(invalid_path), node.dumptxoutset, invalid_path)
 
+        # Only known snapshot versions can be written.
+        assert_raises_rpc_error(
+            -8, "Unsupported snapshot version 3", node.dumptxoutset, 'txoutset_v3.dat', 3)
+
 
 if __name__ == '__main__':
     DumptxoutsetTest().main()
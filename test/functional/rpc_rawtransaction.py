@@ -70,7 +70,7 @@ class RawTransactionsTest(BitcoinTestFramework):
         self.num_nodes = 3
         self.extra_args = [
             ["-txindex"],
-            ["-txindex"],
+            ["-txindex", "-txindexformat=compact", "-prevoutindex"],
             ["-fastprune", "-prune=1"],
         ]
         # whitelist peers to speed up tx relay / mempool sync
@@ -126,6 +126,9 @@ class RawTransactionsTest(BitcoinTestFramework):
 
                 # 5. valid parameters - supply txid and True for non-verbose
                 assert_equal(self.nodes[n].getrawtransaction(txId, True)["hex"], tx['hex'])
+
+                # The compact txindex format finds the same transaction
+                assert_equal(self.nodes[1].getrawtransaction(txId, True), self.nodes[n].getrawtransaction(txId, True))
             else:
                 # Without -txindex, expect to raise.
                 for verbose in [None, 0, False, 1, True]:
@@ -240,6 +243,9 @@ class RawTransactionsTest(BitcoinTestFramework):
 
         # check verbosity 2 without blockhash but with txindex
         assert 'fee' in self.nodes[0].getrawtransaction(txid=tx, verbosity=2)
+        self.log.info("Test getrawtransaction_verbosity 2 with -prevoutindex")
+        self.wait_until(lambda: self.nodes[1].getindexinfo('prevoutindex')['prevoutindex']['synced'])
+        assert_equal(self.nodes[1].getrawtransaction(txid=tx, verbosity=2), self.nodes[0].getrawtransaction(txid=tx, verbosity=2))
         # check that coinbase has no fee or does not throw any errors for verbosity 2
         coin_base = self.nodes[1].getblock(block1)['tx'][0]
         gottx = self.nodes[1].getrawtransaction(txid=coin_base, verbosity=2, blockhash=block1)
@@ -835,6 +835,45 @@ class CBlock(CBlockHeader):
                time.ctime(self.nTime), self.nBits, self.nNonce, repr(self.vtx))
 
 
+class BlockTemplateDiff:
+    """A block template as a change to an earlier one, as returned by
+    getblocktemplatediff and published by -zmqpubtemplatediff."""
+    __slots__ = ("id", "base_id", "header", "fees", "coinbase", "removed", "added")
+
+    def __init__(self):
+        self.id = 0
+        self.base_id = 0
+        self.header = CBlockHeader()
+        self.fees = 0
+        self.coinbase = CTransaction()
+        self.removed = []
+        self.added = []
+
+    def deserialize(self, f):
+        self.id = int.from_bytes(f.read(8), "little")
+        self.base_id = int.from_bytes(f.read(8), "little")
+        self.header.deserialize(f)
+        self.fees = int.from_bytes(f.read(8), "little", signed=True)
+        self.coinbase.deserialize(f)
+        self.removed = deser_uint256_vector(f)
+        self.added = deser_vector(f, CTransaction)
+
+    def apply(self, txs):
+        """Return the template's block, given the non-coinbase transactions of the base template."""
+        if self.base_id == 0:
+            txs = []
+        for tx in txs:
+            tx.calc_sha256()
+        removed = set(self.removed)
+        block = CBlock(self.header)
+        block.vtx = [self.coinbase] + [tx for tx in txs if tx.sha256 not in removed] + self.added
+        return block
+
+    def __repr__(self):
+        return "BlockTemplateDiff(id=%i base_id=%i header=%s fees=%i removed=%i added=%i)" \
+            % (self.id, self.base_id, repr(self.header), self.fees, len(self.removed), len(self.added))
+
+
 class PrefilledTransaction:
     __slots__ = ("index", "tx")
 
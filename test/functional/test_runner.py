@@ -96,6 +96,7 @@ BASE_SCRIPTS = [
     'feature_block.py',
     # vv Tests less than 2m vv
     'mining_getblocktemplate_longpoll.py',
+    'mining_getblocktemplatediff.py',
     'p2p_segwit.py',
     'feature_maxuploadtarget.py',
     'mempool_updatefromblock.py',
@@ -378,6 +379,8 @@ BASE_SCRIPTS = [
     'feature_anchors.py',
     'mempool_datacarrier.py',
     'feature_coinstatsindex.py',
+    'feature_scripthistoryindex.py',
+    'feature_scriptutxoindex.py',
     'wallet_orphanedreward.py',
     'wallet_timelock.py',
     'p2p_node_network_limited.py --v1transport',